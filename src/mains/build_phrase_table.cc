@@ -0,0 +1,59 @@
+#include "nlp_common/ErrorDefs.h"
+#include "phrase_models/IncrPhraseModel.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+void printUsage()
+{
+  std::cerr << "Usage: build_phrase_table [-k <max. translations per source phrase>] [-c <min. pair count>]"
+            << std::endl
+            << "                          [-f <min. significance> -n <number of sentence pairs>]" << std::endl
+            << "                          <ttable file> <binary ttable file>" << std::endl;
+}
+
+/// @brief Convert a plain text phrase table into the binary format that is mapped into memory when it is loaded,
+/// optionally pruning it
+int main(int argc, char* argv[])
+{
+  PhraseTablePruningParameters pruningPars;
+  int nextArg = 1;
+  while (nextArg + 1 < argc && argv[nextArg][0] == '-' && strlen(argv[nextArg]) == 2)
+  {
+    const char* value = argv[nextArg + 1];
+    switch (argv[nextArg][1])
+    {
+    case 'k':
+      pruningPars.maxTrgPhrasesPerSrc = (unsigned int)strtoul(value, NULL, 10);
+      break;
+    case 'c':
+      pruningPars.minPairCount = (float)atof(value);
+      break;
+    case 'f':
+      pruningPars.minSignificance = atof(value);
+      break;
+    case 'n':
+      pruningPars.numSentencePairs = (size_t)strtoull(value, NULL, 10);
+      break;
+    default:
+      printUsage();
+      return 1;
+    }
+    nextArg += 2;
+  }
+  if (argc - nextArg != 2 || (pruningPars.minSignificance > 0 && pruningPars.numSentencePairs == 0))
+  {
+    printUsage();
+    return 1;
+  }
+
+  IncrPhraseModel model;
+  model.setPruningParameters(pruningPars);
+  if (model.buildBinaryPhraseTable(argv[nextArg], argv[nextArg + 1], 1) == THOT_ERROR)
+  {
+    std::cerr << "Error while building binary phrase table " << argv[nextArg + 1] << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+#include "nlp_common/ErrorDefs.h"
+#include "sw_models/FastAlignModel.h"
+#include "sw_models/HmmAlignmentModel.h"
+#include "sw_models/Ibm1AlignmentModel.h"
+#include "sw_models/Ibm1Eflomal.h"
+#include "sw_models/Ibm2AlignmentModel.h"
+#include "sw_models/Ibm3AlignmentModel.h"
+#include "sw_models/Ibm4AlignmentModel.h"
+#include "sw_models/IncrHmmAlignmentModel.h"
+#include "sw_models/IncrIbm1AlignmentModel.h"
+#include "sw_models/IncrIbm2AlignmentModel.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <yaml-cpp/yaml.h>
+
+/// @brief Create an empty model of the type recorded in the model configuration
+/// @param type value of the "model" key of the .yml file, as written by the model itself
+/// @return the new model, or nullptr if the type is unknown
+AlignmentModel* createAlignmentModel(const std::string& type)
+{
+  if (type == "ibm1")
+    return new Ibm1AlignmentModel();
+  if (type == "eflomal")
+    return new Ibm1Eflomal();
+  if (type == "ibm2")
+    return new Ibm2AlignmentModel();
+  if (type == "hmm")
+    return new HmmAlignmentModel();
+  if (type == "ibm3")
+    return new Ibm3AlignmentModel();
+  if (type == "ibm4")
+    return new Ibm4AlignmentModel();
+  if (type == "fastAlign")
+    return new FastAlignModel();
+  if (type == "incrIbm1")
+    return new IncrIbm1AlignmentModel();
+  if (type == "incrIbm2")
+    return new IncrIbm2AlignmentModel();
+  if (type == "incrHmm")
+    return new IncrHmmAlignmentModel();
+  return nullptr;
+}
+
+/// @brief Convert a model stored as a set of files sharing a prefix into a single container file
+int main(int argc, char* argv[])
+{
+  if (argc != 3)
+  {
+    std::cerr << "Usage: convert_alignment_model <model prefix> <container file>" << std::endl;
+    return 1;
+  }
+  std::string prefix = argv[1];
+  const char* containerFileName = argv[2];
+
+  std::string type;
+  try
+  {
+    YAML::Node config = YAML::LoadFile(prefix + ".yml");
+    type = config["model"].as<std::string>();
+  }
+  catch (const YAML::Exception&)
+  {
+    std::cerr << "Error: the model type could not be read from " << prefix << ".yml" << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<AlignmentModel> model(createAlignmentModel(type));
+  if (!model)
+  {
+    std::cerr << "Error: unknown model type " << type << std::endl;
+    return 1;
+  }
+
+  if (model->load(prefix.c_str(), 1) == THOT_ERROR)
+  {
+    std::cerr << "Error while loading model " << prefix << std::endl;
+    return 1;
+  }
+  if (model->printContainer(containerFileName, 1) == THOT_ERROR)
+  {
+    std::cerr << "Error while writing container " << containerFileName << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,343 @@
+#include "nlp_common/FrozenVocab.h"
+
+#include "nlp_common/ErrorDefs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+const char FROZEN_VOCAB_MAGIC[8] = {'T', 'H', 'O', 'T', 'V', 'O', 'C', 'B'};
+const uint32_t FROZEN_VOCAB_VERSION = 1;
+const uint32_t MAX_DISPLACEMENT_SEED = 1u << 24;
+
+std::size_t alignedSize(std::size_t size)
+{
+  return (size + 7) & ~(std::size_t)7;
+}
+
+template <typename T>
+bool takeArray(const char* image, std::size_t imageSize, std::size_t& pos, uint64_t n, const T*& array)
+{
+  if (n > imageSize / sizeof(T))
+    return false;
+  array = reinterpret_cast<const T*>(image + pos);
+  pos += alignedSize(n * sizeof(T));
+  return pos <= imageSize;
+}
+} // namespace
+
+FrozenVocab::FrozenVocab()
+    : header{nullptr}, offsets{nullptr}, seeds{nullptr}, slots{nullptr}, arena{nullptr}
+{
+}
+
+bool FrozenVocab::isFrozen() const
+{
+  return header != nullptr;
+}
+
+std::size_t FrozenVocab::size() const
+{
+  return header == nullptr ? 0 : header->numWords;
+}
+
+uint64_t FrozenVocab::hashString(const char* str, std::size_t len)
+{
+  // FNV-1a followed by the murmur3 finalizer
+  uint64_t h = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < len; ++i)
+  {
+    h ^= (unsigned char)str[i];
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t FrozenVocab::slotHash(uint64_t keyHash, uint32_t seed)
+{
+  uint64_t h = keyHash ^ ((uint64_t)seed * 0x9e3779b97f4a7c15ULL);
+  h ^= h >> 31;
+  h *= 0x7fb5d329728ea185ULL;
+  h ^= h >> 27;
+  h *= 0x81dadef4bc2dd44dULL;
+  h ^= h >> 33;
+  return h;
+}
+
+bool FrozenVocab::buildImage(const std::vector<std::pair<const std::string*, WordIndex>>& entries)
+{
+  uint64_t numWords = entries.size();
+  uint64_t numIndices = 0;
+  uint64_t arenaSize = 0;
+  for (std::size_t k = 0; k < entries.size(); ++k)
+  {
+    numIndices = std::max(numIndices, (uint64_t)entries[k].second + 1);
+    arenaSize += entries[k].first->size();
+  }
+  uint64_t numBuckets = std::max<uint64_t>(1, (numWords + 3) / 4);
+
+  // Group keys by bucket and process the largest buckets first
+  std::vector<uint64_t> keyHashes(entries.size());
+  std::vector<std::vector<uint32_t>> buckets(numBuckets);
+  for (std::size_t k = 0; k < entries.size(); ++k)
+  {
+    keyHashes[k] = hashString(entries[k].first->data(), entries[k].first->size());
+    buckets[(keyHashes[k] >> 32) % numBuckets].push_back((uint32_t)k);
+  }
+  std::vector<uint32_t> bucketOrder(numBuckets);
+  for (uint32_t b = 0; b < numBuckets; ++b)
+    bucketOrder[b] = b;
+  std::stable_sort(bucketOrder.begin(), bucketOrder.end(),
+                   [&](uint32_t b1, uint32_t b2) { return buckets[b1].size() > buckets[b2].size(); });
+
+  std::vector<uint32_t> bucketSeeds(numBuckets, 0);
+  std::vector<uint32_t> slotToIndex(numWords, 0);
+  std::vector<bool> taken(numWords, false);
+  std::vector<uint64_t> bucketSlots;
+  for (uint32_t b : bucketOrder)
+  {
+    const std::vector<uint32_t>& bucket = buckets[b];
+    if (bucket.empty())
+      break;
+    uint32_t seed = 1;
+    for (; seed < MAX_DISPLACEMENT_SEED; ++seed)
+    {
+      bucketSlots.clear();
+      bool ok = true;
+      for (uint32_t k : bucket)
+      {
+        uint64_t slot = slotHash(keyHashes[k], seed) % numWords;
+        if (taken[slot] || std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end())
+        {
+          ok = false;
+          break;
+        }
+        bucketSlots.push_back(slot);
+      }
+      if (ok)
+        break;
+    }
+    if (seed == MAX_DISPLACEMENT_SEED)
+      return THOT_ERROR;
+    bucketSeeds[b] = seed;
+    for (std::size_t k = 0; k < bucket.size(); ++k)
+    {
+      taken[bucketSlots[k]] = true;
+      slotToIndex[bucketSlots[k]] = (uint32_t)entries[bucket[k]].second;
+    }
+  }
+
+  // Lay out the image
+  std::size_t offsetsPos = alignedSize(sizeof(Header));
+  std::size_t seedsPos = offsetsPos + alignedSize((numIndices + 1) * sizeof(uint64_t));
+  std::size_t slotsPos = seedsPos + alignedSize(numBuckets * sizeof(uint32_t));
+  std::size_t arenaPos = slotsPos + alignedSize(numWords * sizeof(uint32_t));
+  std::size_t imageSize = arenaPos + alignedSize(arenaSize);
+
+  std::vector<uint64_t> image(imageSize / sizeof(uint64_t), 0);
+  char* base = reinterpret_cast<char*>(image.data());
+
+  Header h;
+  std::memcpy(h.magic, FROZEN_VOCAB_MAGIC, sizeof(h.magic));
+  h.version = FROZEN_VOCAB_VERSION;
+  h.numWords = (uint32_t)numWords;
+  h.numIndices = numIndices;
+  h.numBuckets = numBuckets;
+  h.arenaSize = arenaSize;
+  std::memcpy(base, &h, sizeof(Header));
+
+  // Words are stored in index order; unused indices get an empty string
+  std::vector<const std::string*> words(numIndices, nullptr);
+  for (std::size_t k = 0; k < entries.size(); ++k)
+    words[entries[k].second] = entries[k].first;
+  uint64_t* offs = reinterpret_cast<uint64_t*>(base + offsetsPos);
+  char* arenaPtr = base + arenaPos;
+  uint64_t pos = 0;
+  for (uint64_t w = 0; w < numIndices; ++w)
+  {
+    offs[w] = pos;
+    if (words[w] != nullptr)
+    {
+      std::memcpy(arenaPtr + pos, words[w]->data(), words[w]->size());
+      pos += words[w]->size();
+    }
+  }
+  offs[numIndices] = pos;
+  if (!bucketSeeds.empty())
+    std::memcpy(base + seedsPos, bucketSeeds.data(), numBuckets * sizeof(uint32_t));
+  if (!slotToIndex.empty())
+    std::memcpy(base + slotsPos, slotToIndex.data(), numWords * sizeof(uint32_t));
+
+  clear();
+  std::shared_ptr<std::vector<uint64_t>> ownedImagePtr = std::make_shared<std::vector<uint64_t>>();
+  ownedImagePtr->swap(image);
+  ownedImage = ownedImagePtr;
+  return attach(reinterpret_cast<const char*>(ownedImage->data()), imageSize);
+}
+
+bool FrozenVocab::attach(const char* image, std::size_t imageSize)
+{
+  if (imageSize < sizeof(Header))
+    return THOT_ERROR;
+  const Header* h = reinterpret_cast<const Header*>(image);
+  if (std::memcmp(h->magic, FROZEN_VOCAB_MAGIC, sizeof(h->magic)) != 0 || h->version != FROZEN_VOCAB_VERSION)
+    return THOT_ERROR;
+
+  std::size_t pos = alignedSize(sizeof(Header));
+  const uint64_t* imageOffsets;
+  const uint32_t* imageSeeds;
+  const uint32_t* imageSlots;
+  const char* imageArena;
+  if (h->numIndices >= imageSize || (h->numWords > 0 && h->numBuckets == 0)
+      || !takeArray(image, imageSize, pos, h->numIndices + 1, imageOffsets)
+      || !takeArray(image, imageSize, pos, h->numBuckets, imageSeeds)
+      || !takeArray(image, imageSize, pos, h->numWords, imageSlots)
+      || !takeArray(image, imageSize, pos, h->arenaSize, imageArena))
+    return THOT_ERROR;
+
+  // The offsets and slots are checked once here, so that lookups can index the arena
+  // directly
+  if (imageOffsets[0] != 0 || imageOffsets[h->numIndices] != h->arenaSize)
+    return THOT_ERROR;
+  for (uint64_t w = 0; w < h->numIndices; ++w)
+  {
+    if (imageOffsets[w] > imageOffsets[w + 1])
+      return THOT_ERROR;
+  }
+  for (uint32_t slot = 0; slot < h->numWords; ++slot)
+  {
+    if (imageSlots[slot] >= h->numIndices)
+      return THOT_ERROR;
+  }
+
+  header = h;
+  offsets = imageOffsets;
+  seeds = imageSeeds;
+  slots = imageSlots;
+  arena = imageArena;
+  return THOT_OK;
+}
+
+WordIndex FrozenVocab::stringToWordIndex(const char* str, std::size_t len) const
+{
+  if (header == nullptr || header->numWords == 0)
+    return UNK_WORD;
+
+  uint64_t keyHash = hashString(str, len);
+  uint32_t seed = seeds[(keyHash >> 32) % header->numBuckets];
+  WordIndex w = slots[slotHash(keyHash, seed) % header->numWords];
+  if (offsets[w + 1] - offsets[w] == len && std::memcmp(arena + offsets[w], str, len) == 0)
+    return w;
+  return UNK_WORD;
+}
+
+WordIndex FrozenVocab::stringToWordIndex(const std::string& str) const
+{
+  return stringToWordIndex(str.data(), str.size());
+}
+
+bool FrozenVocab::exists(const char* str, std::size_t len) const
+{
+  WordIndex w = stringToWordIndex(str, len);
+  if (w != UNK_WORD)
+    return true;
+  // UNK_WORD is also returned for the unknown word symbol itself
+  std::size_t unkLen;
+  const char* unk = wordIndexToString(UNK_WORD, unkLen);
+  return unk != nullptr && unkLen == len && std::memcmp(unk, str, len) == 0;
+}
+
+bool FrozenVocab::exists(const std::string& str) const
+{
+  return exists(str.data(), str.size());
+}
+
+const char* FrozenVocab::wordIndexToString(WordIndex w, std::size_t& len) const
+{
+  if (header == nullptr || w >= header->numIndices)
+  {
+    len = 0;
+    return nullptr;
+  }
+  len = (std::size_t)(offsets[w + 1] - offsets[w]);
+  if (len == 0)
+    return nullptr;
+  return arena + offsets[w];
+}
+
+std::string FrozenVocab::wordIndexToString(WordIndex w) const
+{
+  std::size_t len;
+  const char* str = wordIndexToString(w, len);
+  if (str == nullptr)
+    return UNK_WORD_STR;
+  return std::string(str, len);
+}
+
+bool FrozenVocab::load(const char* fileName, int verbose)
+{
+  if (verbose)
+    std::cerr << "Loading frozen vocabulary from " << fileName << std::endl;
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+  if (file->open(fileName, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+  if (load(file, file->data(), file->size()) == THOT_ERROR)
+  {
+    if (verbose)
+      std::cerr << "Error: " << fileName << " is not a valid frozen vocabulary file" << std::endl;
+    return THOT_ERROR;
+  }
+  return THOT_OK;
+}
+
+bool FrozenVocab::load(const std::shared_ptr<MappedFile>& file, const char* image, std::size_t imageSize)
+{
+  if (attach(image, imageSize) == THOT_ERROR)
+    return THOT_ERROR;
+  ownedImage.reset();
+  mappedImage = file;
+  return THOT_OK;
+}
+
+bool FrozenVocab::print(const char* fileName) const
+{
+  if (header == nullptr)
+    return THOT_ERROR;
+
+  std::ofstream outF(fileName, std::ios::out | std::ios::binary);
+  if (!outF)
+  {
+    std::cerr << "Error while printing frozen vocabulary." << std::endl;
+    return THOT_ERROR;
+  }
+  return print(outF);
+}
+
+bool FrozenVocab::print(std::ostream& out) const
+{
+  if (header == nullptr)
+    return THOT_ERROR;
+
+  std::size_t imageSize = (std::size_t)(arena - reinterpret_cast<const char*>(header)) + alignedSize(header->arenaSize);
+  out.write(reinterpret_cast<const char*>(header), imageSize);
+  return out ? THOT_OK : THOT_ERROR;
+}
+
+void FrozenVocab::clear()
+{
+  header = nullptr;
+  offsets = nullptr;
+  seeds = nullptr;
+  slots = nullptr;
+  arena = nullptr;
+  ownedImage.reset();
+  mappedImage.reset();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "nlp_common/MappedFile.h"
+#include "nlp_common/WordIndex.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Read-only vocabulary for a single language.
+//
+// All the words are stored in one contiguous arena. The index-to-string
+// direction is a direct lookup in an offset array, and the string-to-index
+// direction uses a minimal perfect hash function (hash and displace) that is
+// built when the vocabulary is frozen. Every lookup is verified against the
+// arena, so unknown words are reliably rejected.
+//
+// The in-memory image has the same layout as the file written by print(), so
+// load() simply maps the file into memory. The image is immutable, so copies
+// share it.
+class FrozenVocab
+{
+public:
+  FrozenVocab();
+
+  // Builds the structure from any map-like container of (string, index) pairs
+  template <typename Vocab>
+  bool build(const Vocab& vocab);
+
+  bool isFrozen() const;
+  std::size_t size() const;
+
+  WordIndex stringToWordIndex(const char* str, std::size_t len) const;
+  WordIndex stringToWordIndex(const std::string& str) const;
+  bool exists(const char* str, std::size_t len) const;
+  bool exists(const std::string& str) const;
+  // Returns a pointer into the arena, or nullptr if the index is not used
+  const char* wordIndexToString(WordIndex w, std::size_t& len) const;
+  std::string wordIndexToString(WordIndex w) const;
+
+  // Adds every word to the given map-like container
+  template <typename Vocab>
+  void fill(Vocab& vocab) const;
+
+  bool load(const char* fileName, int verbose = 0);
+  // Uses an image stored inside a mapped file, which is kept open
+  bool load(const std::shared_ptr<MappedFile>& file, const char* image, std::size_t imageSize);
+  bool print(const char* fileName) const;
+  bool print(std::ostream& out) const;
+
+  void clear();
+
+private:
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t numWords;
+    uint64_t numIndices;
+    uint64_t numBuckets;
+    uint64_t arenaSize;
+  };
+
+  bool buildImage(const std::vector<std::pair<const std::string*, WordIndex>>& entries);
+  bool attach(const char* image, std::size_t imageSize);
+
+  static uint64_t hashString(const char* str, std::size_t len);
+  static uint64_t slotHash(uint64_t keyHash, uint32_t seed);
+
+  std::shared_ptr<const std::vector<uint64_t>> ownedImage;
+  std::shared_ptr<MappedFile> mappedImage;
+
+  const Header* header;
+  const uint64_t* offsets;
+  const uint32_t* seeds;
+  const uint32_t* slots;
+  const char* arena;
+};
+
+template <typename Vocab>
+bool FrozenVocab::build(const Vocab& vocab)
+{
+  std::vector<std::pair<const std::string*, WordIndex>> entries;
+  entries.reserve(vocab.size());
+  for (typename Vocab::const_iterator iter = vocab.begin(); iter != vocab.end(); ++iter)
+    entries.push_back(std::make_pair(&iter->first, (WordIndex)iter->second));
+  return buildImage(entries);
+}
+
+template <typename Vocab>
+void FrozenVocab::fill(Vocab& vocab) const
+{
+  if (!isFrozen())
+    return;
+  for (uint64_t w = 0; w < header->numIndices; ++w)
+  {
+    std::size_t len;
+    const char* str = wordIndexToString((WordIndex)w, len);
+    if (str != nullptr)
+      vocab[std::string(str, len)] = (WordIndex)w;
+  }
+}
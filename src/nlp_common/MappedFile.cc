@@ -0,0 +1,109 @@
+#include "nlp_common/MappedFile.h"
+
+#include "nlp_common/ErrorDefs.h"
+
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : addr{nullptr}, length{0}, mapped{false}
+{
+}
+
+bool MappedFile::open(const char* fileName, int verbose)
+{
+  close();
+
+#ifndef _WIN32
+  int fd = ::open(fileName, O_RDONLY);
+  if (fd == -1)
+  {
+    if (verbose)
+      std::cerr << "Error: file " << fileName << " could not be opened" << std::endl;
+    return THOT_ERROR;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == -1)
+  {
+    ::close(fd);
+    return THOT_ERROR;
+  }
+  length = (std::size_t)st.st_size;
+  if (length > 0)
+  {
+    void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+      ::close(fd);
+      length = 0;
+      if (verbose)
+        std::cerr << "Error: file " << fileName << " could not be mapped into memory" << std::endl;
+      return THOT_ERROR;
+    }
+    addr = static_cast<const char*>(p);
+    mapped = true;
+  }
+  ::close(fd);
+#else
+  std::ifstream inF(fileName, std::ios::in | std::ios::binary);
+  if (!inF)
+  {
+    if (verbose)
+      std::cerr << "Error: file " << fileName << " could not be opened" << std::endl;
+    return THOT_ERROR;
+  }
+  inF.seekg(0, std::ios::end);
+  length = (std::size_t)inF.tellg();
+  inF.seekg(0, std::ios::beg);
+  buffer.resize(length);
+  if (length > 0 && !inF.read(buffer.data(), length))
+  {
+    buffer.clear();
+    length = 0;
+    return THOT_ERROR;
+  }
+  addr = buffer.data();
+#endif
+  if (addr == nullptr)
+    addr = "";
+  return THOT_OK;
+}
+
+bool MappedFile::isOpen() const
+{
+  return addr != nullptr;
+}
+
+const char* MappedFile::data() const
+{
+  return addr;
+}
+
+std::size_t MappedFile::size() const
+{
+  return length;
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+  if (mapped)
+    munmap(const_cast<char*>(addr), length);
+#endif
+  buffer.clear();
+  buffer.shrink_to_fit();
+  addr = nullptr;
+  length = 0;
+  mapped = false;
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Read-only view of the contents of a file. On POSIX systems the file is
+// memory mapped, so its pages are loaded on demand and shared between all the
+// processes that map the same file. On other platforms the file is read into a
+// private buffer.
+class MappedFile
+{
+public:
+  MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const char* fileName, int verbose = 0);
+  bool isOpen() const;
+  const char* data() const;
+  std::size_t size() const;
+  void close();
+
+  ~MappedFile();
+
+private:
+  const char* addr;
+  std::size_t length;
+  bool mapped;
+  std::vector<char> buffer;
+};
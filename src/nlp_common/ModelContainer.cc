@@ -0,0 +1,218 @@
+#include "nlp_common/ModelContainer.h"
+
+#include "nlp_common/ErrorDefs.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+const char MODEL_CONTAINER_MAGIC[8] = {'T', 'H', 'O', 'T', 'M', 'O', 'D', 'L'};
+const uint32_t MODEL_CONTAINER_VERSION = 1;
+
+std::size_t alignedSize(std::size_t size)
+{
+  return (size + 7) & ~(std::size_t)7;
+}
+
+// Reads a value from the directory, checking that it lies inside the file
+template <typename T>
+bool readValue(const char* data, std::size_t size, std::size_t& pos, T& value)
+{
+  if (pos + sizeof(T) > size)
+    return false;
+  std::memcpy(&value, data + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+bool readString(const char* data, std::size_t size, std::size_t& pos, std::string& str)
+{
+  uint32_t len;
+  if (!readValue(data, size, pos, len) || pos + len > size)
+    return false;
+  str.assign(data + pos, len);
+  pos += len;
+  return true;
+}
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(std::ostream& out, const std::string& str)
+{
+  writeValue(out, (uint32_t)str.size());
+  out.write(str.data(), str.size());
+}
+
+void writePadding(std::ostream& out, std::size_t size)
+{
+  static const char zeros[8] = {0};
+  out.write(zeros, alignedSize(size) - size);
+}
+} // namespace
+
+ModelContainer::ModelContainer()
+{
+}
+
+void ModelContainer::setModelType(const std::string& type)
+{
+  modelType = type;
+}
+
+const std::string& ModelContainer::getModelType() const
+{
+  return modelType;
+}
+
+void ModelContainer::addSection(const std::string& name, const std::string& data)
+{
+  Section section;
+  section.name = name;
+  section.offset = 0;
+  section.size = data.size();
+  section.data = data;
+  sections.push_back(section);
+}
+
+bool ModelContainer::write(const char* fileName, int verbose) const
+{
+  std::ofstream outF(fileName, std::ios::out | std::ios::binary);
+  if (!outF)
+  {
+    if (verbose)
+      std::cerr << "Error while printing model container to file " << fileName << std::endl;
+    return THOT_ERROR;
+  }
+
+  // The directory goes first, so its size determines where the sections start
+  std::size_t directorySize = sizeof(MODEL_CONTAINER_MAGIC) + 3 * sizeof(uint32_t) + modelType.size();
+  for (const Section& section : sections)
+    directorySize += sizeof(uint32_t) + section.name.size() + 2 * sizeof(uint64_t);
+
+  outF.write(MODEL_CONTAINER_MAGIC, sizeof(MODEL_CONTAINER_MAGIC));
+  writeValue(outF, MODEL_CONTAINER_VERSION);
+  writeValue(outF, (uint32_t)sections.size());
+  writeString(outF, modelType);
+  uint64_t offset = alignedSize(directorySize);
+  for (const Section& section : sections)
+  {
+    writeString(outF, section.name);
+    writeValue(outF, offset);
+    writeValue(outF, section.size);
+    offset += alignedSize(section.size);
+  }
+  writePadding(outF, directorySize);
+
+  for (const Section& section : sections)
+  {
+    outF.write(section.data.data(), section.data.size());
+    writePadding(outF, section.data.size());
+  }
+
+  if (!outF)
+  {
+    if (verbose)
+      std::cerr << "Error while printing model container to file " << fileName << std::endl;
+    return THOT_ERROR;
+  }
+  return THOT_OK;
+}
+
+bool ModelContainer::open(const char* fileName, int verbose)
+{
+  clear();
+
+  std::shared_ptr<MappedFile> mappedFile = std::make_shared<MappedFile>();
+  if (mappedFile->open(fileName, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data = mappedFile->data();
+  std::size_t size = mappedFile->size();
+  std::size_t pos = sizeof(MODEL_CONTAINER_MAGIC);
+  uint32_t version;
+  uint32_t numSections;
+  if (size < pos || std::memcmp(data, MODEL_CONTAINER_MAGIC, sizeof(MODEL_CONTAINER_MAGIC)) != 0
+      || !readValue(data, size, pos, version) || version != MODEL_CONTAINER_VERSION
+      || !readValue(data, size, pos, numSections) || !readString(data, size, pos, modelType))
+  {
+    if (verbose)
+      std::cerr << "Error: " << fileName << " is not a valid model container" << std::endl;
+    clear();
+    return THOT_ERROR;
+  }
+
+  for (uint32_t k = 0; k < numSections; ++k)
+  {
+    Section section;
+    if (!readString(data, size, pos, section.name) || !readValue(data, size, pos, section.offset)
+        || !readValue(data, size, pos, section.size) || section.offset + section.size > size)
+    {
+      if (verbose)
+        std::cerr << "Error: corrupted section directory in model container " << fileName << std::endl;
+      clear();
+      return THOT_ERROR;
+    }
+    sections.push_back(section);
+  }
+
+  file = mappedFile;
+  return THOT_OK;
+}
+
+bool ModelContainer::hasSection(const std::string& name) const
+{
+  return findSection(name) != nullptr;
+}
+
+bool ModelContainer::getSection(const std::string& name, const char*& data, std::size_t& size) const
+{
+  const Section* section = findSection(name);
+  if (section == nullptr)
+    return THOT_ERROR;
+
+  if (file)
+    data = file->data() + section->offset;
+  else
+    data = section->data.data();
+  size = section->size;
+  return THOT_OK;
+}
+
+const std::shared_ptr<MappedFile>& ModelContainer::getFile() const
+{
+  return file;
+}
+
+void ModelContainer::clear()
+{
+  modelType.clear();
+  sections.clear();
+  file.reset();
+}
+
+const ModelContainer::Section* ModelContainer::findSection(const std::string& name) const
+{
+  for (const Section& section : sections)
+  {
+    if (section.name == name)
+      return &section;
+  }
+  return nullptr;
+}
+
+MemoryInputStream::MemoryInputStream(const char* data, std::size_t size) : std::istream(this)
+{
+  char* begin = const_cast<char*>(data);
+  setg(begin, begin, begin + size);
+}
+
+bool MemoryInputStream::canRead(std::size_t count, std::size_t itemSize)
+{
+  return itemSize == 0 || count <= (std::size_t)(egptr() - gptr()) / itemSize;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "nlp_common/MappedFile.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// Single file that stores every component of a model as a named binary
+// section. The file starts with a header and a directory of sections, and each
+// section begins at an 8-byte aligned offset, so components whose layout is
+// designed to be mapped (such as frozen vocabularies) can be used in place.
+// Containers are read through a MappedFile, so opening one does not copy its
+// contents.
+class ModelContainer
+{
+public:
+  ModelContainer();
+
+  void setModelType(const std::string& type);
+  const std::string& getModelType() const;
+
+  // Functions to build a new container
+  void addSection(const std::string& name, const std::string& data);
+  bool write(const char* fileName, int verbose = 0) const;
+
+  // Functions to read an existing container
+  bool open(const char* fileName, int verbose = 0);
+  bool hasSection(const std::string& name) const;
+  bool getSection(const std::string& name, const char*& data, std::size_t& size) const;
+  const std::shared_ptr<MappedFile>& getFile() const;
+
+  void clear();
+
+private:
+  struct Section
+  {
+    std::string name;
+    uint64_t offset;
+    uint64_t size;
+    std::string data;
+  };
+
+  std::string modelType;
+  std::vector<Section> sections;
+  std::shared_ptr<MappedFile> file;
+
+  const Section* findSection(const std::string& name) const;
+};
+
+// Input stream over a read-only memory range, used to parse the sections of a
+// mapped container with the regular stream-based loaders
+class MemoryInputStream : private std::streambuf, public std::istream
+{
+public:
+  MemoryInputStream(const char* data, std::size_t size);
+
+  // Returns true if count items of itemSize bytes are left to read, so that sizes
+  // read from a section can be checked before anything is allocated for them
+  bool canRead(std::size_t count, std::size_t itemSize);
+};
@@ -26,6 +26,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 #include "nlp_common/AwkInputStream.h"
 #include "nlp_common/ErrorDefs.h"
+#include "nlp_common/StrProcUtils.h"
 
 #include <fstream>
 #include <iostream>
@@ -59,17 +60,28 @@ bool SingleWordVocab::loadSrcVocab(const char* srcInputVocabFileName, int verbos
 //-------------------------
 SingleWordVocab::StrToIdxVocab SingleWordVocab::getSrcVocab(void) const
 {
+  if (frozenSrcVocab.isFrozen())
+  {
+    StrToIdxVocab vocab;
+    frozenSrcVocab.fill(vocab);
+    return vocab;
+  }
   return stringToSrcWordIndexMap;
 }
 
 //-------------------------
 size_t SingleWordVocab::getSrcVocabSize(void) const
 {
+  if (frozenSrcVocab.isFrozen())
+    return frozenSrcVocab.size();
   return stringToSrcWordIndexMap.size();
 }
 //-------------------------
-WordIndex SingleWordVocab::stringToSrcWordIndex(std::string s) const
+WordIndex SingleWordVocab::stringToSrcWordIndex(const std::string& s) const
 {
+  if (frozenSrcVocab.isFrozen())
+    return frozenSrcVocab.stringToWordIndex(s);
+
   StrToIdxVocab::const_iterator strToIdxVocabIter;
 
   strToIdxVocabIter = stringToSrcWordIndexMap.find(s);
@@ -84,6 +96,9 @@ WordIndex SingleWordVocab::stringToSrcWordIndex(std::string s) const
 //-------------------------
 std::string SingleWordVocab::wordIndexToSrcString(WordIndex w) const
 {
+  if (frozenSrcVocab.isFrozen())
+    return frozenSrcVocab.wordIndexToString(w);
+
   IdxToStrVocab::const_iterator idxToStrVocabIter;
 
   idxToStrVocabIter = srcWordIndexMapToString.find(w);
@@ -98,6 +113,9 @@ std::string SingleWordVocab::wordIndexToSrcString(WordIndex w) const
 //-------------------------
 bool SingleWordVocab::existSrcSymbol(std::string s) const
 {
+  if (frozenSrcVocab.isFrozen())
+    return frozenSrcVocab.exists(s);
+
   StrToIdxVocab::const_iterator strToIdxVocabIter;
 
   strToIdxVocabIter = stringToSrcWordIndexMap.find(s);
@@ -110,10 +128,11 @@ bool SingleWordVocab::existSrcSymbol(std::string s) const
 }
 
 //-------------------------
-std::vector<WordIndex> SingleWordVocab::strVectorToSrcIndexVector(std::vector<std::string> s)
+std::vector<WordIndex> SingleWordVocab::strVectorToSrcIndexVector(const std::vector<std::string>& s)
 {
   unsigned int i;
   std::vector<WordIndex> wordIndex_s;
+  wordIndex_s.reserve(s.size());
   WordIndex wordIndex;
 
   for (i = 0; i < s.size(); ++i)
@@ -130,6 +149,13 @@ WordIndex SingleWordVocab::addSrcSymbol(std::string s)
   WordIndex wordIndex;
   StrToIdxVocab::const_iterator strToIdxVocabIter;
 
+  if (frozenSrcVocab.isFrozen())
+  {
+    if (frozenSrcVocab.exists(s))
+      return frozenSrcVocab.stringToWordIndex(s);
+    thawSrcVocab();
+  }
+
   strToIdxVocabIter = stringToSrcWordIndexMap.find(s);
   if (strToIdxVocabIter != stringToSrcWordIndexMap.end())
   {
@@ -143,6 +169,21 @@ WordIndex SingleWordVocab::addSrcSymbol(std::string s)
   }
   return wordIndex;
 }
+//-------------------------
+void SingleWordVocab::encodeSrcSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                         const size_t* wordOffsets, WordIndex* wordIndices) const
+{
+  encodeSentences(frozenSrcVocab, stringToSrcWordIndexMap, buffer, sentenceOffsets, numSentences, wordOffsets,
+                  wordIndices);
+}
+
+//-------------------------
+void SingleWordVocab::encodeSrcTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                                      WordIndex* wordIndices) const
+{
+  encodeTokens(frozenSrcVocab, stringToSrcWordIndexMap, tokens, tokenLengths, numTokens, wordIndices);
+}
+
 //-------------------------
 bool SingleWordVocab::printSrcVocab(const char* outputFileName)
 {
@@ -201,7 +242,10 @@ bool SingleWordVocab::printGIZASrcVocab(const char* outputFileName)
     std::cerr << "Error while printing source vocabulary." << std::endl;
     return THOT_ERROR;
   }
-  outF << stringToSrcWordIndexMap;
+  if (frozenSrcVocab.isFrozen())
+    outF << getSrcVocab();
+  else
+    outF << stringToSrcWordIndexMap;
   outF.close();
   return THOT_OK;
 }
@@ -215,18 +259,29 @@ bool SingleWordVocab::loadTrgVocab(const char* trgInputVocabFileName, int verbos
 //-------------------------
 SingleWordVocab::StrToIdxVocab SingleWordVocab::getTrgVocab(void) const
 {
+  if (frozenTrgVocab.isFrozen())
+  {
+    StrToIdxVocab vocab;
+    frozenTrgVocab.fill(vocab);
+    return vocab;
+  }
   return stringToTrgWordIndexMap;
 }
 
 //-------------------------
 size_t SingleWordVocab::getTrgVocabSize(void) const
 {
+  if (frozenTrgVocab.isFrozen())
+    return frozenTrgVocab.size();
   return stringToTrgWordIndexMap.size();
 }
 
 //-------------------------
-WordIndex SingleWordVocab::stringToTrgWordIndex(std::string t) const
+WordIndex SingleWordVocab::stringToTrgWordIndex(const std::string& t) const
 {
+  if (frozenTrgVocab.isFrozen())
+    return frozenTrgVocab.stringToWordIndex(t);
+
   StrToIdxVocab::const_iterator trgVocabIter;
 
   trgVocabIter = stringToTrgWordIndexMap.find(t);
@@ -241,6 +296,9 @@ WordIndex SingleWordVocab::stringToTrgWordIndex(std::string t) const
 //-------------------------
 std::string SingleWordVocab::wordIndexToTrgString(WordIndex w) const
 {
+  if (frozenTrgVocab.isFrozen())
+    return frozenTrgVocab.wordIndexToString(w);
+
   IdxToStrVocab::const_iterator trgVocabIter;
 
   trgVocabIter = trgWordIndexMapToString.find(w);
@@ -255,6 +313,9 @@ std::string SingleWordVocab::wordIndexToTrgString(WordIndex w) const
 //-------------------------
 bool SingleWordVocab::existTrgSymbol(std::string t) const
 {
+  if (frozenTrgVocab.isFrozen())
+    return frozenTrgVocab.exists(t);
+
   StrToIdxVocab::const_iterator trgVocabIter;
 
   trgVocabIter = stringToTrgWordIndexMap.find(t);
@@ -267,10 +328,11 @@ bool SingleWordVocab::existTrgSymbol(std::string t) const
 }
 
 //-------------------------
-std::vector<WordIndex> SingleWordVocab::strVectorToTrgIndexVector(std::vector<std::string> t)
+std::vector<WordIndex> SingleWordVocab::strVectorToTrgIndexVector(const std::vector<std::string>& t)
 {
   unsigned int i;
   std::vector<WordIndex> wordIndex_t;
+  wordIndex_t.reserve(t.size());
   WordIndex wordIndex;
 
   for (i = 0; i < t.size(); ++i)
@@ -286,6 +348,13 @@ WordIndex SingleWordVocab::addTrgSymbol(std::string t)
   WordIndex wordIndex;
   StrToIdxVocab::const_iterator trgVocabIter;
 
+  if (frozenTrgVocab.isFrozen())
+  {
+    if (frozenTrgVocab.exists(t))
+      return frozenTrgVocab.stringToWordIndex(t);
+    thawTrgVocab();
+  }
+
   trgVocabIter = stringToTrgWordIndexMap.find(t);
   if (trgVocabIter != stringToTrgWordIndexMap.end())
   {
@@ -299,6 +368,21 @@ WordIndex SingleWordVocab::addTrgSymbol(std::string t)
   }
   return wordIndex;
 }
+//-------------------------
+void SingleWordVocab::encodeTrgSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                         const size_t* wordOffsets, WordIndex* wordIndices) const
+{
+  encodeSentences(frozenTrgVocab, stringToTrgWordIndexMap, buffer, sentenceOffsets, numSentences, wordOffsets,
+                  wordIndices);
+}
+
+//-------------------------
+void SingleWordVocab::encodeTrgTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                                      WordIndex* wordIndices) const
+{
+  encodeTokens(frozenTrgVocab, stringToTrgWordIndexMap, tokens, tokenLengths, numTokens, wordIndices);
+}
+
 //-------------------------
 bool SingleWordVocab::printTrgVocab(const char* outputFileName)
 {
@@ -357,14 +441,225 @@ bool SingleWordVocab::printGIZATrgVocab(const char* outputFileName)
     std::cerr << "Error while printing target vocabulary." << std::endl;
     return THOT_ERROR;
   }
-  outF << stringToTrgWordIndexMap;
+  if (frozenTrgVocab.isFrozen())
+    outF << getTrgVocab();
+  else
+    outF << stringToTrgWordIndexMap;
   outF.close();
   return THOT_OK;
 }
 
+//-------------------------
+bool SingleWordVocab::freeze(void)
+{
+  // Both vocabularies are built before either is replaced, so that a failure leaves
+  // the vocabulary as it was
+  FrozenVocab srcVocab = frozenSrcVocab;
+  if (!srcVocab.isFrozen() && srcVocab.build(stringToSrcWordIndexMap) == THOT_ERROR)
+    return THOT_ERROR;
+  FrozenVocab trgVocab = frozenTrgVocab;
+  if (!trgVocab.isFrozen() && trgVocab.build(stringToTrgWordIndexMap) == THOT_ERROR)
+    return THOT_ERROR;
+
+  if (!frozenSrcVocab.isFrozen())
+  {
+    frozenSrcVocab = srcVocab;
+    stringToSrcWordIndexMap.clear();
+    srcWordIndexMapToString.clear();
+  }
+  if (!frozenTrgVocab.isFrozen())
+  {
+    frozenTrgVocab = trgVocab;
+    stringToTrgWordIndexMap.clear();
+    trgWordIndexMapToString.clear();
+  }
+  return THOT_OK;
+}
+
+//-------------------------
+void SingleWordVocab::thaw(void)
+{
+  thawSrcVocab();
+  thawTrgVocab();
+}
+
+//-------------------------
+bool SingleWordVocab::isFrozen(void) const
+{
+  return frozenSrcVocab.isFrozen() && frozenTrgVocab.isFrozen();
+}
+
+//-------------------------
+bool SingleWordVocab::loadFrozenSrcVocab(const char* srcInputVocabFileName, int verbose /*=0*/)
+{
+  if (frozenSrcVocab.load(srcInputVocabFileName, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+  stringToSrcWordIndexMap.clear();
+  srcWordIndexMapToString.clear();
+  return THOT_OK;
+}
+
+//-------------------------
+bool SingleWordVocab::loadFrozenSrcVocab(const std::shared_ptr<MappedFile>& file, const char* image, size_t imageSize)
+{
+  if (frozenSrcVocab.load(file, image, imageSize) == THOT_ERROR)
+    return THOT_ERROR;
+  stringToSrcWordIndexMap.clear();
+  srcWordIndexMapToString.clear();
+  return THOT_OK;
+}
+
+//-------------------------
+bool SingleWordVocab::printFrozenSrcVocab(const char* outputFileName)
+{
+  if (!frozenSrcVocab.isFrozen())
+  {
+    FrozenVocab vocab;
+    if (vocab.build(stringToSrcWordIndexMap) == THOT_ERROR)
+      return THOT_ERROR;
+    return vocab.print(outputFileName);
+  }
+  return frozenSrcVocab.print(outputFileName);
+}
+
+//-------------------------
+bool SingleWordVocab::printFrozenSrcVocab(std::ostream& out)
+{
+  if (!frozenSrcVocab.isFrozen())
+  {
+    FrozenVocab vocab;
+    if (vocab.build(stringToSrcWordIndexMap) == THOT_ERROR)
+      return THOT_ERROR;
+    return vocab.print(out);
+  }
+  return frozenSrcVocab.print(out);
+}
+
+//-------------------------
+bool SingleWordVocab::loadFrozenTrgVocab(const char* trgInputVocabFileName, int verbose /*=0*/)
+{
+  if (frozenTrgVocab.load(trgInputVocabFileName, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+  stringToTrgWordIndexMap.clear();
+  trgWordIndexMapToString.clear();
+  return THOT_OK;
+}
+
+//-------------------------
+bool SingleWordVocab::loadFrozenTrgVocab(const std::shared_ptr<MappedFile>& file, const char* image, size_t imageSize)
+{
+  if (frozenTrgVocab.load(file, image, imageSize) == THOT_ERROR)
+    return THOT_ERROR;
+  stringToTrgWordIndexMap.clear();
+  trgWordIndexMapToString.clear();
+  return THOT_OK;
+}
+
+//-------------------------
+bool SingleWordVocab::printFrozenTrgVocab(const char* outputFileName)
+{
+  if (!frozenTrgVocab.isFrozen())
+  {
+    FrozenVocab vocab;
+    if (vocab.build(stringToTrgWordIndexMap) == THOT_ERROR)
+      return THOT_ERROR;
+    return vocab.print(outputFileName);
+  }
+  return frozenTrgVocab.print(outputFileName);
+}
+
+//-------------------------
+bool SingleWordVocab::printFrozenTrgVocab(std::ostream& out)
+{
+  if (!frozenTrgVocab.isFrozen())
+  {
+    FrozenVocab vocab;
+    if (vocab.build(stringToTrgWordIndexMap) == THOT_ERROR)
+      return THOT_ERROR;
+    return vocab.print(out);
+  }
+  return frozenTrgVocab.print(out);
+}
+
+//-------------------------
+WordIndex SingleWordVocab::lookUpWord(const FrozenVocab& frozenVocab, const StrToIdxVocab& vocab, const char* str,
+                                      size_t len, std::string& scratch)
+{
+  if (frozenVocab.isFrozen())
+    return frozenVocab.stringToWordIndex(str, len);
+
+  // The hash map can only be searched with a string key. The scratch
+  // string keeps its capacity, so it is not reallocated for every word
+  scratch.assign(str, len);
+  StrToIdxVocab::const_iterator iter = vocab.find(scratch);
+  if (iter != vocab.end())
+    return iter->second;
+  return UNK_WORD;
+}
+
+//-------------------------
+void SingleWordVocab::encodeSentences(const FrozenVocab& frozenVocab, const StrToIdxVocab& vocab, const char* buffer,
+                                      const size_t* sentenceOffsets, size_t numSentences, const size_t* wordOffsets,
+                                      WordIndex* wordIndices)
+{
+#pragma omp parallel
+  {
+    std::string scratch;
+#pragma omp for schedule(dynamic, 64)
+    for (long long s = 0; s < (long long)numSentences; ++s)
+    {
+      WordIndex* out = wordIndices + wordOffsets[s];
+      size_t pos = sentenceOffsets[s];
+      size_t wordStart;
+      while (StrProcUtils::nextWord(buffer, pos, sentenceOffsets[s + 1], wordStart))
+        *out++ = lookUpWord(frozenVocab, vocab, buffer + wordStart, pos - wordStart, scratch);
+    }
+  }
+}
+
+//-------------------------
+void SingleWordVocab::encodeTokens(const FrozenVocab& frozenVocab, const StrToIdxVocab& vocab, const char* const* tokens,
+                                   const size_t* tokenLengths, size_t numTokens, WordIndex* wordIndices)
+{
+#pragma omp parallel
+  {
+    std::string scratch;
+#pragma omp for schedule(static)
+    for (long long k = 0; k < (long long)numTokens; ++k)
+      wordIndices[k] = lookUpWord(frozenVocab, vocab, tokens[k], tokenLengths[k], scratch);
+  }
+}
+
+//-------------------------
+void SingleWordVocab::thawSrcVocab(void)
+{
+  if (!frozenSrcVocab.isFrozen())
+    return;
+
+  frozenSrcVocab.fill(stringToSrcWordIndexMap);
+  for (StrToIdxVocab::const_iterator iter = stringToSrcWordIndexMap.begin(); iter != stringToSrcWordIndexMap.end();
+       ++iter)
+    srcWordIndexMapToString[iter->second] = iter->first;
+  frozenSrcVocab.clear();
+}
+
+//-------------------------
+void SingleWordVocab::thawTrgVocab(void)
+{
+  if (!frozenTrgVocab.isFrozen())
+    return;
+
+  frozenTrgVocab.fill(stringToTrgWordIndexMap);
+  for (StrToIdxVocab::const_iterator iter = stringToTrgWordIndexMap.begin(); iter != stringToTrgWordIndexMap.end();
+       ++iter)
+    trgWordIndexMapToString[iter->second] = iter->first;
+  frozenTrgVocab.clear();
+}
+
 //-------------------------
 void SingleWordVocab::clearSrcVocab(void)
 {
+  frozenSrcVocab.clear();
   stringToSrcWordIndexMap.clear();
   srcWordIndexMapToString.clear();
 
@@ -376,6 +671,7 @@ void SingleWordVocab::clearSrcVocab(void)
 //-------------------------
 void SingleWordVocab::clearTrgVocab(void)
 {
+  frozenTrgVocab.clear();
   stringToTrgWordIndexMap.clear();
   trgWordIndexMapToString.clear();
 
@@ -26,6 +26,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 //--------------- Include files ---------------------------------------
 
+#include "nlp_common/FrozenVocab.h"
 #include "nlp_common/WordIndex.h"
 
 #include <string>
@@ -90,14 +91,24 @@ public:
   // Functions related to the source vocabulary
   StrToIdxVocab getSrcVocab(void) const;
   size_t getSrcVocabSize(void) const; // Returns the source vocabulary size
-  WordIndex stringToSrcWordIndex(std::string s) const;
+  WordIndex stringToSrcWordIndex(const std::string& s) const;
   std::string wordIndexToSrcString(WordIndex w) const;
   bool existSrcSymbol(std::string s) const;
-  std::vector<WordIndex> strVectorToSrcIndexVector(std::vector<std::string> s);
+  std::vector<WordIndex> strVectorToSrcIndexVector(const std::vector<std::string>& s);
   // converts a string vector into a source word index vector, this
   // function automatically handles the source vocabulary,
   // increasing and modifying it if necessary
   WordIndex addSrcSymbol(std::string s);
+  void encodeSrcSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                          const size_t* wordOffsets, WordIndex* wordIndices) const;
+  // Encodes a batch of blank-separated source sentences stored in a
+  // single buffer (see StrProcUtils::countSentenceWords) into the flat
+  // array wordIndices, which must have room for wordOffsets[numSentences]
+  // entries. Unknown words are mapped to UNK_WORD. The vocabulary is
+  // not modified, so sentences are encoded in parallel
+  void encodeSrcTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                       WordIndex* wordIndices) const;
+  // Same as above for tokens given as (pointer, length) pairs
   bool loadSrcVocab(const char* srcInputVocabFileName, int verbose = 0);
   bool printSrcVocab(const char* outputFileName);
   bool loadGIZASrcVocab(const char* srcInputVocabFileName, int verbose = 0);
@@ -107,20 +118,46 @@ public:
   // Functions related to the target vocabulary
   StrToIdxVocab getTrgVocab(void) const;
   size_t getTrgVocabSize(void) const; // Returns the target vocabulary size
-  WordIndex stringToTrgWordIndex(std::string t) const;
+  WordIndex stringToTrgWordIndex(const std::string& t) const;
   std::string wordIndexToTrgString(WordIndex w) const;
   bool existTrgSymbol(std::string t) const;
-  std::vector<WordIndex> strVectorToTrgIndexVector(std::vector<std::string> t);
+  std::vector<WordIndex> strVectorToTrgIndexVector(const std::vector<std::string>& t);
   // converts a string vector into a target word index vector, this
   // function automatically handles the target vocabulary,
   // increasing and modifying it if necessary
   WordIndex addTrgSymbol(std::string t);
+  void encodeTrgSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                          const size_t* wordOffsets, WordIndex* wordIndices) const;
+  // Encodes a batch of blank-separated target sentences stored in a
+  // single buffer (see StrProcUtils::countSentenceWords) into the flat
+  // array wordIndices, which must have room for wordOffsets[numSentences]
+  // entries. Unknown words are mapped to UNK_WORD. The vocabulary is
+  // not modified, so sentences are encoded in parallel
+  void encodeTrgTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                       WordIndex* wordIndices) const;
+  // Same as above for tokens given as (pointer, length) pairs
   bool loadTrgVocab(const char* trgInputVocabFileName, int verbose = 0);
   bool printTrgVocab(const char* outputFileName);
   bool loadGIZATrgVocab(const char* trgInputVocabFileName, int verbose = 0);
   bool printGIZATrgVocab(const char* trgInputVocabFileName);
   // Reads target vocabulary from a file in GIZA format
 
+  // Functions related to frozen vocabularies. A frozen vocabulary is
+  // stored in a compact read-only structure (see FrozenVocab) that
+  // speeds up lookups. Adding a new symbol to a frozen vocabulary
+  // thaws it again
+  bool freeze(void);
+  void thaw(void);
+  bool isFrozen(void) const;
+  bool loadFrozenSrcVocab(const char* srcInputVocabFileName, int verbose = 0);
+  bool loadFrozenSrcVocab(const std::shared_ptr<MappedFile>& file, const char* image, size_t imageSize);
+  bool printFrozenSrcVocab(const char* outputFileName);
+  bool printFrozenSrcVocab(std::ostream& out);
+  bool loadFrozenTrgVocab(const char* trgInputVocabFileName, int verbose = 0);
+  bool loadFrozenTrgVocab(const std::shared_ptr<MappedFile>& file, const char* image, size_t imageSize);
+  bool printFrozenTrgVocab(const char* outputFileName);
+  bool printFrozenTrgVocab(std::ostream& out);
+
   // clear() function
   void clear(void);
 
@@ -132,7 +169,18 @@ protected:
   IdxToStrVocab srcWordIndexMapToString;
   StrToIdxVocab stringToTrgWordIndexMap;
   IdxToStrVocab trgWordIndexMapToString;
-
+  FrozenVocab frozenSrcVocab;
+  FrozenVocab frozenTrgVocab;
+
+  static WordIndex lookUpWord(const FrozenVocab& frozenVocab, const StrToIdxVocab& vocab, const char* str,
+                              size_t len, std::string& scratch);
+  static void encodeSentences(const FrozenVocab& frozenVocab, const StrToIdxVocab& vocab, const char* buffer,
+                              const size_t* sentenceOffsets, size_t numSentences, const size_t* wordOffsets,
+                              WordIndex* wordIndices);
+  static void encodeTokens(const FrozenVocab& frozenVocab, const StrToIdxVocab& vocab, const char* const* tokens,
+                           const size_t* tokenLengths, size_t numTokens, WordIndex* wordIndices);
+  void thawSrcVocab(void);
+  void thawTrgVocab(void);
   void clearSrcVocab(void);
   void clearTrgVocab(void);
   void add_null_word_to_srcvoc(void);
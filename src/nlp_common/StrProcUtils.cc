@@ -208,4 +208,20 @@ std::vector<std::string> split(const std::string& s, char delim)
   }
   return elems;
 }
+
+std::size_t countSentenceWords(const char* buffer, const std::size_t* sentenceOffsets, std::size_t numSentences,
+                               std::size_t* wordOffsets)
+{
+  wordOffsets[0] = 0;
+  for (std::size_t s = 0; s < numSentences; ++s)
+  {
+    std::size_t numWords = 0;
+    std::size_t pos = sentenceOffsets[s];
+    std::size_t wordStart;
+    while (nextWord(buffer, pos, sentenceOffsets[s + 1], wordStart))
+      ++numWords;
+    wordOffsets[s + 1] = wordOffsets[s] + numWords;
+  }
+  return wordOffsets[numSentences];
+}
 } // namespace StrProcUtils
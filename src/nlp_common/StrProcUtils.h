@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -25,4 +26,27 @@ std::string addBlank(std::string str);
 std::vector<float> strVecToFloatVec(std::vector<std::string> strVec);
 // Convert string vector into a float vector
 std::vector<std::string> split(const std::string& s, char delim);
+
+inline bool isBlank(char c)
+{
+  return c == ' ' || c == '\t';
+}
+inline bool nextWord(const char* buffer, std::size_t& pos, std::size_t end, std::size_t& wordStart)
+{
+  while (pos < end && isBlank(buffer[pos]))
+    ++pos;
+  wordStart = pos;
+  while (pos < end && !isBlank(buffer[pos]))
+    ++pos;
+  return pos > wordStart;
+}
+// Finds the next word in buffer[pos, end). Words are separated by spaces and
+// tabs, as in stringToStringVector(). On success, the word is
+// buffer[wordStart, pos)
+std::size_t countSentenceWords(const char* buffer, const std::size_t* sentenceOffsets, std::size_t numSentences,
+                               std::size_t* wordOffsets);
+// Counts the words of a batch of sentences stored in buffer, where sentence
+// s is buffer[sentenceOffsets[s], sentenceOffsets[s + 1]). wordOffsets
+// (numSentences + 1 entries) receives the position of the first word of each
+// sentence in a flat word array. Returns the total number of words
 } // namespace StrProcUtils
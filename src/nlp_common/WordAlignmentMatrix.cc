@@ -1,31 +1,51 @@
 #include "nlp_common/WordAlignmentMatrix.h"
 
-#include <set>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+// Returns the position of the lowest set bit of a non-zero word
+unsigned int lowestBitIndex(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned int)__builtin_ctzll(word);
+#else
+  unsigned int index = 0;
+  while ((word & 1) == 0)
+  {
+    word >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+} // namespace
 
 WordAlignmentMatrix::WordAlignmentMatrix()
 {
   I = 0;
   J = 0;
+  wordsPerRow = 0;
 }
 
 WordAlignmentMatrix::WordAlignmentMatrix(unsigned int I_dims, unsigned int J_dims)
 {
   I = 0;
   J = 0;
+  wordsPerRow = 0;
   init(I_dims, J_dims);
 }
 
 WordAlignmentMatrix::WordAlignmentMatrix(const WordAlignmentMatrix& waMatrix)
+    : I{waMatrix.I}, J{waMatrix.J}, wordsPerRow{waMatrix.wordsPerRow}, bits{waMatrix.bits}
 {
-  unsigned int i, j;
-
-  I = 0;
-  J = 0;
-  init(waMatrix.I, waMatrix.J);
+}
 
-  for (i = 0; i < I; ++i)
-    for (j = 0; j < J; ++j)
-      matrix[i][j] = waMatrix.matrix[i][j];
+WordAlignmentMatrix::WordAlignmentMatrix(WordAlignmentMatrix&& waMatrix)
+    : I{waMatrix.I}, J{waMatrix.J}, wordsPerRow{waMatrix.wordsPerRow}, bits{std::move(waMatrix.bits)}
+{
+  waMatrix.clear();
 }
 
 unsigned int WordAlignmentMatrix::get_I() const
@@ -40,7 +60,7 @@ unsigned int WordAlignmentMatrix::get_J() const
 
 bool WordAlignmentMatrix::getValue(unsigned int i, unsigned int j) const
 {
-  return matrix[i][j];
+  return (row(i)[j / 64] >> (j % 64)) & 1;
 }
 
 void WordAlignmentMatrix::init(unsigned int I_dims, unsigned int J_dims)
@@ -50,11 +70,8 @@ void WordAlignmentMatrix::init(unsigned int I_dims, unsigned int J_dims)
     clear();
     I = I_dims;
     J = J_dims;
-
-    matrix = new bool*[I];
-    bool* pool = new bool[(size_t)I * J]{false};
-    for (unsigned int i = 0; i < I; ++i, pool += J)
-      matrix[i] = pool;
+    wordsPerRow = (J + 63) / 64;
+    bits.assign((size_t)I * wordsPerRow, 0);
   }
   else
     reset();
@@ -69,28 +86,28 @@ void WordAlignmentMatrix::putAligVec(const std::vector<PositionIndex>& aligVec)
     for (j = 0; j < aligVec.size(); ++j)
     {
       if (aligVec[j] > 0)
-        matrix[aligVec[j] - 1][j] = true;
+        set(aligVec[j] - 1, j);
     }
   }
 }
 
 bool WordAlignmentMatrix::getAligVec(std::vector<PositionIndex>& aligVec) const
 {
-  aligVec.clear();
-  for (unsigned int j = 0; j < J; ++j)
+  aligVec.assign(J, 0);
+  for (unsigned int i = 0; i < I; ++i)
   {
-    aligVec.push_back(0);
-    for (unsigned int i = 0; i < I; ++i)
+    const uint64_t* r = row(i);
+    for (unsigned int w = 0; w < wordsPerRow; ++w)
     {
-      if (matrix[i][j])
+      for (uint64_t word = r[w]; word != 0; word &= word - 1)
       {
-        if (aligVec[j] == 0)
-          aligVec[j] = i + 1;
-        else
+        unsigned int j = w * 64 + lowestBitIndex(word);
+        if (aligVec[j] != 0)
         {
           aligVec.clear();
           return false;
         }
+        aligVec[j] = i + 1;
       }
     }
   }
@@ -99,32 +116,30 @@ bool WordAlignmentMatrix::getAligVec(std::vector<PositionIndex>& aligVec) const
 
 void WordAlignmentMatrix::reset()
 {
-  unsigned int i, j;
-
-  for (i = 0; i < I; ++i)
-    for (j = 0; j < J; ++j)
-      matrix[i][j] = false;
+  std::fill(bits.begin(), bits.end(), 0);
 }
 
 void WordAlignmentMatrix::set()
 {
-  unsigned int i, j;
-
-  for (i = 0; i < I; ++i)
-    for (j = 0; j < J; ++j)
-      matrix[i][j] = true;
+  std::fill(bits.begin(), bits.end(), ~(uint64_t)0);
+  clearPadding();
 }
 
 void WordAlignmentMatrix::set(unsigned int i, unsigned int j)
 {
   if (i < I && j < J)
-    matrix[i][j] = true;
+    row(i)[j / 64] |= (uint64_t)1 << (j % 64);
 }
 
 void WordAlignmentMatrix::setValue(unsigned int i, unsigned int j, bool val)
 {
   if (i < I && j < J)
-    matrix[i][j] = val;
+  {
+    if (val)
+      row(i)[j / 64] |= (uint64_t)1 << (j % 64);
+    else
+      row(i)[j / 64] &= ~((uint64_t)1 << (j % 64));
+  }
 }
 
 void WordAlignmentMatrix::transpose()
@@ -137,125 +152,89 @@ void WordAlignmentMatrix::transpose()
   for (i = 0; i < I; ++i)
     for (j = 0; j < J; ++j)
     {
-      wam.matrix[j][i] = matrix[i][j];
+      if (getValue(i, j))
+        wam.set(j, i);
     }
-  *this = wam;
+  *this = std::move(wam);
 }
 
 WordAlignmentMatrix& WordAlignmentMatrix::operator=(const WordAlignmentMatrix& waMatrix)
 {
-  unsigned int i, j;
+  I = waMatrix.I;
+  J = waMatrix.J;
+  wordsPerRow = waMatrix.wordsPerRow;
+  bits = waMatrix.bits;
 
-  init(waMatrix.I, waMatrix.J);
-  for (i = 0; i < I; ++i)
-    for (j = 0; j < J; ++j)
-      matrix[i][j] = waMatrix.matrix[i][j];
+  return *this;
+}
 
+WordAlignmentMatrix& WordAlignmentMatrix::operator=(WordAlignmentMatrix&& waMatrix)
+{
+  if (this != &waMatrix)
+  {
+    I = waMatrix.I;
+    J = waMatrix.J;
+    wordsPerRow = waMatrix.wordsPerRow;
+    bits = std::move(waMatrix.bits);
+    waMatrix.clear();
+  }
   return *this;
 }
 
 bool WordAlignmentMatrix::operator==(const WordAlignmentMatrix& waMatrix) const
 {
-  unsigned int i, j;
-
-  if (waMatrix.I != I || waMatrix.J != J)
-    return false;
-  for (i = 0; i < I; ++i)
-    for (j = 0; j < J; ++j)
-    {
-      if (waMatrix.matrix[i][j] != matrix[i][j])
-        return false;
-    }
-
-  return true;
+  return waMatrix.I == I && waMatrix.J == J && waMatrix.bits == bits;
 }
 
 WordAlignmentMatrix& WordAlignmentMatrix::flip()
 {
-  unsigned int i, j;
-
-  for (i = 0; i < I; ++i)
-    for (j = 0; j < J; ++j)
-    {
-      if (!matrix[i][j])
-        matrix[i][j] = true;
-      else
-        matrix[i][j] = false;
-    }
+  for (uint64_t& word : bits)
+    word = ~word;
+  clearPadding();
   return *this;
 }
 
 WordAlignmentMatrix& WordAlignmentMatrix::operator&=(const WordAlignmentMatrix& waMatrix)
 {
-  unsigned int i, j;
-
   if (I == waMatrix.I && J == waMatrix.J)
   {
-    for (i = 0; i < I; ++i)
-      for (j = 0; j < J; ++j)
-      {
-        if (!(matrix[i][j] && waMatrix.matrix[i][j]))
-          matrix[i][j] = false;
-      }
+    for (size_t k = 0; k < bits.size(); ++k)
+      bits[k] &= waMatrix.bits[k];
   }
   return *this;
 }
 
 WordAlignmentMatrix& WordAlignmentMatrix::operator|=(const WordAlignmentMatrix& waMatrix)
 {
-  unsigned int i, j;
-
   if (I == waMatrix.I && J == waMatrix.J)
   {
-    for (i = 0; i < I; ++i)
-      for (j = 0; j < J; ++j)
-        if (matrix[i][j] || waMatrix.matrix[i][j])
-          matrix[i][j] = true;
+    for (size_t k = 0; k < bits.size(); ++k)
+      bits[k] |= waMatrix.bits[k];
   }
   return *this;
 }
 
 WordAlignmentMatrix& WordAlignmentMatrix::operator^=(const WordAlignmentMatrix& waMatrix)
 {
-  unsigned int i, j;
-
   if (I == waMatrix.I && J == waMatrix.J)
   {
-    for (i = 0; i < I; ++i)
-      for (j = 0; j < J; ++j)
-      {
-        if ((matrix[i][j] && !waMatrix.matrix[i][j]) || (!matrix[i][j] && waMatrix.matrix[i][j]))
-          matrix[i][j] = true;
-        else
-          matrix[i][j] = false;
-      }
+    for (size_t k = 0; k < bits.size(); ++k)
+      bits[k] ^= waMatrix.bits[k];
   }
   return *this;
 }
 
 WordAlignmentMatrix& WordAlignmentMatrix::operator+=(const WordAlignmentMatrix& waMatrix)
 {
-  unsigned int i, j;
-
-  if (I == waMatrix.I && J == waMatrix.J)
-  {
-    for (i = 0; i < I; ++i)
-      for (j = 0; j < J; ++j)
-        matrix[i][j] = matrix[i][j] || waMatrix.matrix[i][j];
-  }
-  return *this;
+  return *this |= waMatrix;
 }
 
 WordAlignmentMatrix& WordAlignmentMatrix::operator-=(const WordAlignmentMatrix& waMatrix)
 {
-  unsigned int i, j;
-
   if (I == waMatrix.I && J == waMatrix.J)
   {
-    for (i = 0; i < I; ++i)
-      for (j = 0; j < J; ++j)
-        if (matrix[i][j] && !waMatrix.matrix[i][j])
-          matrix[i][j] = true;
+    for (size_t k = 0; k < bits.size(); ++k)
+      bits[k] &= ~waMatrix.bits[k];
   }
   return *this;
 }
@@ -268,9 +247,7 @@ WordAlignmentMatrix& WordAlignmentMatrix::symmetr1(const WordAlignmentMatrix& wa
   WordAlignmentMatrix orig = *this;
   *this &= waMatrix;
 
-  auto isBlockNeighborAligned = [&](unsigned int i, unsigned int j) {
-    return isHorizontalNeighborAligned(i, j) || isVerticalNeighborAligned(i, j);
-  };
+  auto isBlockNeighborAligned = [](bool horizontal, bool vertical, bool) { return horizontal || vertical; };
   ochGrow(isBlockNeighborAligned, orig, waMatrix);
 
   return *this;
@@ -278,12 +255,10 @@ WordAlignmentMatrix& WordAlignmentMatrix::symmetr1(const WordAlignmentMatrix& wa
 
 WordAlignmentMatrix& WordAlignmentMatrix::symmetr2(const WordAlignmentMatrix& waMatrix)
 {
-  if (I != waMatrix.I && J != waMatrix.J)
+  if (I != waMatrix.I || J != waMatrix.J)
     return *this;
 
-  auto isPriorityBlockNeighborAligned = [&](unsigned int i, unsigned int j) {
-    return isHorizontalNeighborAligned(i, j) ^ isVerticalNeighborAligned(i, j);
-  };
+  auto isPriorityBlockNeighborAligned = [](bool horizontal, bool vertical, bool) { return horizontal != vertical; };
   ochGrow(isPriorityBlockNeighborAligned, *this, waMatrix);
 
   return *this;
@@ -297,9 +272,7 @@ WordAlignmentMatrix& WordAlignmentMatrix::grow(const WordAlignmentMatrix& waMatr
   WordAlignmentMatrix orig = *this;
   *this &= waMatrix;
 
-  auto isBlockNeighborAligned = [&](unsigned int i, unsigned int j) {
-    return isHorizontalNeighborAligned(i, j) || isVerticalNeighborAligned(i, j);
-  };
+  auto isBlockNeighborAligned = [](bool horizontal, bool vertical, bool) { return horizontal || vertical; };
   koehnGrow(isBlockNeighborAligned, orig, waMatrix);
 
   return *this;
@@ -313,8 +286,8 @@ WordAlignmentMatrix& WordAlignmentMatrix::growDiag(const WordAlignmentMatrix& wa
   WordAlignmentMatrix orig = *this;
   *this &= waMatrix;
 
-  auto isBlockOrDiagNeighborAligned = [&](unsigned int i, unsigned int j) {
-    return isHorizontalNeighborAligned(i, j) || isVerticalNeighborAligned(i, j) || isDiagonalNeighborAligned(i, j);
+  auto isBlockOrDiagNeighborAligned = [](bool horizontal, bool vertical, bool diagonal) {
+    return horizontal || vertical || diagonal;
   };
   koehnGrow(isBlockOrDiagNeighborAligned, orig, waMatrix);
 
@@ -329,12 +302,12 @@ WordAlignmentMatrix& WordAlignmentMatrix::growDiagFinal(const WordAlignmentMatri
   WordAlignmentMatrix orig = *this;
   *this &= waMatrix;
 
-  auto isBlockOrDiagNeighborAligned = [&](unsigned int i, unsigned int j) {
-    return isHorizontalNeighborAligned(i, j) || isVerticalNeighborAligned(i, j) || isDiagonalNeighborAligned(i, j);
+  auto isBlockOrDiagNeighborAligned = [](bool horizontal, bool vertical, bool diagonal) {
+    return horizontal || vertical || diagonal;
   };
   koehnGrow(isBlockOrDiagNeighborAligned, orig, waMatrix);
 
-  auto isOneOrBothUnaligned = [&](unsigned int i, unsigned int j) { return !isRowAligned(i) || !isColumnAligned(j); };
+  auto isOneOrBothUnaligned = [](bool rowAligned, bool columnAligned) { return !rowAligned || !columnAligned; };
   final(isOneOrBothUnaligned, orig);
   final(isOneOrBothUnaligned, waMatrix);
 
@@ -349,12 +322,12 @@ WordAlignmentMatrix& WordAlignmentMatrix::growDiagFinalAnd(const WordAlignmentMa
   WordAlignmentMatrix orig = *this;
   *this &= waMatrix;
 
-  auto isBlockOrDiagNeighborAligned = [&](unsigned int i, unsigned int j) {
-    return isHorizontalNeighborAligned(i, j) || isVerticalNeighborAligned(i, j) || isDiagonalNeighborAligned(i, j);
+  auto isBlockOrDiagNeighborAligned = [](bool horizontal, bool vertical, bool diagonal) {
+    return horizontal || vertical || diagonal;
   };
   koehnGrow(isBlockOrDiagNeighborAligned, orig, waMatrix);
 
-  auto isBothUnaligned = [&](unsigned int i, unsigned int j) { return !isRowAligned(i) && !isColumnAligned(j); };
+  auto isBothUnaligned = [](bool rowAligned, bool columnAligned) { return !rowAligned && !columnAligned; };
   final(isBothUnaligned, orig);
   final(isBothUnaligned, waMatrix);
 
@@ -363,50 +336,23 @@ WordAlignmentMatrix& WordAlignmentMatrix::growDiagFinalAnd(const WordAlignmentMa
 
 bool WordAlignmentMatrix::isDiagonalNeighborAligned(unsigned int i, unsigned int j) const
 {
-  if (i < I - 1 && j < J - 1)
-    if (matrix[i + 1][j + 1])
-      return true;
-  if (i > 0 && j < J - 1)
-    if (matrix[i - 1][j + 1])
-      return true;
-  if (i < I - 1 && j > 0)
-    if (matrix[i + 1][j - 1])
-      return true;
-  if (i > 0 && j > 0)
-    if (matrix[i - 1][j - 1])
-      return true;
-
-  return false;
+  return (diagonalNeighborMask(i, j / 64) >> (j % 64)) & 1;
 }
 
 bool WordAlignmentMatrix::isHorizontalNeighborAligned(unsigned int i, unsigned int j) const
 {
-  if (j > 0)
-    if (matrix[i][j - 1])
-      return true;
-  if (j < J - 1)
-    if (matrix[i][j + 1])
-      return true;
-
-  return false;
+  return (horizontalNeighborMask(i, j / 64) >> (j % 64)) & 1;
 }
 
 bool WordAlignmentMatrix::isVerticalNeighborAligned(unsigned int i, unsigned int j) const
 {
-  if (i > 0)
-    if (matrix[i - 1][j])
-      return true;
-  if (i < I - 1)
-    if (matrix[i + 1][j])
-      return true;
-
-  return false;
+  return (verticalNeighborMask(i, j / 64) >> (j % 64)) & 1;
 }
 
 bool WordAlignmentMatrix::isColumnAligned(unsigned int j) const
 {
   for (unsigned int i = 0; i < I; ++i)
-    if (matrix[i][j])
+    if (getValue(i, j))
       return true;
 
   return false;
@@ -414,23 +360,21 @@ bool WordAlignmentMatrix::isColumnAligned(unsigned int j) const
 
 bool WordAlignmentMatrix::isRowAligned(unsigned int i) const
 {
-  for (unsigned int j = 0; j < J; ++j)
-    if (matrix[i][j])
-      return 1;
+  const uint64_t* r = row(i);
+  for (unsigned int w = 0; w < wordsPerRow; ++w)
+    if (r[w] != 0)
+      return true;
 
-  return 0;
+  return false;
 }
 
 void WordAlignmentMatrix::clear(void)
 {
-  if (I > 0)
-  {
-    delete[] matrix[0];
-    delete[] matrix;
-    matrix = nullptr;
-  }
+  bits.clear();
+  bits.shrink_to_fit();
   I = 0;
   J = 0;
+  wordsPerRow = 0;
 }
 
 std::ostream& operator<<(std::ostream& outS, const WordAlignmentMatrix& waMatrix)
@@ -441,7 +385,7 @@ std::ostream& operator<<(std::ostream& outS, const WordAlignmentMatrix& waMatrix
   for (i = (int)waMatrix.I - 1; i >= 0; --i)
   {
     for (j = 0; j < waMatrix.J; ++j)
-      outS << (unsigned int)waMatrix.matrix[i][j] << " ";
+      outS << (unsigned int)waMatrix.getValue(i, j) << " ";
     outS << std::endl;
   }
   return outS;
@@ -455,7 +399,7 @@ void WordAlignmentMatrix::print(FILE* f) const
   for (i = (int)this->I - 1; i >= 0; --i)
   {
     for (j = 0; j < this->J; ++j)
-      fprintf(f, "%d ", this->matrix[i][j]);
+      fprintf(f, "%d ", this->getValue(i, j));
     fprintf(f, "\n");
   }
 }
@@ -476,9 +420,10 @@ void WordAlignmentMatrix::wordAligAsVectors(std::vector<std::pair<unsigned int,
     intPair.second = 0;
     for (j = 0; j < J; ++j)
     {
-      if (matrix[i][j] && intPair.first == 0)
+      bool value = getValue(i, j);
+      if (value && intPair.first == 0)
         intPair.first = j + 1;
-      if (!matrix[i][j] && intPair.first != 0 && intPair.second == 0)
+      if (!value && intPair.first != 0 && intPair.second == 0)
         intPair.second = j;
     }
     if (intPair.second == 0)
@@ -494,9 +439,32 @@ void WordAlignmentMatrix::wordAligAsVectors(std::vector<std::pair<unsigned int,
   targetCuts.push_back(i);
 }
 
-bool** WordAlignmentMatrix::ptr()
+void WordAlignmentMatrix::getAlignedCells(std::vector<std::pair<unsigned int, unsigned int>>& cells) const
 {
-  return matrix;
+  for (unsigned int i = 0; i < I; ++i)
+  {
+    const uint64_t* words = row(i);
+    for (unsigned int w = 0; w < wordsPerRow; ++w)
+    {
+      for (uint64_t word = words[w]; word != 0; word &= word - 1)
+        cells.push_back(std::make_pair(i, w * 64 + lowestBitIndex(word)));
+    }
+  }
+}
+
+unsigned int WordAlignmentMatrix::getWordsPerRow() const
+{
+  return wordsPerRow;
+}
+
+const uint64_t* WordAlignmentMatrix::packedData() const
+{
+  return bits.empty() ? nullptr : bits.data();
+}
+
+uint64_t* WordAlignmentMatrix::packedData()
+{
+  return bits.empty() ? nullptr : bits.data();
 }
 
 WordAlignmentMatrix::~WordAlignmentMatrix()
@@ -504,78 +472,142 @@ WordAlignmentMatrix::~WordAlignmentMatrix()
   clear();
 }
 
-void WordAlignmentMatrix::ochGrow(std::function<bool(unsigned int, unsigned int)> growCondition,
-                                  const WordAlignmentMatrix& orig, const WordAlignmentMatrix& other)
+const uint64_t* WordAlignmentMatrix::row(unsigned int i) const
 {
-  bool added;
-  do
-  {
-    added = false;
-    for (unsigned int i = 0; i < I; ++i)
-    {
-      for (unsigned int j = 0; j < J; ++j)
-      {
-        if ((other.getValue(i, j) || orig.getValue(i, j)) && !getValue(i, j))
-        {
-          if (!isRowAligned(i) && !isColumnAligned(j))
-          {
-            set(i, j);
-            added = true;
-          }
-          else if (growCondition(i, j))
-          {
-            set(i, j);
-            added = true;
-          }
-        }
-      }
-    }
+  return bits.data() + (size_t)i * wordsPerRow;
+}
 
-  } while (added);
+uint64_t* WordAlignmentMatrix::row(unsigned int i)
+{
+  return bits.data() + (size_t)i * wordsPerRow;
+}
+
+uint64_t WordAlignmentMatrix::lastWordMask() const
+{
+  return J % 64 == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (J % 64)) - 1;
+}
+
+void WordAlignmentMatrix::clearPadding()
+{
+  if (wordsPerRow == 0)
+    return;
+  for (unsigned int i = 0; i < I; ++i)
+    row(i)[wordsPerRow - 1] &= lastWordMask();
+}
+
+uint64_t WordAlignmentMatrix::horizontalNeighborMask(unsigned int i, unsigned int w) const
+{
+  const uint64_t* r = row(i);
+  uint64_t mask = (r[w] << 1) | (r[w] >> 1);
+  if (w > 0)
+    mask |= r[w - 1] >> 63;
+  if (w + 1 < wordsPerRow)
+    mask |= r[w + 1] << 63;
+  else
+    mask &= lastWordMask();
+  return mask;
 }
 
-void WordAlignmentMatrix::koehnGrow(std::function<bool(unsigned int, unsigned int)> growCondition,
-                                    const WordAlignmentMatrix& orig, const WordAlignmentMatrix& other)
+uint64_t WordAlignmentMatrix::verticalNeighborMask(unsigned int i, unsigned int w) const
 {
-  std::set<std::pair<unsigned int, unsigned int>> p;
+  uint64_t mask = 0;
+  if (i > 0)
+    mask |= row(i - 1)[w];
+  if (i + 1 < I)
+    mask |= row(i + 1)[w];
+  return mask;
+}
+
+uint64_t WordAlignmentMatrix::diagonalNeighborMask(unsigned int i, unsigned int w) const
+{
+  uint64_t mask = 0;
+  if (i > 0)
+    mask |= horizontalNeighborMask(i - 1, w);
+  if (i + 1 < I)
+    mask |= horizontalNeighborMask(i + 1, w);
+  return mask;
+}
+
+// Visits the cells of adds1 | adds2 that are not aligned yet in row-major
+// order and sets those that satisfy the condition. Cells set during the scan
+// are taken into account for the cells visited after them, so the result is
+// the same as that of a cell-by-cell scan, but candidates and neighbors are
+// computed 64 columns at a time
+template <typename Condition>
+bool WordAlignmentMatrix::addCells(const WordAlignmentMatrix& adds1, const WordAlignmentMatrix* adds2,
+                                   Condition condition)
+{
+  std::vector<uint64_t> alignedColumns(wordsPerRow, 0);
   for (unsigned int i = 0; i < I; ++i)
   {
-    for (unsigned int j = 0; j < J; ++j)
-    {
-      if ((orig.getValue(i, j) || other.getValue(i, j)) && !getValue(i, j))
-        p.insert(std::make_pair(i, j));
-    }
+    const uint64_t* r = row(i);
+    for (unsigned int w = 0; w < wordsPerRow; ++w)
+      alignedColumns[w] |= r[w];
   }
 
-  bool keepGoing = !p.empty();
-  while (keepGoing)
+  bool added = false;
+  for (unsigned int i = 0; i < I; ++i)
   {
-    keepGoing = false;
-    std::set<std::pair<unsigned int, unsigned int>> added;
-    for (auto pair : p)
+    uint64_t* r = row(i);
+    bool rowAligned = isRowAligned(i);
+    for (unsigned int w = 0; w < wordsPerRow; ++w)
     {
-      unsigned int i = pair.first;
-      unsigned int j = pair.second;
-      if ((!isRowAligned(i) || !isColumnAligned(j)) && growCondition(i, j))
+      uint64_t candidates = adds1.row(i)[w];
+      if (adds2 != nullptr)
+        candidates |= adds2->row(i)[w];
+      candidates &= ~r[w];
+      if (candidates == 0)
+        continue;
+
+      uint64_t horizontal = horizontalNeighborMask(i, w);
+      uint64_t vertical = verticalNeighborMask(i, w);
+      uint64_t diagonal = diagonalNeighborMask(i, w);
+      while (candidates != 0)
       {
-        set(i, j);
-        added.insert(std::make_pair(i, j));
-        keepGoing = true;
+        uint64_t bit = candidates & (~candidates + 1);
+        candidates ^= bit;
+        if (condition(rowAligned, (alignedColumns[w] & bit) != 0, (horizontal & bit) != 0, (vertical & bit) != 0,
+                      (diagonal & bit) != 0))
+        {
+          r[w] |= bit;
+          alignedColumns[w] |= bit;
+          rowAligned = true;
+          horizontal = horizontalNeighborMask(i, w);
+          added = true;
+        }
       }
     }
-    for (auto pair : added)
-      p.erase(pair);
   }
+  return added;
 }
 
-void WordAlignmentMatrix::final(std::function<bool(unsigned int, unsigned int)> pred, const WordAlignmentMatrix& adds)
+template <typename Condition>
+void WordAlignmentMatrix::ochGrow(Condition growCondition, const WordAlignmentMatrix& orig,
+                                  const WordAlignmentMatrix& other)
 {
-  for (unsigned int i = 0; i < I; ++i)
-  {
-    for (unsigned int j = 0; j < J; ++j)
-    {
-      if (adds.getValue(i, j) && !getValue(i, j) && pred(i, j))
-        set(i, j);
-    }
-  }
+  auto condition = [&](bool rowAligned, bool columnAligned, bool horizontal, bool vertical, bool diagonal) {
+    return (!rowAligned && !columnAligned) || growCondition(horizontal, vertical, diagonal);
+  };
+  while (addCells(orig, &other, condition))
+    ;
+}
+
+template <typename Condition>
+void WordAlignmentMatrix::koehnGrow(Condition growCondition, const WordAlignmentMatrix& orig,
+                                    const WordAlignmentMatrix& other)
+{
+  auto condition = [&](bool rowAligned, bool columnAligned, bool horizontal, bool vertical, bool diagonal) {
+    return (!rowAligned || !columnAligned) && growCondition(horizontal, vertical, diagonal);
+  };
+  while (addCells(orig, &other, condition))
+    ;
+}
+
+template <typename Condition>
+void WordAlignmentMatrix::final(Condition pred, const WordAlignmentMatrix& adds)
+{
+  auto condition = [&](bool rowAligned, bool columnAligned, bool, bool, bool) {
+    return pred(rowAligned, columnAligned);
+  };
+  addCells(adds, nullptr, condition);
 }
@@ -3,8 +3,8 @@
 
 #include "nlp_common/PositionIndex.h"
 
+#include <cstdint>
 #include <fstream>
-#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -14,6 +14,11 @@
 #include <string>
 #include <vector>
 
+// Alignment matrix between I source words and J target words. The matrix is
+// stored bit-packed in a contiguous buffer: each row takes getWordsPerRow()
+// 64-bit words, and column j of a row is bit j % 64 of its word j / 64. The
+// padding bits past column J - 1 are always zero, so bitwise operations and
+// neighbor masks are computed a whole word at a time
 class WordAlignmentMatrix
 {
 public:
@@ -21,6 +26,7 @@ public:
   WordAlignmentMatrix();
   WordAlignmentMatrix(unsigned int I_dims, unsigned int J_dims);
   WordAlignmentMatrix(const WordAlignmentMatrix& waMatrix);
+  WordAlignmentMatrix(WordAlignmentMatrix&& waMatrix);
 
   // Basic operations
   unsigned int get_I() const;
@@ -40,6 +46,7 @@ public:
   void setValue(unsigned int i, unsigned int j, bool val);
   void transpose();
   WordAlignmentMatrix& operator=(const WordAlignmentMatrix& waMatrix);
+  WordAlignmentMatrix& operator=(WordAlignmentMatrix&& waMatrix);
   bool operator==(const WordAlignmentMatrix& waMatrix) const;
   WordAlignmentMatrix& flip(); // flips every bit of the matrix
 
@@ -79,23 +86,40 @@ public:
   void print(FILE* f) const;
   void wordAligAsVectors(std::vector<std::pair<unsigned int, unsigned int>>& sourceSegm,
                          std::vector<unsigned int>& targetCuts) const;
+  // Appends the (i, j) positions of the aligned cells in row-major order
+  void getAlignedCells(std::vector<std::pair<unsigned int, unsigned int>>& cells) const;
 
-  bool** ptr();
+  // Access to the bit-packed representation
+  unsigned int getWordsPerRow() const;
+  const uint64_t* packedData() const;
+  uint64_t* packedData();
 
   // Destructor
   ~WordAlignmentMatrix();
 
 private:
-  void ochGrow(std::function<bool(unsigned int, unsigned int)> growCondition, const WordAlignmentMatrix& orig,
-               const WordAlignmentMatrix& other);
-  void koehnGrow(std::function<bool(unsigned int, unsigned int)> growCondition, const WordAlignmentMatrix& orig,
-                 const WordAlignmentMatrix& other);
-  void final(std::function<bool(unsigned int, unsigned int)> pred, const WordAlignmentMatrix& adds);
+  const uint64_t* row(unsigned int i) const;
+  uint64_t* row(unsigned int i);
+  uint64_t lastWordMask() const;
+  void clearPadding();
+  uint64_t horizontalNeighborMask(unsigned int i, unsigned int w) const;
+  uint64_t verticalNeighborMask(unsigned int i, unsigned int w) const;
+  uint64_t diagonalNeighborMask(unsigned int i, unsigned int w) const;
+
+  template <typename Condition>
+  bool addCells(const WordAlignmentMatrix& adds1, const WordAlignmentMatrix* adds2, Condition condition);
+  template <typename Condition>
+  void ochGrow(Condition growCondition, const WordAlignmentMatrix& orig, const WordAlignmentMatrix& other);
+  template <typename Condition>
+  void koehnGrow(Condition growCondition, const WordAlignmentMatrix& orig, const WordAlignmentMatrix& other);
+  template <typename Condition>
+  void final(Condition pred, const WordAlignmentMatrix& adds);
 
   // Data members
   unsigned int I;
   unsigned int J;
-  bool** matrix = nullptr;
+  unsigned int wordsPerRow;
+  std::vector<uint64_t> bits;
 };
 
 std::ostream& operator<<(std::ostream& outS, const WordAlignmentMatrix& waMatrix);
@@ -3,6 +3,7 @@
 #include "nlp_common/ErrorDefs.h"
 #include "nlp_common/StrProcUtils.h"
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 
@@ -162,6 +163,81 @@ bool WordClasses::print(const char* prefFileName, int verbose) const
   return THOT_OK;
 }
 
+bool WordClasses::load(std::istream& in)
+{
+  if (loadWordClassNames(in, srcWordClassNames) == THOT_ERROR || loadWordClasses(in, srcWordClasses) == THOT_ERROR
+      || loadWordClassNames(in, trgWordClassNames) == THOT_ERROR || loadWordClasses(in, trgWordClasses) == THOT_ERROR)
+  {
+    clear();
+    return THOT_ERROR;
+  }
+  return THOT_OK;
+}
+
+bool WordClasses::print(std::ostream& out) const
+{
+  printWordClassNames(out, srcWordClassNames);
+  printWordClasses(out, srcWordClasses);
+  printWordClassNames(out, trgWordClassNames);
+  printWordClasses(out, trgWordClasses);
+  return out ? THOT_OK : THOT_ERROR;
+}
+
+bool WordClasses::loadWordClasses(std::istream& in, std::vector<WordClassIndex>& wordClasses)
+{
+  uint64_t size;
+  if (!in.read((char*)&size, sizeof(uint64_t)))
+    return THOT_ERROR;
+  wordClasses.resize(size);
+  if (size > 0 && !in.read((char*)wordClasses.data(), size * sizeof(WordClassIndex)))
+    return THOT_ERROR;
+  return THOT_OK;
+}
+
+bool WordClasses::loadWordClassNames(std::istream& in,
+                                     std::unordered_map<std::string, WordClassIndex>& wordClassNames)
+{
+  uint64_t size;
+  if (!in.read((char*)&size, sizeof(uint64_t)))
+    return THOT_ERROR;
+  wordClassNames.clear();
+  std::string name;
+  for (uint64_t k = 0; k < size; ++k)
+  {
+    uint32_t length;
+    WordClassIndex wordClassIndex;
+    if (!in.read((char*)&length, sizeof(uint32_t)))
+      return THOT_ERROR;
+    name.resize(length);
+    if ((length > 0 && !in.read(&name[0], length)) || !in.read((char*)&wordClassIndex, sizeof(WordClassIndex)))
+      return THOT_ERROR;
+    wordClassNames[name] = wordClassIndex;
+  }
+  return THOT_OK;
+}
+
+void WordClasses::printWordClasses(std::ostream& out, const std::vector<WordClassIndex>& wordClasses)
+{
+  uint64_t size = wordClasses.size();
+  out.write((char*)&size, sizeof(uint64_t));
+  if (size > 0)
+    out.write((const char*)wordClasses.data(), size * sizeof(WordClassIndex));
+}
+
+void WordClasses::printWordClassNames(std::ostream& out,
+                                      const std::unordered_map<std::string, WordClassIndex>& wordClassNames)
+{
+  uint64_t size = wordClassNames.size();
+  out.write((char*)&size, sizeof(uint64_t));
+  for (auto& wordClassName : wordClassNames)
+  {
+    uint32_t length = (uint32_t)wordClassName.first.size();
+    out.write((char*)&length, sizeof(uint32_t));
+    out.write(wordClassName.first.data(), length);
+    out.write((const char*)&wordClassName.second, sizeof(WordClassIndex));
+  }
+}
+
 bool WordClasses::loadSrcWordClasses(const char* srcWordClassesFile, int verbose)
 {
   return loadWordClasses(srcWordClassesFile, srcWordClasses, verbose);
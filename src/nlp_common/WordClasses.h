@@ -3,6 +3,7 @@
 #include "nlp_common/SingleWordVocab.h"
 #include "nlp_common/WordIndex.h"
 
+#include <iostream>
 #include <unordered_map>
 #include <vector>
 
@@ -32,6 +33,9 @@ public:
 
   bool load(const char* prefFileName, int verbose = 0);
   bool print(const char* prefFileName, int verbose = 0) const;
+  // Single binary stream holding the four files
+  bool load(std::istream& in);
+  bool print(std::ostream& out) const;
 
   void clear();
 
@@ -53,6 +57,12 @@ private:
   bool printWordClassNames(const char* wordClassNamesFile,
                            const std::unordered_map<std::string, WordClassIndex>& wordClassNames, int verbose) const;
 
+  static bool loadWordClasses(std::istream& in, std::vector<WordClassIndex>& wordClasses);
+  static bool loadWordClassNames(std::istream& in, std::unordered_map<std::string, WordClassIndex>& wordClassNames);
+  static void printWordClasses(std::ostream& out, const std::vector<WordClassIndex>& wordClasses);
+  static void printWordClassNames(std::ostream& out,
+                                  const std::unordered_map<std::string, WordClassIndex>& wordClassNames);
+
   std::unordered_map<std::string, WordClassIndex> srcWordClassNames;
   std::unordered_map<std::string, WordClassIndex> trgWordClassNames;
 
@@ -135,6 +135,16 @@ bool BasePhraseModel::strGetNbestTransFor_t_(const std::vector<std::string>& t,
   return getNbestTransFor_t_(wIndex_t, nbt, N);
 }
 
+//-------------------------
+bool BasePhraseModel::getNbestTransViewFor_t_(const std::vector<WordIndex>& t, PhraseNbestListView& view,
+                                              int N /*=-1*/)
+{
+  NbestTableNode<PhraseTransTableNodeData> nbt;
+  bool found = getNbestTransFor_t_(t, nbt);
+  view = PhraseNbestListView(PhraseNbestListView::makeList(nbt), N);
+  return found;
+}
+
 //-------------------------
 int BasePhraseModel::trainSentPair(const std::vector<std::string>& /*srcSentStrVec*/,
                                    const std::vector<std::string>& /*trgSentStrVec*/, Count /*c*/, int /*verbose*/)
@@ -99,6 +99,11 @@ public:
                                       int N = -1);
   virtual bool getNbestTransFor_t_(const std::vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt,
                                    int N = -1) = 0;
+  virtual bool getNbestTransViewFor_t_(const std::vector<WordIndex>& t, PhraseNbestListView& view, int N = -1);
+  // View of the first N entries of the n-best list of t, it does
+  // not copy the list when the phrase table keeps it sorted. The
+  // n-best list of the phrase is kept by the phrase table between
+  // sentences
 
   // Functions for extending the model
   virtual int trainSentPair(const std::vector<std::string>& srcSentStrVec,
@@ -29,8 +29,10 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 #include "nlp_common/LogCount.h"
 #include "nlp_common/NbestTableNode.h"
 #include "phrase_models/PhraseDefs.h"
+#include "phrase_models/PhraseNbestList.h"
 #include "phrase_models/PhrasePairInfo.h"
 #include "phrase_models/PhraseTransTableNodeData.h"
+#include "phrase_models/PhraseVocabulary.h"
 
 //--------------- Constants ------------------------------------------
 
@@ -79,6 +81,23 @@ public:
   virtual bool getNbestForSrc(const std::vector<WordIndex>& s, NbestTableNode<PhraseTransTableNodeData>& nbt) = 0;
   virtual bool getNbestForTrg(const std::vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt,
                               int N = -1) = 0;
+  virtual bool getNbestViewForSrc(const std::vector<WordIndex>& s, PhraseNbestListView& view, int N = -1)
+  {
+    NbestTableNode<PhraseTransTableNodeData> nbt;
+    bool found = getNbestForSrc(s, nbt);
+    view = PhraseNbestListView(PhraseNbestListView::makeList(nbt), N);
+    return found;
+  }
+  virtual bool getNbestViewForTrg(const std::vector<WordIndex>& t, PhraseNbestListView& view, int N = -1)
+  {
+    NbestTableNode<PhraseTransTableNodeData> nbt;
+    bool found = getNbestForTrg(t, nbt);
+    view = PhraseNbestListView(PhraseNbestListView::makeList(nbt), N);
+    return found;
+  }
+  // Views of the first N entries of the n-best lists, tables that keep
+  // their lists sorted can redefine them to avoid copying the lists.
+  // Return true if the phrase has any entries, whatever the value of N
 
   // Counts-related functions
   virtual Count cSrcTrg(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) = 0;
@@ -98,6 +117,99 @@ public:
     return log((float)cTrg(t));
   };
 
+  // Phrase id functions, a phrase gets an id the first time it is requested. Ids are
+  // reset by clear(). The functions are not thread-safe, tables shared between
+  // threads need the callers to serialize them
+  PhraseId getSrcPhraseId(const std::vector<WordIndex>& s)
+  {
+    return srcPhraseVocab.add(s);
+  }
+  PhraseId getTrgPhraseId(const std::vector<WordIndex>& t)
+  {
+    return trgPhraseVocab.add(t);
+  }
+  bool existSrcPhraseId(PhraseId sId) const
+  {
+    return sId < srcPhraseVocab.size();
+  }
+  bool existTrgPhraseId(PhraseId tId) const
+  {
+    return tId < trgPhraseVocab.size();
+  }
+  // Ids that were not given by the table yield an empty phrase
+  const std::vector<WordIndex>& getSrcPhrase(PhraseId sId) const
+  {
+    return existSrcPhraseId(sId) ? srcPhraseVocab.getPhrase(sId) : noPhrase;
+  }
+  const std::vector<WordIndex>& getTrgPhrase(PhraseId tId) const
+  {
+    return existTrgPhraseId(tId) ? trgPhraseVocab.getPhrase(tId) : noPhrase;
+  }
+
+  // Id-based versions of the functions above, tables that store phrase ids can
+  // redefine them to avoid looking up the phrases. Unknown ids are treated as
+  // phrases that are not in the table
+  virtual Count cSrcTrgById(PhraseId sId, PhraseId tId)
+  {
+    if (!existSrcPhraseId(sId) || !existTrgPhraseId(tId))
+      return Count(0);
+    return cSrcTrg(getSrcPhrase(sId), getTrgPhrase(tId));
+  }
+  virtual Count cSrcById(PhraseId sId)
+  {
+    if (!existSrcPhraseId(sId))
+      return Count(0);
+    return cSrc(getSrcPhrase(sId));
+  }
+  virtual Count cTrgById(PhraseId tId)
+  {
+    if (!existTrgPhraseId(tId))
+      return Count(0);
+    return cTrg(getTrgPhrase(tId));
+  }
+  virtual Prob pTrgGivenSrcById(PhraseId sId, PhraseId tId)
+  {
+    if (!existSrcPhraseId(sId) || !existTrgPhraseId(tId))
+      return PHRASE_PROB_SMOOTH;
+    return pTrgGivenSrc(getSrcPhrase(sId), getTrgPhrase(tId));
+  }
+  virtual LgProb logpTrgGivenSrcById(PhraseId sId, PhraseId tId)
+  {
+    if (!existSrcPhraseId(sId) || !existTrgPhraseId(tId))
+      return LOG_PHRASE_PROB_SMOOTH;
+    return logpTrgGivenSrc(getSrcPhrase(sId), getTrgPhrase(tId));
+  }
+  virtual Prob pSrcGivenTrgById(PhraseId sId, PhraseId tId)
+  {
+    if (!existSrcPhraseId(sId) || !existTrgPhraseId(tId))
+      return PHRASE_PROB_SMOOTH;
+    return pSrcGivenTrg(getSrcPhrase(sId), getTrgPhrase(tId));
+  }
+  virtual LgProb logpSrcGivenTrgById(PhraseId sId, PhraseId tId)
+  {
+    if (!existSrcPhraseId(sId) || !existTrgPhraseId(tId))
+      return LOG_PHRASE_PROB_SMOOTH;
+    return logpSrcGivenTrg(getSrcPhrase(sId), getTrgPhrase(tId));
+  }
+  virtual bool getNbestForSrcById(PhraseId sId, NbestTableNode<PhraseTransTableNodeData>& nbt)
+  {
+    if (!existSrcPhraseId(sId))
+    {
+      nbt.clear();
+      return false;
+    }
+    return getNbestForSrc(getSrcPhrase(sId), nbt);
+  }
+  virtual bool getNbestForTrgById(PhraseId tId, NbestTableNode<PhraseTransTableNodeData>& nbt, int N = -1)
+  {
+    if (!existTrgPhraseId(tId))
+    {
+      nbt.clear();
+      return false;
+    }
+    return getNbestForTrg(getTrgPhrase(tId), nbt, N);
+  }
+
   // size and clear functions
   virtual size_t size(void) = 0;
   virtual void clear(void) = 0;
@@ -106,5 +218,15 @@ public:
   virtual ~BasePhraseTable(){};
 
 protected:
+  // To be called by the clear() function of the tables
+  void clearPhraseIds()
+  {
+    srcPhraseVocab.clear();
+    trgPhraseVocab.clear();
+  }
+
+  PhraseVocabulary srcPhraseVocab;
+  PhraseVocabulary trgPhraseVocab;
+  const std::vector<WordIndex> noPhrase;
 };
 
@@ -0,0 +1,650 @@
+#include "phrase_models/ExternalPhraseTableBuilder.h"
+
+#include "nlp_common/ErrorDefs.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+const size_t DEFAULT_MEMORY_LIMIT = (size_t)1 << 30;
+// Bookkeeping of the hash table for every buffered pair
+const size_t BUFFER_ENTRY_OVERHEAD = 64;
+// Maximum number of runs read at the same time
+const size_t MAX_MERGED_RUNS = 128;
+
+void writeVarint(ostream& out, size_t value)
+{
+  while (value >= 0x80)
+  {
+    out.put((char)((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.put((char)value);
+}
+
+bool readVarint(istream& in, size_t& value)
+{
+  value = 0;
+  for (unsigned int shift = 0; shift < 64; shift += 7)
+  {
+    int c = in.get();
+    if (c == EOF)
+      return false;
+    value |= (size_t)(c & 0x7F) << shift;
+    if ((c & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+class RunWriter
+{
+public:
+  RunWriter(const string& fileName) : out{fileName, ios::binary}
+  {
+  }
+
+  bool isOpen() const
+  {
+    return (bool)out;
+  }
+
+  void write(const string& key, float count)
+  {
+    size_t shared = 0;
+    size_t maxShared = min(key.size(), prevKey.size());
+    while (shared < maxShared && key[shared] == prevKey[shared])
+      ++shared;
+    writeVarint(out, shared);
+    writeVarint(out, key.size() - shared);
+    out.write(key.data() + shared, key.size() - shared);
+    out.write(reinterpret_cast<const char*>(&count), sizeof(float));
+    prevKey = key;
+  }
+
+  bool close()
+  {
+    out.close();
+    return !out.fail();
+  }
+
+private:
+  ofstream out;
+  string prevKey;
+};
+
+class RunReader
+{
+public:
+  RunReader(const string& fileName) : in{fileName, ios::binary}, count{0}, error{false}
+  {
+  }
+
+  bool isOpen() const
+  {
+    return (bool)in;
+  }
+
+  // Returns false at the end of the run and on read errors, failed() tells them apart
+  bool next()
+  {
+    if (in.peek() == EOF)
+    {
+      error = in.bad();
+      return false;
+    }
+    size_t shared, suffixSize;
+    if (!readVarint(in, shared) || !readVarint(in, suffixSize) || shared > key.size())
+    {
+      error = true;
+      return false;
+    }
+    key.resize(shared + suffixSize);
+    in.read(&key[shared], suffixSize);
+    in.read(reinterpret_cast<char*>(&count), sizeof(float));
+    error = in.fail();
+    return !error;
+  }
+
+  // True if the run is truncated or could not be read
+  bool failed() const
+  {
+    return error;
+  }
+
+  const string& getKey() const
+  {
+    return key;
+  }
+
+  float getCount() const
+  {
+    return count;
+  }
+
+private:
+  ifstream in;
+  string key;
+  float count;
+  bool error;
+};
+
+// Reads a set of runs in key order, adding up the counts of every distinct key
+class RunMerger
+{
+public:
+  RunMerger() : count{0}, error{false}
+  {
+  }
+
+  bool open(const vector<string>& fileNames)
+  {
+    this->fileNames = fileNames;
+    for (size_t r = 0; r < fileNames.size(); ++r)
+    {
+      readers.push_back(unique_ptr<RunReader>(new RunReader(fileNames[r])));
+      if (!readers.back()->isOpen())
+      {
+        cerr << "Error while reading run file " << fileNames[r] << endl;
+        return THOT_ERROR;
+      }
+      advance(r);
+    }
+    return error ? THOT_ERROR : THOT_OK;
+  }
+
+  // Moves to the next distinct key. Returns false at the end of the runs and on read
+  // errors, failed() tells them apart
+  bool next()
+  {
+    if (error || heap.empty())
+      return false;
+    key = readers[heap.front()]->getKey();
+    double sum = 0;
+    while (!heap.empty() && readers[heap.front()]->getKey() == key)
+    {
+      pop_heap(heap.begin(), heap.end(), Greater{readers});
+      size_t r = heap.back();
+      heap.pop_back();
+      sum += readers[r]->getCount();
+      advance(r);
+    }
+    count = (float)sum;
+    return !error;
+  }
+
+  bool failed() const
+  {
+    return error;
+  }
+
+  const string& getKey() const
+  {
+    return key;
+  }
+
+  float getCount() const
+  {
+    return count;
+  }
+
+private:
+  struct Greater
+  {
+    const vector<unique_ptr<RunReader>>& readers;
+
+    bool operator()(size_t r1, size_t r2) const
+    {
+      return readers[r1]->getKey() > readers[r2]->getKey();
+    }
+  };
+
+  void advance(size_t r)
+  {
+    if (readers[r]->next())
+    {
+      heap.push_back(r);
+      push_heap(heap.begin(), heap.end(), Greater{readers});
+    }
+    else if (readers[r]->failed())
+    {
+      cerr << "Error while reading run file " << fileNames[r] << ", the file is truncated or corrupt" << endl;
+      error = true;
+    }
+  }
+
+  vector<string> fileNames;
+  vector<unique_ptr<RunReader>> readers;
+  vector<size_t> heap;
+  string key;
+  float count;
+  bool error;
+};
+
+// Reads the runs in key order and calls emit() once per distinct key with the sum of
+// its counts
+template <typename Emit>
+bool mergeRunFiles(const vector<string>& fileNames, Emit emit)
+{
+  RunMerger merger;
+  if (merger.open(fileNames) == THOT_ERROR)
+    return THOT_ERROR;
+  while (merger.next())
+    emit(merger.getKey(), merger.getCount());
+  return merger.failed() ? THOT_ERROR : THOT_OK;
+}
+
+bool createRunFile(const string& tempDir, vector<string>& runs, string& fileName)
+{
+  string dir = tempDir.empty() ? "." : tempDir;
+#ifndef _WIN32
+  string pattern = dir + "/thot-phrase-pairs-XXXXXX";
+  vector<char> name(pattern.begin(), pattern.end());
+  name.push_back('\0');
+  int fd = mkstemp(name.data());
+  if (fd == -1)
+  {
+    cerr << "Error while creating a run file in " << dir << endl;
+    return THOT_ERROR;
+  }
+  close(fd);
+  fileName = name.data();
+#else
+  char* name = _tempnam(dir.c_str(), "thot-phrase-pairs-");
+  if (name == NULL)
+  {
+    cerr << "Error while creating a run file in " << dir << endl;
+    return THOT_ERROR;
+  }
+  fileName = name;
+  free(name);
+#endif
+  runs.push_back(fileName);
+  return THOT_OK;
+}
+
+// Writes the buffered pairs sorted by key to a new run and empties the buffer
+bool spillBuffer(const string& tempDir, unordered_map<string, float>& buffer, vector<string>& runs)
+{
+  if (buffer.empty())
+    return THOT_OK;
+
+  vector<const pair<const string, float>*> entries;
+  entries.reserve(buffer.size());
+  for (const pair<const string, float>& entry : buffer)
+    entries.push_back(&entry);
+  sort(entries.begin(), entries.end(),
+       [](const pair<const string, float>* e1, const pair<const string, float>* e2) { return e1->first < e2->first; });
+
+  string fileName;
+  if (createRunFile(tempDir, runs, fileName) == THOT_ERROR)
+    return THOT_ERROR;
+  RunWriter writer(fileName);
+  for (const pair<const string, float>* entry : entries)
+    writer.write(entry->first, entry->second);
+  if (!writer.close())
+  {
+    cerr << "Error while writing run file " << fileName << endl;
+    return THOT_ERROR;
+  }
+
+  unordered_map<string, float>().swap(buffer);
+  return THOT_OK;
+}
+
+// Merges the oldest runs until they can all be read at the same time
+bool reduceRunFiles(const string& tempDir, vector<string>& runs)
+{
+  while (runs.size() > MAX_MERGED_RUNS)
+  {
+    vector<string> inputs(runs.begin(), runs.begin() + MAX_MERGED_RUNS);
+    string fileName;
+    if (createRunFile(tempDir, runs, fileName) == THOT_ERROR)
+      return THOT_ERROR;
+    RunWriter writer(fileName);
+    if (mergeRunFiles(inputs, [&writer](const string& key, float count) { writer.write(key, count); }) == THOT_ERROR
+        || !writer.close())
+    {
+      cerr << "Error while writing run file " << fileName << endl;
+      return THOT_ERROR;
+    }
+    for (const string& input : inputs)
+      remove(input.c_str());
+    runs.erase(runs.begin(), runs.begin() + MAX_MERGED_RUNS);
+  }
+  return THOT_OK;
+}
+
+void removeRunFiles(vector<string>& runs)
+{
+  for (const string& run : runs)
+    remove(run.c_str());
+  runs.clear();
+}
+
+// Sorts (key, count) pairs that do not fit in memory, adding up the counts of equal
+// keys. The runs are removed with the sorter
+class RunSorter
+{
+public:
+  RunSorter(const string& tempDir, size_t memoryLimit) : tempDir{tempDir}, memoryLimit{memoryLimit}, bufferBytes{0}
+  {
+  }
+  RunSorter(const RunSorter&) = delete;
+  RunSorter& operator=(const RunSorter&) = delete;
+
+  bool add(const string& key, float count)
+  {
+    pair<unordered_map<string, float>::iterator, bool> result = buffer.insert(make_pair(key, count));
+    if (!result.second)
+      result.first->second += count;
+    else
+      bufferBytes += key.size() + sizeof(float) + BUFFER_ENTRY_OVERHEAD;
+    if (bufferBytes > memoryLimit)
+      return spill();
+    return THOT_OK;
+  }
+
+  // Writes the buffered pairs, the runs can be merged afterwards
+  bool finish()
+  {
+    if (spill() == THOT_ERROR)
+      return THOT_ERROR;
+    return reduceRunFiles(tempDir, runs);
+  }
+
+  const vector<string>& getRuns() const
+  {
+    return runs;
+  }
+
+  ~RunSorter()
+  {
+    removeRunFiles(runs);
+  }
+
+private:
+  bool spill()
+  {
+    bufferBytes = 0;
+    return spillBuffer(tempDir, buffer, runs);
+  }
+
+  string tempDir;
+  size_t memoryLimit;
+  unordered_map<string, float> buffer;
+  size_t bufferBytes;
+  vector<string> runs;
+};
+
+// Prints the pairs of a source phrase once all of them are known
+class PhraseTablePrinter
+{
+public:
+  PhraseTablePrinter(ostream& out, PhraseTablePruner& pruner) : out{out}, pruner(pruner), srcCount{0}
+  {
+  }
+
+  // trgCount is the count of the target phrase, only used by the significance test
+  void add(const string& key, float count, float trgCount)
+  {
+    size_t sep = key.find('\0');
+    if (src.size() != sep || key.compare(0, sep, src) != 0)
+    {
+      flush();
+      src.assign(key, 0, sep);
+    }
+    trgs.push_back(key.substr(sep + 1));
+    pairCounts.push_back(count);
+    trgCounts.push_back(trgCount);
+    srcCount += count;
+  }
+
+  void flush()
+  {
+    if (pruner.isEnabled() && !trgs.empty())
+      pruner.pruneSrcPhrase((float)srcCount, pairCounts, trgCounts, keep);
+
+    char counts[64];
+    for (size_t k = 0; k < trgs.size(); ++k)
+    {
+      if (!keep.empty() && !keep[k])
+        continue;
+      snprintf(counts, sizeof(counts), "%.8f %.8f", (float)srcCount, pairCounts[k]);
+      out << src << " ||| " << trgs[k] << " ||| " << counts << "\n";
+    }
+    trgs.clear();
+    pairCounts.clear();
+    trgCounts.clear();
+    keep.clear();
+    srcCount = 0;
+  }
+
+private:
+  ostream& out;
+  PhraseTablePruner& pruner;
+  string src;
+  vector<string> trgs;
+  vector<float> pairCounts;
+  vector<float> trgCounts;
+  vector<bool> keep;
+  double srcCount;
+};
+
+// The target count of every pair is obtained with three sorts on disk: the pairs are
+// sorted by target phrase and the counts of every target phrase are added up, both
+// are read side by side to give every pair the count of its target phrase, and the
+// result is sorted back by source phrase
+bool sortTrgCounts(const string& tempDir, size_t memoryLimit, const vector<string>& runs, RunSorter& trgCountSorter)
+{
+  RunSorter pairsByTrg(tempDir, memoryLimit / 2);
+  RunSorter trgTotals(tempDir, memoryLimit / 2);
+  RunMerger pairMerger;
+  if (pairMerger.open(runs) == THOT_ERROR)
+    return THOT_ERROR;
+  string trgKey;
+  while (pairMerger.next())
+  {
+    const string& key = pairMerger.getKey();
+    size_t sep = key.find('\0');
+    trgKey.assign(key, sep + 1, string::npos);
+    trgKey += '\0';
+    trgKey.append(key, 0, sep);
+    if (pairsByTrg.add(trgKey, pairMerger.getCount()) == THOT_ERROR
+        || trgTotals.add(key.substr(sep + 1), pairMerger.getCount()) == THOT_ERROR)
+      return THOT_ERROR;
+  }
+  if (pairMerger.failed() || pairsByTrg.finish() == THOT_ERROR || trgTotals.finish() == THOT_ERROR)
+    return THOT_ERROR;
+
+  // The null character sorts before any other, so the pairs come in the order of the
+  // totals of their target phrases
+  RunMerger trgPairMerger;
+  RunMerger totalMerger;
+  if (trgPairMerger.open(pairsByTrg.getRuns()) == THOT_ERROR || totalMerger.open(trgTotals.getRuns()) == THOT_ERROR)
+    return THOT_ERROR;
+  string srcKey;
+  bool hasTotal = false;
+  while (trgPairMerger.next())
+  {
+    const string& key = trgPairMerger.getKey();
+    size_t sep = key.find('\0');
+    while (!hasTotal || totalMerger.getKey().compare(0, string::npos, key, 0, sep) != 0)
+    {
+      if (!totalMerger.next())
+      {
+        cerr << "Error: missing count of a target phrase" << endl;
+        return THOT_ERROR;
+      }
+      hasTotal = true;
+    }
+    srcKey.assign(key, sep + 1, string::npos);
+    srcKey += '\0';
+    srcKey.append(key, 0, sep);
+    if (trgCountSorter.add(srcKey, totalMerger.getCount()) == THOT_ERROR)
+      return THOT_ERROR;
+  }
+  if (trgPairMerger.failed())
+    return THOT_ERROR;
+  return trgCountSorter.finish();
+}
+} // namespace
+
+ExternalPhraseTableBuilder::ExternalPhraseTableBuilder() : memoryLimit{DEFAULT_MEMORY_LIMIT}, bufferBytes{0}
+{
+}
+
+void ExternalPhraseTableBuilder::setTempDir(const string& dir)
+{
+  tempDir = dir;
+}
+
+const string& ExternalPhraseTableBuilder::getTempDir() const
+{
+  return tempDir;
+}
+
+void ExternalPhraseTableBuilder::setPruningParameters(const PhraseTablePruningParameters& params)
+{
+  pruner.setParameters(params);
+}
+
+const PhraseTablePruningParameters& ExternalPhraseTableBuilder::getPruningParameters() const
+{
+  return pruner.getParameters();
+}
+
+const PhraseTablePruningStats& ExternalPhraseTableBuilder::getPruningStats() const
+{
+  return pruner.getStats();
+}
+
+void ExternalPhraseTableBuilder::setMemoryLimit(size_t limit)
+{
+  memoryLimit = limit;
+}
+
+size_t ExternalPhraseTableBuilder::getMemoryLimit() const
+{
+  return memoryLimit;
+}
+
+bool ExternalPhraseTableBuilder::addPhrasePair(const vector<string>& s, const vector<string>& t, float count)
+{
+  string key;
+  for (size_t i = 0; i < s.size(); ++i)
+  {
+    if (i > 0)
+      key += ' ';
+    key += s[i];
+  }
+  key += '\0';
+  for (size_t i = 0; i < t.size(); ++i)
+  {
+    if (i > 0)
+      key += ' ';
+    key += t[i];
+  }
+
+  pair<unordered_map<string, float>::iterator, bool> result = buffer.insert(make_pair(key, count));
+  if (!result.second)
+    result.first->second += count;
+  else
+    bufferBytes += key.size() + sizeof(float) + BUFFER_ENTRY_OVERHEAD;
+
+  if (bufferBytes > memoryLimit)
+    return spill();
+  return THOT_OK;
+}
+
+size_t ExternalPhraseTableBuilder::numRuns() const
+{
+  return runs.size();
+}
+
+bool ExternalPhraseTableBuilder::print(const char* fileName)
+{
+  ofstream outF(fileName);
+  if (!outF)
+  {
+    cerr << "Error while opening output file " << fileName << endl;
+    return THOT_ERROR;
+  }
+  if (print(outF) == THOT_ERROR)
+    return THOT_ERROR;
+  outF.close();
+  return outF.fail() ? THOT_ERROR : THOT_OK;
+}
+
+bool ExternalPhraseTableBuilder::print(ostream& out)
+{
+  if (!pruner.hasValidParameters())
+  {
+    cerr << "Error: the significance test needs the number of sentence pairs of the table" << endl;
+    return THOT_ERROR;
+  }
+  if (spill() == THOT_ERROR || reduceRunFiles(tempDir, runs) == THOT_ERROR)
+    return THOT_ERROR;
+
+  pruner.clearStats();
+  PhraseTablePrinter printer(out, pruner);
+  if (!pruner.needsTrgCounts())
+  {
+    if (mergeRunFiles(runs, [&printer](const string& key, float count) { printer.add(key, count, 0); })
+        == THOT_ERROR)
+      return THOT_ERROR;
+    printer.flush();
+    return out.fail() ? THOT_ERROR : THOT_OK;
+  }
+
+  // The pairs and their target counts are read side by side, both sorted by pair
+  RunSorter trgCountSorter(tempDir, memoryLimit);
+  if (sortTrgCounts(tempDir, memoryLimit, runs, trgCountSorter) == THOT_ERROR)
+    return THOT_ERROR;
+  RunMerger pairMerger;
+  RunMerger trgCountMerger;
+  if (pairMerger.open(runs) == THOT_ERROR || trgCountMerger.open(trgCountSorter.getRuns()) == THOT_ERROR)
+    return THOT_ERROR;
+  while (pairMerger.next())
+  {
+    if (!trgCountMerger.next() || trgCountMerger.getKey() != pairMerger.getKey())
+    {
+      cerr << "Error: the target phrase counts do not match the phrase pairs" << endl;
+      return THOT_ERROR;
+    }
+    printer.add(pairMerger.getKey(), pairMerger.getCount(), trgCountMerger.getCount());
+  }
+  if (pairMerger.failed())
+    return THOT_ERROR;
+  printer.flush();
+  return out.fail() ? THOT_ERROR : THOT_OK;
+}
+
+void ExternalPhraseTableBuilder::clear()
+{
+  buffer.clear();
+  bufferBytes = 0;
+  removeRunFiles(runs);
+}
+
+ExternalPhraseTableBuilder::~ExternalPhraseTableBuilder()
+{
+  clear();
+}
+
+bool ExternalPhraseTableBuilder::spill()
+{
+  bufferBytes = 0;
+  return spillBuffer(tempDir, buffer, runs);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "phrase_models/PhraseTablePruner.h"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Builds a phrase table whose counts do not fit in memory. Phrase pair counts are
+// added up in a buffer; when the buffer exceeds the memory limit its pairs are
+// sorted and written to a run file in the temporary directory. print() merges the
+// runs and writes the table in the plain text format read by
+// _incrPhraseModel::load_ttable(), with the source count of every pair computed
+// from the pairs of its source phrase.
+//
+// The pairs of every source phrase can be pruned as they are printed. The significance
+// test needs the target phrase counts, which are obtained by sorting the pairs by
+// target phrase on disk, so that memory use stays within the limit. Source counts are
+// not changed by pruning.
+//
+// Runs are prefix-compressed: every pair only stores the part of its key that
+// differs from the previous one.
+class ExternalPhraseTableBuilder
+{
+public:
+  ExternalPhraseTableBuilder();
+  ExternalPhraseTableBuilder(const ExternalPhraseTableBuilder&) = delete;
+  ExternalPhraseTableBuilder& operator=(const ExternalPhraseTableBuilder&) = delete;
+
+  // Directory of the run files, the current directory if it is empty
+  void setTempDir(const std::string& dir);
+  const std::string& getTempDir() const;
+  // Approximate number of bytes of the buffered pairs
+  void setMemoryLimit(std::size_t limit);
+  std::size_t getMemoryLimit() const;
+  void setPruningParameters(const PhraseTablePruningParameters& params);
+  const PhraseTablePruningParameters& getPruningParameters() const;
+  // Pairs removed by the last call to print()
+  const PhraseTablePruningStats& getPruningStats() const;
+
+  bool addPhrasePair(const std::vector<std::string>& s, const std::vector<std::string>& t, float count);
+  std::size_t numRuns() const;
+
+  bool print(const char* fileName);
+  bool print(std::ostream& out);
+
+  // Removes the buffered pairs and the run files
+  void clear();
+
+  ~ExternalPhraseTableBuilder();
+
+private:
+  bool spill();
+
+  std::string tempDir;
+  std::size_t memoryLimit;
+  // Keys hold the source phrase and the target phrase separated by a null character,
+  // so that sorting them groups the pairs of every source phrase
+  std::unordered_map<std::string, float> buffer;
+  std::size_t bufferBytes;
+  std::vector<std::string> runs;
+  PhraseTablePruner pruner;
+};
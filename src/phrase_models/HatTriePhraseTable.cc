@@ -26,60 +26,130 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 #include "phrase_models/HatTriePhraseTable.h"
 
-//--------------- Function definitions
+namespace
+{
+// A word index is written as its digits in base 128 with the high bit set, most
+// significant first, followed by its last digit in base 127 stored as a byte from 1
+// to 127. Indices below 127, which the vocabularies give to the earliest and usually
+// most frequent words, take a single byte. No byte is 0 and no code is a prefix of
+// another one, so a key prefix made of whole words only matches the keys that start
+// with the same words
+void appendWord(WordIndex w, std::string& key)
+{
+  char highDigits[5];
+  int numHighDigits = 0;
+  for (WordIndex high = w / 127; high > 0; high >>= 7)
+    highDigits[numHighDigits++] = (char)(0x80 | (high & 0x7f));
+  while (numHighDigits > 0)
+    key.push_back(highDigits[--numHighDigits]);
+  key.push_back((char)(w % 127 + 1));
+}
 
-//-------------------------
-HatTriePhraseTable::HatTriePhraseTable(void)
+void appendWords(const std::vector<WordIndex>& vec, std::string& key)
 {
+  for (size_t i = 0; i < vec.size(); ++i)
+    appendWord(vec[i], key);
 }
 
-//-------------------------
-std::string HatTriePhraseTable::vectorToStdString(const std::vector<WordIndex>& vec) const
+// Decodes the words of the key that start at byte pos
+void decodeWords(const std::string& key, size_t pos, std::vector<WordIndex>& vec)
 {
-  std::vector<WordIndex> str;
-  for (size_t i = 0; i < vec.size(); i++)
+  vec.clear();
+  WordIndex w = 0;
+  for (; pos < key.size(); ++pos)
   {
-    // Use WORD_INDEX_MODULO_BYTES bytes to encode index
-    for (int j = WORD_INDEX_MODULO_BYTES - 1; j >= 0; j--)
+    unsigned char b = (unsigned char)key[pos];
+    if (b & 0x80)
     {
-      str.push_back(1 + (vec[i] / (unsigned int)pow(WORD_INDEX_MODULO_BASE, j) % WORD_INDEX_MODULO_BASE));
+      w = (w << 7) | (b & 0x7f);
+    }
+    else
+    {
+      vec.push_back(w * 127 + (b - 1));
+      w = 0;
     }
   }
+}
+
+std::string& keyBuffer()
+{
+  static thread_local std::string buffer;
+  return buffer;
+}
+} // namespace
+
+//--------------- Function definitions
 
-  std::string s(str.begin(), str.end());
+//-------------------------
+HatTriePhraseTable::HatTriePhraseTable(void) : nbestCacheSize(DEFAULT_NBEST_CACHE_SIZE)
+{
+  nbestScore = [](Count pairCount, Count phraseCount) -> Score {
+    LgProb lgProb = log((float)pairCount.get_c_st() / (float)phraseCount);
+    return lgProb;
+  };
+}
 
-  return s;
+//-------------------------
+std::string HatTriePhraseTable::vectorToKey(const std::vector<WordIndex>& vec) const
+{
+  std::string key;
+  appendWords(vec, key);
+  return key;
 }
 
 //-------------------------
-std::vector<WordIndex> HatTriePhraseTable::stringToVector(const std::string s) const
+std::vector<WordIndex> HatTriePhraseTable::keyToVector(const std::string& key) const
 {
   std::vector<WordIndex> vec;
+  decodeWords(key, 0, vec);
+  return vec;
+}
 
-  for (size_t i = 0; i < s.size();) // A string length is WORD_INDEX_MODULO_BYTES * n + 1
-  {
-    unsigned int wi = 0;
-    for (int j = WORD_INDEX_MODULO_BYTES - 1; j >= 0; j--, i++)
-    {
-      wi += (((unsigned char)s[i]) - 1) * (unsigned int)pow(WORD_INDEX_MODULO_BASE, j);
-    }
-
-    vec.push_back(wi);
-  }
+//-------------------------
+const std::string& HatTriePhraseTable::srcKey(const std::vector<WordIndex>& s) const
+{
+  // (UNUSED_WORD, s)
+  std::string& key = keyBuffer();
+  key.clear();
+  appendWord(UNUSED_WORD, key);
+  appendWords(s, key);
+  return key;
+}
 
-  return vec;
+//-------------------------
+const std::string& HatTriePhraseTable::trgKey(const std::vector<WordIndex>& t) const
+{
+  std::string& key = keyBuffer();
+  key.clear();
+  appendWords(t, key);
+  return key;
 }
 
 //-------------------------
-std::string HatTriePhraseTable::vectorToKey(const std::vector<WordIndex>& vec) const
+const std::string& HatTriePhraseTable::srcTrgKey(const std::vector<WordIndex>& s,
+                                                 const std::vector<WordIndex>& t) const
 {
-  return vectorToStdString(vec);
+  // (UNUSED_WORD, s, UNUSED_WORD, t)
+  std::string& key = keyBuffer();
+  key.clear();
+  appendWord(UNUSED_WORD, key);
+  appendWords(s, key);
+  appendWord(UNUSED_WORD, key);
+  appendWords(t, key);
+  return key;
 }
 
 //-------------------------
-std::vector<WordIndex> HatTriePhraseTable::keyToVector(const std::string key) const
+const std::string& HatTriePhraseTable::trgSrcKey(const std::vector<WordIndex>& s,
+                                                 const std::vector<WordIndex>& t) const
 {
-  return stringToVector(key);
+  // (t, UNUSED_WORD, s)
+  std::string& key = keyBuffer();
+  key.clear();
+  appendWords(t, key);
+  appendWord(UNUSED_WORD, key);
+  appendWords(s, key);
+  return key;
 }
 
 //-------------------------
@@ -118,96 +188,164 @@ std::vector<WordIndex> HatTriePhraseTable::getTrgSrc(const std::vector<WordIndex
 //-------------------------
 bool HatTriePhraseTable::getNbestForSrc(const std::vector<WordIndex>& s, NbestTableNode<PhraseTransTableNodeData>& nbt)
 {
-  HatTriePhraseTable::TrgTableNode::iterator iter;
-
-  bool found;
-  Count s_count;
-  HatTriePhraseTable::TrgTableNode node;
-  LgProb lgProb;
-
-  // Make sure that collection does not contain any old elements
-  nbt.clear();
+  PhraseNbestListView view;
+  bool found = getNbestViewForSrc(s, view);
+  view.copyTo(nbt);
+  return found;
+}
 
-  found = getEntriesForSource(s, node);
-  s_count = cSrc(s);
+//-------------------------
+bool HatTriePhraseTable::getNbestForTrg(const std::vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt,
+                                        int N)
+{
+  PhraseNbestListView view;
+  bool found = getNbestViewForTrg(t, view, N);
+  view.copyTo(nbt);
+  return found;
+}
 
-  if (found)
+//-------------------------
+bool HatTriePhraseTable::getNbestViewForSrc(const std::vector<WordIndex>& s, PhraseNbestListView& view, int N)
+{
+  std::string key = srcKey(s);
+  std::shared_ptr<const PhraseNbestList> list = findCachedNbestList(srcNbestCache, key);
+  if (!list)
   {
-    // Generate transTableNode
-    for (iter = node.begin(); iter != node.end(); iter++)
-    {
-      std::vector<WordIndex> t = iter->first;
-      PhrasePairInfo ppi = (PhrasePairInfo)iter->second;
-      float c_st = (float)ppi.second.get_c_st();
-      lgProb = log(c_st / (float)s_count);
-      nbt.insert(lgProb, t); // Insert pair <log probability, target phrase>
-    }
-
-#ifdef DO_STABLE_SORT_ON_NBEST_TABLE
-    // Performs stable sort on n-best table, this is done to ensure
-    // that the n-best lists generated by cache models and
-    // conventional models are identical. However this process is
-    // time consuming and must be avoided if possible
-    nbt.stableSort();
-#endif
-    return true;
+    HatTriePhraseTable::TrgTableNode node;
+    getEntriesForSource(s, node);
+    list = buildNbestList(node, cSrc(s));
+    cacheNbestList(srcNbestCache, key, list);
   }
-  else
+  view = PhraseNbestListView(list, N);
+  return !list->empty();
+}
+
+//-------------------------
+bool HatTriePhraseTable::getNbestViewForTrg(const std::vector<WordIndex>& t, PhraseNbestListView& view, int N)
+{
+  std::string key = trgKey(t);
+  std::shared_ptr<const PhraseNbestList> list = findCachedNbestList(trgNbestCache, key);
+  if (!list)
   {
-    // Cannot find the source phrase
-    return false;
+    HatTriePhraseTable::SrcTableNode node;
+    getEntriesForTarget(t, node);
+    list = buildNbestList(node, cTrg(t));
+    cacheNbestList(trgNbestCache, key, list);
   }
+  view = PhraseNbestListView(list, N);
+  return !list->empty();
 }
+
 //-------------------------
-bool HatTriePhraseTable::getNbestForTrg(const std::vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt,
-                                        int N)
+void HatTriePhraseTable::setNbestScoreFunction(NbestScoreFunction scoreFunction)
 {
-  HatTriePhraseTable::SrcTableNode::iterator iter;
-
-  bool found;
-  Count t_count;
-  HatTriePhraseTable::SrcTableNode node;
-  LgProb lgProb;
-
-  // Make sure that collection does not contain any old elements
-  nbt.clear();
+  std::lock_guard<std::mutex> lock(nbestCacheMutex);
+  nbestScore = scoreFunction;
+  srcNbestCache.clear();
+  trgNbestCache.clear();
+}
 
-  found = getEntriesForTarget(t, node);
-  t_count = cTrg(t);
+//-------------------------
+void HatTriePhraseTable::setNbestCacheSize(size_t maxPhrases)
+{
+  std::lock_guard<std::mutex> lock(nbestCacheMutex);
+  nbestCacheSize = maxPhrases;
+  srcNbestCache.clear();
+  trgNbestCache.clear();
+}
 
-  if (found)
+//-------------------------
+std::shared_ptr<const PhraseNbestList> HatTriePhraseTable::buildNbestList(
+    const std::map<std::vector<WordIndex>, PhrasePairInfo>& entries, Count phraseCount) const
+{
+  NbestTableNode<PhraseTransTableNodeData> nbt;
+  for (std::map<std::vector<WordIndex>, PhrasePairInfo>::const_iterator iter = entries.begin(); iter != entries.end();
+       ++iter)
   {
-    // Generate transTableNode
-    for (iter = node.begin(); iter != node.end(); iter++)
-    {
-      std::vector<WordIndex> s = iter->first;
-      PhrasePairInfo ppi = (PhrasePairInfo)iter->second;
-      float c_st = (float)ppi.second.get_c_st();
-      lgProb = log(c_st / (float)t_count);
-      nbt.insert(lgProb, s); // Insert pair <log probability, source phrase>
-    }
+    nbt.insert(nbestScore(iter->second.second, phraseCount), iter->first);
+  }
 
 #ifdef DO_STABLE_SORT_ON_NBEST_TABLE
-    // Performs stable sort on n-best table, this is done to ensure
-    // that the n-best lists generated by cache models and
-    // conventional models are identical. However this process is
-    // time consuming and must be avoided if possible
-    nbt.stableSort();
+  // Performs stable sort on n-best table, this is done to ensure
+  // that the n-best lists generated by cache models and
+  // conventional models are identical. However this process is
+  // time consuming and must be avoided if possible
+  nbt.stableSort();
 #endif
+  return PhraseNbestListView::makeList(nbt);
+}
 
-    while (nbt.size() > (unsigned int)N && N >= 0)
-    {
-      // node contains N inverse translations, remove last element
-      nbt.removeLastElement();
-    }
+//-------------------------
+std::shared_ptr<const PhraseNbestList> HatTriePhraseTable::findCachedNbestList(NbestCache& cache,
+                                                                                const std::string& key)
+{
+  std::lock_guard<std::mutex> lock(nbestCacheMutex);
+  return cache.find(key);
+}
 
-    return true;
+//-------------------------
+void HatTriePhraseTable::cacheNbestList(NbestCache& cache, const std::string& key,
+                                        std::shared_ptr<const PhraseNbestList> list)
+{
+  std::lock_guard<std::mutex> lock(nbestCacheMutex);
+  if (nbestCacheSize > 0)
+    cache.insert(key, list, nbestCacheSize);
+}
+
+//-------------------------
+void HatTriePhraseTable::removeCachedNbestList(NbestCache& cache, const std::string& key)
+{
+  std::lock_guard<std::mutex> lock(nbestCacheMutex);
+  cache.erase(key);
+}
+
+//-------------------------
+std::shared_ptr<const PhraseNbestList> HatTriePhraseTable::NbestCache::find(const std::string& key)
+{
+  auto iter = lists.find(key);
+  if (iter == lists.end())
+    return std::shared_ptr<const PhraseNbestList>();
+  lru.splice(lru.begin(), lru, iter->second.second);
+  return iter->second.first;
+}
+
+//-------------------------
+void HatTriePhraseTable::NbestCache::insert(const std::string& key, std::shared_ptr<const PhraseNbestList> list,
+                                            size_t maxSize)
+{
+  auto iter = lists.find(key);
+  if (iter != lists.end())
+  {
+    // Another thread built the same list
+    iter->second.first = list;
+    lru.splice(lru.begin(), lru, iter->second.second);
+    return;
   }
-  else
+  while (lists.size() >= maxSize && !lru.empty())
   {
-    // Cannot find the target phrase
-    return false;
+    lists.erase(lru.back());
+    lru.pop_back();
   }
+  lru.push_front(key);
+  lists.insert(std::make_pair(key, std::make_pair(list, lru.begin())));
+}
+
+//-------------------------
+void HatTriePhraseTable::NbestCache::erase(const std::string& key)
+{
+  auto iter = lists.find(key);
+  if (iter != lists.end())
+  {
+    lru.erase(iter->second.second);
+    lists.erase(iter);
+  }
+}
+
+//-------------------------
+void HatTriePhraseTable::NbestCache::clear(void)
+{
+  lists.clear();
+  lru.clear();
 }
 
 //-------------------------
@@ -225,22 +363,26 @@ void HatTriePhraseTable::addTableEntry(const std::vector<WordIndex>& s, const st
 //-------------------------
 void HatTriePhraseTable::addSrcInfo(const std::vector<WordIndex>& s, Count s_inf)
 {
-  std::string srcKey = vectorToKey(getSrc(s));
-  phraseTable[srcKey.c_str()] = s_inf;
+  const std::string& key = srcKey(s);
+  phraseTable[key] = s_inf;
+  removeCachedNbestList(srcNbestCache, key);
 }
 
 //-------------------------
 void HatTriePhraseTable::addTrgInfo(const std::vector<WordIndex>& t, Count t_inf)
 {
-  std::string trgKey = vectorToKey(t);
-  phraseTable[trgKey.c_str()] = t_inf;
+  const std::string& key = trgKey(t);
+  phraseTable[key] = t_inf;
+  removeCachedNbestList(trgNbestCache, key);
 }
 
 //-------------------------
 void HatTriePhraseTable::addSrcTrgInfo(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, Count st_inf)
 {
-  std::string trgSrcKey = vectorToKey(getTrgSrc(s, t));
-  phraseTable[trgSrcKey.c_str()] = st_inf;
+  phraseTable[trgSrcKey(s, t)] = st_inf;
+  srcTrgTable[srcTrgKey(s, t)] = st_inf;
+  removeCachedNbestList(srcNbestCache, srcKey(s));
+  removeCachedNbestList(trgNbestCache, trgKey(t));
 }
 
 //-------------------------
@@ -279,8 +421,7 @@ PhrasePairInfo HatTriePhraseTable::infSrcTrg(const std::vector<WordIndex>& s, co
 //-------------------------
 Count HatTriePhraseTable::getSrcInfo(const std::vector<WordIndex>& s, bool& found)
 {
-  std::string srcKey = vectorToKey(getSrc(s));
-  PhraseTable::iterator iter = phraseTable.find(srcKey.c_str());
+  PhraseTable::iterator iter = phraseTable.find(srcKey(s));
 
   if (iter == phraseTable.end()) // Check if s exists in collection
   {
@@ -297,8 +438,7 @@ Count HatTriePhraseTable::getSrcInfo(const std::vector<WordIndex>& s, bool& foun
 //-------------------------
 Count HatTriePhraseTable::getTrgInfo(const std::vector<WordIndex>& t, bool& found)
 {
-  std::string trgKey = vectorToKey(t);
-  PhraseTable::iterator iter = phraseTable.find(trgKey.c_str());
+  PhraseTable::iterator iter = phraseTable.find(trgKey(t));
 
   if (iter == phraseTable.end()) // Check if t exists in collection
   {
@@ -315,8 +455,7 @@ Count HatTriePhraseTable::getTrgInfo(const std::vector<WordIndex>& t, bool& foun
 //-------------------------
 Count HatTriePhraseTable::getSrcTrgInfo(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, bool& found)
 {
-  std::string trgSrcKey = vectorToKey(getTrgSrc(s, t));
-  PhraseTable::iterator iter = phraseTable.find(trgSrcKey);
+  PhraseTable::iterator iter = phraseTable.find(trgSrcKey(s, t));
 
   // // Check if entry for (s, t) pair exists
   if (iter == phraseTable.end())
@@ -384,19 +523,23 @@ bool HatTriePhraseTable::getEntriesForTarget(const std::vector<WordIndex>& t, Ha
   bool found;
   srctn.clear(); // Make sure that structure does not keep old values
 
-  // Prepare iterators
+  // Prepare iterators, the prefix range keeps its own copy of the prefix
   const std::vector<WordIndex> emptyVec;
-  std::vector<WordIndex> trgSrcPrefix = getTrgSrc(emptyVec, t);
-  std::string trgSrcPrefixStr = vectorToKey(trgSrcPrefix);
+  const std::string& trgSrcPrefix = trgSrcKey(emptyVec, t); // (t, UNUSED_WORD)
+  size_t prefixSize = trgSrcPrefix.size();
 
-  auto prefixIterators = phraseTable.equal_prefix_range(trgSrcPrefixStr);
+  auto prefixIterators = phraseTable.equal_prefix_range(trgSrcPrefix);
 
+  std::string key;
+  std::vector<WordIndex> s;
   for (auto iter = prefixIterators.first; iter != prefixIterators.second; iter++)
   {
-    std::vector<WordIndex> vec = keyToVector(iter.key());
-    std::vector<WordIndex> s(vec.begin() + t.size() + 1, vec.end());
+    iter.key(key);
+    decodeWords(key, prefixSize, s);
 
-    PhrasePairInfo ppi = infSrcTrg(s, t, found);
+    PhrasePairInfo ppi;
+    ppi.first = getSrcInfo(s, found); // s count
+    ppi.second = iter.value();        // (s, t) count
     if (!found || fabs(ppi.first.get_c_s()) < EPSILON || fabs(ppi.second.get_c_s()) < EPSILON)
       continue;
 
@@ -411,21 +554,19 @@ bool HatTriePhraseTable::getEntriesForSource(const std::vector<WordIndex>& s, Ha
 {
   trgtn.clear(); // Make sure that structure does not keep old values
 
-  std::vector<WordIndex> srcVec = getSrc(s); // (UNUSED_WORD, s)
-
-  // Scan (s, t) collection to find matching elements for a given s
-  for (auto iter = phraseTable.begin(); iter != phraseTable.end(); iter++)
-  {
-    std::vector<WordIndex> phrase = keyToVector(iter.key());
+  // Prepare iterators
+  const std::vector<WordIndex> emptyVec;
+  const std::string& srcTrgPrefix = srcTrgKey(s, emptyVec); // (UNUSED_WORD, s, UNUSED_WORD)
+  size_t prefixSize = srcTrgPrefix.size();
 
-    if (phrase.size() <= srcVec.size()) // Phrase is to short to contain given source and target
-      continue;
+  auto prefixIterators = srcTrgTable.equal_prefix_range(srcTrgPrefix);
 
-    std::vector<WordIndex> srcPhrase(phrase.end() - srcVec.size(), phrase.end());
-    if (srcPhrase != srcVec) // Found source does not match to given source
-      continue;
-
-    std::vector<WordIndex> trgPhrase(phrase.begin(), phrase.end() - srcVec.size());
+  std::string key;
+  std::vector<WordIndex> trgPhrase;
+  for (auto iter = prefixIterators.first; iter != prefixIterators.second; iter++)
+  {
+    iter.key(key);
+    decodeWords(key, prefixSize, trgPhrase);
 
     PhrasePairInfo ppi;
     ppi.first = cTrg(trgPhrase); // t count
@@ -516,6 +657,11 @@ size_t HatTriePhraseTable::size(void)
 void HatTriePhraseTable::clear(void)
 {
   phraseTable.clear();
+  srcTrgTable.clear();
+  std::lock_guard<std::mutex> lock(nbestCacheMutex);
+  srcNbestCache.clear();
+  trgNbestCache.clear();
+  clearPhraseIds();
 }
 
 //-------------------------
@@ -24,19 +24,21 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
-#define WORD_INDEX_MODULO_BASE 254
-// Increase this parameter if you have more word in dictionary than
-// WORD_INDEX_MODULO_BASE ^ WORD_INDEX_MODULO_BYTES (by default 254^3)
-#define WORD_INDEX_MODULO_BYTES 3
-
 //--------------- Include files --------------------------------------
 
 #include "phrase_models/BasePhraseTable.h"
 
+#include <functional>
 #include <hat_trie/htrie_map.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 //--------------- Constants ------------------------------------------
 
+#define DEFAULT_NBEST_CACHE_SIZE 65536
+
 //--------------- typedefs -------------------------------------------
 
 //--------------- function declarations ------------------------------
@@ -61,6 +63,10 @@ public:
   // Returned result types by iterator
   typedef std::pair<std::vector<WordIndex>, Count> PhraseInfoElement;
 
+  // Score of a pair in the n-best lists, given its count and the count
+  // of the phrase the list is for
+  typedef std::function<Score(Count pairCount, Count phraseCount)> NbestScoreFunction;
+
   // Constructor
   HatTriePhraseTable(void);
 
@@ -90,6 +96,18 @@ public:
   virtual bool getNbestForSrc(const std::vector<WordIndex>& s, NbestTableNode<PhraseTransTableNodeData>& nbt);
   virtual bool getNbestForTrg(const std::vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt,
                               int N = -1);
+  virtual bool getNbestViewForSrc(const std::vector<WordIndex>& s, PhraseNbestListView& view, int N = -1);
+  virtual bool getNbestViewForTrg(const std::vector<WordIndex>& t, PhraseNbestListView& view, int N = -1);
+  // The n-best lists are sorted once and kept until a count they
+  // depend on changes, so later queries for the same phrase only
+  // take a view of their first N entries
+
+  // N-best list configuration
+  void setNbestScoreFunction(NbestScoreFunction scoreFunction);
+  // log(pairCount / phraseCount) by default
+  void setNbestCacheSize(size_t maxPhrases);
+  // Maximum number of phrases of each language whose n-best lists
+  // are kept, 0 disables the cache
 
   // Counts-related functions
   virtual Count cSrcTrg(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t);
@@ -145,6 +163,40 @@ public:
 
 protected:
   PhraseTable phraseTable;
+  // Counts of the (s, t) pairs keyed by (UNUSED_WORD, s, UNUSED_WORD, t), so that the
+  // entries of a source phrase share a prefix like those of a target phrase do in
+  // phraseTable
+  PhraseTable srcTrgTable;
+
+  // Sorted n-best lists keyed by the key of the phrase they are for. When the
+  // cache is full the least recently used list is dropped
+  class NbestCache
+  {
+  public:
+    std::shared_ptr<const PhraseNbestList> find(const std::string& key);
+    void insert(const std::string& key, std::shared_ptr<const PhraseNbestList> list, size_t maxSize);
+    void erase(const std::string& key);
+    void clear(void);
+
+  private:
+    typedef std::list<std::string> LruList;
+    // Most recently used keys first
+    LruList lru;
+    std::unordered_map<std::string, std::pair<std::shared_ptr<const PhraseNbestList>, LruList::iterator>> lists;
+  };
+  NbestCache srcNbestCache;
+  NbestCache trgNbestCache;
+  size_t nbestCacheSize;
+  NbestScoreFunction nbestScore;
+  // Queries may come from several threads, and the cache is also
+  // updated when counts change
+  std::mutex nbestCacheMutex;
+
+  std::shared_ptr<const PhraseNbestList> buildNbestList(const std::map<std::vector<WordIndex>, PhrasePairInfo>& entries,
+                                                        Count phraseCount) const;
+  std::shared_ptr<const PhraseNbestList> findCachedNbestList(NbestCache& cache, const std::string& key);
+  void cacheNbestList(NbestCache& cache, const std::string& key, std::shared_ptr<const PhraseNbestList> list);
+  void removeCachedNbestList(NbestCache& cache, const std::string& key);
 
   // Check type of phrase in vector
   bool isTargetPhrase(const std::vector<WordIndex>& vec) const;
@@ -159,8 +211,13 @@ protected:
 
   // Key converters
   virtual std::string vectorToKey(const std::vector<WordIndex>& vec) const;
-  virtual std::vector<WordIndex> keyToVector(const std::string key) const;
-  virtual std::string vectorToStdString(const std::vector<WordIndex>& vec) const;
-  virtual std::vector<WordIndex> stringToVector(const std::string s) const;
+  virtual std::vector<WordIndex> keyToVector(const std::string& key) const;
+
+  // Key builders, the returned key is kept in a buffer of the calling thread that
+  // is reused by the next call
+  const std::string& srcKey(const std::vector<WordIndex>& s) const;
+  const std::string& trgKey(const std::vector<WordIndex>& t) const;
+  const std::string& srcTrgKey(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) const;
+  const std::string& trgSrcKey(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) const;
 };
 
@@ -0,0 +1,617 @@
+#include "phrase_models/MmapPhraseTable.h"
+
+#include "nlp_common/ErrorDefs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+const char MMAP_PHRASE_TABLE_MAGIC[8] = {'T', 'H', 'O', 'T', 'P', 'H', 'R', 'T'};
+const uint32_t MMAP_PHRASE_TABLE_VERSION = 1;
+
+struct SideHeader
+{
+  uint64_t numPhrases;
+  uint64_t numWords;
+};
+
+// The header is followed by the arrays of the source side and then by those of the
+// target side, each one starting at an 8-byte aligned offset: word offsets, words,
+// phrase counts, pair offsets, partners, pair counts and n-best order
+struct Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t numPairs;
+  SideHeader src;
+  SideHeader trg;
+};
+
+std::size_t alignedSize(std::size_t size)
+{
+  return (size + 7) & ~(std::size_t)7;
+}
+
+template <typename T>
+bool takeArray(const char* image, std::size_t imageSize, std::size_t& pos, uint64_t n, const T*& array)
+{
+  if (n > imageSize / sizeof(T))
+    return false;
+  array = reinterpret_cast<const T*>(image + pos);
+  pos += alignedSize(n * sizeof(T));
+  return pos <= imageSize;
+}
+
+template <typename T>
+void writeArray(ostream& out, const vector<T>& array)
+{
+  static const char zeros[8] = {0};
+  std::size_t size = array.size() * sizeof(T);
+  if (size > 0)
+    out.write(reinterpret_cast<const char*>(array.data()), size);
+  out.write(zeros, alignedSize(size) - size);
+}
+
+struct SidePair
+{
+  uint32_t phrase;
+  uint32_t partner;
+  float count;
+};
+
+// Arrays of one side of the table, in the order in which they are written
+struct SideArrays
+{
+  vector<uint64_t> wordOffsets;
+  vector<WordIndex> words;
+  vector<float> counts;
+  vector<uint64_t> pairOffsets;
+  vector<uint32_t> partners;
+  vector<float> pairCounts;
+  vector<uint32_t> nbestOrder;
+
+  // The pairs must be sorted by phrase and partner
+  void fill(const vector<const vector<WordIndex>*>& phrases, const vector<float>& phraseCounts,
+            const vector<SidePair>& pairs)
+  {
+    wordOffsets.assign(1, 0);
+    for (size_t i = 0; i < phrases.size(); ++i)
+    {
+      words.insert(words.end(), phrases[i]->begin(), phrases[i]->end());
+      wordOffsets.push_back(words.size());
+    }
+    counts = phraseCounts;
+
+    pairOffsets.assign(phrases.size() + 1, 0);
+    partners.resize(pairs.size());
+    pairCounts.resize(pairs.size());
+    nbestOrder.resize(pairs.size());
+    size_t p = 0;
+    for (uint32_t i = 0; i < phrases.size(); ++i)
+    {
+      size_t begin = p;
+      pairOffsets[i] = begin;
+      for (; p < pairs.size() && pairs[p].phrase == i; ++p)
+      {
+        partners[p] = pairs[p].partner;
+        pairCounts[p] = pairs[p].count;
+        nbestOrder[p] = (uint32_t)(p - begin);
+      }
+      const float* blockCounts = pairCounts.data() + begin;
+      stable_sort(nbestOrder.begin() + begin, nbestOrder.begin() + p,
+                  [blockCounts](uint32_t k1, uint32_t k2) { return blockCounts[k1] > blockCounts[k2]; });
+    }
+    pairOffsets[phrases.size()] = p;
+  }
+
+  void write(ostream& out) const
+  {
+    writeArray(out, wordOffsets);
+    writeArray(out, words);
+    writeArray(out, counts);
+    writeArray(out, pairOffsets);
+    writeArray(out, partners);
+    writeArray(out, pairCounts);
+    writeArray(out, nbestOrder);
+  }
+};
+
+// Numbers the distinct phrases in lexicographic order, so that the indices follow the
+// order of a std::map. ids[k] receives the index of phrases[k] and lastPositions[i]
+// the position of the last occurrence of the phrase with index i
+void numberPhrases(const vector<const vector<WordIndex>*>& phrases, vector<uint32_t>& ids,
+                   vector<size_t>& lastPositions)
+{
+  vector<size_t> order(phrases.size());
+  for (size_t k = 0; k < order.size(); ++k)
+    order[k] = k;
+  stable_sort(order.begin(), order.end(), [&phrases](size_t k1, size_t k2) { return *phrases[k1] < *phrases[k2]; });
+
+  ids.assign(phrases.size(), 0);
+  lastPositions.clear();
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    if (i == 0 || *phrases[order[i - 1]] < *phrases[order[i]])
+      lastPositions.push_back(order[i]);
+    else
+      lastPositions.back() = order[i];
+    ids[order[i]] = (uint32_t)(lastPositions.size() - 1);
+  }
+}
+
+bool pairLess(const SidePair& p1, const SidePair& p2)
+{
+  return p1.phrase < p2.phrase || (p1.phrase == p2.phrase && p1.partner < p2.partner);
+}
+} // namespace
+
+//--------------- MmapPhraseTable
+
+MmapPhraseTable::MmapPhraseTable() : loaded{false}, numPairs{0}, src(), trg()
+{
+}
+
+bool MmapPhraseTable::load(const char* fileName, int verbose)
+{
+  if (verbose)
+    cerr << "Loading binary phrase table from " << fileName << endl;
+  shared_ptr<MappedFile> file = make_shared<MappedFile>();
+  if (file->open(fileName, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+  if (load(file, file->data(), file->size()) == THOT_ERROR)
+  {
+    if (verbose)
+      cerr << "Error: " << fileName << " is not a valid binary phrase table file" << endl;
+    return THOT_ERROR;
+  }
+  return THOT_OK;
+}
+
+bool MmapPhraseTable::load(const shared_ptr<MappedFile>& file, const char* image, std::size_t imageSize)
+{
+  clear();
+  if (attach(image, imageSize) == THOT_ERROR)
+  {
+    clear();
+    return THOT_ERROR;
+  }
+  mappedImage = file;
+  return THOT_OK;
+}
+
+bool MmapPhraseTable::attach(const char* image, std::size_t imageSize)
+{
+  if (imageSize < sizeof(Header))
+    return THOT_ERROR;
+  const Header* h = reinterpret_cast<const Header*>(image);
+  if (memcmp(h->magic, MMAP_PHRASE_TABLE_MAGIC, sizeof(h->magic)) != 0 || h->version != MMAP_PHRASE_TABLE_VERSION)
+    return THOT_ERROR;
+
+  size_t pos = alignedSize(sizeof(Header));
+  Side* sides[2] = {&src, &trg};
+  const SideHeader* sideHeaders[2] = {&h->src, &h->trg};
+  for (int i = 0; i < 2; ++i)
+  {
+    Side& side = *sides[i];
+    uint64_t n = sideHeaders[i]->numPhrases;
+    side.numPhrases = n;
+    if (n >= imageSize || !takeArray(image, imageSize, pos, n + 1, side.wordOffsets)
+        || !takeArray(image, imageSize, pos, sideHeaders[i]->numWords, side.words)
+        || !takeArray(image, imageSize, pos, n, side.counts)
+        || !takeArray(image, imageSize, pos, n + 1, side.pairOffsets)
+        || !takeArray(image, imageSize, pos, h->numPairs, side.partners)
+        || !takeArray(image, imageSize, pos, h->numPairs, side.pairCounts)
+        || !takeArray(image, imageSize, pos, h->numPairs, side.nbestOrder))
+      return THOT_ERROR;
+  }
+  // The arrays are checked once here, so that lookups can index them directly
+  if (!src.isValid(h->src.numWords, h->numPairs, trg.numPhrases)
+      || !trg.isValid(h->trg.numWords, h->numPairs, src.numPhrases))
+    return THOT_ERROR;
+  numPairs = h->numPairs;
+  loaded = true;
+  return THOT_OK;
+}
+
+bool MmapPhraseTable::isLoaded() const
+{
+  return loaded;
+}
+
+bool MmapPhraseTable::Side::isValid(uint64_t numWords, uint64_t numPairs, uint64_t numPartners) const
+{
+  if (wordOffsets[0] != 0 || wordOffsets[numPhrases] != numWords || pairOffsets[0] != 0
+      || pairOffsets[numPhrases] != numPairs)
+    return false;
+  for (uint64_t id = 0; id < numPhrases; ++id)
+  {
+    if (wordOffsets[id] > wordOffsets[id + 1] || pairOffsets[id] > pairOffsets[id + 1])
+      return false;
+    uint64_t blockSize = pairOffsets[id + 1] - pairOffsets[id];
+    for (uint64_t p = pairOffsets[id]; p < pairOffsets[id + 1]; ++p)
+    {
+      // Partners are sorted within a block, since pairs are found by binary search
+      if (partners[p] >= numPartners || (p > pairOffsets[id] && partners[p - 1] >= partners[p])
+          || nbestOrder[p] >= blockSize)
+        return false;
+    }
+  }
+  return true;
+}
+
+bool MmapPhraseTable::Side::find(const vector<WordIndex>& phrase, uint64_t& id) const
+{
+  uint64_t low = 0;
+  uint64_t high = numPhrases;
+  while (low < high)
+  {
+    uint64_t mid = low + (high - low) / 2;
+    if (lexicographical_compare(words + wordOffsets[mid], words + wordOffsets[mid + 1], phrase.begin(), phrase.end()))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if (low == numPhrases || wordOffsets[low + 1] - wordOffsets[low] != phrase.size()
+      || !equal(phrase.begin(), phrase.end(), words + wordOffsets[low]))
+    return false;
+  id = low;
+  return true;
+}
+
+bool MmapPhraseTable::Side::findPair(uint64_t id, uint32_t partner, uint64_t& pos) const
+{
+  const uint32_t* begin = partners + pairOffsets[id];
+  const uint32_t* end = partners + pairOffsets[id + 1];
+  const uint32_t* iter = lower_bound(begin, end, partner);
+  if (iter == end || *iter != partner)
+    return false;
+  pos = (uint64_t)(iter - partners);
+  return true;
+}
+
+void MmapPhraseTable::Side::getPhrase(uint64_t id, vector<WordIndex>& phrase) const
+{
+  phrase.assign(words + wordOffsets[id], words + wordOffsets[id + 1]);
+}
+
+void MmapPhraseTable::addTableEntry(const vector<WordIndex>&, const vector<WordIndex>&, PhrasePairInfo)
+{
+}
+
+void MmapPhraseTable::addSrcInfo(const vector<WordIndex>&, Count)
+{
+}
+
+void MmapPhraseTable::addSrcTrgInfo(const vector<WordIndex>&, const vector<WordIndex>&, Count)
+{
+}
+
+void MmapPhraseTable::incrCountsOfEntry(const vector<WordIndex>&, const vector<WordIndex>&, Count)
+{
+}
+
+PhrasePairInfo MmapPhraseTable::infSrcTrg(const vector<WordIndex>& s, const vector<WordIndex>& t, bool& found)
+{
+  PhrasePairInfo ppi;
+  ppi.first = getSrcInfo(s, found);
+  if (!found)
+    ppi.second = 0;
+  else
+    ppi.second = getSrcTrgInfo(s, t, found);
+  return ppi;
+}
+
+Count MmapPhraseTable::getSrcInfo(const vector<WordIndex>& s, bool& found)
+{
+  uint64_t srcId;
+  found = loaded && src.find(s, srcId);
+  return found ? src.counts[srcId] : 0;
+}
+
+Count MmapPhraseTable::getTrgInfo(const vector<WordIndex>& t, bool& found)
+{
+  uint64_t trgId;
+  found = loaded && trg.find(t, trgId);
+  return found ? trg.counts[trgId] : 0;
+}
+
+Count MmapPhraseTable::getSrcTrgInfo(const vector<WordIndex>& s, const vector<WordIndex>& t, bool& found)
+{
+  uint64_t srcId, trgId, pos;
+  found = loaded && src.find(s, srcId) && trg.find(t, trgId) && src.findPair(srcId, (uint32_t)trgId, pos);
+  return found ? src.pairCounts[pos] : 0;
+}
+
+Prob MmapPhraseTable::pTrgGivenSrc(const vector<WordIndex>& s, const vector<WordIndex>& t)
+{
+  Count st_count = cSrcTrg(s, t);
+  if ((float)st_count > 0)
+  {
+    Count s_count = cSrc(s);
+    if ((float)s_count > 0)
+      return ((float)st_count) / ((float)s_count);
+  }
+  return PHRASE_PROB_SMOOTH;
+}
+
+LgProb MmapPhraseTable::logpTrgGivenSrc(const vector<WordIndex>& s, const vector<WordIndex>& t)
+{
+  return log((double)pTrgGivenSrc(s, t));
+}
+
+Prob MmapPhraseTable::pSrcGivenTrg(const vector<WordIndex>& s, const vector<WordIndex>& t)
+{
+  Count st_count = cSrcTrg(s, t);
+  if ((float)st_count > 0)
+  {
+    Count t_count = cTrg(t);
+    if ((float)t_count > 0)
+      return ((float)st_count) / ((float)t_count);
+  }
+  return PHRASE_PROB_SMOOTH;
+}
+
+LgProb MmapPhraseTable::logpSrcGivenTrg(const vector<WordIndex>& s, const vector<WordIndex>& t)
+{
+  return log((double)pSrcGivenTrg(s, t));
+}
+
+bool MmapPhraseTable::getEntriesForTarget(const vector<WordIndex>& t, SrcTableNode& srctn)
+{
+  srctn.clear();
+  uint64_t trgId;
+  if (!loaded || !trg.find(t, trgId))
+    return false;
+
+  vector<WordIndex> s;
+  for (uint64_t p = trg.pairOffsets[trgId]; p < trg.pairOffsets[trgId + 1]; ++p)
+  {
+    PhrasePairInfo ppi;
+    ppi.first = src.counts[trg.partners[p]]; // s count
+    ppi.second = trg.pairCounts[p];          // (s, t) count
+    if (fabs(ppi.first.get_c_s()) < EPSILON || fabs(ppi.second.get_c_s()) < EPSILON)
+      continue;
+
+    src.getPhrase(trg.partners[p], s);
+    srctn.insert(make_pair(s, ppi));
+  }
+  return srctn.size();
+}
+
+bool MmapPhraseTable::getEntriesForSource(const vector<WordIndex>& s, TrgTableNode& trgtn)
+{
+  trgtn.clear();
+  uint64_t srcId;
+  if (!loaded || !src.find(s, srcId))
+    return false;
+
+  vector<WordIndex> t;
+  for (uint64_t p = src.pairOffsets[srcId]; p < src.pairOffsets[srcId + 1]; ++p)
+  {
+    PhrasePairInfo ppi;
+    ppi.first = trg.counts[src.partners[p]]; // t count
+    ppi.second = src.pairCounts[p];          // (s, t) count
+    if (fabs(ppi.first.get_c_s()) < EPSILON || fabs(ppi.second.get_c_s()) < EPSILON)
+      continue;
+
+    trg.getPhrase(src.partners[p], t);
+    trgtn.insert(make_pair(t, ppi));
+  }
+  return trgtn.size();
+}
+
+bool MmapPhraseTable::getNbestForSrc(const vector<WordIndex>& s, NbestTableNode<PhraseTransTableNodeData>& nbt)
+{
+  nbt.clear();
+  uint64_t srcId;
+  if (!loaded || !src.find(s, srcId))
+    return false;
+
+  // The blocks are already sorted by decreasing count, and pairs with the same count
+  // are inserted in the order of their phrases, which is the order of a stable sort
+  float s_count = src.counts[srcId];
+  uint64_t begin = src.pairOffsets[srcId];
+  vector<WordIndex> t;
+  for (uint64_t p = begin; p < src.pairOffsets[srcId + 1]; ++p)
+  {
+    uint64_t pos = begin + src.nbestOrder[p];
+    if (src.pairCounts[pos] < EPSILON || trg.counts[src.partners[pos]] < EPSILON)
+      continue;
+    trg.getPhrase(src.partners[pos], t);
+    nbt.insert(log(src.pairCounts[pos] / s_count), t);
+  }
+  return nbt.size() > 0;
+}
+
+bool MmapPhraseTable::getNbestForTrg(const vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt,
+                                     int N)
+{
+  nbt.clear();
+  uint64_t trgId;
+  if (!loaded || !trg.find(t, trgId))
+    return false;
+
+  // The block is sorted, so reading stops after the first N pairs
+  float t_count = trg.counts[trgId];
+  uint64_t begin = trg.pairOffsets[trgId];
+  vector<WordIndex> s;
+  bool found = false;
+  for (uint64_t p = begin; p < trg.pairOffsets[trgId + 1]; ++p)
+  {
+    uint64_t pos = begin + trg.nbestOrder[p];
+    if (trg.pairCounts[pos] < EPSILON || src.counts[trg.partners[pos]] < EPSILON)
+      continue;
+    found = true;
+    if (N >= 0 && nbt.size() >= (unsigned int)N)
+      break;
+    src.getPhrase(trg.partners[pos], s);
+    nbt.insert(log(trg.pairCounts[pos] / t_count), s);
+  }
+  return found;
+}
+
+Count MmapPhraseTable::cSrcTrg(const vector<WordIndex>& s, const vector<WordIndex>& t)
+{
+  bool found;
+  return getSrcTrgInfo(s, t, found).get_c_st();
+}
+
+Count MmapPhraseTable::cSrc(const vector<WordIndex>& s)
+{
+  bool found;
+  return getSrcInfo(s, found).get_c_s();
+}
+
+Count MmapPhraseTable::cTrg(const vector<WordIndex>& t)
+{
+  bool found;
+  return getTrgInfo(t, found).get_c_st();
+}
+
+uint64_t MmapPhraseTable::getNumTrgPhrases() const
+{
+  return loaded ? trg.numPhrases : 0;
+}
+
+void MmapPhraseTable::getTrgPhraseAt(uint64_t index, vector<WordIndex>& t) const
+{
+  if (index >= getNumTrgPhrases())
+  {
+    t.clear();
+    return;
+  }
+  trg.getPhrase(index, t);
+}
+
+size_t MmapPhraseTable::size()
+{
+  return loaded ? (size_t)(src.numPhrases + trg.numPhrases + numPairs) : 0;
+}
+
+void MmapPhraseTable::clear()
+{
+  mappedImage.reset();
+  loaded = false;
+  numPairs = 0;
+  src = Side();
+  trg = Side();
+  clearPhraseIds();
+}
+
+//--------------- MmapPhraseTableBuilder
+
+void MmapPhraseTableBuilder::addTableEntry(const vector<WordIndex>& s, const vector<WordIndex>& t,
+                                           PhrasePairInfo inf)
+{
+  Entry entry;
+  entry.s = s;
+  entry.t = t;
+  entry.srcCount = inf.first.get_c_s();
+  entry.pairCount = inf.second.get_c_st();
+  entries.push_back(entry);
+}
+
+std::size_t MmapPhraseTableBuilder::numEntries() const
+{
+  return entries.size();
+}
+
+bool MmapPhraseTableBuilder::print(const char* fileName) const
+{
+  ofstream outF(fileName, ios::out | ios::binary);
+  if (!outF)
+  {
+    cerr << "Error while printing binary phrase table." << endl;
+    return THOT_ERROR;
+  }
+  return print(outF);
+}
+
+bool MmapPhraseTableBuilder::print(ostream& out) const
+{
+  vector<const vector<WordIndex>*> srcPhrases(entries.size());
+  vector<const vector<WordIndex>*> trgPhrases(entries.size());
+  for (size_t k = 0; k < entries.size(); ++k)
+  {
+    srcPhrases[k] = &entries[k].s;
+    trgPhrases[k] = &entries[k].t;
+  }
+  vector<uint32_t> srcIds, trgIds;
+  vector<size_t> srcLastPositions, trgLastPositions;
+  numberPhrases(srcPhrases, srcIds, srcLastPositions);
+  numberPhrases(trgPhrases, trgIds, trgLastPositions);
+
+  vector<const vector<WordIndex>*> srcPhraseList(srcLastPositions.size());
+  vector<float> srcCounts(srcLastPositions.size());
+  for (size_t i = 0; i < srcLastPositions.size(); ++i)
+  {
+    srcPhraseList[i] = &entries[srcLastPositions[i]].s;
+    srcCounts[i] = entries[srcLastPositions[i]].srcCount;
+  }
+  vector<const vector<WordIndex>*> trgPhraseList(trgLastPositions.size());
+  vector<float> trgCounts(trgLastPositions.size(), 0);
+  for (size_t i = 0; i < trgLastPositions.size(); ++i)
+    trgPhraseList[i] = &entries[trgLastPositions[i]].t;
+  for (size_t k = 0; k < entries.size(); ++k)
+    trgCounts[trgIds[k]] += entries[k].pairCount;
+
+  // Keep the last count given for every pair
+  vector<SidePair> srcPairs(entries.size());
+  for (size_t k = 0; k < entries.size(); ++k)
+  {
+    srcPairs[k].phrase = srcIds[k];
+    srcPairs[k].partner = trgIds[k];
+    srcPairs[k].count = entries[k].pairCount;
+  }
+  stable_sort(srcPairs.begin(), srcPairs.end(), pairLess);
+  size_t numPairs = 0;
+  for (size_t k = 0; k < srcPairs.size(); ++k)
+  {
+    if (numPairs > 0 && srcPairs[numPairs - 1].phrase == srcPairs[k].phrase
+        && srcPairs[numPairs - 1].partner == srcPairs[k].partner)
+      srcPairs[numPairs - 1] = srcPairs[k];
+    else
+      srcPairs[numPairs++] = srcPairs[k];
+  }
+  srcPairs.resize(numPairs);
+
+  vector<SidePair> trgPairs(numPairs);
+  for (size_t k = 0; k < numPairs; ++k)
+  {
+    trgPairs[k].phrase = srcPairs[k].partner;
+    trgPairs[k].partner = srcPairs[k].phrase;
+    trgPairs[k].count = srcPairs[k].count;
+  }
+  sort(trgPairs.begin(), trgPairs.end(), pairLess);
+
+  SideArrays srcArrays, trgArrays;
+  srcArrays.fill(srcPhraseList, srcCounts, srcPairs);
+  trgArrays.fill(trgPhraseList, trgCounts, trgPairs);
+
+  Header h;
+  memset(&h, 0, sizeof(Header));
+  memcpy(h.magic, MMAP_PHRASE_TABLE_MAGIC, sizeof(h.magic));
+  h.version = MMAP_PHRASE_TABLE_VERSION;
+  h.numPairs = numPairs;
+  h.src.numPhrases = srcPhraseList.size();
+  h.src.numWords = srcArrays.words.size();
+  h.trg.numPhrases = trgPhraseList.size();
+  h.trg.numWords = trgArrays.words.size();
+  static const char zeros[8] = {0};
+  out.write(reinterpret_cast<const char*>(&h), sizeof(Header));
+  out.write(zeros, alignedSize(sizeof(Header)) - sizeof(Header));
+  srcArrays.write(out);
+  trgArrays.write(out);
+  return out ? THOT_OK : THOT_ERROR;
+}
+
+void MmapPhraseTableBuilder::clear()
+{
+  entries.clear();
+}
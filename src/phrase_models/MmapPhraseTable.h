@@ -0,0 +1,120 @@
+#pragma once
+
+#include "nlp_common/MappedFile.h"
+#include "phrase_models/BasePhraseTable.h"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// Read-only phrase table. The in-memory image has the same layout as the file
+// written by MmapPhraseTableBuilder, so load() maps the file instead of parsing it
+// and its pages are shared by all the processes that use the same table.
+//
+// The source and the target phrases are kept in two sorted arrays. Every phrase
+// points to a contiguous block with the pairs it belongs to, sorted by the index of
+// the phrase on the other side so that a pair is found by binary search, and to the
+// order of the block by decreasing count, so n-best lists are filled without
+// sorting. The functions that modify the table have no effect.
+class MmapPhraseTable : public BasePhraseTable
+{
+public:
+  MmapPhraseTable();
+  MmapPhraseTable(const MmapPhraseTable&) = delete;
+  MmapPhraseTable& operator=(const MmapPhraseTable&) = delete;
+
+  bool load(const char* fileName, int verbose = 0);
+  // Uses an image stored inside a mapped file, which is kept open
+  bool load(const std::shared_ptr<MappedFile>& file, const char* image, std::size_t imageSize);
+  bool isLoaded() const;
+
+  void addTableEntry(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, PhrasePairInfo inf) override;
+  void addSrcInfo(const std::vector<WordIndex>& s, Count s_inf) override;
+  void addSrcTrgInfo(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, Count st_inf) override;
+  void incrCountsOfEntry(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, Count c) override;
+
+  PhrasePairInfo infSrcTrg(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, bool& found) override;
+  Count getSrcInfo(const std::vector<WordIndex>& s, bool& found) override;
+  Count getSrcTrgInfo(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, bool& found) override;
+  Prob pTrgGivenSrc(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) override;
+  LgProb logpTrgGivenSrc(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) override;
+  Prob pSrcGivenTrg(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) override;
+  LgProb logpSrcGivenTrg(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) override;
+  bool getEntriesForTarget(const std::vector<WordIndex>& t, SrcTableNode& srctn) override;
+  bool getEntriesForSource(const std::vector<WordIndex>& s, TrgTableNode& trgtn) override;
+  bool getNbestForSrc(const std::vector<WordIndex>& s, NbestTableNode<PhraseTransTableNodeData>& nbt) override;
+  bool getNbestForTrg(const std::vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt,
+                      int N = -1) override;
+
+  Count cSrcTrg(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t) override;
+  Count cSrc(const std::vector<WordIndex>& s) override;
+  Count cTrg(const std::vector<WordIndex>& t) override;
+
+  // Target phrases in lexicographic order, to go through the whole table. An index out
+  // of range gives an empty phrase
+  uint64_t getNumTrgPhrases() const;
+  void getTrgPhraseAt(uint64_t index, std::vector<WordIndex>& t) const;
+
+  // Returns the number of source phrases, target phrases and phrase pairs
+  size_t size() override;
+  void clear() override;
+
+private:
+  // Phrases of one language and the blocks of the pairs they belong to
+  struct Side
+  {
+    uint64_t numPhrases;
+    const uint64_t* wordOffsets;
+    const WordIndex* words;
+    const float* counts;
+    const uint64_t* pairOffsets;
+    // Index of the phrase on the other side of each pair
+    const uint32_t* partners;
+    const float* pairCounts;
+    // Positions in its block of the pairs of each phrase by decreasing count
+    const uint32_t* nbestOrder;
+
+    // Checks that offsets, partners and n-best positions stay within the arrays
+    bool isValid(uint64_t numWords, uint64_t numPairs, uint64_t numPartners) const;
+    bool find(const std::vector<WordIndex>& phrase, uint64_t& id) const;
+    bool findPair(uint64_t id, uint32_t partner, uint64_t& pos) const;
+    void getPhrase(uint64_t id, std::vector<WordIndex>& phrase) const;
+  };
+
+  bool attach(const char* image, std::size_t imageSize);
+  Count getTrgInfo(const std::vector<WordIndex>& t, bool& found);
+
+  std::shared_ptr<MappedFile> mappedImage;
+  bool loaded;
+  uint64_t numPairs;
+  Side src;
+  Side trg;
+};
+
+// Collects the entries of a phrase table and writes them in the format read by
+// MmapPhraseTable. Entries are merged as BasePhraseTable::addTableEntry() does:
+// the last counts given for a source phrase and for a pair are kept, and the count
+// of a target phrase is the sum of the pair counts given for it.
+class MmapPhraseTableBuilder
+{
+public:
+  void addTableEntry(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, PhrasePairInfo inf);
+  std::size_t numEntries() const;
+
+  bool print(const char* fileName) const;
+  bool print(std::ostream& out) const;
+
+  void clear();
+
+private:
+  struct Entry
+  {
+    std::vector<WordIndex> s;
+    std::vector<WordIndex> t;
+    float srcCount;
+    float pairCount;
+  };
+
+  std::vector<Entry> entries;
+};
@@ -20,7 +20,29 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 //--------------- Include files --------------------------------------
 
+#include <cstdint>
+
 //--------------- typedefs -------------------------------------------
 
-typedef unsigned int PhraseId;
+typedef uint32_t PhraseId;
+
+// Identifies a phrase pair by the ids of its source and target phrases
+typedef uint64_t PhrasePairId;
+
+//--------------- function declarations ------------------------------
+
+inline PhrasePairId makePhrasePairId(PhraseId srcId, PhraseId trgId)
+{
+  return ((PhrasePairId)srcId << 32) | trgId;
+}
+
+inline PhraseId phrasePairSrcId(PhrasePairId pairId)
+{
+  return (PhraseId)(pairId >> 32);
+}
+
+inline PhraseId phrasePairTrgId(PhrasePairId pairId)
+{
+  return (PhraseId)pairId;
+}
 
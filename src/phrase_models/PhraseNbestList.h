@@ -0,0 +1,71 @@
+#pragma once
+
+#include "nlp_common/NbestTableNode.h"
+#include "nlp_common/Score.h"
+#include "phrase_models/PhraseTransTableNodeData.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Translations of a phrase sorted by decreasing score
+typedef std::vector<std::pair<Score, PhraseTransTableNodeData>> PhraseNbestList;
+
+// Read-only view of the first entries of an n-best list. The view shares the list,
+// so it stays valid when the table that built it drops the list from its cache
+class PhraseNbestListView
+{
+public:
+  typedef PhraseNbestList::const_iterator const_iterator;
+
+  PhraseNbestListView() : count{0}
+  {
+  }
+  // A negative N keeps the whole list
+  PhraseNbestListView(std::shared_ptr<const PhraseNbestList> list, int N = -1) : list{std::move(list)}, count{0}
+  {
+    if (this->list)
+      count = N < 0 ? this->list->size() : std::min((std::size_t)N, this->list->size());
+  }
+
+  const_iterator begin() const
+  {
+    return list ? list->begin() : const_iterator();
+  }
+  const_iterator end() const
+  {
+    return list ? list->begin() + count : const_iterator();
+  }
+  std::size_t size() const
+  {
+    return count;
+  }
+  bool empty() const
+  {
+    return count == 0;
+  }
+
+  // Copies the entries of the view into nbt
+  void copyTo(NbestTableNode<PhraseTransTableNodeData>& nbt) const
+  {
+    nbt.clear();
+    for (const_iterator iter = begin(); iter != end(); ++iter)
+      nbt.insert(iter->first, iter->second);
+  }
+
+  // Builds a list from an n-best table node
+  static std::shared_ptr<const PhraseNbestList> makeList(NbestTableNode<PhraseTransTableNodeData>& nbt)
+  {
+    std::shared_ptr<PhraseNbestList> list = std::make_shared<PhraseNbestList>();
+    list->reserve(nbt.size());
+    for (NbestTableNode<PhraseTransTableNodeData>::iterator iter = nbt.begin(); iter != nbt.end(); ++iter)
+      list->push_back(std::make_pair(iter->first, iter->second));
+    return list;
+  }
+
+private:
+  std::shared_ptr<const PhraseNbestList> list;
+  std::size_t count;
+};
@@ -0,0 +1,142 @@
+#include "phrase_models/PhraseTablePruner.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+double logBinomial(double n, double k)
+{
+  return lgamma(n + 1) - lgamma(k + 1) - lgamma(n - k + 1);
+}
+} // namespace
+
+size_t PhraseTablePruningStats::numPruned() const
+{
+  return numPrunedByCount + numPrunedBySignificance + numPrunedByRank;
+}
+
+void PhraseTablePruningStats::print(ostream& out) const
+{
+  out << "Pruned " << numPruned() << " of " << numPairs << " phrase pairs (count: " << numPrunedByCount
+      << ", significance: " << numPrunedBySignificance << ", rank: " << numPrunedByRank << ")" << endl;
+  if (numCountsAboveSentencePairs > 0)
+    out << "Warning: " << numCountsAboveSentencePairs
+        << " phrase pairs have phrase counts above the number of sentence pairs, their significance is approximate"
+        << endl;
+}
+
+PhraseTablePruner::PhraseTablePruner()
+{
+}
+
+PhraseTablePruner::PhraseTablePruner(const PhraseTablePruningParameters& params) : params{params}
+{
+}
+
+void PhraseTablePruner::setParameters(const PhraseTablePruningParameters& params)
+{
+  this->params = params;
+}
+
+const PhraseTablePruningParameters& PhraseTablePruner::getParameters() const
+{
+  return params;
+}
+
+bool PhraseTablePruner::isEnabled() const
+{
+  return params.maxTrgPhrasesPerSrc > 0 || params.minPairCount > 0 || needsTrgCounts();
+}
+
+bool PhraseTablePruner::hasValidParameters() const
+{
+  return params.minSignificance <= 0 || params.numSentencePairs > 0;
+}
+
+bool PhraseTablePruner::needsTrgCounts() const
+{
+  return params.minSignificance > 0 && params.numSentencePairs > 0;
+}
+
+void PhraseTablePruner::pruneSrcPhrase(float srcCount, const vector<float>& pairCounts,
+                                       const vector<float>& trgCounts, vector<bool>& keep)
+{
+  keep.assign(pairCounts.size(), true);
+  stats.numPairs += pairCounts.size();
+
+  vector<size_t> kept;
+  for (size_t k = 0; k < pairCounts.size(); ++k)
+  {
+    if (pairCounts[k] < params.minPairCount)
+    {
+      keep[k] = false;
+      ++stats.numPrunedByCount;
+    }
+    else if (needsTrgCounts() && !isSignificant(pairCounts[k], srcCount, trgCounts[k]))
+    {
+      keep[k] = false;
+      ++stats.numPrunedBySignificance;
+    }
+    else
+    {
+      kept.push_back(k);
+    }
+  }
+
+  // All the pairs share the source count, so they are ranked by p(t|s) through their
+  // own counts
+  if (params.maxTrgPhrasesPerSrc > 0 && kept.size() > params.maxTrgPhrasesPerSrc)
+  {
+    stable_sort(kept.begin(), kept.end(),
+                [&pairCounts](size_t k1, size_t k2) { return pairCounts[k1] > pairCounts[k2]; });
+    for (size_t i = params.maxTrgPhrasesPerSrc; i < kept.size(); ++i)
+      keep[kept[i]] = false;
+    stats.numPrunedByRank += kept.size() - params.maxTrgPhrasesPerSrc;
+  }
+}
+
+bool PhraseTablePruner::isSignificant(float pairCount, float srcCount, float trgCount)
+{
+  double numSentencePairs = (double)params.numSentencePairs;
+  if (srcCount > numSentencePairs || trgCount > numSentencePairs)
+    ++stats.numCountsAboveSentencePairs;
+  return fisherSignificance(pairCount, srcCount, trgCount, numSentencePairs) >= params.minSignificance;
+}
+
+const PhraseTablePruningStats& PhraseTablePruner::getStats() const
+{
+  return stats;
+}
+
+void PhraseTablePruner::clearStats()
+{
+  stats = PhraseTablePruningStats();
+}
+
+double fisherSignificance(double pairCount, double srcCount, double trgCount, double numSentencePairs)
+{
+  double a = round(pairCount);
+  double cs = max(round(srcCount), a);
+  double ct = max(round(trgCount), a);
+  double n = max(round(numSentencePairs), cs + ct - a);
+  if (a <= 0 || a <= cs * ct / n)
+    return 0;
+
+  // The p-value adds up the probabilities of the tables with at least a
+  // co-occurrences, every term is obtained from the previous one
+  double logFirst = logBinomial(cs, a) + logBinomial(n - cs, ct - a) - logBinomial(n, ct);
+  double sum = 1;
+  double term = 1;
+  double maxCooc = min(cs, ct);
+  for (double k = a; k < maxCooc; ++k)
+  {
+    term *= (cs - k) * (ct - k) / ((k + 1) * (n - cs - ct + k + 1));
+    sum += term;
+    if (term < sum * 1e-15)
+      break;
+  }
+  return max(0.0, -(logFirst + log(sum)));
+}
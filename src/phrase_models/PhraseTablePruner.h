@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+struct PhraseTablePruningParameters
+{
+  // Maximum number of target phrases kept for every source phrase, the ones with the
+  // highest p(t|s) are kept. Zero keeps all of them
+  unsigned int maxTrgPhrasesPerSrc = 0;
+  // Pairs with a lower count are removed
+  float minPairCount = 0;
+  // Pairs whose significance, the negative natural logarithm of the p-value of
+  // Fisher's exact test on the co-occurrence of their phrases, is lower are removed.
+  // Johnson et al. (2007) use log(numSentencePairs) + epsilon, which removes the
+  // pairs whose phrases occur once and together. Zero disables the test.
+  //
+  // The test is an approximation of theirs: Johnson et al. count the sentence pairs
+  // in which the phrases occur, while the phrase table only has the counts of the
+  // extracted pairs, so c(s), c(t) and c(s,t) stand for them. A phrase extracted
+  // more than once from a sentence pair counts more than once, and its count can
+  // exceed numSentencePairs; the pruning stats report how many pairs it affects
+  double minSignificance = 0;
+  // Number of sentence pairs the counts come from, required by the significance test
+  std::size_t numSentencePairs = 0;
+};
+
+struct PhraseTablePruningStats
+{
+  std::size_t numPairs = 0;
+  std::size_t numPrunedByCount = 0;
+  std::size_t numPrunedBySignificance = 0;
+  std::size_t numPrunedByRank = 0;
+  // Pairs tested for significance whose source or target count exceeds the number of
+  // sentence pairs, see PhraseTablePruningParameters::minSignificance
+  std::size_t numCountsAboveSentencePairs = 0;
+
+  std::size_t numPruned() const;
+  void print(std::ostream& out) const;
+};
+
+// Decides which phrase pairs of a table are kept. The pairs are given grouped by
+// source phrase; the count threshold and the significance test are applied first
+// and the highest ranked of the remaining pairs are kept
+class PhraseTablePruner
+{
+public:
+  PhraseTablePruner();
+  PhraseTablePruner(const PhraseTablePruningParameters& params);
+
+  void setParameters(const PhraseTablePruningParameters& params);
+  const PhraseTablePruningParameters& getParameters() const;
+  bool isEnabled() const;
+  // False if the significance test is enabled without the number of sentence pairs,
+  // the tables refuse to prune with such parameters
+  bool hasValidParameters() const;
+  // The significance test needs the count of every target phrase
+  bool needsTrgCounts() const;
+
+  // keep[k] receives whether the k-th pair of a source phrase is kept. trgCounts is
+  // not used if needsTrgCounts() is false
+  void pruneSrcPhrase(float srcCount, const std::vector<float>& pairCounts, const std::vector<float>& trgCounts,
+                      std::vector<bool>& keep);
+
+  const PhraseTablePruningStats& getStats() const;
+  void clearStats();
+
+private:
+  bool isSignificant(float pairCount, float srcCount, float trgCount);
+
+  PhraseTablePruningParameters params;
+  PhraseTablePruningStats stats;
+};
+
+// Negative natural logarithm of the one-sided p-value of Fisher's exact test for two
+// phrases that occur together pairCount times and srcCount and trgCount times in
+// total, in numSentencePairs sentence pairs. Counts are rounded to integers. Phrases
+// that do not occur together more often than expected by chance get zero. Counts
+// that do not fit in numSentencePairs are clamped so that the test is defined
+double fisherSignificance(double pairCount, double srcCount, double trgCount, double numSentencePairs);
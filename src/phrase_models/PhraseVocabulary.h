@@ -0,0 +1,97 @@
+#pragma once
+
+#include "nlp_common/WordIndex.h"
+#include "phrase_models/PhraseId.h"
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template <typename Word>
+struct PhraseHash
+{
+  std::size_t operator()(const std::vector<Word>& phrase) const
+  {
+    std::hash<Word> wordHash;
+    std::size_t h = phrase.size();
+    for (const Word& word : phrase)
+      h ^= wordHash(word) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+  }
+};
+
+// Interns phrases into consecutive ids starting at zero. Every phrase is stored once
+// and its id stays valid until clear() is called. Tables and caches can then key on
+// ids, which are cheaper to hash and compare than the phrases themselves
+template <typename Word>
+class BasicPhraseVocabulary
+{
+public:
+  typedef std::vector<Word> Phrase;
+
+  BasicPhraseVocabulary()
+  {
+  }
+  // The phrase list points to the keys of the id table, so copies add the phrases again
+  BasicPhraseVocabulary(const BasicPhraseVocabulary& other)
+  {
+    for (const Phrase* phrase : other.phrases)
+      add(*phrase);
+  }
+  BasicPhraseVocabulary& operator=(const BasicPhraseVocabulary& other)
+  {
+    if (this != &other)
+    {
+      clear();
+      for (const Phrase* phrase : other.phrases)
+        add(*phrase);
+    }
+    return *this;
+  }
+  BasicPhraseVocabulary(BasicPhraseVocabulary&&) = default;
+  BasicPhraseVocabulary& operator=(BasicPhraseVocabulary&&) = default;
+
+  // Returns the id of the phrase, adding it if it is not in the vocabulary
+  PhraseId add(const Phrase& phrase)
+  {
+    std::pair<typename IdMap::iterator, bool> result = ids.insert(std::make_pair(phrase, (PhraseId)phrases.size()));
+    if (result.second)
+      phrases.push_back(&result.first->first);
+    return result.first->second;
+  }
+
+  bool find(const Phrase& phrase, PhraseId& id) const
+  {
+    typename IdMap::const_iterator iter = ids.find(phrase);
+    if (iter == ids.end())
+      return false;
+    id = iter->second;
+    return true;
+  }
+
+  const Phrase& getPhrase(PhraseId id) const
+  {
+    return *phrases[id];
+  }
+
+  std::size_t size() const
+  {
+    return phrases.size();
+  }
+
+  void clear()
+  {
+    ids.clear();
+    phrases.clear();
+  }
+
+private:
+  typedef std::unordered_map<Phrase, PhraseId, PhraseHash<Word>> IdMap;
+
+  IdMap ids;
+  std::vector<const Phrase*> phrases;
+};
+
+typedef BasicPhraseVocabulary<WordIndex> PhraseVocabulary;
@@ -0,0 +1,306 @@
+#include "phrase_models/PlainTextPhraseTableReader.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/MappedFile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <omp.h>
+
+using namespace std;
+
+namespace
+{
+const size_t DEFAULT_ROUND_SIZE = (size_t)256 << 20;
+// Chunks of a round for every thread, so that threads that are done early take over
+// part of the work of the others
+const int CHUNKS_PER_THREAD = 4;
+
+struct WordView
+{
+  const char* data;
+  size_t length;
+
+  bool operator==(const WordView& other) const
+  {
+    return length == other.length && memcmp(data, other.data, length) == 0;
+  }
+
+  bool equals(const char* str) const
+  {
+    return length == strlen(str) && memcmp(data, str, length) == 0;
+  }
+};
+
+struct WordViewHash
+{
+  size_t operator()(const WordView& word) const
+  {
+    // FNV-1a
+    size_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < word.length; ++i)
+    {
+      h ^= (unsigned char)word.data[i];
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+};
+
+class ChunkVocab
+{
+public:
+  WordIndex add(const WordView& word)
+  {
+    pair<unordered_map<WordView, WordIndex, WordViewHash>::iterator, bool> result =
+        ids.insert(make_pair(word, (WordIndex)words.size()));
+    if (result.second)
+      words.push_back(word);
+    return result.first->second;
+  }
+
+  const vector<WordView>& getWords() const
+  {
+    return words;
+  }
+
+private:
+  unordered_map<WordView, WordIndex, WordViewHash> ids;
+  vector<WordView> words;
+};
+
+struct ChunkEntry
+{
+  unsigned int srcLength;
+  unsigned int trgLength;
+  float srcCount;
+  float pairCount;
+};
+
+// Entries of a part of the file, with the words numbered by the vocabularies of the
+// chunk
+class Chunk
+{
+public:
+  Chunk() : numLines{0}
+  {
+  }
+
+  void parse(const char* begin, const char* end)
+  {
+    vector<WordView> fields;
+    const char* line = begin;
+    while (line < end)
+    {
+      const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+      if (lineEnd == NULL)
+        lineEnd = end;
+      split(line, lineEnd, fields);
+      if (fields.size() > 1 && !addEntry(fields))
+        invalidLines.push_back(numLines);
+      ++numLines;
+      line = lineEnd + 1;
+    }
+  }
+
+  ChunkVocab srcVocab;
+  ChunkVocab trgVocab;
+  // Source words followed by target words of every entry
+  vector<WordIndex> words;
+  vector<ChunkEntry> entries;
+  // Line numbers within the chunk, starting at zero
+  vector<size_t> invalidLines;
+  size_t numLines;
+
+private:
+  static void split(const char* line, const char* lineEnd, vector<WordView>& fields)
+  {
+    fields.clear();
+    const char* p = line;
+    while (p < lineEnd)
+    {
+      while (p < lineEnd && *p == ' ')
+        ++p;
+      const char* fieldBegin = p;
+      while (p < lineEnd && *p != ' ')
+        ++p;
+      if (p > fieldBegin)
+        fields.push_back(WordView{fieldBegin, (size_t)(p - fieldBegin)});
+    }
+  }
+
+  static float parseCount(const WordView& field)
+  {
+    char buffer[64];
+    size_t length = min(field.length, sizeof(buffer) - 1);
+    memcpy(buffer, field.data, length);
+    buffer[length] = '\0';
+    return (float)atof(buffer);
+  }
+
+  bool addEntry(const vector<WordView>& fields)
+  {
+    size_t srcEnd = 0;
+    while (srcEnd < fields.size() && !fields[srcEnd].equals("|||"))
+      ++srcEnd;
+    size_t trgEnd = srcEnd + 1;
+    while (trgEnd < fields.size() && !fields[trgEnd].equals("|||"))
+      ++trgEnd;
+    if (srcEnd == 0 || trgEnd == srcEnd + 1 || trgEnd + 2 >= fields.size())
+      return false;
+
+    for (size_t i = 0; i < srcEnd; ++i)
+      words.push_back(srcVocab.add(fields[i]));
+    for (size_t i = srcEnd + 1; i < trgEnd; ++i)
+      words.push_back(trgVocab.add(fields[i]));
+    entries.push_back(ChunkEntry{(unsigned int)srcEnd, (unsigned int)(trgEnd - srcEnd - 1),
+                                 parseCount(fields[trgEnd + 1]), parseCount(fields[trgEnd + 2])});
+    return true;
+  }
+};
+
+// Returns the position that follows the end of the line that contains pos
+const char* nextLine(const char* pos, const char* end)
+{
+  if (pos >= end)
+    return end;
+  const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', end - pos));
+  return lineEnd == NULL ? end : lineEnd + 1;
+}
+} // namespace
+
+PlainTextPhraseTableReader::PlainTextPhraseTableReader() : roundSize{DEFAULT_ROUND_SIZE}
+{
+}
+
+void PlainTextPhraseTableReader::setRoundSize(size_t bytes)
+{
+  roundSize = max(bytes, (size_t)1);
+}
+
+size_t PlainTextPhraseTableReader::getRoundSize() const
+{
+  return roundSize;
+}
+
+bool PlainTextPhraseTableReader::read(const char* fileName, const EntryFunction& addEntry, int verbose)
+{
+  MappedFile file;
+  if (file.open(fileName) == THOT_ERROR)
+  {
+    if (verbose)
+      cerr << "Error in phrase model file: " << fileName << endl;
+    return THOT_ERROR;
+  }
+
+  const char* fileEnd = file.data() + file.size();
+  int numChunks = omp_get_max_threads() * CHUNKS_PER_THREAD;
+  vector<const char*> bounds(numChunks + 1);
+  vector<WordIndex> srcIndices, trgIndices;
+  vector<WordIndex> s, t;
+  size_t lineNumber = 1;
+  for (const char* roundBegin = file.data(); roundBegin < fileEnd;)
+  {
+    const char* roundEnd = nextLine(roundBegin + min(roundSize, (size_t)(fileEnd - roundBegin)) - 1, fileEnd);
+    bounds[0] = roundBegin;
+    for (int k = 1; k < numChunks; ++k)
+    {
+      const char* target = roundBegin + (roundEnd - roundBegin) * k / numChunks;
+      bounds[k] = max(bounds[k - 1], target > roundBegin ? nextLine(target - 1, roundEnd) : roundBegin);
+    }
+    bounds[numChunks] = roundEnd;
+
+    vector<Chunk> chunks(numChunks);
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < numChunks; ++k)
+      chunks[k].parse(bounds[k], bounds[k + 1]);
+
+    // Merge the chunks in file order
+    for (const Chunk& chunk : chunks)
+    {
+      srcIndices.clear();
+      for (const WordView& word : chunk.srcVocab.getWords())
+        srcIndices.push_back(srcVocab.add(word.data, word.length));
+      trgIndices.clear();
+      for (const WordView& word : chunk.trgVocab.getWords())
+        trgIndices.push_back(trgVocab.add(word.data, word.length));
+
+      if (verbose)
+      {
+        for (size_t line : chunk.invalidLines)
+          cerr << "Warning: discarding anomalous phrase table entry at line " << lineNumber + line << endl;
+      }
+
+      size_t pos = 0;
+      for (const ChunkEntry& entry : chunk.entries)
+      {
+        s.resize(entry.srcLength);
+        for (WordIndex& w : s)
+          w = srcIndices[chunk.words[pos++]];
+        t.resize(entry.trgLength);
+        for (WordIndex& w : t)
+          w = trgIndices[chunk.words[pos++]];
+        PhrasePairInfo inf;
+        inf.first = entry.srcCount;
+        inf.second = entry.pairCount;
+        addEntry(s, t, inf);
+      }
+      lineNumber += chunk.numLines;
+    }
+    roundBegin = roundEnd;
+  }
+  return THOT_OK;
+}
+
+const string& PlainTextPhraseTableReader::getSrcWord(WordIndex w) const
+{
+  return srcVocab.getWord(w);
+}
+
+size_t PlainTextPhraseTableReader::getSrcVocabSize() const
+{
+  return srcVocab.size();
+}
+
+const string& PlainTextPhraseTableReader::getTrgWord(WordIndex w) const
+{
+  return trgVocab.getWord(w);
+}
+
+size_t PlainTextPhraseTableReader::getTrgVocabSize() const
+{
+  return trgVocab.size();
+}
+
+void PlainTextPhraseTableReader::clear()
+{
+  srcVocab.clear();
+  trgVocab.clear();
+}
+
+WordIndex PlainTextPhraseTableReader::Vocab::add(const char* word, size_t length)
+{
+  pair<unordered_map<string, WordIndex>::iterator, bool> result =
+      ids.insert(make_pair(string(word, length), (WordIndex)words.size()));
+  if (result.second)
+    words.push_back(result.first->first);
+  return result.first->second;
+}
+
+const string& PlainTextPhraseTableReader::Vocab::getWord(WordIndex w) const
+{
+  return words[w];
+}
+
+size_t PlainTextPhraseTableReader::Vocab::size() const
+{
+  return words.size();
+}
+
+void PlainTextPhraseTableReader::Vocab::clear()
+{
+  ids.clear();
+  words.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "nlp_common/WordIndex.h"
+#include "phrase_models/PhrasePairInfo.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reads a phrase table in the plain text format written by
+// _incrPhraseModel::printPhraseTable(), one "s ||| t ||| c_s c_st" entry per line.
+//
+// The file is mapped into memory and read in rounds. Every round is split into
+// line-aligned chunks that are parsed in parallel; the words of a chunk are kept as
+// views into the file and numbered by a vocabulary of the chunk. The chunks are then
+// merged in file order, so entries are passed on in the order of the file and words
+// are numbered in the order of their first occurrence in a valid entry.
+class PlainTextPhraseTableReader
+{
+public:
+  // The words of the phrases are indices of the vocabularies of the reader
+  typedef std::function<void(const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, PhrasePairInfo inf)>
+      EntryFunction;
+
+  PlainTextPhraseTableReader();
+
+  // Approximate number of bytes of the file parsed at the same time
+  void setRoundSize(std::size_t bytes);
+  std::size_t getRoundSize() const;
+
+  bool read(const char* fileName, const EntryFunction& addEntry, int verbose = 0);
+
+  const std::string& getSrcWord(WordIndex w) const;
+  std::size_t getSrcVocabSize() const;
+  const std::string& getTrgWord(WordIndex w) const;
+  std::size_t getTrgVocabSize() const;
+
+  void clear();
+
+private:
+  class Vocab
+  {
+  public:
+    WordIndex add(const char* word, std::size_t length);
+    const std::string& getWord(WordIndex w) const;
+    std::size_t size() const;
+    void clear();
+
+  private:
+    std::unordered_map<std::string, WordIndex> ids;
+    std::vector<std::string> words;
+  };
+
+  std::size_t roundSize;
+  Vocab srcVocab;
+  Vocab trgVocab;
+};
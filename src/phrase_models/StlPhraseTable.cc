@@ -500,6 +500,7 @@ void StlPhraseTable::clear(void)
   srcPhraseInfo.clear();
   trgPhraseInfo.clear();
   srcTrgPhraseInfo.clear();
+  clearPhraseIds();
 }
 
 //-------------------------
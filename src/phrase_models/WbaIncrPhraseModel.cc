@@ -39,51 +39,9 @@ bool WbaIncrPhraseModel::printPhraseTable(const char* outputFileName, int n)
     for (phraseTIter = ptPtr->begin(); phraseTIter != ptPtr->end(); ++phraseTIter)
     {
       HatTriePhraseTable::SrcTableNode srctn;
-      HatTriePhraseTable::SrcTableNode::iterator srctnIter;
       const PhraseTransTableNodeData& t = phraseTIter->first;
       ptPtr->getEntriesForTarget(t, srctn);
-
-      if (n < 0 || (int)srctn.size() <= n)
-      {
-        for (srctnIter = srctn.begin(); srctnIter != srctn.end(); ++srctnIter)
-        {
-          printPhraseTableEntry(file, t, srctnIter);
-        }
-      }
-      else
-      {
-        NbestTableNode<PhraseTransTableNodeData> nbt;
-        for (srctnIter = srctn.begin(); srctnIter != srctn.end(); ++srctnIter)
-        {
-          nbt.insert(srctnIter->second.second.get_c_st(), srctnIter->first);
-        }
-
-        int count = 0;
-        float remainder = 0;
-        NbestTableNode<PhraseTransTableNodeData>::iterator nbtIter;
-        for (nbtIter = nbt.begin(); nbtIter != nbt.end(); ++nbtIter)
-        {
-          count++;
-          if (count <= n)
-          {
-            srctnIter = srctn.find(nbtIter->second);
-            printPhraseTableEntry(file, t, srctnIter);
-          }
-          else
-          {
-            remainder += nbtIter->first;
-          }
-        }
-
-        if (remainder > 0)
-        {
-          fprintf(file, "<UNUSED_WORD> |||");
-          std::vector<WordIndex>::const_iterator vectorWordIndexIter;
-          for (vectorWordIndexIter = t.begin(); vectorWordIndexIter != t.end(); ++vectorWordIndexIter)
-            fprintf(file, " %s", wordIndexToTrgString(*vectorWordIndexIter).c_str());
-          fprintf(file, " ||| 0 %.8f\n", remainder);
-        }
-      }
+      printTrgPhraseEntries(file, t, srctn, n);
     }
   }
 #else
@@ -98,54 +56,18 @@ bool WbaIncrPhraseModel::printPhraseTable(const char* outputFileName, int n)
     for (phraseTIter = ptPtr->beginTrg(); phraseTIter != ptPtr->endTrg(); ++phraseTIter)
     {
       StlPhraseTable::SrcTableNode srctn;
-      StlPhraseTable::SrcTableNode::iterator srctnIter;
       const PhraseTransTableNodeData& t = phraseTIter->first;
       ptPtr->getEntriesForTarget(t, srctn);
-
-      if (n < 0 || (int)srctn.size() <= n)
-      {
-        for (srctnIter = srctn.begin(); srctnIter != srctn.end(); ++srctnIter)
-        {
-          printPhraseTableEntry(file, t, srctnIter);
-        }
-      }
-      else
-      {
-        NbestTableNode<PhraseTransTableNodeData> nbt;
-        for (srctnIter = srctn.begin(); srctnIter != srctn.end(); ++srctnIter)
-        {
-          nbt.insert(srctnIter->second.second.get_c_st(), srctnIter->first);
-        }
-
-        int count = 0;
-        float remainder = 0;
-        NbestTableNode<PhraseTransTableNodeData>::iterator nbtIter;
-        for (nbtIter = nbt.begin(); nbtIter != nbt.end(); ++nbtIter)
-        {
-          count++;
-          if (count <= n)
-          {
-            srctnIter = srctn.find(nbtIter->second);
-            printPhraseTableEntry(file, t, srctnIter);
-          }
-          else
-          {
-            remainder += nbtIter->first;
-          }
-        }
-
-        if (remainder > 0)
-        {
-          fprintf(file, "<UNUSED_WORD> |||");
-          std::vector<WordIndex>::const_iterator vectorWordIndexIter;
-          for (vectorWordIndexIter = t.begin(); vectorWordIndexIter != t.end(); ++vectorWordIndexIter)
-            fprintf(file, " %s", wordIndexToTrgString(*vectorWordIndexIter).c_str());
-          fprintf(file, " ||| 0 %.8f\n", remainder);
-        }
-      }
+      printTrgPhraseEntries(file, t, srctn, n);
     }
   }
 #endif
+  else if (printMmapPhraseTable(file, n) == THOT_ERROR)
+  {
+    std::cerr << "Error: the phrase table in use cannot be printed" << std::endl;
+    fclose(file);
+    return THOT_ERROR;
+  }
 
   fclose(file);
   return THOT_OK;
@@ -18,6 +18,10 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 #include "phrase_models/_incrPhraseModel.h"
 
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
 _incrPhraseModel::_incrPhraseModel()
 {
 }
@@ -200,6 +204,12 @@ bool _incrPhraseModel::getNbestTransFor_t_(const std::vector<WordIndex>& t,
   return basePhraseTablePtr->getNbestForTrg(t, nbt, N);
 }
 
+bool _incrPhraseModel::getNbestTransViewFor_t_(const std::vector<WordIndex>& t, PhraseNbestListView& view,
+                                               int N /*=-1*/)
+{
+  return basePhraseTablePtr->getNbestViewForTrg(t, view, N);
+}
+
 bool _incrPhraseModel::load(const char* prefix, int verbose /*=0*/)
 {
   return load_given_prefix(prefix, verbose);
@@ -212,6 +222,7 @@ bool _incrPhraseModel::load_given_prefix(const char* prefix, int verbose /*=0*/)
   bool ret;
 
   // Clear previous tables
+  useWritablePhraseTable();
   basePhraseTablePtr->clear();
   segLenTable.clear();
 
@@ -247,6 +258,12 @@ bool _incrPhraseModel::load_given_prefix(const char* prefix, int verbose /*=0*/)
 
 bool _incrPhraseModel::load_ttable(const char* _incrPhraseModelFileName, int verbose /*=0*/)
 {
+  // Binary tables are stored in a model container
+  ModelContainer container;
+  if (container.open(_incrPhraseModelFileName) == THOT_OK)
+    return loadBinaryPhraseTable(container, verbose);
+
+  useWritablePhraseTable();
   AwkInputStream awk;
 
   if (awk.open(_incrPhraseModelFileName) == THOT_ERROR)
@@ -282,71 +299,213 @@ bool _incrPhraseModel::load_ttable(const char* _incrPhraseModelFileName, int ver
 
 bool _incrPhraseModel::loadPlainTextPhraseTable(const char* phraseTTableFileName, int verbose)
 {
-  unsigned int i;
-  std::vector<std::string> s, t;
-  AwkInputStream awk;
-  PhrasePairInfo phpinfo;
-  Count count_s_;
-  Count count_s_t_;
-
   if (verbose)
     std::cerr << "Loading phrase ttable from file " << phraseTTableFileName << std::endl;
 
-  if (awk.open(phraseTTableFileName) == THOT_ERROR)
+  return readPrunedPlainTextPhraseTable(
+      phraseTTableFileName, verbose,
+      [this](const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, PhrasePairInfo phpinfo) {
+        addTableEntry(s, t, phpinfo);
+      });
+}
+
+bool _incrPhraseModel::readPrunedPlainTextPhraseTable(
+    const char* phraseTTableFileName, int verbose,
+    const std::function<void(const std::vector<WordIndex>&, const std::vector<WordIndex>&, PhrasePairInfo)>&
+        addEntry)
+{
+  // The words of the reader are added to the vocabularies of the model when an entry
+  // that is passed on uses them for the first time
+  const WordIndex unmapped = std::numeric_limits<WordIndex>::max();
+  PlainTextPhraseTableReader reader;
+  std::vector<WordIndex> srcIndices, trgIndices;
+  std::vector<WordIndex> modelS, modelT;
+  auto addModelEntry = [&](const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, PhrasePairInfo phpinfo) {
+    srcIndices.resize(reader.getSrcVocabSize(), unmapped);
+    modelS.clear();
+    for (WordIndex w : s)
+    {
+      if (srcIndices[w] == unmapped)
+        srcIndices[w] = addSrcSymbol(reader.getSrcWord(w));
+      modelS.push_back(srcIndices[w]);
+    }
+    trgIndices.resize(reader.getTrgVocabSize(), unmapped);
+    modelT.clear();
+    for (WordIndex w : t)
+    {
+      if (trgIndices[w] == unmapped)
+        trgIndices[w] = addTrgSymbol(reader.getTrgWord(w));
+      modelT.push_back(trgIndices[w]);
+    }
+    addEntry(modelS, modelT, phpinfo);
+  };
+
+  phraseTablePruner.clearStats();
+  if (!phraseTablePruner.hasValidParameters())
   {
     if (verbose)
-      std::cerr << "Error in phrase model file: " << phraseTTableFileName << std::endl;
+      std::cerr << "Error: the significance test needs the number of sentence pairs of the table" << std::endl;
     return THOT_ERROR;
   }
-  else
+  if (!phraseTablePruner.isEnabled())
+    return reader.read(phraseTTableFileName, addModelEntry, verbose);
+
+  struct Entry
+  {
+    std::vector<WordIndex> s;
+    std::vector<WordIndex> t;
+    PhrasePairInfo phpinfo;
+  };
+  std::vector<Entry> entries;
+  std::map<std::vector<WordIndex>, float> trgCounts;
+  bool ret = reader.read(
+      phraseTTableFileName,
+      [&entries, &trgCounts](const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, PhrasePairInfo phpinfo) {
+        entries.push_back(Entry{s, t, phpinfo});
+        trgCounts[t] += (float)phpinfo.second.get_c_st();
+      },
+      verbose);
+  if (ret == THOT_ERROR)
+    return THOT_ERROR;
+
+  // Group the entries by source phrase
+  std::vector<size_t> order(entries.size());
+  for (size_t k = 0; k < order.size(); ++k)
+    order[k] = k;
+  std::stable_sort(order.begin(), order.end(),
+                   [&entries](size_t k1, size_t k2) { return entries[k1].s < entries[k2].s; });
+
+  std::vector<bool> keep(entries.size());
+  std::vector<float> pairCounts;
+  std::vector<float> groupTrgCounts;
+  std::vector<bool> groupKeep;
+  for (size_t begin = 0; begin < order.size();)
   {
-    unsigned int numEntry = 1;
-    while (awk.getln())
+    size_t end = begin + 1;
+    while (end < order.size() && entries[order[end]].s == entries[order[begin]].s)
+      ++end;
+
+    pairCounts.clear();
+    groupTrgCounts.clear();
+    for (size_t i = begin; i < end; ++i)
     {
-      if (awk.FNR >= 1 && awk.NF > 1)
-      {
-        // Read source phrase
-        i = 1;
-        s.clear();
-        while (i <= awk.NF && strcmp("|||", awk.dollar(i).c_str()) != 0)
-        {
-          s.push_back(awk.dollar(i));
-          ++i;
-        }
-        // Read target phrase
-        ++i;
-        t.clear();
-        while (i <= awk.NF && strcmp("|||", awk.dollar(i).c_str()) != 0)
-        {
-          t.push_back(awk.dollar(i));
-          ++i;
-        }
-        // Verify entry
-        if (i < awk.NF - 1 && strcmp("|||", awk.dollar(i).c_str()) == 0 && !s.empty() && !t.empty())
-        {
-          // Read count information
-          ++i;
-          count_s_ = atof(awk.dollar(i).c_str());
-          ++i;
-          count_s_t_ = atof(awk.dollar(i).c_str());
-
-          // Add table entry
-          phpinfo.first = count_s_;
-          phpinfo.second = count_s_t_;
-          strAddTableEntry(s, t, phpinfo);
-        }
-        else
-        {
-          if (verbose)
-            std::cerr << "Warning: discarding anomalous phrase table entry at line " << numEntry << std::endl;
-        }
-      }
-      ++numEntry;
+      const Entry& entry = entries[order[i]];
+      pairCounts.push_back((float)entry.phpinfo.second.get_c_st());
+      groupTrgCounts.push_back(trgCounts[entry.t]);
     }
+    // The last source count of a phrase is the one kept by the table
+    float srcCount = (float)entries[order[end - 1]].phpinfo.first.get_c_s();
+    phraseTablePruner.pruneSrcPhrase(srcCount, pairCounts, groupTrgCounts, groupKeep);
+    for (size_t i = begin; i < end; ++i)
+      keep[order[i]] = groupKeep[i - begin];
+    begin = end;
+  }
+
+  for (size_t k = 0; k < entries.size(); ++k)
+  {
+    if (keep[k])
+      addModelEntry(entries[k].s, entries[k].t, entries[k].phpinfo);
   }
+  if (verbose)
+    phraseTablePruner.getStats().print(std::cerr);
+  return THOT_OK;
+}
+
+bool _incrPhraseModel::loadBinaryPhraseTable(const ModelContainer& container, int verbose)
+{
+  if (container.getModelType() != "phraseTable")
+  {
+    if (verbose)
+      std::cerr << "Error: the container holds a " << container.getModelType() << " model, expected a phrase table"
+                << std::endl;
+    return THOT_ERROR;
+  }
+
+  if (verbose)
+    std::cerr << "Loading binary phrase ttable" << std::endl;
+
+  const char* data;
+  size_t size;
+  std::unique_ptr<MmapPhraseTable> mmapPhraseTablePtr(new MmapPhraseTable);
+  if (container.getSection(".ttable.bin", data, size) == THOT_ERROR
+      || mmapPhraseTablePtr->load(container.getFile(), data, size) == THOT_ERROR)
+    return THOT_ERROR;
+
+  // The frozen vocabularies are used directly from the mapped file. All the sections
+  // are loaded before the model is changed, so that a failure leaves it as it was
+  SingleWordVocab vocab;
+  if (container.getSection(".svcb.bin", data, size) == THOT_ERROR
+      || vocab.loadFrozenSrcVocab(container.getFile(), data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  if (container.getSection(".tvcb.bin", data, size) == THOT_ERROR
+      || vocab.loadFrozenTrgVocab(container.getFile(), data, size) == THOT_ERROR)
+    return THOT_ERROR;
+
+  singleWordVocab = vocab;
+  if (writablePhraseTablePtr == nullptr)
+    writablePhraseTablePtr = basePhraseTablePtr;
+  else
+    delete basePhraseTablePtr;
+  basePhraseTablePtr = mmapPhraseTablePtr.release();
   return THOT_OK;
 }
 
+void _incrPhraseModel::useWritablePhraseTable(void)
+{
+  if (writablePhraseTablePtr != nullptr)
+  {
+    delete basePhraseTablePtr;
+    basePhraseTablePtr = writablePhraseTablePtr;
+    writablePhraseTablePtr = nullptr;
+  }
+}
+
+bool _incrPhraseModel::buildBinaryPhraseTable(const char* phraseTTableFileName, const char* outputFileName,
+                                              int verbose)
+{
+  if (verbose)
+    std::cerr << "Building binary phrase ttable from file " << phraseTTableFileName << std::endl;
+
+  // The words of the table are added to the vocabularies of the model
+  MmapPhraseTableBuilder builder;
+  bool ret = readPrunedPlainTextPhraseTable(
+      phraseTTableFileName, verbose,
+      [&builder](const std::vector<WordIndex>& s, const std::vector<WordIndex>& t, PhrasePairInfo phpinfo) {
+        builder.addTableEntry(s, t, phpinfo);
+      });
+  if (ret == THOT_ERROR)
+    return THOT_ERROR;
+
+  std::ostringstream table;
+  std::ostringstream srcVocab;
+  std::ostringstream trgVocab;
+  if (builder.print(table) == THOT_ERROR || singleWordVocab.printFrozenSrcVocab(srcVocab) == THOT_ERROR
+      || singleWordVocab.printFrozenTrgVocab(trgVocab) == THOT_ERROR)
+    return THOT_ERROR;
+
+  ModelContainer container;
+  container.setModelType("phraseTable");
+  container.addSection(".ttable.bin", table.str());
+  container.addSection(".svcb.bin", srcVocab.str());
+  container.addSection(".tvcb.bin", trgVocab.str());
+  return container.write(outputFileName, verbose);
+}
+
+void _incrPhraseModel::setPruningParameters(const PhraseTablePruningParameters& params)
+{
+  phraseTablePruner.setParameters(params);
+}
+
+const PhraseTablePruningParameters& _incrPhraseModel::getPruningParameters() const
+{
+  return phraseTablePruner.getParameters();
+}
+
+const PhraseTablePruningStats& _incrPhraseModel::getPruningStats() const
+{
+  return phraseTablePruner.getStats();
+}
+
 bool _incrPhraseModel::load_seglentable(const char* segmLengthTableFileName, int verbose /*=0*/)
 {
   return segLenTable.load_seglentable(segmLengthTableFileName, verbose);
@@ -386,6 +545,73 @@ void _incrPhraseModel::printPhraseTableEntry(FILE* file, const PhraseTransTableN
           (float)srctnIter->second.second.get_c_st());
 }
 
+//-------------------------
+void _incrPhraseModel::printTrgPhraseEntries(FILE* file, const PhraseTransTableNodeData& t,
+                                             BasePhraseTable::SrcTableNode& srctn, int n)
+{
+  BasePhraseTable::SrcTableNode::iterator srctnIter;
+  if (n < 0 || (int)srctn.size() <= n)
+  {
+    for (srctnIter = srctn.begin(); srctnIter != srctn.end(); ++srctnIter)
+    {
+      printPhraseTableEntry(file, t, srctnIter);
+    }
+  }
+  else
+  {
+    NbestTableNode<PhraseTransTableNodeData> nbt;
+    for (srctnIter = srctn.begin(); srctnIter != srctn.end(); ++srctnIter)
+    {
+      nbt.insert(srctnIter->second.second.get_c_st(), srctnIter->first);
+    }
+
+    int count = 0;
+    float remainder = 0;
+    NbestTableNode<PhraseTransTableNodeData>::iterator nbtIter;
+    for (nbtIter = nbt.begin(); nbtIter != nbt.end(); ++nbtIter)
+    {
+      count++;
+      if (count <= n)
+      {
+        srctnIter = srctn.find(nbtIter->second);
+        printPhraseTableEntry(file, t, srctnIter);
+      }
+      else
+      {
+        remainder += nbtIter->first;
+      }
+    }
+
+    if (remainder > 0)
+    {
+      fprintf(file, "<UNUSED_WORD> |||");
+      std::vector<WordIndex>::const_iterator vectorWordIndexIter;
+      for (vectorWordIndexIter = t.begin(); vectorWordIndexIter != t.end(); ++vectorWordIndexIter)
+        fprintf(file, " %s", wordIndexToTrgString(*vectorWordIndexIter).c_str());
+      fprintf(file, " ||| 0 %.8f\n", remainder);
+    }
+  }
+}
+
+//-------------------------
+bool _incrPhraseModel::printMmapPhraseTable(FILE* file, int n)
+{
+  MmapPhraseTable* ptPtr = dynamic_cast<MmapPhraseTable*>(basePhraseTablePtr);
+  if (ptPtr == NULL)
+    return THOT_ERROR;
+
+  std::vector<WordIndex> t;
+  for (uint64_t i = 0; i < ptPtr->getNumTrgPhrases(); ++i)
+  {
+    ptPtr->getTrgPhraseAt(i, t);
+    BasePhraseTable::SrcTableNode srctn;
+    ptPtr->getEntriesForTarget(t, srctn);
+    printTrgPhraseEntries(file, t, srctn, n);
+  }
+  return THOT_OK;
+}
+
+//-------------------------
 bool _incrPhraseModel::printSegmLengthTable(const char* outputFileName)
 {
   std::ofstream outF;
@@ -596,6 +822,7 @@ size_t _incrPhraseModel::size(void)
 
 void _incrPhraseModel::clear(void)
 {
+  useWritablePhraseTable();
   singleWordVocab.clear();
   basePhraseTablePtr->clear();
   alignmentExtractor.close();
@@ -608,4 +835,5 @@ void _incrPhraseModel::clearTempVars(void)
 
 _incrPhraseModel::~_incrPhraseModel()
 {
+  delete writablePhraseTablePtr;
 }
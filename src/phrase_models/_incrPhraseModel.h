@@ -2,12 +2,16 @@
 
 #include "nlp_common/AwkInputStream.h"
 #include "nlp_common/Bitset.h"
+#include "nlp_common/ModelContainer.h"
 #include "nlp_common/NbestTransTable.h"
 #include "nlp_common/SingleWordVocab.h"
 #include "nlp_common/WordAlignmentMatrix.h"
 #include "nlp_common/printAligFuncs.h"
 #include "phrase_models/AlignmentExtractor.h"
 #include "phrase_models/BaseIncrPhraseModel.h"
+#include "phrase_models/MmapPhraseTable.h"
+#include "phrase_models/PlainTextPhraseTableReader.h"
+#include "phrase_models/PhraseTablePruner.h"
 #include "phrase_models/SegLenTable.h"
 #include "phrase_models/SrcSegmLenTable.h"
 #include "phrase_models/TrgCutsTable.h"
@@ -15,6 +19,7 @@
 
 #include <float.h>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -80,6 +85,7 @@ public:
   bool getTransFor_t_(const std::vector<WordIndex>& t, SrcTableNode& srctn);
   bool getNbestTransFor_s_(const std::vector<WordIndex>& s, NbestTableNode<PhraseTransTableNodeData>& nbt);
   bool getNbestTransFor_t_(const std::vector<WordIndex>& t, NbestTableNode<PhraseTransTableNodeData>& nbt, int N = -1);
+  bool getNbestTransViewFor_t_(const std::vector<WordIndex>& t, PhraseNbestListView& view, int N = -1);
 
   // Loading functions
   bool load(const char* prefix, int verbose = 0);
@@ -89,6 +95,16 @@ public:
   // non-zero if error
   bool load_seglentable(const char* segmLengthTableFileName, int verbose = 0);
   // Load a table with segmentation length information
+  bool buildBinaryPhraseTable(const char* phraseTTableFileName, const char* outputFileName, int verbose = 0);
+  // Converts a plain text translation table, together with the
+  // vocabularies it uses, into the read-only binary format that
+  // load_ttable() maps into memory (see MmapPhraseTable)
+  void setPruningParameters(const PhraseTablePruningParameters& params);
+  const PhraseTablePruningParameters& getPruningParameters() const;
+  const PhraseTablePruningStats& getPruningStats() const;
+  // Pruning applied to the plain text tables read by load_ttable()
+  // and buildBinaryPhraseTable(), and the pairs it removed from the
+  // last one
 
   // Printing functions
   bool print(const char* prefix);
@@ -157,6 +173,10 @@ protected:
   BasePhraseTable* basePhraseTablePtr{};
 #endif
 
+  // Table created by the derived class, kept aside while a binary
+  // table is in use
+  BasePhraseTable* writablePhraseTablePtr{};
+
   SegLenTable segLenTable;
 
   SrcSegmLenTable srcSegmLenTable;
@@ -165,14 +185,35 @@ protected:
 
   TrgSegmLenTable trgSegmLenTable;
 
+  PhraseTablePruner phraseTablePruner;
+
   void printPhraseTableEntry(FILE* file, const PhraseTransTableNodeData& t,
                              BasePhraseTable::SrcTableNode::iterator srctnIter);
+  void printTrgPhraseEntries(FILE* file, const PhraseTransTableNodeData& t, BasePhraseTable::SrcTableNode& srctn,
+                             int n);
+  // Prints the entries of a target phrase, keeping the n most
+  // frequent ones if n is not negative
+  bool printMmapPhraseTable(FILE* file, int n);
+  // Prints the entries of the binary table if it is in use,
+  // returns THOT_ERROR otherwise
 
   void printNbestTransTableNode(NbestTableNode<PhraseTransTableNodeData> tTableNode, std::ostream& outS);
   void printSegmLengthTable(std::ostream& outS);
 
   // Functions to load ttable
   virtual bool loadPlainTextPhraseTable(const char* phraseTTableFileName, int verbose);
-  // Reads a plain text phrase model file, returns non-zero if
-  // error
+  bool readPrunedPlainTextPhraseTable(
+      const char* phraseTTableFileName, int verbose,
+      const std::function<void(const std::vector<WordIndex>&, const std::vector<WordIndex>&, PhrasePairInfo)>&
+          addEntry);
+  // Reads a plain text phrase model file with a
+  // PlainTextPhraseTableReader and passes the entries kept by the
+  // pruner to addEntry, with their words added to the vocabularies
+  // of the model. Entries are read in full before pruning
+  virtual bool loadBinaryPhraseTable(const ModelContainer& container, int verbose);
+  // Uses the binary phrase table and the vocabularies stored in a
+  // container, which stays mapped in memory
+  void useWritablePhraseTable(void);
+  // Restores the table created by the derived class if a binary
+  // table is in use
 };
@@ -18,6 +18,81 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 #include "phrase_models/_wbaIncrPhraseModel.h"
 
+#include "nlp_common/StrProcUtils.h"
+#include "phrase_models/PhraseVocabulary.h"
+
+#include <fstream>
+#include <omp.h>
+#include <unordered_map>
+
+namespace
+{
+// Counts of the phrase pairs extracted by one thread. Phrases are interned, so that
+// every distinct pair is counted once and added to the model once
+class PhrasePairCounts
+{
+public:
+  void add(const std::vector<std::string>& s, const std::vector<std::string>& t, float count)
+  {
+    PhraseId srcId = srcVocab.add(s);
+    PhraseId trgId = trgVocab.add(t);
+    std::pair<std::unordered_map<PhrasePairId, size_t>::iterator, bool> result =
+        pairIds.insert(std::make_pair(makePhrasePairId(srcId, trgId), pairs.size()));
+    if (result.second)
+      pairs.push_back(PairCount{srcId, trgId, count});
+    else
+      pairs[result.first->second].count += count;
+  }
+
+  // Adds the counts to the model in the order in which the pairs were first
+  // extracted, so that words get the same indices as when storing one pair at a time
+  void addTo(_incrPhraseModel& model) const
+  {
+    std::vector<std::vector<WordIndex>> srcIndices(srcVocab.size());
+    std::vector<std::vector<WordIndex>> trgIndices(trgVocab.size());
+    for (const PairCount& pair : pairs)
+    {
+      if (srcIndices[pair.src].empty())
+        srcIndices[pair.src] = model.strVectorToSrcIndexVector(srcVocab.getPhrase(pair.src));
+      if (trgIndices[pair.trg].empty())
+        trgIndices[pair.trg] = model.strVectorToTrgIndexVector(trgVocab.getPhrase(pair.trg));
+      model.incrCountsOfEntry(srcIndices[pair.src], trgIndices[pair.trg], pair.count);
+    }
+  }
+
+  bool addTo(ExternalPhraseTableBuilder& builder) const
+  {
+    for (const PairCount& pair : pairs)
+    {
+      if (builder.addPhrasePair(srcVocab.getPhrase(pair.src), trgVocab.getPhrase(pair.trg), pair.count) == THOT_ERROR)
+        return THOT_ERROR;
+    }
+    return THOT_OK;
+  }
+
+  void clear()
+  {
+    srcVocab.clear();
+    trgVocab.clear();
+    pairIds.clear();
+    pairs.clear();
+  }
+
+private:
+  struct PairCount
+  {
+    PhraseId src;
+    PhraseId trg;
+    float count;
+  };
+
+  BasicPhraseVocabulary<std::string> srcVocab;
+  BasicPhraseVocabulary<std::string> trgVocab;
+  std::unordered_map<PhrasePairId, size_t> pairIds;
+  std::vector<PairCount> pairs;
+};
+} // namespace
+
 bool _wbaIncrPhraseModel::generateWbaIncrPhraseModel(const char* aligFileName, PhraseExtractParameters phePars,
                                                      bool BRF, int verbose /*=0*/)
 {
@@ -44,12 +119,18 @@ bool _wbaIncrPhraseModel::extendModel(const char* aligFileName, PhraseExtractPar
 void _wbaIncrPhraseModel::extendModelFromAlignments(PhraseExtractParameters phePars, bool BRF,
                                                     AlignmentExtractor& outAlignments, int verbose /*=0*/)
 {
+  numSent = 0;
+
+  if (!BRF && extractionBatchSize > 0)
+  {
+    extractFromAlignmentBatches(phePars, false, extractionBatchSize, outAlignments, NULL, verbose);
+    return;
+  }
+
   std::vector<std::string> ns, t;
   WordAlignmentMatrix waMatrix;
   float numReps;
 
-  numSent = 0;
-
   while (outAlignments.getNextAlignment())
   {
     ++numSent;
@@ -64,6 +145,259 @@ void _wbaIncrPhraseModel::extendModelFromAlignments(PhraseExtractParameters pheP
   }
 }
 
+bool _wbaIncrPhraseModel::buildPhraseTable(const char* aligFileName, PhraseExtractParameters phePars, bool BRF,
+                                           ExternalPhraseTableBuilder& builder, const char* outputFileName,
+                                           int verbose /*=0*/)
+{
+  AlignmentExtractor alignments;
+  if (alignments.open(aligFileName, GIZA_ALIG_FILE_FORMAT) == THOT_ERROR)
+  {
+    if (verbose)
+      std::cerr << "Error while reading alignment file." << std::endl;
+    return THOT_ERROR;
+  }
+
+  builder.clear();
+  numSent = 0;
+  unsigned int batchSize = extractionBatchSize > 0 ? extractionBatchSize : 1;
+  bool result = extractFromAlignmentBatches(phePars, BRF, batchSize, alignments, &builder, verbose);
+  alignments.close();
+  if (result == THOT_ERROR)
+    return THOT_ERROR;
+  return printBuiltPhraseTable(builder, outputFileName, verbose);
+}
+
+bool _wbaIncrPhraseModel::extendModelFromAligner(Aligner& aligner, const char* srcFileName, const char* trgFileName,
+                                                 PhraseExtractParameters phePars, bool BRF, int verbose /*=0*/)
+{
+  numSent = 0;
+  return extractFromAligner(aligner, srcFileName, trgFileName, phePars, BRF, NULL, verbose);
+}
+
+bool _wbaIncrPhraseModel::buildPhraseTableFromAligner(Aligner& aligner, const char* srcFileName,
+                                                      const char* trgFileName, PhraseExtractParameters phePars,
+                                                      bool BRF, ExternalPhraseTableBuilder& builder,
+                                                      const char* outputFileName, int verbose /*=0*/)
+{
+  builder.clear();
+  numSent = 0;
+  if (extractFromAligner(aligner, srcFileName, trgFileName, phePars, BRF, &builder, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+  return printBuiltPhraseTable(builder, outputFileName, verbose);
+}
+
+bool _wbaIncrPhraseModel::printBuiltPhraseTable(ExternalPhraseTableBuilder& builder, const char* outputFileName,
+                                                int verbose /*=0*/)
+{
+  // The significance test uses the size of the corpus the pairs come from
+  PhraseTablePruningParameters pruningPars = builder.getPruningParameters();
+  if (pruningPars.numSentencePairs == 0)
+  {
+    PhraseTablePruningParameters corpusPruningPars = pruningPars;
+    corpusPruningPars.numSentencePairs = numSent;
+    builder.setPruningParameters(corpusPruningPars);
+  }
+
+  if (verbose)
+    std::cerr << "Merging " << builder.numRuns() << " sorted runs..." << std::endl;
+  bool result = builder.print(outputFileName);
+  if (verbose && result == THOT_OK)
+    builder.getPruningStats().print(std::cerr);
+  builder.setPruningParameters(pruningPars);
+  builder.clear();
+  return result;
+}
+
+bool _wbaIncrPhraseModel::extractFromAlignmentBatches(PhraseExtractParameters phePars, bool BRF,
+                                                      unsigned int maxBatchSize, AlignmentExtractor& outAlignments,
+                                                      ExternalPhraseTableBuilder* builder, int verbose /*=0*/)
+{
+  AlignedPairBatchReader readBatch = [&outAlignments](unsigned int maxBatchSize, AlignedPairBatch& batch) {
+    batch.size = 0;
+    while (batch.size < maxBatchSize && outAlignments.getNextAlignment())
+    {
+      batch.nsVec[batch.size] = outAlignments.get_ns();
+      batch.tVec[batch.size] = outAlignments.get_t();
+      batch.waMatrixVec[batch.size] = outAlignments.get_wamatrix();
+      batch.numRepsVec[batch.size] = outAlignments.get_numReps();
+      batch.alignedVec[batch.size] = true;
+      ++batch.size;
+    }
+    return THOT_OK;
+  };
+  return extractFromAlignmentBatches(phePars, BRF, maxBatchSize, readBatch, builder, verbose);
+}
+
+bool _wbaIncrPhraseModel::extractFromAligner(Aligner& aligner, const char* srcFileName, const char* trgFileName,
+                                             PhraseExtractParameters phePars, bool BRF,
+                                             ExternalPhraseTableBuilder* builder, int verbose /*=0*/)
+{
+  std::ifstream srcFile(srcFileName);
+  std::ifstream trgFile(trgFileName);
+  if (!srcFile || !trgFile)
+  {
+    if (verbose)
+      std::cerr << "Error while reading the corpus files." << std::endl;
+    return THOT_ERROR;
+  }
+
+  // Word indices of the batch, stored one sentence after the other as expected by
+  // Aligner::getBestAlignments()
+  std::vector<WordIndex> srcWordIndices, trgWordIndices;
+  std::vector<size_t> srcOffsets, trgOffsets;
+  std::vector<unsigned int> alignedPairs;
+  std::vector<WordAlignmentMatrix> waMatrices;
+  std::vector<LgProb> logProbs;
+  std::vector<std::string> src;
+  AlignedPairBatchReader readBatch = [&](unsigned int maxBatchSize, AlignedPairBatch& batch) {
+    srcWordIndices.clear();
+    trgWordIndices.clear();
+    srcOffsets.assign(1, 0);
+    trgOffsets.assign(1, 0);
+    alignedPairs.clear();
+    std::string srcLine, trgLine;
+    for (batch.size = 0; batch.size < maxBatchSize; ++batch.size)
+    {
+      bool srcRead = (bool)std::getline(srcFile, srcLine);
+      bool trgRead = (bool)std::getline(trgFile, trgLine);
+      if (srcRead != trgRead)
+      {
+        if (verbose)
+          std::cerr << "Error: the corpus files have a different number of lines." << std::endl;
+        return THOT_ERROR;
+      }
+      if (!srcRead)
+        break;
+
+      src = StrProcUtils::stringToStringVector(srcLine);
+      batch.nsVec[batch.size] = addNullWordToStrVec(src);
+      batch.tVec[batch.size] = StrProcUtils::stringToStringVector(trgLine);
+      batch.numRepsVec[batch.size] = 1;
+      // The aligner needs both sentences, and pairs that are too long
+      // are not extracted anyway
+      const std::vector<std::string>& t = batch.tVec[batch.size];
+      batch.alignedVec[batch.size] =
+          !src.empty() && !t.empty() && src.size() < MAX_SENTENCE_LENGTH && t.size() < MAX_SENTENCE_LENGTH;
+      if (!batch.alignedVec[batch.size])
+        continue;
+      alignedPairs.push_back(batch.size);
+      for (const std::string& word : src)
+        srcWordIndices.push_back(aligner.stringToSrcWordIndex(word));
+      for (const std::string& word : t)
+        trgWordIndices.push_back(aligner.stringToTrgWordIndex(word));
+      srcOffsets.push_back(srcWordIndices.size());
+      trgOffsets.push_back(trgWordIndices.size());
+    }
+
+    waMatrices.resize(alignedPairs.size());
+    logProbs.resize(alignedPairs.size());
+    aligner.getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(), trgOffsets.data(),
+                              alignedPairs.size(), logProbs.data(), waMatrices.data());
+    for (size_t k = 0; k < alignedPairs.size(); ++k)
+      std::swap(batch.waMatrixVec[alignedPairs[k]], waMatrices[k]);
+    return THOT_OK;
+  };
+
+  unsigned int batchSize = extractionBatchSize > 0 ? extractionBatchSize : 1;
+  return extractFromAlignmentBatches(phePars, BRF, batchSize, readBatch, builder, verbose);
+}
+
+bool _wbaIncrPhraseModel::extractFromAlignmentBatches(PhraseExtractParameters phePars, bool BRF,
+                                                      unsigned int maxBatchSize, AlignedPairBatchReader readBatch,
+                                                      ExternalPhraseTableBuilder* builder, int verbose /*=0*/)
+{
+  AlignedPairBatch batch;
+  batch.nsVec.resize(maxBatchSize);
+  batch.tVec.resize(maxBatchSize);
+  batch.waMatrixVec.resize(maxBatchSize);
+  batch.numRepsVec.resize(maxBatchSize);
+  batch.alignedVec.resize(maxBatchSize);
+  const std::vector<std::vector<std::string>>& nsVec = batch.nsVec;
+  const std::vector<std::vector<std::string>>& tVec = batch.tVec;
+  const std::vector<WordAlignmentMatrix>& waMatrixVec = batch.waMatrixVec;
+  const std::vector<float>& numRepsVec = batch.numRepsVec;
+  const std::vector<bool>& alignedVec = batch.alignedVec;
+  std::vector<PhrasePairCounts> threadCounts(omp_get_max_threads());
+
+  while (true)
+  {
+    // Read the next batch
+    if (readBatch(maxBatchSize, batch) == THOT_ERROR)
+      return THOT_ERROR;
+    long long batchSize = batch.size;
+    if (batchSize == 0)
+      break;
+    if (verbose && (!BRF || batchSize > 1))
+      std::cerr << "Processing sent. pairs #" << numSent + 1 << " to #" << numSent + batchSize << "..." << std::endl;
+
+    // Extract the phrase pairs, the static schedule gives every thread a
+    // contiguous range of the batch. The BRF estimation draws random
+    // numbers, so it runs on a single thread
+#pragma omp parallel if (!BRF)
+    {
+      decltype(phraseExtract) threadPhraseExtract;
+      PhrasePairCounts& counts = threadCounts[omp_get_thread_num()];
+      std::vector<PhrasePair> vecPhPair;
+#pragma omp for schedule(static)
+      for (long long k = 0; k < batchSize; ++k)
+      {
+        const std::vector<std::string>& ns = nsVec[k];
+        const std::vector<std::string>& t = tVec[k];
+        if (t.size() >= MAX_SENTENCE_LENGTH || ns.size() - 1 >= MAX_SENTENCE_LENGTH)
+        {
+          if (verbose)
+          {
+#pragma omp critical
+            std::cerr << "  Warning: Max. sentence length exceeded for sentence pair " << numSent + k + 1
+                      << std::endl;
+          }
+          continue;
+        }
+        if (!alignedVec[k])
+          continue;
+        if (BRF)
+        {
+          threadPhraseExtract.segmBasedExtraction(phePars, ns, t, waMatrixVec[k], vecPhPair);
+          for (unsigned int i = 0; i < vecPhPair.size(); ++i)
+            counts.add(vecPhPair[i].s_, vecPhPair[i].t_, numRepsVec[k] * vecPhPair[i].weight);
+          continue;
+        }
+        threadPhraseExtract.extractConsistentPhrases(phePars, ns, t, waMatrixVec[k], vecPhPair);
+        for (unsigned int i = 0; i < vecPhPair.size(); ++i)
+        {
+          if (phrasePairFilter.phrasePairIsOk(vecPhPair[i].s_, vecPhPair[i].t_))
+            counts.add(vecPhPair[i].s_, vecPhPair[i].t_, numRepsVec[k] * vecPhPair[i].weight);
+        }
+      }
+    }
+
+    // Add the counts of the threads in the order of the sentence pairs
+    bool result = THOT_OK;
+    for (PhrasePairCounts& counts : threadCounts)
+    {
+      if (builder == NULL)
+        counts.addTo(*this);
+      else if (result == THOT_OK)
+        result = counts.addTo(*builder);
+      counts.clear();
+    }
+    if (result == THOT_ERROR)
+      return THOT_ERROR;
+    numSent += batchSize;
+  }
+  return THOT_OK;
+}
+
+void _wbaIncrPhraseModel::setExtractionBatchSize(unsigned int batchSize)
+{
+  extractionBatchSize = batchSize;
+}
+
+unsigned int _wbaIncrPhraseModel::getExtractionBatchSize() const
+{
+  return extractionBatchSize;
+}
+
 void _wbaIncrPhraseModel::extModelFromPairAligVec(PhraseExtractParameters phePars, bool BRF,
                                                   std::vector<std::vector<std::string>> sVec,
                                                   std::vector<std::vector<std::string>> tVec,
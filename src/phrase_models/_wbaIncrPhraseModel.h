@@ -19,7 +19,11 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "phrase_models/CategPhrasePairFilter.h"
+#include "phrase_models/ExternalPhraseTableBuilder.h"
 #include "phrase_models/_incrPhraseModel.h"
+#include "sw_models/Aligner.h"
+
+#include <functional>
 
 #ifdef USE_OCH_PHRASE_EXTRACT
 #include "phrase_models/PhraseExtractor.h"
@@ -27,6 +31,8 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 #include "phrase_models/PhraseExtractionTable.h"
 #endif
 
+#define DEFAULT_EXTRACTION_BATCH_SIZE 10000
+
 /**
  * Defines the _wbaIncrPhraseModel class.  _wbaIncrPhraseModel is
  * a predecessor class for derivating new phrase model classes which use
@@ -41,6 +47,7 @@ public:
   _wbaIncrPhraseModel() : _incrPhraseModel()
   {
     numSent = 0;
+    extractionBatchSize = DEFAULT_EXTRACTION_BATCH_SIZE;
   }
 
   bool generateWbaIncrPhraseModel(const char* aligFileName, PhraseExtractParameters phePars, bool pseudoML,
@@ -56,6 +63,29 @@ public:
                                  int verbose = 0);
   // Extends the model giving a previously initialized
   // AlignmentExtractor object.
+  bool buildPhraseTable(const char* aligFileName, PhraseExtractParameters phePars, bool pseudoML,
+                        ExternalPhraseTableBuilder& builder, const char* outputFileName, int verbose = 0);
+  // Extracts the phrase pairs of the given Giza-style file and
+  // writes them as a phrase table using the given builder, so that
+  // their counts are never kept in memory. The model is not modified.
+  bool extendModelFromAligner(Aligner& aligner, const char* srcFileName, const char* trgFileName,
+                              PhraseExtractParameters phePars, bool pseudoML, int verbose = 0);
+  bool buildPhraseTableFromAligner(Aligner& aligner, const char* srcFileName, const char* trgFileName,
+                                   PhraseExtractParameters phePars, bool pseudoML, ExternalPhraseTableBuilder& builder,
+                                   const char* outputFileName, int verbose = 0);
+  // The same as extendModel() and buildPhraseTable(), but the
+  // sentence pairs of the given tokenized corpus are aligned in
+  // batches with the aligner, which can be a SymmetrizedAligner, and
+  // their phrase pairs are extracted from the resulting matrices
+  // without writing or parsing an alignment file.
+  void setExtractionBatchSize(unsigned int batchSize);
+  unsigned int getExtractionBatchSize() const;
+  // Number of sentence pairs that extendModelFromAlignments() reads
+  // before extracting their phrase pairs in parallel. The pairs
+  // extracted by each thread are counted in a table of its own, which
+  // is added to the model once the batch is done. A size of zero
+  // processes one sentence pair at a time. The BRF estimation draws
+  // random numbers, so it is never run in parallel.
   virtual void extModelFromPairAligVec(PhraseExtractParameters phePars, bool pseudoML,
                                        std::vector<std::vector<std::string>> sVec,
                                        std::vector<std::vector<std::string>> tVec,
@@ -91,8 +121,39 @@ protected:
   LgProb logLikelihood;
   LgProb logLikelihoodMaxApprox;
   unsigned int numSent;
+  unsigned int extractionBatchSize;
   CategPhrasePairFilter phrasePairFilter;
 
+  struct AlignedPairBatch
+  {
+    std::vector<std::vector<std::string>> nsVec;
+    std::vector<std::vector<std::string>> tVec;
+    std::vector<WordAlignmentMatrix> waMatrixVec;
+    std::vector<float> numRepsVec;
+    // False for the pairs that the reader could not align, which are
+    // counted but not extracted
+    std::vector<bool> alignedVec;
+    unsigned int size;
+  };
+  typedef std::function<bool(unsigned int maxBatchSize, AlignedPairBatch& batch)> AlignedPairBatchReader;
+  // Fills the batch with at most maxBatchSize sentence pairs, the
+  // source sentences start with the NULL word. An empty batch ends
+  // the input
+
+  bool extractFromAlignmentBatches(PhraseExtractParameters phePars, bool BRF, unsigned int maxBatchSize,
+                                   AlignmentExtractor& outAlignments, ExternalPhraseTableBuilder* builder,
+                                   int verbose = 0);
+  bool extractFromAlignmentBatches(PhraseExtractParameters phePars, bool BRF, unsigned int maxBatchSize,
+                                   AlignedPairBatchReader readBatch, ExternalPhraseTableBuilder* builder,
+                                   int verbose = 0);
+  // Adds the phrase pairs to the builder, or to the model if it is NULL
+  bool extractFromAligner(Aligner& aligner, const char* srcFileName, const char* trgFileName,
+                          PhraseExtractParameters phePars, bool BRF, ExternalPhraseTableBuilder* builder,
+                          int verbose = 0);
+  bool printBuiltPhraseTable(ExternalPhraseTableBuilder& builder, const char* outputFileName, int verbose = 0);
+  // Writes the pairs added to the builder, the significance test uses
+  // the number of sentence pairs read unless the builder has one
+
   bool existRowOfNulls(unsigned int j1, unsigned int j2, std::vector<unsigned int>& alig);
   void storePhrasePairs(const std::vector<PhrasePair>& vecPhPair, float numReps, int verbose = 0);
   Bitset<MAX_SENTENCE_LENGTH> zeroFertBitset(std::vector<unsigned int>& alig);
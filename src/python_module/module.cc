@@ -1,6 +1,7 @@
 #include "incr_models/IncrJelMerNgramLM.h"
 #include "incr_models/WordPenaltyModel.h"
 #include "nlp_common/ErrorDefs.h"
+#include "nlp_common/StrProcUtils.h"
 #include "stack_dec/PhrLocalSwLiTm.h"
 #include "stack_dec/TranslationMetadata.h"
 #include "stack_dec/multi_stack_decoder_rec.h"
@@ -20,6 +21,9 @@
 #include "sw_models/SentenceLengthModel.h"
 #include "sw_models/SymmetrizedAligner.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
@@ -31,70 +35,210 @@ namespace py = pybind11;
 
 std::vector<WordIndex> getSrcWordIndices(Aligner& aligner, const char* srcSentence)
 {
-  std::vector<WordIndex> wordIndices;
-  size_t i = 0;
-  std::string s;
-  while (srcSentence[i] != 0)
-  {
-    s = "";
-    while (srcSentence[i] == ' ' && srcSentence[i] != 0)
-    {
-      ++i;
-    }
-    while (srcSentence[i] != ' ' && srcSentence[i] != 0)
-    {
-      s = s + srcSentence[i];
-      ++i;
-    }
-    if (s != "")
-    {
-      WordIndex wordIndex = aligner.stringToSrcWordIndex(s);
-      wordIndices.push_back(wordIndex);
-    }
-  }
+  size_t sentenceOffsets[2] = {0, strlen(srcSentence)};
+  size_t wordOffsets[2];
+  std::vector<WordIndex> wordIndices(StrProcUtils::countSentenceWords(srcSentence, sentenceOffsets, 1, wordOffsets));
+  aligner.encodeSrcSentences(srcSentence, sentenceOffsets, 1, wordOffsets, wordIndices.data());
   return wordIndices;
 }
 
 std::vector<WordIndex> getSrcWordIndices(Aligner& aligner, const std::vector<std::string>& srcSentence)
 {
   std::vector<WordIndex> wordIndices;
+  wordIndices.reserve(srcSentence.size());
   for (auto& w : srcSentence)
     wordIndices.push_back(aligner.stringToSrcWordIndex(w));
   return wordIndices;
 }
 
 std::vector<WordIndex> getTrgWordIndices(Aligner& aligner, const char* trgSentence)
+{
+  size_t sentenceOffsets[2] = {0, strlen(trgSentence)};
+  size_t wordOffsets[2];
+  std::vector<WordIndex> wordIndices(StrProcUtils::countSentenceWords(trgSentence, sentenceOffsets, 1, wordOffsets));
+  aligner.encodeTrgSentences(trgSentence, sentenceOffsets, 1, wordOffsets, wordIndices.data());
+  return wordIndices;
+}
+
+std::vector<WordIndex> getTrgWordIndices(Aligner& aligner, const std::vector<std::string>& trgSentence)
 {
   std::vector<WordIndex> wordIndices;
-  size_t i = 0;
-  std::string s;
-  while (trgSentence[i] != 0)
+  wordIndices.reserve(trgSentence.size());
+  for (auto& w : trgSentence)
+    wordIndices.push_back(aligner.stringToTrgWordIndex(w));
+  return wordIndices;
+}
+
+py::tuple encodeSentences(const Aligner& aligner, const char* buffer, const size_t* sentenceOffsets,
+                          size_t numSentences, bool source)
+{
+  py::array_t<size_t> wordOffsets(numSentences + 1);
+  size_t numWords = StrProcUtils::countSentenceWords(buffer, sentenceOffsets, numSentences, wordOffsets.mutable_data());
+  py::array_t<WordIndex> wordIndices(numWords);
+  if (source)
+    aligner.encodeSrcSentences(buffer, sentenceOffsets, numSentences, wordOffsets.data(), wordIndices.mutable_data());
+  else
+    aligner.encodeTrgSentences(buffer, sentenceOffsets, numSentences, wordOffsets.data(), wordIndices.mutable_data());
+  return py::make_tuple(wordIndices, wordOffsets);
+}
+
+py::tuple encodeSentences(const Aligner& aligner, const std::vector<std::string>& sentences, bool source)
+{
+  std::vector<size_t> sentenceOffsets(sentences.size() + 1, 0);
+  for (size_t s = 0; s < sentences.size(); ++s)
+    sentenceOffsets[s + 1] = sentenceOffsets[s] + sentences[s].size();
+  std::string buffer;
+  buffer.reserve(sentenceOffsets.back());
+  for (const std::string& sentence : sentences)
+    buffer += sentence;
+  return encodeSentences(aligner, buffer.data(), sentenceOffsets.data(), sentences.size(), source);
+}
+
+py::tuple encodeSentences(const Aligner& aligner, const py::bytes& buffer,
+                          const py::array_t<size_t, py::array::c_style | py::array::forcecast>& sentenceOffsets,
+                          bool source)
+{
+  char* data;
+  py::ssize_t length;
+  PYBIND11_BYTES_AS_STRING_AND_SIZE(buffer.ptr(), &data, &length);
+  size_t numSentences = sentenceOffsets.size() == 0 ? 0 : sentenceOffsets.size() - 1;
+  for (size_t s = 0; s < numSentences; ++s)
   {
-    s = "";
-    while (trgSentence[i] == ' ' && trgSentence[i] != 0)
-    {
-      ++i;
-    }
-    while (trgSentence[i] != ' ' && trgSentence[i] != 0)
+    if (sentenceOffsets.at(s) > sentenceOffsets.at(s + 1) || sentenceOffsets.at(s + 1) > (size_t)length)
+      throw py::value_error("Invalid sentence offsets.");
+  }
+  return encodeSentences(aligner, data, sentenceOffsets.data(), numSentences, source);
+}
+
+void encodeTokens(const Aligner& aligner, const std::vector<std::vector<std::string>>& sentences, bool source,
+                  std::vector<WordIndex>& wordIndices, std::vector<size_t>& offsets)
+{
+  offsets.assign(sentences.size() + 1, 0);
+  for (size_t s = 0; s < sentences.size(); ++s)
+    offsets[s + 1] = offsets[s] + sentences[s].size();
+  std::vector<const char*> tokens;
+  std::vector<size_t> tokenLengths;
+  tokens.reserve(offsets.back());
+  tokenLengths.reserve(offsets.back());
+  for (const std::vector<std::string>& sentence : sentences)
+  {
+    for (const std::string& token : sentence)
     {
-      s = s + trgSentence[i];
-      ++i;
+      tokens.push_back(token.data());
+      tokenLengths.push_back(token.size());
     }
-    if (s != "")
+  }
+  wordIndices.resize(offsets.back());
+  if (source)
+    aligner.encodeSrcTokens(tokens.data(), tokenLengths.data(), tokens.size(), wordIndices.data());
+  else
+    aligner.encodeTrgTokens(tokens.data(), tokenLengths.data(), tokens.size(), wordIndices.data());
+}
+
+void flattenSentences(const std::vector<std::vector<WordIndex>>& sentences, std::vector<WordIndex>& wordIndices,
+                      std::vector<size_t>& offsets)
+{
+  offsets.assign(sentences.size() + 1, 0);
+  for (size_t s = 0; s < sentences.size(); ++s)
+    offsets[s + 1] = offsets[s] + sentences[s].size();
+  wordIndices.clear();
+  wordIndices.reserve(offsets.back());
+  for (const std::vector<WordIndex>& sentence : sentences)
+    wordIndices.insert(wordIndices.end(), sentence.begin(), sentence.end());
+}
+
+std::vector<std::tuple<double, WordAlignmentMatrix>> getBestAlignments(Aligner& aligner,
+                                                                       const std::vector<WordIndex>& srcWordIndices,
+                                                                       const std::vector<size_t>& srcOffsets,
+                                                                       const std::vector<WordIndex>& trgWordIndices,
+                                                                       const std::vector<size_t>& trgOffsets)
+{
+  size_t numPairs = srcOffsets.size() - 1;
+  std::vector<LgProb> logProbs(numPairs);
+  std::vector<WordAlignmentMatrix> waMatrices(numPairs);
+  {
+    py::gil_scoped_release release;
+    aligner.getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(), trgOffsets.data(),
+                              numPairs, logProbs.data(), waMatrices.data());
+  }
+  std::vector<std::tuple<double, WordAlignmentMatrix>> alignments;
+  alignments.reserve(numPairs);
+  for (size_t k = 0; k < numPairs; ++k)
+    alignments.push_back(std::make_tuple((double)logProbs[k], std::move(waMatrices[k])));
+  return alignments;
+}
+
+typedef py::array_t<WordIndex, py::array::c_style | py::array::forcecast> WordIndexArray;
+typedef py::array_t<size_t, py::array::c_style | py::array::forcecast> OffsetArray;
+
+size_t checkSentenceArrays(const WordIndexArray& wordIndices, const OffsetArray& offsets)
+{
+  size_t numSentences = offsets.size() == 0 ? 0 : offsets.size() - 1;
+  const size_t* data = offsets.data();
+  for (size_t s = 0; s < numSentences; ++s)
+  {
+    if (data[s] > data[s + 1] || data[s + 1] > (size_t)wordIndices.size())
+      throw py::value_error("Invalid sentence offsets.");
+  }
+  return numSentences;
+}
+
+// Returns the log-probabilities of the alignments and an array with one (sentence, i, j) row per
+// aligned cell, i and j being zero-based source and target positions
+py::tuple getBestAlignments(Aligner& aligner, const WordIndexArray& srcWordIndices, const OffsetArray& srcOffsets,
+                            const WordIndexArray& trgWordIndices, const OffsetArray& trgOffsets)
+{
+  size_t numPairs = checkSentenceArrays(srcWordIndices, srcOffsets);
+  if (checkSentenceArrays(trgWordIndices, trgOffsets) != numPairs)
+    throw py::value_error("The number of source and target sentences must be the same.");
+
+  py::array_t<double> logProbs(numPairs);
+  double* logProbsData = logProbs.mutable_data();
+  std::vector<int32_t> cells;
+  {
+    py::gil_scoped_release release;
+    std::vector<LgProb> lgProbs(numPairs);
+    std::vector<WordAlignmentMatrix> waMatrices(numPairs);
+    aligner.getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(), trgOffsets.data(),
+                              numPairs, lgProbs.data(), waMatrices.data());
+    std::vector<std::pair<unsigned int, unsigned int>> sentenceCells;
+    for (size_t k = 0; k < numPairs; ++k)
     {
-      WordIndex wordIndex = aligner.stringToTrgWordIndex(s);
-      wordIndices.push_back(wordIndex);
+      logProbsData[k] = (double)lgProbs[k];
+      sentenceCells.clear();
+      waMatrices[k].getAlignedCells(sentenceCells);
+      for (const std::pair<unsigned int, unsigned int>& cell : sentenceCells)
+      {
+        cells.push_back((int32_t)k);
+        cells.push_back((int32_t)cell.first);
+        cells.push_back((int32_t)cell.second);
+      }
     }
   }
-  return wordIndices;
+  py::array_t<int32_t> alignments({cells.size() / 3, (size_t)3});
+  std::copy(cells.begin(), cells.end(), alignments.mutable_data());
+  return py::make_tuple(logProbs, alignments);
 }
 
-std::vector<WordIndex> getTrgWordIndices(Aligner& aligner, const std::vector<std::string>& trgSentence)
+py::tuple getAlignmentPosteriors(AlignmentModel& model, const std::vector<WordIndex>& srcWordIndices,
+                                 const std::vector<size_t>& srcOffsets, const std::vector<WordIndex>& trgWordIndices,
+                                 const std::vector<size_t>& trgOffsets)
 {
-  std::vector<WordIndex> wordIndices;
-  for (auto& w : trgSentence)
-    wordIndices.push_back(aligner.stringToTrgWordIndex(w));
-  return wordIndices;
+  size_t numPairs = srcOffsets.size() - 1;
+  py::array_t<size_t> posteriorOffsets(numPairs + 1);
+  size_t* offsets = posteriorOffsets.mutable_data();
+  offsets[0] = 0;
+  for (size_t k = 0; k < numPairs; ++k)
+    offsets[k + 1] = offsets[k] + (srcOffsets[k + 1] - srcOffsets[k]) * (trgOffsets[k + 1] - trgOffsets[k]);
+  // The model writes straight into the NumPy buffer
+  py::array_t<float> posteriors(offsets[numPairs]);
+  float* posteriorsData = posteriors.mutable_data();
+  {
+    py::gil_scoped_release release;
+    model.getAlignmentPosteriors(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(), trgOffsets.data(),
+                                 numPairs, offsets, posteriorsData);
+  }
+  return py::make_tuple(posteriors, posteriorOffsets);
 }
 
 AlignmentModel* createAlignmentModel(AlignmentModelType type)
@@ -213,8 +357,24 @@ PYBIND11_MODULE(thot, m)
       .def(
           "__eq__", [](const WordAlignmentMatrix& matrix, const WordAlignmentMatrix& other) { return matrix == other; },
           py::arg("other"))
-      .def("to_numpy", [](WordAlignmentMatrix& matrix) {
-        return py::array_t<bool>({matrix.get_I(), matrix.get_J()}, matrix.ptr() == nullptr ? nullptr : matrix.ptr()[0]);
+      .def("to_numpy",
+           [](const WordAlignmentMatrix& matrix) {
+             py::array_t<bool> array({matrix.get_I(), matrix.get_J()});
+             auto cells = array.mutable_unchecked<2>();
+             for (unsigned int i = 0; i < matrix.get_I(); ++i)
+             {
+               for (unsigned int j = 0; j < matrix.get_J(); ++j)
+                 cells(i, j) = matrix.getValue(i, j);
+             }
+             return array;
+           })
+      .def("to_packed_numpy", [](py::object self) {
+        // Zero-copy view of the bit-packed rows (little-endian bit order on little-endian hosts), valid while the
+        // matrix is not resized
+        WordAlignmentMatrix& matrix = self.cast<WordAlignmentMatrix&>();
+        size_t rowBytes = (size_t)matrix.getWordsPerRow() * sizeof(uint64_t);
+        return py::array_t<uint8_t>({(size_t)matrix.get_I(), rowBytes}, {rowBytes, (size_t)1},
+                                    reinterpret_cast<uint8_t*>(matrix.packedData()), self);
       });
 
   py::class_<IncrJelMerNgramLM>(common, "NGramLanguageModel")
@@ -235,6 +395,32 @@ PYBIND11_MODULE(thot, m)
   py::class_<Aligner, std::shared_ptr<Aligner>>(alignment, "Aligner")
       .def("get_src_word_index", &Aligner::stringToSrcWordIndex, py::arg("word"))
       .def("get_trg_word_index", &Aligner::stringToTrgWordIndex, py::arg("word"))
+      .def(
+          "encode_src_sentences",
+          [](const Aligner& aligner, const std::vector<std::string>& sentences) {
+            return encodeSentences(aligner, sentences, true);
+          },
+          py::arg("sentences"))
+      .def(
+          "encode_src_sentences",
+          [](const Aligner& aligner, const py::bytes& buffer,
+             const py::array_t<size_t, py::array::c_style | py::array::forcecast>& sentenceOffsets) {
+            return encodeSentences(aligner, buffer, sentenceOffsets, true);
+          },
+          py::arg("buffer"), py::arg("sentence_offsets"))
+      .def(
+          "encode_trg_sentences",
+          [](const Aligner& aligner, const std::vector<std::string>& sentences) {
+            return encodeSentences(aligner, sentences, false);
+          },
+          py::arg("sentences"))
+      .def(
+          "encode_trg_sentences",
+          [](const Aligner& aligner, const py::bytes& buffer,
+             const py::array_t<size_t, py::array::c_style | py::array::forcecast>& sentenceOffsets) {
+            return encodeSentences(aligner, buffer, sentenceOffsets, false);
+          },
+          py::arg("buffer"), py::arg("sentence_offsets"))
       .def(
           "get_best_alignment",
           [](Aligner& aligner, const char* srcSentence, const char* trgSentence) {
@@ -266,33 +452,38 @@ PYBIND11_MODULE(thot, m)
           "get_best_alignments",
           [](Aligner& aligner, const std::vector<std::vector<std::string>>& srcSentences,
              const std::vector<std::vector<std::string>>& trgSentences) {
-            std::vector<std::tuple<double, WordAlignmentMatrix>> alignments(srcSentences.size());
-#pragma omp parallel for schedule(dynamic)
-            for (int i = 0; i < (int)srcSentences.size(); ++i)
+            if (srcSentences.size() != trgSentences.size())
+              throw py::value_error("The number of source and target sentences must be the same.");
+            std::vector<WordIndex> srcWordIndices, trgWordIndices;
+            std::vector<size_t> srcOffsets, trgOffsets;
             {
-              WordAlignmentMatrix waMatrix;
-              LgProb logProb = aligner.getBestAlignment(getSrcWordIndices(aligner, srcSentences[i]),
-                                                        getTrgWordIndices(aligner, trgSentences[i]), waMatrix);
-              alignments[i] = std::make_tuple((double)logProb, std::move(waMatrix));
+              py::gil_scoped_release release;
+              encodeTokens(aligner, srcSentences, true, srcWordIndices, srcOffsets);
+              encodeTokens(aligner, trgSentences, false, trgWordIndices, trgOffsets);
             }
-            return alignments;
+            return getBestAlignments(aligner, srcWordIndices, srcOffsets, trgWordIndices, trgOffsets);
           },
           py::arg("src_sentences"), py::arg("trg_sentences"))
       .def(
           "get_best_alignments",
           [](Aligner& aligner, const std::vector<std::vector<WordIndex>>& srcSentences,
              const std::vector<std::vector<WordIndex>>& trgSentences) {
-            std::vector<std::tuple<double, WordAlignmentMatrix>> alignments(srcSentences.size());
-#pragma omp parallel for schedule(dynamic)
-            for (int i = 0; i < (int)srcSentences.size(); ++i)
-            {
-              WordAlignmentMatrix waMatrix;
-              LgProb logProb = aligner.getBestAlignment(srcSentences[i], trgSentences[i], waMatrix);
-              alignments[i] = std::make_tuple((double)logProb, std::move(waMatrix));
-            }
-            return alignments;
+            if (srcSentences.size() != trgSentences.size())
+              throw py::value_error("The number of source and target sentences must be the same.");
+            std::vector<WordIndex> srcWordIndices, trgWordIndices;
+            std::vector<size_t> srcOffsets, trgOffsets;
+            flattenSentences(srcSentences, srcWordIndices, srcOffsets);
+            flattenSentences(trgSentences, trgWordIndices, trgOffsets);
+            return getBestAlignments(aligner, srcWordIndices, srcOffsets, trgWordIndices, trgOffsets);
+          },
+          py::arg("src_sentences"), py::arg("trg_sentences"))
+      .def(
+          "get_best_alignments",
+          [](Aligner& aligner, const WordIndexArray& srcWordIndices, const OffsetArray& srcOffsets,
+             const WordIndexArray& trgWordIndices, const OffsetArray& trgOffsets) {
+            return getBestAlignments(aligner, srcWordIndices, srcOffsets, trgWordIndices, trgOffsets);
           },
-          py::arg("src_sentences"), py::arg("trg_sentences"));
+          py::arg("src_word_indices"), py::arg("src_offsets"), py::arg("trg_word_indices"), py::arg("trg_offsets"));
 
   py::enum_<SymmetrizationHeuristic>(alignment, "SymmetrizationHeuristic")
       .value("NONE", SymmetrizationHeuristic::None)
@@ -320,6 +511,28 @@ PYBIND11_MODULE(thot, m)
       .value("INCR_IBM2", AlignmentModelType::IncrIbm2)
       .value("INCR_HMM", AlignmentModelType::IncrHmm);
 
+  py::class_<TrainingPhaseMetrics>(alignment, "TrainingPhaseMetrics")
+      .def_readonly("count", &TrainingPhaseMetrics::count)
+      .def_readonly("wall_time", &TrainingPhaseMetrics::wallTime)
+      .def_readonly("cpu_time", &TrainingPhaseMetrics::cpuTime);
+
+  py::class_<TrainingMetrics>(alignment, "TrainingMetrics")
+      .def_readonly("start_training", &TrainingMetrics::startTraining)
+      .def_readonly("iteration", &TrainingMetrics::iteration)
+      .def_readonly("io", &TrainingMetrics::io)
+      .def_readonly("e_step", &TrainingMetrics::eStep)
+      .def_readonly("m_step", &TrainingMetrics::mStep)
+      .def_readonly("reduction", &TrainingMetrics::reduction)
+      .def_readonly("load", &TrainingMetrics::load)
+      .def_readonly("save", &TrainingMetrics::save)
+      .def_readonly("num_tokens", &TrainingMetrics::numTokens)
+      .def_property_readonly("tokens_per_second", &TrainingMetrics::tokensPerSecond)
+      .def_readonly("peak_rss", &TrainingMetrics::peakRss)
+      .def_readonly("src_vocab_size", &TrainingMetrics::srcVocabSize)
+      .def_readonly("trg_vocab_size", &TrainingMetrics::trgVocabSize)
+      .def_readonly("num_sentence_pairs", &TrainingMetrics::numSentencePairs)
+      .def_readonly("num_lex_counts", &TrainingMetrics::numLexCounts);
+
   py::class_<AlignmentModel, Aligner, std::shared_ptr<AlignmentModel>>(alignment, "AlignmentModel")
       .def_property_readonly("model_type", &AlignmentModel::getModelType)
       .def_property("variational_bayes", &AlignmentModel::getVariationalBayes, &AlignmentModel::setVariationalBayes)
@@ -350,8 +563,32 @@ PYBIND11_MODULE(thot, m)
           py::arg("n"))
       .def_property_readonly("max_sentence_length", &AlignmentModel::getMaxSentenceLength)
       .def("start_training", [](AlignmentModel& model) { return model.startTraining(); })
-      .def("train", [](AlignmentModel& model) { model.train(); })
+      .def(
+          "train",
+          [](AlignmentModel& model, unsigned int numIters, double minRelImprovement) {
+            return model.trainIterations(numIters, minRelImprovement);
+          },
+          py::arg("num_iters") = 1, py::arg("min_rel_improvement") = 0)
+      .def(
+          "read_held_out_sentence_pairs",
+          [](AlignmentModel& model, const char* srcFileName, const char* trgFileName) {
+            return model.readHeldOutSentencePairs(srcFileName, trgFileName) == THOT_OK;
+          },
+          py::arg("src_filename"), py::arg("trg_filename"))
+      .def("add_held_out_sentence_pair", &AlignmentModel::addHeldOutSentencePair, py::arg("src_sentence"),
+           py::arg("trg_sentence"))
+      .def_property_readonly("num_held_out_sentence_pairs", &AlignmentModel::numHeldOutSentencePairs)
+      .def("clear_held_out_sentence_pairs", &AlignmentModel::clearHeldOutSentencePairs)
+      .def("log_likelihood", [](AlignmentModel& model) { return model.loglikelihoodForAllSentences(); })
+      .def("held_out_log_likelihood",
+           [](AlignmentModel& model) { return model.loglikelihoodForHeldOutSentences(); })
       .def("end_training", &AlignmentModel::endTraining)
+      .def_property_readonly("training_metrics", &AlignmentModel::getTrainingMetrics)
+      .def("clear_training_metrics", &AlignmentModel::clearTrainingMetrics)
+      .def(
+          "set_training_metrics_file",
+          [](AlignmentModel& model, const char* fileName) { return model.setTrainingMetricsFile(fileName) == THOT_OK; },
+          py::arg("file_name"))
       .def(
           "sentence_length_prob",
           [](AlignmentModel& model, unsigned int slen, unsigned int tlen) {
@@ -370,6 +607,24 @@ PYBIND11_MODULE(thot, m)
       .def(
           "print", [](AlignmentModel& model, const char* prefFileName) { return model.print(prefFileName) == THOT_OK; },
           py::arg("prefix_filename"))
+      .def(
+          "load_container",
+          [](AlignmentModel& model, const char* fileName) { return model.loadContainer(fileName) == THOT_OK; },
+          py::arg("filename"))
+      .def(
+          "print_container",
+          [](AlignmentModel& model, const char* fileName) { return model.printContainer(fileName) == THOT_OK; },
+          py::arg("filename"))
+      .def(
+          "load_checkpoint",
+          [](AlignmentModel& model, const char* prefFileName) { return model.loadCheckpoint(prefFileName) == THOT_OK; },
+          py::arg("prefix_filename"))
+      .def(
+          "print_checkpoint",
+          [](AlignmentModel& model, const char* prefFileName) {
+            return model.printCheckpoint(prefFileName) == THOT_OK;
+          },
+          py::arg("prefix_filename"))
       .def_property_readonly("src_vocab_size", &AlignmentModel::getSrcVocabSize)
       .def("get_src_word", &AlignmentModel::wordIndexToSrcString, py::arg("word_index"))
       .def("src_word_exists", &AlignmentModel::existSrcSymbol, py::arg("word"))
@@ -378,6 +633,46 @@ PYBIND11_MODULE(thot, m)
       .def("get_trg_word", &AlignmentModel::wordIndexToTrgString, py::arg("word_index"))
       .def("trg_word_exists", &AlignmentModel::existTrgSymbol, py::arg("word"))
       .def("add_trg_word", &AlignmentModel::addTrgSymbol, py::arg("word"))
+      .def("freeze_vocab", [](AlignmentModel& model) { return model.freezeVocab() == THOT_OK; })
+      .def_property_readonly("vocab_frozen", &AlignmentModel::isVocabFrozen)
+      .def(
+          "get_alignment_posteriors",
+          [](AlignmentModel& model, const std::vector<WordIndex>& srcSentence,
+             const std::vector<WordIndex>& trgSentence) {
+            py::array_t<float> posteriors({srcSentence.size(), trgSentence.size()});
+            model.getAlignmentPosteriors(srcSentence, trgSentence, posteriors.mutable_data());
+            return posteriors;
+          },
+          py::arg("src_sentence"), py::arg("trg_sentence"))
+      .def(
+          "get_alignment_posteriors",
+          [](AlignmentModel& model, const std::vector<std::vector<std::string>>& srcSentences,
+             const std::vector<std::vector<std::string>>& trgSentences) {
+            if (srcSentences.size() != trgSentences.size())
+              throw py::value_error("The number of source and target sentences must be the same.");
+            std::vector<WordIndex> srcWordIndices, trgWordIndices;
+            std::vector<size_t> srcOffsets, trgOffsets;
+            {
+              py::gil_scoped_release release;
+              encodeTokens(model, srcSentences, true, srcWordIndices, srcOffsets);
+              encodeTokens(model, trgSentences, false, trgWordIndices, trgOffsets);
+            }
+            return getAlignmentPosteriors(model, srcWordIndices, srcOffsets, trgWordIndices, trgOffsets);
+          },
+          py::arg("src_sentences"), py::arg("trg_sentences"))
+      .def(
+          "get_alignment_posteriors",
+          [](AlignmentModel& model, const std::vector<std::vector<WordIndex>>& srcSentences,
+             const std::vector<std::vector<WordIndex>>& trgSentences) {
+            if (srcSentences.size() != trgSentences.size())
+              throw py::value_error("The number of source and target sentences must be the same.");
+            std::vector<WordIndex> srcWordIndices, trgWordIndices;
+            std::vector<size_t> srcOffsets, trgOffsets;
+            flattenSentences(srcSentences, srcWordIndices, srcOffsets);
+            flattenSentences(trgSentences, trgWordIndices, trgOffsets);
+            return getAlignmentPosteriors(model, srcWordIndices, srcOffsets, trgWordIndices, trgOffsets);
+          },
+          py::arg("src_sentences"), py::arg("trg_sentences"))
       .def(
           "get_translations",
           [](AlignmentModel& model, WordIndex s, double threshold) {
@@ -759,6 +1054,7 @@ PYBIND11_MODULE(thot, m)
           "translate_batch",
           [](multi_stack_decoder_rec<PhrLocalSwLiTm>& decoder, const std::vector<std::string>& sentences) {
             std::vector<TranslationData> results(sentences.size());
+            py::gil_scoped_release release;
 #pragma omp parallel num_threads(NUM_TRANSLATE_THREADS)
             {
               multi_stack_decoder_rec<PhrLocalSwLiTm> threadDecoder;
@@ -790,6 +1086,7 @@ PYBIND11_MODULE(thot, m)
           "translate_n_batch",
           [](multi_stack_decoder_rec<PhrLocalSwLiTm>& decoder, const std::vector<std::string>& sentences, int n) {
             std::vector<std::vector<TranslationData>> results(sentences.size());
+            py::gil_scoped_release release;
 #pragma omp parallel num_threads(NUM_TRANSLATE_THREADS)
             {
               multi_stack_decoder_rec<PhrLocalSwLiTm> threadDecoder;
@@ -878,6 +1175,13 @@ PYBIND11_MODULE(thot, m)
       .def_readwrite("count_spurious", &PhraseExtractParameters::countSpurious)
       .def_readwrite("max_combs_in_table", &PhraseExtractParameters::maxNumbOfCombsInTable);
 
+  py::class_<PhraseTablePruningParameters>(translation, "PhraseTablePruningParameters")
+      .def(py::init())
+      .def_readwrite("max_target_phrases_per_source", &PhraseTablePruningParameters::maxTrgPhrasesPerSrc)
+      .def_readwrite("min_pair_count", &PhraseTablePruningParameters::minPairCount)
+      .def_readwrite("min_significance", &PhraseTablePruningParameters::minSignificance)
+      .def_readwrite("num_sentence_pairs", &PhraseTablePruningParameters::numSentencePairs);
+
   py::class_<WbaIncrPhraseModel>(translation, "PhraseModel")
       .def(py::init())
       .def(
@@ -886,12 +1190,55 @@ PYBIND11_MODULE(thot, m)
             return model.generateWbaIncrPhraseModel(aligFileName, phePars, pseudoML) == THOT_OK;
           },
           py::arg("alignment_filename"), py::arg("parameters"), py::arg("pseudo_ml"))
+      .def(
+          "build_phrase_table",
+          [](WbaIncrPhraseModel& model, const char* aligFileName, PhraseExtractParameters phePars, bool pseudoML,
+             const char* outputFileName, size_t memoryLimit, const std::string& tempDir,
+             const PhraseTablePruningParameters& pruningPars) {
+            ExternalPhraseTableBuilder builder;
+            if (memoryLimit > 0)
+              builder.setMemoryLimit(memoryLimit);
+            builder.setTempDir(tempDir);
+            builder.setPruningParameters(pruningPars);
+            return model.buildPhraseTable(aligFileName, phePars, pseudoML, builder, outputFileName) == THOT_OK;
+          },
+          py::arg("alignment_filename"), py::arg("parameters"), py::arg("pseudo_ml"), py::arg("output_filename"),
+          py::arg("memory_limit") = 0, py::arg("temp_dir") = "",
+          py::arg("pruning_parameters") = PhraseTablePruningParameters())
+      .def(
+          "build_from_aligner",
+          [](WbaIncrPhraseModel& model, Aligner& aligner, const char* srcFileName, const char* trgFileName,
+             PhraseExtractParameters phePars, bool pseudoML) {
+            model.clear();
+            return model.extendModelFromAligner(aligner, srcFileName, trgFileName, phePars, pseudoML) == THOT_OK;
+          },
+          py::arg("aligner"), py::arg("source_filename"), py::arg("target_filename"), py::arg("parameters"),
+          py::arg("pseudo_ml"))
+      .def(
+          "build_phrase_table_from_aligner",
+          [](WbaIncrPhraseModel& model, Aligner& aligner, const char* srcFileName, const char* trgFileName,
+             PhraseExtractParameters phePars, bool pseudoML, const char* outputFileName, size_t memoryLimit,
+             const std::string& tempDir, const PhraseTablePruningParameters& pruningPars) {
+            ExternalPhraseTableBuilder builder;
+            if (memoryLimit > 0)
+              builder.setMemoryLimit(memoryLimit);
+            builder.setTempDir(tempDir);
+            builder.setPruningParameters(pruningPars);
+            return model.buildPhraseTableFromAligner(aligner, srcFileName, trgFileName, phePars, pseudoML, builder,
+                                                     outputFileName)
+                == THOT_OK;
+          },
+          py::arg("aligner"), py::arg("source_filename"), py::arg("target_filename"), py::arg("parameters"),
+          py::arg("pseudo_ml"), py::arg("output_filename"), py::arg("memory_limit") = 0, py::arg("temp_dir") = "",
+          py::arg("pruning_parameters") = PhraseTablePruningParameters())
       .def(
           "print_phrase_table",
           [](WbaIncrPhraseModel& model, const char* fileName, int n) {
             return model.printPhraseTable(fileName, n) == THOT_OK;
           },
           py::arg("filename"), py::arg("n") = -1)
+      .def_property("extraction_batch_size", &WbaIncrPhraseModel::getExtractionBatchSize,
+                    &WbaIncrPhraseModel::setExtractionBatchSize)
       .def("clear", &WbaIncrPhraseModel::clear);
 
   py::class_<AlignmentExtractor>(translation, "AlignmentExtractor")
@@ -5,6 +5,7 @@
 
 #include "incr_models/IncrJelMerNgramLM.h"
 #include "incr_models/WordPenaltyModel.h"
+#include "nlp_common/StrProcUtils.h"
 #include "phrase_models/WbaIncrPhraseModel.h"
 #include "stack_dec/BasePbTransModel.h"
 #include "stack_dec/KbMiraLlWu.h"
@@ -27,8 +28,12 @@
 #include "sw_models/IncrHmmAlignmentModel.h"
 #include "sw_models/IncrIbm1AlignmentModel.h"
 #include "sw_models/IncrIbm2AlignmentModel.h"
+#include "sw_models/SymmetrizedAligner.h"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <omp.h>
 #include <sstream>
 
 struct SmtModelInfo
@@ -38,6 +43,12 @@ struct SmtModelInfo
   std::string tmFileNamePrefix;
 };
 
+struct AlignmentBatch
+{
+  std::vector<LgProb> logProbs;
+  std::vector<WordAlignmentMatrix> waMatrices;
+};
+
 struct WordGraphInfo
 {
   std::string wordGraphStr;
@@ -55,30 +66,80 @@ unsigned int copyString(const std::string& result, char* cstring, unsigned int c
   return (unsigned int)result.length();
 }
 
+void encodeSentences(const Aligner& aligner, const char** sentences, unsigned int count, bool source,
+                     std::vector<WordIndex>& wordIndices, std::vector<size_t>& wordOffsets)
+{
+  std::vector<size_t> sentenceOffsets(count + 1, 0);
+  for (unsigned int s = 0; s < count; ++s)
+    sentenceOffsets[s + 1] = sentenceOffsets[s] + strlen(sentences[s]);
+  std::string buffer;
+  buffer.reserve(sentenceOffsets[count]);
+  for (unsigned int s = 0; s < count; ++s)
+    buffer += sentences[s];
+
+  wordOffsets.resize(count + 1);
+  wordIndices.resize(StrProcUtils::countSentenceWords(buffer.data(), sentenceOffsets.data(), count, wordOffsets.data()));
+  if (source)
+    aligner.encodeSrcSentences(buffer.data(), sentenceOffsets.data(), count, wordOffsets.data(), wordIndices.data());
+  else
+    aligner.encodeTrgSentences(buffer.data(), sentenceOffsets.data(), count, wordOffsets.data(), wordIndices.data());
+}
+
 std::vector<WordIndex> getWordIndices(AlignmentModel* alignmentModel, const char* sentence, bool source)
 {
   std::vector<WordIndex> wordIndices;
-  size_t i = 0;
-  std::string s;
-  while (sentence[i] != 0)
+  std::vector<size_t> wordOffsets;
+  encodeSentences(*alignmentModel, &sentence, 1, source, wordIndices, wordOffsets);
+  return wordIndices;
+}
+
+AlignmentBatch* getBestAlignments(Aligner& aligner, const char** sourceSentences, const char** targetSentences,
+                                  unsigned int count)
+{
+  std::vector<WordIndex> srcWordIndices, trgWordIndices;
+  std::vector<size_t> srcOffsets, trgOffsets;
+  encodeSentences(aligner, sourceSentences, count, true, srcWordIndices, srcOffsets);
+  encodeSentences(aligner, targetSentences, count, false, trgWordIndices, trgOffsets);
+
+  auto batch = new AlignmentBatch;
+  batch->logProbs.resize(count);
+  batch->waMatrices.resize(count);
+  aligner.getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(), trgOffsets.data(), count,
+                            batch->logProbs.data(), batch->waMatrices.data());
+  return batch;
+}
+
+// Sets the number of OpenMP threads used by the calling thread while the object is alive, zero keeps the
+// current setting. The setting is restored afterwards, so that concurrent callers do not affect each other
+class ScopedNumThreads
+{
+public:
+  ScopedNumThreads(unsigned int numThreads) : prevNumThreads{omp_get_max_threads()}
   {
-    s = "";
-    while (sentence[i] == ' ' && sentence[i] != 0)
-    {
-      ++i;
-    }
-    while (sentence[i] != ' ' && sentence[i] != 0)
-    {
-      s = s + sentence[i];
-      ++i;
-    }
-    if (s != "")
-    {
-      WordIndex wordIndex = source ? alignmentModel->stringToSrcWordIndex(s) : alignmentModel->stringToTrgWordIndex(s);
-      wordIndices.push_back(wordIndex);
-    }
+    if (numThreads > 0)
+      omp_set_num_threads((int)numThreads);
+  }
+
+  ~ScopedNumThreads()
+  {
+    omp_set_num_threads(prevNumThreads);
+  }
+
+private:
+  int prevNumThreads;
+};
+
+// The alignment of target word j of pair k is written at alignments[trgOffsets[k] + j], and it is the source
+// position aligned with it, 1-based, or 0 if the word is aligned with NULL
+void copyAlignmentVectors(const std::vector<WordAlignmentMatrix>& waMatrices, const std::vector<size_t>& trgOffsets,
+                          unsigned int* alignments)
+{
+  std::vector<PositionIndex> aligVec;
+  for (size_t k = 0; k < waMatrices.size(); ++k)
+  {
+    waMatrices[k].getAligVec(aligVec);
+    std::copy(aligVec.begin(), aligVec.end(), alignments + trgOffsets[k]);
   }
-  return wordIndices;
 }
 
 AlignmentModel* createAlignmentModel(int type, AlignmentModel* model = nullptr)
@@ -546,6 +607,28 @@ extern "C"
     return alignmentModel;
   }
 
+  void* swAlignModel_openContainer(int type, const char* fileName)
+  {
+    AlignmentModel* alignmentModel = createAlignmentModel(type);
+    if (alignmentModel->loadContainer(fileName) == THOT_ERROR)
+    {
+      delete alignmentModel;
+      return NULL;
+    }
+    return alignmentModel;
+  }
+
+  void* swAlignModel_openCheckpoint(int type, const char* prefFileName)
+  {
+    AlignmentModel* alignmentModel = createAlignmentModel(type);
+    if (alignmentModel->loadCheckpoint(prefFileName) == THOT_ERROR)
+    {
+      delete alignmentModel;
+      return NULL;
+    }
+    return alignmentModel;
+  }
+
   unsigned int swAlignModel_getMaxSentenceLength(void* swAlignModelHandle)
   {
     auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
@@ -789,6 +872,20 @@ extern "C"
       alignmentModel->train();
   }
 
+  bool swAlignModel_readHeldOutSentencePairs(void* swAlignModelHandle, const char* sourceFilename,
+                                             const char* targetFilename)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    return alignmentModel->readHeldOutSentencePairs(sourceFilename, targetFilename) == THOT_OK;
+  }
+
+  unsigned int swAlignModel_trainWithEarlyStopping(void* swAlignModelHandle, unsigned int maxIters,
+                                                   double minRelImprovement)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    return alignmentModel->trainIterations(maxIters, minRelImprovement);
+  }
+
   void swAlignModel_endTraining(void* swAlignModelHandle)
   {
     auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
@@ -801,6 +898,18 @@ extern "C"
     alignmentModel->print(prefFileName);
   }
 
+  bool swAlignModel_saveContainer(void* swAlignModelHandle, const char* fileName)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    return alignmentModel->printContainer(fileName) == THOT_OK;
+  }
+
+  bool swAlignModel_saveCheckpoint(void* swAlignModelHandle, const char* prefFileName)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    return alignmentModel->printCheckpoint(prefFileName) == THOT_OK;
+  }
+
   double swAlignModel_getTranslationProbability(void* swAlignModelHandle, const char* srcWord, const char* trgWord)
   {
     auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
@@ -849,9 +958,9 @@ extern "C"
 
     WordAlignmentMatrix waMatrix;
     LgProb prob = alignmentModel->getBestAlignment(sourceWordIndices, targetWordIndices, waMatrix);
-    for (unsigned int i = 0; i < *iLen; i++)
+    for (unsigned int i = 0; i < *iLen && i < waMatrix.get_I(); i++)
     {
-      for (unsigned int j = 0; j < *jLen; j++)
+      for (unsigned int j = 0; j < *jLen && j < waMatrix.get_J(); j++)
         matrix[i][j] = waMatrix.getValue(i, j);
     }
     *iLen = waMatrix.get_I();
@@ -914,6 +1023,149 @@ extern "C"
     delete targetWordsPtr;
   }
 
+  void* swAlignModel_getBestAlignments(void* swAlignModelHandle, const char** sourceSentences,
+                                       const char** targetSentences, unsigned int count)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    return getBestAlignments(*alignmentModel, sourceSentences, targetSentences, count);
+  }
+
+  bool swAlignModel_getBestAlignmentVectors(void* swAlignModelHandle, const char** sourceSentences,
+                                            const char** targetSentences, unsigned int count, unsigned int numThreads,
+                                            double* logProbs, unsigned int* targetOffsets, unsigned int* alignments,
+                                            unsigned int capacity, unsigned int* size)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    ScopedNumThreads scopedNumThreads(numThreads);
+    std::vector<WordIndex> srcWordIndices, trgWordIndices;
+    std::vector<size_t> srcOffsets, trgOffsets;
+    encodeSentences(*alignmentModel, sourceSentences, count, true, srcWordIndices, srcOffsets);
+    encodeSentences(*alignmentModel, targetSentences, count, false, trgWordIndices, trgOffsets);
+    // Nothing is aligned if the alignment vectors do not fit, the caller can retry with the size
+    *size = (unsigned int)trgWordIndices.size();
+    if (trgWordIndices.size() > capacity)
+      return false;
+
+    std::vector<LgProb> lgProbs(count);
+    std::vector<WordAlignmentMatrix> waMatrices(count);
+    alignmentModel->getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(),
+                                      trgOffsets.data(), count, lgProbs.data(), waMatrices.data());
+    for (unsigned int k = 0; k < count; ++k)
+      logProbs[k] = lgProbs[k];
+    std::copy(trgOffsets.begin(), trgOffsets.end(), targetOffsets);
+    copyAlignmentVectors(waMatrices, trgOffsets, alignments);
+    return true;
+  }
+
+  void swAlignModel_getBestAlignmentVectorsByIndex(void* swAlignModelHandle, const unsigned int* sourceWordIndices,
+                                                   const unsigned int* sourceOffsets,
+                                                   const unsigned int* targetWordIndices,
+                                                   const unsigned int* targetOffsets, unsigned int count,
+                                                   unsigned int numThreads, double* logProbs, unsigned int* alignments)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    ScopedNumThreads scopedNumThreads(numThreads);
+    std::vector<WordIndex> srcWordIndices(sourceWordIndices, sourceWordIndices + sourceOffsets[count]);
+    std::vector<WordIndex> trgWordIndices(targetWordIndices, targetWordIndices + targetOffsets[count]);
+    std::vector<size_t> srcOffsets(sourceOffsets, sourceOffsets + count + 1);
+    std::vector<size_t> trgOffsets(targetOffsets, targetOffsets + count + 1);
+
+    std::vector<LgProb> lgProbs(count);
+    std::vector<WordAlignmentMatrix> waMatrices(count);
+    alignmentModel->getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(),
+                                      trgOffsets.data(), count, lgProbs.data(), waMatrices.data());
+    for (unsigned int k = 0; k < count; ++k)
+      logProbs[k] = lgProbs[k];
+    copyAlignmentVectors(waMatrices, trgOffsets, alignments);
+  }
+
+  bool swAlignModel_getBestAlignmentsForFiles(void* swAlignModelHandle, const char* sourceFilename,
+                                              const char* targetFilename, const char* outputFilename,
+                                              unsigned int numThreads)
+  {
+    auto alignmentModel = static_cast<AlignmentModel*>(swAlignModelHandle);
+    ScopedNumThreads scopedNumThreads(numThreads);
+    return alignmentModel->getBestAlignments(sourceFilename, targetFilename, outputFilename) == THOT_OK;
+  }
+
+  void* symmAligner_create(void* directSwAlignModelHandle, void* inverseSwAlignModelHandle)
+  {
+    // The models are owned by the caller, so the aligner does not delete them
+    auto noDelete = [](Aligner*) {};
+    std::shared_ptr<Aligner> directAligner(static_cast<AlignmentModel*>(directSwAlignModelHandle), noDelete);
+    std::shared_ptr<Aligner> inverseAligner(static_cast<AlignmentModel*>(inverseSwAlignModelHandle), noDelete);
+    return new SymmetrizedAligner(directAligner, inverseAligner);
+  }
+
+  void symmAligner_setHeuristic(void* symmAlignerHandle, int heuristic)
+  {
+    auto symmAligner = static_cast<SymmetrizedAligner*>(symmAlignerHandle);
+    symmAligner->setHeuristic((SymmetrizationHeuristic)heuristic);
+  }
+
+  int symmAligner_getHeuristic(void* symmAlignerHandle)
+  {
+    auto symmAligner = static_cast<SymmetrizedAligner*>(symmAlignerHandle);
+    return (int)symmAligner->getHeuristic();
+  }
+
+  void* symmAligner_getBestAlignments(void* symmAlignerHandle, const char** sourceSentences,
+                                      const char** targetSentences, unsigned int count)
+  {
+    auto symmAligner = static_cast<SymmetrizedAligner*>(symmAlignerHandle);
+    return getBestAlignments(*symmAligner, sourceSentences, targetSentences, count);
+  }
+
+  void symmAligner_destroy(void* symmAlignerHandle)
+  {
+    auto symmAligner = static_cast<SymmetrizedAligner*>(symmAlignerHandle);
+    delete symmAligner;
+  }
+
+  unsigned int alignBatch_getCount(void* alignBatchHandle)
+  {
+    auto batch = static_cast<AlignmentBatch*>(alignBatchHandle);
+    return (unsigned int)batch->logProbs.size();
+  }
+
+  double alignBatch_getLogProbability(void* alignBatchHandle, unsigned int index)
+  {
+    auto batch = static_cast<AlignmentBatch*>(alignBatchHandle);
+    return batch->logProbs[index];
+  }
+
+  unsigned int alignBatch_getAlignment(void* alignBatchHandle, unsigned int index, unsigned int* sourceIndices,
+                                       unsigned int* targetIndices, unsigned int capacity)
+  {
+    auto batch = static_cast<AlignmentBatch*>(alignBatchHandle);
+    const WordAlignmentMatrix& waMatrix = batch->waMatrices[index];
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < waMatrix.get_I(); ++i)
+    {
+      for (unsigned int j = 0; j < waMatrix.get_J(); ++j)
+      {
+        if (waMatrix.getValue(i, j))
+        {
+          if (count < capacity)
+          {
+            if (sourceIndices != NULL)
+              sourceIndices[count] = i;
+            if (targetIndices != NULL)
+              targetIndices[count] = j;
+          }
+          ++count;
+        }
+      }
+    }
+    return count;
+  }
+
+  void alignBatch_destroy(void* alignBatchHandle)
+  {
+    auto batch = static_cast<AlignmentBatch*>(alignBatchHandle);
+    delete batch;
+  }
+
   bool giza_symmetr1(const char* lhsFileName, const char* rhsFileName, const char* outputFileName, bool transpose)
   {
     AlignmentExtractor alExt;
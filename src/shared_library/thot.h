@@ -106,6 +106,10 @@ extern "C"
 
   THOT_API void* swAlignModel_open(int type, const char* prefFileName);
 
+  THOT_API void* swAlignModel_openContainer(int type, const char* fileName);
+
+  THOT_API void* swAlignModel_openCheckpoint(int type, const char* prefFileName);
+
   THOT_API unsigned int swAlignModel_getMaxSentenceLength(void* swAlignModelHandle);
 
   THOT_API void swAlignModel_setVariationalBayes(void* swAlignModelHandle, bool variationalBayes);
@@ -175,10 +179,20 @@ extern "C"
 
   THOT_API void swAlignModel_train(void* swAlignModelHandle, unsigned int numIters);
 
+  THOT_API bool swAlignModel_readHeldOutSentencePairs(void* swAlignModelHandle, const char* sourceFilename,
+                                                      const char* targetFilename);
+
+  THOT_API unsigned int swAlignModel_trainWithEarlyStopping(void* swAlignModelHandle, unsigned int maxIters,
+                                                            double minRelImprovement);
+
   THOT_API void swAlignModel_endTraining(void* swAlignModelHandle);
 
   THOT_API void swAlignModel_save(void* swAlignModelHandle, const char* prefFileName);
 
+  THOT_API bool swAlignModel_saveContainer(void* swAlignModelHandle, const char* fileName);
+
+  THOT_API bool swAlignModel_saveCheckpoint(void* swAlignModelHandle, const char* prefFileName);
+
   THOT_API double swAlignModel_getTranslationProbability(void* swAlignModelHandle, const char* srcWord,
                                                          const char* trgWord);
 
@@ -209,6 +223,47 @@ extern "C"
 
   THOT_API void swAlignTrans_destroy(void* swAlignTransHandle);
 
+  THOT_API void* swAlignModel_getBestAlignments(void* swAlignModelHandle, const char** sourceSentences,
+                                                const char** targetSentences, unsigned int count);
+
+  THOT_API bool swAlignModel_getBestAlignmentVectors(void* swAlignModelHandle, const char** sourceSentences,
+                                                     const char** targetSentences, unsigned int count,
+                                                     unsigned int numThreads, double* logProbs,
+                                                     unsigned int* targetOffsets, unsigned int* alignments,
+                                                     unsigned int capacity, unsigned int* size);
+
+  THOT_API void swAlignModel_getBestAlignmentVectorsByIndex(void* swAlignModelHandle,
+                                                            const unsigned int* sourceWordIndices,
+                                                            const unsigned int* sourceOffsets,
+                                                            const unsigned int* targetWordIndices,
+                                                            const unsigned int* targetOffsets, unsigned int count,
+                                                            unsigned int numThreads, double* logProbs,
+                                                            unsigned int* alignments);
+
+  THOT_API bool swAlignModel_getBestAlignmentsForFiles(void* swAlignModelHandle, const char* sourceFilename,
+                                                       const char* targetFilename, const char* outputFilename,
+                                                       unsigned int numThreads);
+
+  THOT_API void* symmAligner_create(void* directSwAlignModelHandle, void* inverseSwAlignModelHandle);
+
+  THOT_API void symmAligner_setHeuristic(void* symmAlignerHandle, int heuristic);
+
+  THOT_API int symmAligner_getHeuristic(void* symmAlignerHandle);
+
+  THOT_API void* symmAligner_getBestAlignments(void* symmAlignerHandle, const char** sourceSentences,
+                                               const char** targetSentences, unsigned int count);
+
+  THOT_API void symmAligner_destroy(void* symmAlignerHandle);
+
+  THOT_API unsigned int alignBatch_getCount(void* alignBatchHandle);
+
+  THOT_API double alignBatch_getLogProbability(void* alignBatchHandle, unsigned int index);
+
+  THOT_API unsigned int alignBatch_getAlignment(void* alignBatchHandle, unsigned int index, unsigned int* sourceIndices,
+                                                unsigned int* targetIndices, unsigned int capacity);
+
+  THOT_API void alignBatch_destroy(void* alignBatchHandle);
+
   THOT_API bool giza_symmetr1(const char* lhsFileName, const char* rhsFileName, const char* outputFileName,
                               bool transpose);
 
@@ -116,17 +116,17 @@ void DirectPhraseModelFeat<SCORE_INFO>::obtainTransOptions(const std::vector<std
     wordIdxVec.push_back(this->stringToSrcWordindex(wordVec[i]));
 
   // Obtain translation options
-  BasePhraseModel::SrcTableNode srctn;
-  this->invPbModelPtr->getTransFor_t_(wordIdxVec, srctn);
+  PhraseNbestListView view;
+  this->invPbModelPtr->getNbestTransViewFor_t_(wordIdxVec, view);
 
   // Put options in vector
   transOptVec.clear();
-  for (BasePhraseModel::SrcTableNode::iterator iter = srctn.begin(); iter != srctn.end(); ++iter)
+  for (PhraseNbestListView::const_iterator iter = view.begin(); iter != view.end(); ++iter)
   {
     // Convert option to string vector
     std::vector<std::string> transOpt;
-    for (unsigned int i = 0; i < iter->first.size(); ++i)
-      transOpt.push_back(this->wordindexToTrgString(iter->first[i]));
+    for (unsigned int i = 0; i < iter->second.size(); ++i)
+      transOpt.push_back(this->wordindexToTrgString(iter->second[i]));
 
     // Add new entry
     transOptVec.push_back(transOpt);
@@ -26,6 +26,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 //--------------- Include files --------------------------------------
 
+#include "phrase_models/PhraseVocabulary.h"
 #include "stack_dec/PhrNbestTransTable.h"
 #include "stack_dec/PhrNbestTransTablePref.h"
 #include "stack_dec/PhrNbestTransTableRef.h"
@@ -37,8 +38,12 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 class NbestTransCacheData
 {
 public:
+  // Ids of the phrases used as keys of the caches below
+  PhraseVocabulary srcPhraseVocab;
+  PhraseVocabulary trgPhraseVocab;
+
   // Cached n-best lm scores
-  PhraseCacheTable cnbLmScores;
+  PhraseIdCacheTable cnbLmScores;
 
   // Cached translation table to store phrase N-best translations
   PhrNbestTransTable cPhrNbestTransTable;
@@ -50,12 +55,30 @@ public:
   // Cached n-best translations scores (these cached scores are
   // those generated by the nbestTransScore() and
   // nbestTransScoreLast() functions)
-  PhrasePairCacheTable cnbestTransScore;
-  PhrasePairCacheTable cnbestTransScoreLast;
+  PhrasePairIdCacheTable cnbestTransScore;
+  PhrasePairIdCacheTable cnbestTransScoreLast;
+
+  // Phrases are interned once, when the translation options of a
+  // source phrase are collected or a hypothesis is extended, and the
+  // ids are passed to the scoring functions from then on
+  PhraseId srcPhraseId(const std::vector<WordIndex>& s)
+  {
+    return srcPhraseVocab.add(s);
+  }
+  PhraseId trgPhraseId(const std::vector<WordIndex>& t)
+  {
+    return trgPhraseVocab.add(t);
+  }
+  PhrasePairId phrasePairId(PhraseId srcId, const std::vector<WordIndex>& t)
+  {
+    return makePhrasePairId(srcId, trgPhraseVocab.add(t));
+  }
 
   // Function to clear cached data
   void clear(void)
   {
+    srcPhraseVocab.clear();
+    trgPhraseVocab.clear();
     cnbLmScores.clear();
     cPhrNbestTransTable.clear();
     cPhrNbestTransTableRef.clear();
@@ -22,6 +22,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 #include "nlp_common/PositionIndex.h"
 #include "nlp_common/WordIndex.h"
+#include "phrase_models/PhraseId.h"
 #include "stack_dec/SourceSegmentation.h"
 
 #include <vector>
@@ -37,5 +38,10 @@ public:
   // Translation model info
   SourceSegmentation sourceSegmentation;
   std::vector<PositionIndex> targetSegmentCuts;
+
+  // Ids of the phrase pair of each segment in the caches of the
+  // translation model, filled by the models that cache phrase pair
+  // scores while the sentence is translated
+  std::vector<PhrasePairId> phrasePairIds;
 };
 
@@ -275,14 +275,17 @@ double PhrLocalSwLiTm::phraseModelPerplexity(const std::vector<std::vector<Phras
       std::vector<WordIndex> srcPhrasePair = strVectorToSrcIndexVector(invPhrPairs[i][j].t_);
       std::vector<WordIndex> trgPhrasePair = strVectorToTrgIndexVector(invPhrPairs[i][j].s_);
 
+      PhrasePairId pairId =
+          nbTransCacheData.phrasePairId(nbTransCacheData.srcPhraseId(srcPhrasePair), trgPhrasePair);
+
       // Obtain unweighted score for target given source
-      std::vector<Score> logptsScrVec = smoothedPhrScoreVec_t_s_(srcPhrasePair, trgPhrasePair);
+      std::vector<Score> logptsScrVec = smoothedPhrScoreVec_t_s_(pairId, srcPhrasePair, trgPhrasePair);
       Score logptsScr = 0;
       for (unsigned int k = 0; k < logptsScrVec.size(); ++k)
         logptsScr += logptsScrVec[k] / this->phraseModelInfo->phraseModelPars.ptsWeightVec[k];
 
       // Obtain unweighted score for source given target
-      std::vector<Score> logpstScrVec = smoothedPhrScoreVec_s_t_(srcPhrasePair, trgPhrasePair);
+      std::vector<Score> logpstScrVec = smoothedPhrScoreVec_s_t_(pairId, srcPhrasePair, trgPhrasePair);
       Score logpstScr = 0;
       for (unsigned int k = 0; k < logpstScrVec.size(); ++k)
         logpstScr += logpstScrVec[k] / this->phraseModelInfo->phraseModelPars.pstWeightVec[k];
@@ -381,6 +384,7 @@ PhrLocalSwLiTm::HypDataType PhrLocalSwLiTm::nullHypothesisHypData(void)
   dataType.ntarget.push_back(NULL_WORD);
   dataType.sourceSegmentation.clear();
   dataType.targetSegmentCuts.clear();
+  dataType.phrasePairIds.clear();
 
   return dataType;
 }
@@ -423,6 +427,9 @@ bool PhrLocalSwLiTm::obtainPredecessorHypData(HypDataType& hypd)
     predData.sourceSegmentation.pop_back();
     // get previous targetSegmentCuts
     predData.targetSegmentCuts.pop_back();
+    // get previous phrasePairIds
+    if (!predData.phrasePairIds.empty())
+      predData.phrasePairIds.pop_back();
     // set data
     hypd = predData;
 
@@ -1232,13 +1239,18 @@ Score PhrLocalSwLiTm::incrScore(const Hypothesis& pred_hyp, const HypDataType& n
       s_.push_back(pbtmInputVars.nsrcSentIdVec[k]);
     }
 
+    // The ids are missing when the data was not built by extendHypDataIdx()
+    PhrasePairId pairId = i < new_hypd.phrasePairIds.size()
+                            ? new_hypd.phrasePairIds[i]
+                            : nbTransCacheData.phrasePairId(nbTransCacheData.srcPhraseId(s_), trgphrase);
+
     // p(t_|s_) smoothed phrase score
-    std::vector<Score> logptsScrVec = smoothedPhrScoreVec_t_s_(s_, trgphrase);
+    std::vector<Score> logptsScrVec = smoothedPhrScoreVec_t_s_(pairId, s_, trgphrase);
     for (unsigned int i = 0; i < logptsScrVec.size(); ++i)
       scoreComponents[PTS + i] += logptsScrVec[i];
 
     // p(s_|t_) smoothed phrase score
-    std::vector<Score> logpstScrVec = smoothedPhrScoreVec_s_t_(s_, trgphrase);
+    std::vector<Score> logpstScrVec = smoothedPhrScoreVec_s_t_(pairId, s_, trgphrase);
     for (unsigned int i = 0; i < logpstScrVec.size(); ++i)
       scoreComponents[PTS + logptsScrVec.size() + i] += logpstScrVec[i];
 
@@ -1277,16 +1289,18 @@ Score PhrLocalSwLiTm::incrScore(const Hypothesis& pred_hyp, const HypDataType& n
   return hypScoreInfo.score;
 }
 
-Score PhrLocalSwLiTm::smoothedPhrScore_s_t_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_)
+Score PhrLocalSwLiTm::smoothedPhrScore_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                          const std::vector<WordIndex>& t_)
 {
-  std::vector<Score> scoreVec = smoothedPhrScoreVec_s_t_(s_, t_);
+  std::vector<Score> scoreVec = smoothedPhrScoreVec_s_t_(pairId, s_, t_);
   Score sum = 0;
   for (unsigned int i = 0; i < scoreVec.size(); ++i)
     sum += scoreVec[i];
   return sum;
 }
 
-Score PhrLocalSwLiTm::regularSmoothedPhrScore_s_t_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_)
+Score PhrLocalSwLiTm::regularSmoothedPhrScore_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                                 const std::vector<WordIndex>& t_)
 {
   if (swModelInfo->lambda_invswm == 1.0)
   {
@@ -1297,25 +1311,26 @@ Score PhrLocalSwLiTm::regularSmoothedPhrScore_s_t_(const std::vector<WordIndex>&
     float sum1 = log(swModelInfo->lambda_invswm) + (float)phraseModelInfo->invPhraseModel->logpt_s_(t_, s_);
     if (sum1 <= log(PHRASE_PROB_SMOOTH))
       sum1 = PHRSWLITM_LGPROB_SMOOTH;
-    float sum2 = log(1.0 - swModelInfo->lambda_invswm) + (float)invSwLgProb(0, s_, t_);
+    float sum2 = log(1.0 - swModelInfo->lambda_invswm) + (float)invSwLgProb(0, pairId, s_, t_);
     float interp = MathFuncs::lns_sumlog(sum1, sum2);
 
     return phraseModelInfo->phraseModelPars.pstWeightVec[0] * (double)interp;
   }
 }
 
-std::vector<Score> PhrLocalSwLiTm::smoothedPhrScoreVec_s_t_(const std::vector<WordIndex>& s_,
+std::vector<Score> PhrLocalSwLiTm::smoothedPhrScoreVec_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
                                                             const std::vector<WordIndex>& t_)
 {
   std::vector<Score> scoreVec;
-  Score score = regularSmoothedPhrScore_s_t_(s_, t_);
+  Score score = regularSmoothedPhrScore_s_t_(pairId, s_, t_);
   scoreVec.push_back(score);
   return scoreVec;
 }
 
-Score PhrLocalSwLiTm::smoothedPhrScore_t_s_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_)
+Score PhrLocalSwLiTm::smoothedPhrScore_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                          const std::vector<WordIndex>& t_)
 {
-  std::vector<Score> scoreVec = smoothedPhrScoreVec_t_s_(s_, t_);
+  std::vector<Score> scoreVec = smoothedPhrScoreVec_t_s_(pairId, s_, t_);
   Score sum = 0;
   for (unsigned int i = 0; i < scoreVec.size(); ++i)
     sum += scoreVec[i];
@@ -1340,7 +1355,8 @@ void PhrLocalSwLiTm::obtainTrgSwVocWordIdxVec(const std::vector<WordIndex>& t_,
   swVoc_t_ = swModelInfo->swAligModels[0]->strVectorToTrgIndexVector(strVec);
 }
 
-Score PhrLocalSwLiTm::regularSmoothedPhrScore_t_s_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_)
+Score PhrLocalSwLiTm::regularSmoothedPhrScore_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                                 const std::vector<WordIndex>& t_)
 {
   if (swModelInfo->lambda_swm == 1.0)
   {
@@ -1351,22 +1367,23 @@ Score PhrLocalSwLiTm::regularSmoothedPhrScore_t_s_(const std::vector<WordIndex>&
     float sum1 = log(swModelInfo->lambda_swm) + (float)phraseModelInfo->invPhraseModel->logps_t_(t_, s_);
     if (sum1 <= log(PHRASE_PROB_SMOOTH))
       sum1 = PHRSWLITM_LGPROB_SMOOTH;
-    float sum2 = log(1.0 - swModelInfo->lambda_swm) + (float)swLgProb(0, s_, t_);
+    float sum2 = log(1.0 - swModelInfo->lambda_swm) + (float)swLgProb(0, pairId, s_, t_);
     float interp = MathFuncs::lns_sumlog(sum1, sum2);
     return phraseModelInfo->phraseModelPars.ptsWeightVec[0] * (double)interp;
   }
 }
 
-std::vector<Score> PhrLocalSwLiTm::smoothedPhrScoreVec_t_s_(const std::vector<WordIndex>& s_,
+std::vector<Score> PhrLocalSwLiTm::smoothedPhrScoreVec_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
                                                             const std::vector<WordIndex>& t_)
 {
   std::vector<Score> scoreVec;
-  Score score = regularSmoothedPhrScore_t_s_(s_, t_);
+  Score score = regularSmoothedPhrScore_t_s_(pairId, s_, t_);
   scoreVec.push_back(score);
   return scoreVec;
 }
 
-Score PhrLocalSwLiTm::nbestTransScore(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_)
+Score PhrLocalSwLiTm::nbestTransScore(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                      const std::vector<WordIndex>& t_)
 {
   Score score = 0;
 
@@ -1374,18 +1391,19 @@ Score PhrLocalSwLiTm::nbestTransScore(const std::vector<WordIndex>& s_, const st
   score += wordPenaltyScore(t_.size());
 
   // Language model contribution
-  score += nbestLmScoringFunc(t_);
+  score += nbestLmScoringFunc(phrasePairTrgId(pairId), t_);
 
   // Phrase model contribution
-  score += smoothedPhrScore_t_s_(s_, t_);
-  score += smoothedPhrScore_s_t_(s_, t_);
+  score += smoothedPhrScore_t_s_(pairId, s_, t_);
+  score += smoothedPhrScore_s_t_(pairId, s_, t_);
 
   return score;
 }
 
-Score PhrLocalSwLiTm::nbestTransScoreLast(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_)
+Score PhrLocalSwLiTm::nbestTransScoreLast(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                          const std::vector<WordIndex>& t_)
 {
-  return nbestTransScore(s_, t_);
+  return nbestTransScore(pairId, s_, t_);
 }
 
 void PhrLocalSwLiTm::extendHypDataIdx(PositionIndex srcLeft, PositionIndex srcRight,
@@ -1405,6 +1423,13 @@ void PhrLocalSwLiTm::extendHypDataIdx(PositionIndex srcLeft, PositionIndex srcRi
   hypd.sourceSegmentation.push_back(sourceSegm);
 
   hypd.targetSegmentCuts.push_back(hypd.ntarget.size() - 1);
+
+  // Intern the phrase pair, so that scoring the hypothesis does not
+  // need to look the phrases up again
+  std::vector<WordIndex> s_;
+  for (PositionIndex j = srcLeft; j <= srcRight; ++j)
+    s_.push_back(pbtmInputVars.nsrcSentIdVec[j]);
+  hypd.phrasePairIds.push_back(nbTransCacheData.phrasePairId(nbTransCacheData.srcPhraseId(s_), trgPhraseIdx));
 }
 
 PositionIndex PhrLocalSwLiTm::getLastSrcPosCoveredHypData(const HypDataType& hypd)
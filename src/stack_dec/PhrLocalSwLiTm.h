@@ -129,22 +129,29 @@ protected:
   // Scoring functions
   Score incrScore(const Hypothesis& prev_hyp, const HypDataType& new_hypd, Hypothesis& new_hyp,
                   std::vector<Score>& scoreComponents);
-  // Phrase model scoring functions
-  Score smoothedPhrScore_s_t_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  Score regularSmoothedPhrScore_s_t_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  std::vector<Score> smoothedPhrScoreVec_s_t_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-
-  Score smoothedPhrScore_t_s_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  Score regularSmoothedPhrScore_t_s_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  std::vector<Score> smoothedPhrScoreVec_t_s_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  // Phrase model scoring functions, pairId is the id of (s_,t_) in
+  // nbTransCacheData
+  Score smoothedPhrScore_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                              const std::vector<WordIndex>& t_);
+  Score regularSmoothedPhrScore_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                     const std::vector<WordIndex>& t_);
+  std::vector<Score> smoothedPhrScoreVec_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                              const std::vector<WordIndex>& t_);
+
+  Score smoothedPhrScore_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                              const std::vector<WordIndex>& t_);
+  Score regularSmoothedPhrScore_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                     const std::vector<WordIndex>& t_);
+  std::vector<Score> smoothedPhrScoreVec_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                              const std::vector<WordIndex>& t_);
 
   // Vocabulary related functions
   void obtainSrcSwVocWordIdxVec(const std::vector<WordIndex>& s_, std::vector<WordIndex>& swVoc_s_);
   void obtainTrgSwVocWordIdxVec(const std::vector<WordIndex>& t_, std::vector<WordIndex>& swVoc_t_);
 
   // Functions to score n-best translations lists
-  Score nbestTransScore(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  Score nbestTransScoreLast(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  Score nbestTransScore(PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  Score nbestTransScoreLast(PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
 
   PositionIndex getLastSrcPosCoveredHypData(const HypDataType& hypd);
   // Get the index of last source position which was covered
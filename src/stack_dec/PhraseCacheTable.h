@@ -21,11 +21,16 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 //--------------- Include files --------------------------------------
 
 #include "nlp_common/Score.h"
+#include "phrase_models/PhraseId.h"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 //--------------- Classes --------------------------------------------
 
 typedef std::map<std::vector<WordIndex>, Score> PhraseCacheTable;
 
+// Cache keyed by the ids given to the phrases by a PhraseVocabulary
+typedef std::unordered_map<PhraseId, Score> PhraseIdCacheTable;
+
@@ -22,8 +22,10 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 #include "nlp_common/Score.h"
 #include "nlp_common/WordIndex.h"
+#include "phrase_models/PhraseId.h"
 
 #include <map>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,3 +33,6 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 
 typedef std::map<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>, Score> PhrasePairCacheTable;
 
+// Cache keyed by the ids of the source and target phrases, see makePhrasePairId()
+typedef std::unordered_map<PhrasePairId, Score> PhrasePairIdCacheTable;
+
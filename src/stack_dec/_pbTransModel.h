@@ -275,9 +275,12 @@ protected:
   // Functions to score n-best translations lists
   Score nbestTransScore(const std::vector<WordIndex>& srcPhrase, const std::vector<WordIndex>& trgPhrase);
   Score nbestTransScoreLast(const std::vector<WordIndex>& srcPhrase, const std::vector<WordIndex>& t_);
-  // Cached functions to score n-best translations lists
-  Score nbestTransScoreCached(const std::vector<WordIndex>& srcPhrase, const std::vector<WordIndex>& t_);
-  Score nbestTransScoreLastCached(const std::vector<WordIndex>& srcPhrase, const std::vector<WordIndex>& t_);
+  // Cached functions to score n-best translations lists, srcId is the
+  // id of srcPhrase in nbTransCacheData
+  Score nbestTransScoreCached(PhraseId srcId, const std::vector<WordIndex>& srcPhrase,
+                              const std::vector<WordIndex>& t_);
+  Score nbestTransScoreLastCached(PhraseId srcId, const std::vector<WordIndex>& srcPhrase,
+                                  const std::vector<WordIndex>& t_);
 
   // Functions related to getTransInPlainTextVec
   std::vector<std::string> getTransInPlainTextVecTs(const Hypothesis& hyp, std::set<PositionIndex>& unknownWords) const;
@@ -1110,7 +1113,7 @@ Score _pbTransModel<HYPOTHESIS>::unkWordScoreHeur(void)
   srcPhrase.push_back(UNK_WORD);
   trgPhrase.push_back(UNK_WORD);
 
-  return nbestTransScoreCached(srcPhrase, trgPhrase);
+  return nbestTransScoreCached(nbTransCacheData.srcPhraseId(srcPhrase), srcPhrase, trgPhrase);
 }
 
 //---------------------------------
@@ -2409,13 +2412,14 @@ bool _pbTransModel<HYPOTHESIS>::getNbestTransForSrcPhrase(std::vector<WordIndex>
   else
   {
     Score scr;
+    PhraseId srcId = nbTransCacheData.srcPhraseId(srcPhrase);
 
     // This loop may become a bottleneck if the number of translation
     // options is high
     for (std::set<std::vector<WordIndex>>::iterator transSetIter = transSet.begin(); transSetIter != transSet.end();
          ++transSetIter)
     {
-      scr = nbestTransScoreCached(srcPhrase, *transSetIter);
+      scr = nbestTransScoreCached(srcId, srcPhrase, *transSetIter);
       nbt.insert(scr, *transSetIter);
     }
   }
@@ -2569,12 +2573,13 @@ void _pbTransModel<HYPOTHESIS>::transUncovGapRefNoLastGapCached(const Hypothesis
   else
   {
     // translations not present in the cache translation table
+    PhraseId srcId = nbTransCacheData.srcPhraseId(srcPhrase);
     for (PositionIndex i = ntarget.size(); i < pbtmInputVars.nrefSentIdVec.size() - pNbtRefKey.numGaps; ++i)
     {
       trgPhrase.push_back(pbtmInputVars.nrefSentIdVec[i]);
       if (trgPhrase.size() >= minTrgSize && trgPhrase.size() <= maxTrgSize)
       {
-        Score scr = nbestTransScoreCached(srcPhrase, trgPhrase);
+        Score scr = nbestTransScoreCached(srcId, srcPhrase, trgPhrase);
         nbt.insert(scr, trgPhrase);
       }
     }
@@ -2622,7 +2627,7 @@ void _pbTransModel<HYPOTHESIS>::transUncovGapRefLastGapCached(const Hypothesis&
   // Obtain translations
   if (trgPhrase.size() >= minTrgSize && trgPhrase.size() <= maxTrgSize)
   {
-    Score scr = nbestTransScoreCached(srcPhrase, trgPhrase);
+    Score scr = nbestTransScoreCached(nbTransCacheData.srcPhraseId(srcPhrase), srcPhrase, trgPhrase);
     nbt.insert(scr, trgPhrase);
   }
 }
@@ -2725,6 +2730,7 @@ void _pbTransModel<HYPOTHESIS>::transUncovGapPrefNoGen(const Hypothesis& hyp, Po
   unsigned int maxTrgSize = srcPhrase.size() + this->pbTransModelPars.E;
 
   unsigned int ntrgSize = hyp.getPartialTrans().size();
+  PhraseId srcId = nbTransCacheData.srcPhraseId(srcPhrase);
 
   // Check if we are covering the last gap of the hypothesis
   if (this->numberOfUncoveredSrcWords(hyp) - (srcRight - srcLeft + 1) > 0)
@@ -2744,7 +2750,7 @@ void _pbTransModel<HYPOTHESIS>::transUncovGapPrefNoGen(const Hypothesis& hyp, Po
         trgPhrase.push_back(pbtmInputVars.nprefSentIdVec[i]);
         if (trgPhrase.size() >= minTrgSize && trgPhrase.size() <= maxTrgSize)
         {
-          Score scr = nbestTransScoreCached(srcPhrase, trgPhrase);
+          Score scr = nbestTransScoreCached(srcId, srcPhrase, trgPhrase);
           nbt.insert(scr, trgPhrase);
         }
       }
@@ -2763,7 +2769,7 @@ void _pbTransModel<HYPOTHESIS>::transUncovGapPrefNoGen(const Hypothesis& hyp, Po
   std::vector<WordIndex> remainingPref;
   for (unsigned int i = ntrgSize; i < pbtmInputVars.nprefSentIdVec.size(); ++i)
     remainingPref.push_back(pbtmInputVars.nprefSentIdVec[i]);
-  nbt.insert(nbestTransScoreLastCached(srcPhrase, remainingPref), remainingPref);
+  nbt.insert(nbestTransScoreLastCached(srcId, srcPhrase, remainingPref), remainingPref);
 }
 
 //---------------------------------
@@ -2783,6 +2789,7 @@ void _pbTransModel<HYPOTHESIS>::genListOfTransLongerThanPref(std::vector<WordInd
   // Obtain translations for source segment srcPhrase
   std::set<std::vector<WordIndex>> transSet;
   getTransForSrcPhrase(srcPhrase, transSet);
+  PhraseId srcId = nbTransCacheData.srcPhraseId(srcPhrase);
   for (std::set<std::vector<WordIndex>>::iterator transSetIter = transSet.begin(); transSetIter != transSet.end();
        ++transSetIter)
   {
@@ -2799,7 +2806,7 @@ void _pbTransModel<HYPOTHESIS>::genListOfTransLongerThanPref(std::vector<WordInd
         // Filter translations not exactly equal to "remainingPref"
         if (!equal)
         {
-          Score scr = nbestTransScoreLastCached(srcPhrase, *transSetIter);
+          Score scr = nbestTransScoreLastCached(srcId, srcPhrase, *transSetIter);
           nbt.insert(scr, *transSetIter);
         }
       }
@@ -2843,11 +2850,11 @@ bool _pbTransModel<HYPOTHESIS>::trgWordVecIsPrefix(const std::vector<WordIndex>&
 
 //---------------------------------
 template <class HYPOTHESIS>
-Score _pbTransModel<HYPOTHESIS>::nbestTransScoreCached(const std::vector<WordIndex>& srcPhrase,
+Score _pbTransModel<HYPOTHESIS>::nbestTransScoreCached(PhraseId srcId, const std::vector<WordIndex>& srcPhrase,
                                                        const std::vector<WordIndex>& trgPhrase)
 {
-  PhrasePairCacheTable::iterator ppctIter;
-  ppctIter = nbTransCacheData.cnbestTransScore.find(std::make_pair(srcPhrase, trgPhrase));
+  PhrasePairId pairId = nbTransCacheData.phrasePairId(srcId, trgPhrase);
+  PhrasePairIdCacheTable::iterator ppctIter = nbTransCacheData.cnbestTransScore.find(pairId);
   if (ppctIter != nbTransCacheData.cnbestTransScore.end())
   {
     // Score was previously stored in the cache table
@@ -2857,18 +2864,18 @@ Score _pbTransModel<HYPOTHESIS>::nbestTransScoreCached(const std::vector<WordInd
   {
     // Score is not stored in the cache table
     Score scr = nbestTransScore(srcPhrase, trgPhrase);
-    nbTransCacheData.cnbestTransScore[std::make_pair(srcPhrase, trgPhrase)] = scr;
+    nbTransCacheData.cnbestTransScore[pairId] = scr;
     return scr;
   }
 }
 
 //---------------------------------
 template <class HYPOTHESIS>
-Score _pbTransModel<HYPOTHESIS>::nbestTransScoreLastCached(const std::vector<WordIndex>& srcPhrase,
+Score _pbTransModel<HYPOTHESIS>::nbestTransScoreLastCached(PhraseId srcId, const std::vector<WordIndex>& srcPhrase,
                                                            const std::vector<WordIndex>& trgPhrase)
 {
-  PhrasePairCacheTable::iterator ppctIter;
-  ppctIter = nbTransCacheData.cnbestTransScoreLast.find(std::make_pair(srcPhrase, trgPhrase));
+  PhrasePairId pairId = nbTransCacheData.phrasePairId(srcId, trgPhrase);
+  PhrasePairIdCacheTable::iterator ppctIter = nbTransCacheData.cnbestTransScoreLast.find(pairId);
   if (ppctIter != nbTransCacheData.cnbestTransScoreLast.end())
   {
     // Score was previously stored in the cache table
@@ -2878,7 +2885,7 @@ Score _pbTransModel<HYPOTHESIS>::nbestTransScoreLastCached(const std::vector<Wor
   {
     // Score is not stored in the cache table
     Score scr = nbestTransScoreLast(srcPhrase, trgPhrase);
-    nbTransCacheData.cnbestTransScoreLast[std::make_pair(srcPhrase, trgPhrase)] = scr;
+    nbTransCacheData.cnbestTransScoreLast[pairId] = scr;
     return scr;
   }
 }
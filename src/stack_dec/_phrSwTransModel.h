@@ -77,13 +77,15 @@ protected:
   std::vector<std::vector<uint_pair>> lenRangeForGaps;
 
   // Cached scores
-  std::vector<PhrasePairCacheTable> cSwmScoreVec;
-  std::vector<PhrasePairCacheTable> cInvSwmScoreVec;
+  std::vector<PhrasePairIdCacheTable> cSwmScoreVec;
+  std::vector<PhrasePairIdCacheTable> cInvSwmScoreVec;
 
-  Score invSwScore(int idx, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  Score swScore(int idx, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  LgProb swLgProb(int idx, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  LgProb invSwLgProb(int idx, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  // pairId is the id of (s_,t_) in the cache data of the n-best
+  // translations
+  Score invSwScore(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  Score swScore(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  LgProb swLgProb(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  LgProb invSwLgProb(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
 
   // Sentence length scoring functions
   Score sentLenScore(unsigned int slen, unsigned int tlen);
@@ -111,7 +113,7 @@ protected:
 template <class HYPOTHESIS>
 _phrSwTransModel<HYPOTHESIS>::_phrSwTransModel() : _phraseBasedTransModel<HYPOTHESIS>()
 {
-  PhrasePairCacheTable phrasePairCacheTable;
+  PhrasePairIdCacheTable phrasePairCacheTable;
   cSwmScoreVec.push_back(phrasePairCacheTable);
   cInvSwmScoreVec.push_back(phrasePairCacheTable);
 }
@@ -140,20 +142,28 @@ bool _phrSwTransModel<HYPOTHESIS>::loadMultipleSwModelsPrefix(const char* prefix
   std::string invReadTablePrefix = prefixFileName;
   invReadTablePrefix += "_invswm";
   swModelInfo->swModelPars.readTablePrefixVec.push_back(invReadTablePrefix);
-  bool ret = swModelInfo->swAligModels[0]->load(invReadTablePrefix.c_str(), verbose);
-  if (ret == THOT_ERROR)
-    return THOT_ERROR;
 
   // Inverse sw model
   std::string readTablePrefix = prefixFileName;
   readTablePrefix += "_swm";
   swModelInfo->invSwModelPars.readTablePrefixVec.push_back(readTablePrefix);
-  ret = swModelInfo->invSwAligModels[0]->load(readTablePrefix.c_str(), verbose);
-  if (ret == THOT_ERROR)
+
+  // Both models are loaded at the same time, the threads that are not busy with one of them
+  // help loading the component tables of the other
+  bool ret = THOT_OK;
+  bool invRet = THOT_OK;
+#pragma omp parallel sections
+  {
+#pragma omp section
+    ret = swModelInfo->swAligModels[0]->load(invReadTablePrefix.c_str(), verbose);
+#pragma omp section
+    invRet = swModelInfo->invSwAligModels[0]->load(readTablePrefix.c_str(), verbose);
+  }
+  if (ret == THOT_ERROR || invRet == THOT_ERROR)
     return THOT_ERROR;
 
   // Grow caching data structures for swms
-  PhrasePairCacheTable phrasePairCacheTable;
+  PhrasePairIdCacheTable phrasePairCacheTable;
   cSwmScoreVec.push_back(phrasePairCacheTable);
   cInvSwmScoreVec.push_back(phrasePairCacheTable);
 
@@ -206,16 +216,18 @@ bool _phrSwTransModel<HYPOTHESIS>::printAligModel(std::string printPrefix)
     return THOT_ERROR;
 
   // TBD: handle multiple sw models
-  // Print inverse sw model
+  // Print inverse and direct sw models
   std::string invSwModelPrefix = printPrefix + "_swm";
-  ret = swModelInfo->invSwAligModels[0]->print(invSwModelPrefix.c_str());
-  if (ret == THOT_ERROR)
-    return THOT_ERROR;
-
-  // Print direct sw model
   std::string swModelPrefix = printPrefix + "_invswm";
-  ret = swModelInfo->swAligModels[0]->print(swModelPrefix.c_str());
-  if (ret == THOT_ERROR)
+  bool invRet = THOT_OK;
+#pragma omp parallel sections
+  {
+#pragma omp section
+    invRet = swModelInfo->invSwAligModels[0]->print(invSwModelPrefix.c_str());
+#pragma omp section
+    ret = swModelInfo->swAligModels[0]->print(swModelPrefix.c_str());
+  }
+  if (ret == THOT_ERROR || invRet == THOT_ERROR)
     return THOT_ERROR;
 
   return THOT_OK;
@@ -238,24 +250,24 @@ void _phrSwTransModel<HYPOTHESIS>::clear()
 }
 
 template <class HYPOTHESIS>
-Score _phrSwTransModel<HYPOTHESIS>::invSwScore(int idx, const std::vector<WordIndex>& s_,
+Score _phrSwTransModel<HYPOTHESIS>::invSwScore(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_,
                                                const std::vector<WordIndex>& t_)
 {
-  return swModelInfo->invSwModelPars.swWeight * (double)invSwLgProb(idx, s_, t_);
+  return swModelInfo->invSwModelPars.swWeight * (double)invSwLgProb(idx, pairId, s_, t_);
 }
 
 template <class HYPOTHESIS>
-Score _phrSwTransModel<HYPOTHESIS>::swScore(int idx, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_)
+Score _phrSwTransModel<HYPOTHESIS>::swScore(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                            const std::vector<WordIndex>& t_)
 {
-  return swModelInfo->swModelPars.swWeight * (double)swLgProb(idx, s_, t_);
+  return swModelInfo->swModelPars.swWeight * (double)swLgProb(idx, pairId, s_, t_);
 }
 
 template <class HYPOTHESIS>
-LgProb _phrSwTransModel<HYPOTHESIS>::swLgProb(int idx, const std::vector<WordIndex>& s_,
+LgProb _phrSwTransModel<HYPOTHESIS>::swLgProb(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_,
                                               const std::vector<WordIndex>& t_)
 {
-  PhrasePairCacheTable::iterator ppctIter;
-  ppctIter = cSwmScoreVec[idx].find(std::make_pair(s_, t_));
+  PhrasePairIdCacheTable::iterator ppctIter = cSwmScoreVec[idx].find(pairId);
   if (ppctIter != cSwmScoreVec[idx].end())
   {
     // Score was previously stored in the cache table
@@ -265,17 +277,16 @@ LgProb _phrSwTransModel<HYPOTHESIS>::swLgProb(int idx, const std::vector<WordInd
   {
     // Score is not stored in the cache table
     LgProb lp = swModelInfo->swAligModels[idx]->computePhraseSumLogProb(s_, t_);
-    cSwmScoreVec[idx][std::make_pair(s_, t_)] = lp;
+    cSwmScoreVec[idx][pairId] = lp;
     return lp;
   }
 }
 
 template <class HYPOTHESIS>
-LgProb _phrSwTransModel<HYPOTHESIS>::invSwLgProb(int idx, const std::vector<WordIndex>& s_,
+LgProb _phrSwTransModel<HYPOTHESIS>::invSwLgProb(int idx, PhrasePairId pairId, const std::vector<WordIndex>& s_,
                                                  const std::vector<WordIndex>& t_)
 {
-  PhrasePairCacheTable::iterator ppctIter;
-  ppctIter = cInvSwmScoreVec[idx].find(std::make_pair(s_, t_));
+  PhrasePairIdCacheTable::iterator ppctIter = cInvSwmScoreVec[idx].find(pairId);
   if (ppctIter != cInvSwmScoreVec[idx].end())
   {
     // Score was previously stored in the cache table
@@ -285,7 +296,7 @@ LgProb _phrSwTransModel<HYPOTHESIS>::invSwLgProb(int idx, const std::vector<Word
   {
     // Score is not stored in the cache table
     LgProb lp = swModelInfo->invSwAligModels[idx]->computePhraseSumLogProb(t_, s_);
-    cInvSwmScoreVec[idx][std::make_pair(s_, t_)] = lp;
+    cInvSwmScoreVec[idx][pairId] = lp;
     return lp;
   }
 }
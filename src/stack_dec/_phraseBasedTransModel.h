@@ -32,6 +32,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 #include <math.h>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
 #define NO_HEURISTIC 0
 #define LOCAL_T_HEURISTIC 4
@@ -124,7 +125,8 @@ public:
   ~_phraseBasedTransModel();
 
 protected:
-  typedef std::map<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>, std::vector<Score>> PhrasePairVecScore;
+  // Keyed by the phrase pair ids given by nbTransCacheData
+  typedef std::unordered_map<PhrasePairId, std::vector<Score>> PhrasePairVecScore;
 
   // Data structure to store input variables
   PbTransModelInputVars pbtmInputVars;
@@ -246,19 +248,21 @@ protected:
   // Language model scoring functions
   Score wordPenaltyScore(unsigned int tlen);
   Score sumWordPenaltyScore(unsigned int tlen);
-  Score nbestLmScoringFunc(const std::vector<WordIndex>& target);
+  Score nbestLmScoringFunc(PhraseId targetId, const std::vector<WordIndex>& target);
   Score getNgramScoreGivenState(const std::vector<WordIndex>& target, LM_State& state);
   Score getScoreEndGivenState(LM_State& state);
   LgProb getSentenceLgProb(const std::vector<WordIndex>& target, int verbose = 0);
 
   // Phrase model scoring functions
-  Score phrScore_s_t_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  Score phrScore_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
   // obtains the logarithm of pstWeight*ps_t_
-  std::vector<Score> phrScoreVec_s_t_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  std::vector<Score> phrScoreVec_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                       const std::vector<WordIndex>& t_);
   // the same as phrScore_s_t_ but returns a score vector for each model
-  Score phrScore_t_s_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  Score phrScore_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
   // obtains the logarithm of ptsWeight*pt_s_
-  std::vector<Score> phrScoreVec_t_s_(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  std::vector<Score> phrScoreVec_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                       const std::vector<WordIndex>& t_);
   // the same as phrScore_t_s_ but returns a score vector for each model
   Score srcJumpScore(unsigned int offset);
   // obtains score for source jump
@@ -275,12 +279,16 @@ protected:
   // Get N-best translations for a given source phrase s_.
   // If N is between 0 and 1 then N represents a threshold
 
-  // Functions to score n-best translations lists
-  virtual Score nbestTransScore(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_) = 0;
-  virtual Score nbestTransScoreLast(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_) = 0;
-  // Cached functions to score n-best translations lists
-  Score nbestTransScoreCached(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
-  Score nbestTransScoreLastCached(const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  // Functions to score n-best translations lists, pairId is the id
+  // of (s_,t_) in nbTransCacheData
+  virtual Score nbestTransScore(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                const std::vector<WordIndex>& t_) = 0;
+  virtual Score nbestTransScoreLast(PhrasePairId pairId, const std::vector<WordIndex>& s_,
+                                    const std::vector<WordIndex>& t_) = 0;
+  // Cached functions to score n-best translations lists, srcId is the
+  // id of s_ in nbTransCacheData
+  Score nbestTransScoreCached(PhraseId srcId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
+  Score nbestTransScoreLastCached(PhraseId srcId, const std::vector<WordIndex>& s_, const std::vector<WordIndex>& t_);
 
   // Functions related to pre_trans_actions
   virtual void clearTempVars(void);
@@ -473,13 +481,12 @@ Score _phraseBasedTransModel<HYPOTHESIS>::sumWordPenaltyScore(unsigned int tlen)
 }
 
 template <class HYPOTHESIS>
-Score _phraseBasedTransModel<HYPOTHESIS>::nbestLmScoringFunc(const std::vector<WordIndex>& target)
+Score _phraseBasedTransModel<HYPOTHESIS>::nbestLmScoringFunc(PhraseId targetId, const std::vector<WordIndex>& target)
 {
   // Warning: this function may become a bottleneck when the list of
   // translation options is large
 
-  PhraseCacheTable::iterator pctIter;
-  pctIter = nbTransCacheData.cnbLmScores.find(target);
+  PhraseIdCacheTable::iterator pctIter = nbTransCacheData.cnbLmScores.find(targetId);
   if (pctIter != nbTransCacheData.cnbLmScores.end())
   {
     // Score was previously stored in the cache table
@@ -492,7 +499,7 @@ Score _phraseBasedTransModel<HYPOTHESIS>::nbestLmScoringFunc(const std::vector<W
     LM_State state;
     langModelInfo->langModel->getStateForWordSeq(hist, state);
     Score scr = getNgramScoreGivenState(target, state);
-    nbTransCacheData.cnbLmScores[target] = scr;
+    nbTransCacheData.cnbLmScores[targetId] = scr;
     return scr;
   }
 }
@@ -549,10 +556,10 @@ LgProb _phraseBasedTransModel<HYPOTHESIS>::getSentenceLgProb(const std::vector<W
 }
 
 template <class HYPOTHESIS>
-Score _phraseBasedTransModel<HYPOTHESIS>::phrScore_s_t_(const std::vector<WordIndex>& s_,
+Score _phraseBasedTransModel<HYPOTHESIS>::phrScore_s_t_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
                                                         const std::vector<WordIndex>& t_)
 {
-  std::vector<Score> scoreVec = phrScoreVec_s_t_(s_, t_);
+  std::vector<Score> scoreVec = phrScoreVec_s_t_(pairId, s_, t_);
   Score sum = 0;
   for (unsigned int i = 0; i < scoreVec.size(); ++i)
     sum += scoreVec[i];
@@ -560,11 +567,12 @@ Score _phraseBasedTransModel<HYPOTHESIS>::phrScore_s_t_(const std::vector<WordIn
 }
 
 template <class HYPOTHESIS>
-std::vector<Score> _phraseBasedTransModel<HYPOTHESIS>::phrScoreVec_s_t_(const std::vector<WordIndex>& s_,
+std::vector<Score> _phraseBasedTransModel<HYPOTHESIS>::phrScoreVec_s_t_(PhrasePairId pairId,
+                                                                        const std::vector<WordIndex>& s_,
                                                                         const std::vector<WordIndex>& t_)
 {
   // Check if score of phrase pair is stored in cache table
-  PhrasePairVecScore::iterator ppctIter = cachedInversePhrScoreVecs.find(std::make_pair(s_, t_));
+  PhrasePairVecScore::iterator ppctIter = cachedInversePhrScoreVecs.find(pairId);
   if (ppctIter != cachedInversePhrScoreVecs.end())
     return ppctIter->second;
   else
@@ -574,16 +582,16 @@ std::vector<Score> _phraseBasedTransModel<HYPOTHESIS>::phrScoreVec_s_t_(const st
     Score score = this->phraseModelInfo->phraseModelPars.pstWeightVec[0]
                 * (double)this->phraseModelInfo->invPhraseModel->logpt_s_(t_, s_);
     scoreVec.push_back(score);
-    cachedInversePhrScoreVecs[std::make_pair(s_, t_)] = scoreVec;
+    cachedInversePhrScoreVecs[pairId] = scoreVec;
     return scoreVec;
   }
 }
 
 template <class HYPOTHESIS>
-Score _phraseBasedTransModel<HYPOTHESIS>::phrScore_t_s_(const std::vector<WordIndex>& s_,
+Score _phraseBasedTransModel<HYPOTHESIS>::phrScore_t_s_(PhrasePairId pairId, const std::vector<WordIndex>& s_,
                                                         const std::vector<WordIndex>& t_)
 {
-  std::vector<Score> scoreVec = phrScoreVec_t_s_(s_, t_);
+  std::vector<Score> scoreVec = phrScoreVec_t_s_(pairId, s_, t_);
   Score sum = 0;
   for (unsigned int i = 0; i < scoreVec.size(); ++i)
     sum += scoreVec[i];
@@ -591,11 +599,12 @@ Score _phraseBasedTransModel<HYPOTHESIS>::phrScore_t_s_(const std::vector<WordIn
 }
 
 template <class HYPOTHESIS>
-std::vector<Score> _phraseBasedTransModel<HYPOTHESIS>::phrScoreVec_t_s_(const std::vector<WordIndex>& s_,
+std::vector<Score> _phraseBasedTransModel<HYPOTHESIS>::phrScoreVec_t_s_(PhrasePairId pairId,
+                                                                        const std::vector<WordIndex>& s_,
                                                                         const std::vector<WordIndex>& t_)
 {
   // Check if score of phrase pair is stored in cache table
-  PhrasePairVecScore::iterator ppctIter = cachedDirectPhrScoreVecs.find(std::make_pair(s_, t_));
+  PhrasePairVecScore::iterator ppctIter = cachedDirectPhrScoreVecs.find(pairId);
   if (ppctIter != cachedDirectPhrScoreVecs.end())
     return ppctIter->second;
   else
@@ -605,7 +614,7 @@ std::vector<Score> _phraseBasedTransModel<HYPOTHESIS>::phrScoreVec_t_s_(const st
     Score score = this->phraseModelInfo->phraseModelPars.ptsWeightVec[0]
                 * (double)this->phraseModelInfo->invPhraseModel->logps_t_(t_, s_);
     scoreVec.push_back(score);
-    cachedDirectPhrScoreVecs[std::make_pair(s_, t_)] = scoreVec;
+    cachedDirectPhrScoreVecs[pairId] = scoreVec;
     return scoreVec;
   }
 }
@@ -747,11 +756,13 @@ Score _phraseBasedTransModel<HYPOTHESIS>::unkWordScoreHeur(void)
   s_.push_back(UNK_WORD);
   t_.push_back(UNK_WORD);
 
+  PhrasePairId pairId = nbTransCacheData.phrasePairId(nbTransCacheData.srcPhraseId(s_), t_);
+
   // p(t_|s_) phrase score
-  result += this->phrScore_t_s_(s_, t_);
+  result += this->phrScore_t_s_(pairId, s_, t_);
 
   // p(s_|t_) phrase score
-  result += this->phrScore_s_t_(s_, t_);
+  result += this->phrScore_s_t_(pairId, s_, t_);
 
   // Obtain lm scores
   std::vector<WordIndex> hist;
@@ -824,10 +835,12 @@ void _phraseBasedTransModel<HYPOTHESIS>::initHeuristicLocalt(int maxSrcPhraseLen
         if (ttNode.size() != 0) // Obtain best p(s_|t_)
         {
           bestScore_ts = -FLT_MAX;
+          PhraseId srcId = nbTransCacheData.srcPhraseId(s_);
           for (ttNodeIter = ttNode.begin(); ttNodeIter != ttNode.end(); ++ttNodeIter)
           {
             // Obtain phrase to phrase translation probability
-            score_ts = phrScore_s_t_(s_, ttNodeIter->second) + phrScore_t_s_(s_, ttNodeIter->second);
+            PhrasePairId pairId = nbTransCacheData.phrasePairId(srcId, ttNodeIter->second);
+            score_ts = phrScore_s_t_(pairId, s_, ttNodeIter->second) + phrScore_t_s_(pairId, s_, ttNodeIter->second);
             // Obtain language model heuristic estimation
             //            score_ts+=heurLmScoreLt(ttNodeIter->second);
             score_ts += heurLmScoreLtNoAdmiss(ttNodeIter->second);
@@ -2155,12 +2168,13 @@ bool _phraseBasedTransModel<HYPOTHESIS>::getTransForHypUncovGapRef(const Hypothe
     }
     else
     { // translations not present in the cache translation table
+      PhraseId srcId = nbTransCacheData.srcPhraseId(s_);
       for (PositionIndex i = ntarget.size(); i < pbtmInputVars.nrefSentIdVec.size() - pNbtRefKey.numGaps; ++i)
       {
         t_.push_back(pbtmInputVars.nrefSentIdVec[i]);
         if (t_.size() >= minTrgSize && t_.size() <= maxTrgSize)
         {
-          Score scr = nbestTransScoreCached(s_, t_);
+          Score scr = nbestTransScoreCached(srcId, s_, t_);
           nbt.insert(scr, t_);
         }
       }
@@ -2184,7 +2198,7 @@ bool _phraseBasedTransModel<HYPOTHESIS>::getTransForHypUncovGapRef(const Hypothe
       t_.push_back(pbtmInputVars.nrefSentIdVec[i]);
     if (t_.size() >= minTrgSize && t_.size() <= maxTrgSize)
     {
-      Score scr = nbestTransScoreCached(s_, t_);
+      Score scr = nbestTransScoreCached(nbTransCacheData.srcPhraseId(s_), s_, t_);
       nbt.insert(scr, t_);
     }
   }
@@ -2282,6 +2296,7 @@ void _phraseBasedTransModel<HYPOTHESIS>::transUncovGapPrefNoGen(const Hypothesis
   unsigned int maxTrgSize = s_.size() + this->pbTransModelPars.E;
 
   unsigned int ntrgSize = hyp.getPartialTrans().size();
+  PhraseId srcId = nbTransCacheData.srcPhraseId(s_);
 
   // Check if we are covering the last gap of the hypothesis
   if (this->numberOfUncoveredSrcWords(hyp) - (srcRight - srcLeft + 1) > 0)
@@ -2301,7 +2316,7 @@ void _phraseBasedTransModel<HYPOTHESIS>::transUncovGapPrefNoGen(const Hypothesis
         t_.push_back(pbtmInputVars.nprefSentIdVec[i]);
         if (t_.size() >= minTrgSize && t_.size() <= maxTrgSize)
         {
-          Score scr = nbestTransScoreCached(s_, t_);
+          Score scr = nbestTransScoreCached(srcId, s_, t_);
           nbt.insert(scr, t_);
         }
       }
@@ -2320,7 +2335,7 @@ void _phraseBasedTransModel<HYPOTHESIS>::transUncovGapPrefNoGen(const Hypothesis
   std::vector<WordIndex> remainingPref;
   for (unsigned int i = ntrgSize; i < pbtmInputVars.nprefSentIdVec.size(); ++i)
     remainingPref.push_back(pbtmInputVars.nprefSentIdVec[i]);
-  nbt.insert(nbestTransScoreLastCached(s_, remainingPref), remainingPref);
+  nbt.insert(nbestTransScoreLastCached(srcId, s_, remainingPref), remainingPref);
 }
 
 template <class HYPOTHESIS>
@@ -2328,15 +2343,15 @@ bool _phraseBasedTransModel<HYPOTHESIS>::getTransForInvPbModel(const std::vector
                                                                std::set<std::vector<WordIndex>>& transSet)
 {
   // Obtain translation options vector for model
-  BasePhraseModel::SrcTableNode srctn;
-  bool ret = this->phraseModelInfo->invPhraseModel->getTransFor_t_(s_, srctn);
+  PhraseNbestListView view;
+  bool ret = this->phraseModelInfo->invPhraseModel->getNbestTransViewFor_t_(s_, view);
 
   // Create translation options data structure
   transSet.clear();
-  for (BasePhraseModel::SrcTableNode::iterator iter = srctn.begin(); iter != srctn.end(); ++iter)
+  for (PhraseNbestListView::const_iterator iter = view.begin(); iter != view.end(); ++iter)
   {
     // Add new entry
-    transSet.insert(iter->first);
+    transSet.insert(iter->second);
   }
   return ret;
 }
@@ -2357,6 +2372,7 @@ void _phraseBasedTransModel<HYPOTHESIS>::genListOfTransLongerThanPref(std::vecto
   // Obtain translations for source segment s_
   std::set<std::vector<WordIndex>> transSet;
   getTransForInvPbModel(s_, transSet);
+  PhraseId srcId = nbTransCacheData.srcPhraseId(s_);
   for (std::set<std::vector<WordIndex>>::iterator transSetIter = transSet.begin(); transSetIter != transSet.end();
        ++transSetIter)
   {
@@ -2373,7 +2389,7 @@ void _phraseBasedTransModel<HYPOTHESIS>::genListOfTransLongerThanPref(std::vecto
         // Filter translations not exactly equal to "remainingPref"
         if (!equal)
         {
-          Score scr = nbestTransScoreLastCached(s_, *transSetIter);
+          Score scr = nbestTransScoreLastCached(srcId, s_, *transSetIter);
           nbt.insert(scr, *transSetIter);
         }
       }
@@ -2432,13 +2448,14 @@ bool _phraseBasedTransModel<HYPOTHESIS>::getNbestTransFor_s_(std::vector<WordInd
   else
   {
     Score scr;
+    PhraseId srcId = nbTransCacheData.srcPhraseId(s_);
 
     // This loop may become a bottleneck if the number of translation
     // options is high
     for (std::set<std::vector<WordIndex>>::iterator transSetIter = transSet.begin(); transSetIter != transSet.end();
          ++transSetIter)
     {
-      scr = nbestTransScoreCached(s_, *transSetIter);
+      scr = nbestTransScoreCached(srcId, s_, *transSetIter);
       nbt.insert(scr, *transSetIter);
     }
   }
@@ -2456,11 +2473,11 @@ bool _phraseBasedTransModel<HYPOTHESIS>::getNbestTransFor_s_(std::vector<WordInd
 }
 
 template <class HYPOTHESIS>
-Score _phraseBasedTransModel<HYPOTHESIS>::nbestTransScoreCached(const std::vector<WordIndex>& s_,
+Score _phraseBasedTransModel<HYPOTHESIS>::nbestTransScoreCached(PhraseId srcId, const std::vector<WordIndex>& s_,
                                                                 const std::vector<WordIndex>& t_)
 {
-  PhrasePairCacheTable::iterator ppctIter;
-  ppctIter = nbTransCacheData.cnbestTransScore.find(std::make_pair(s_, t_));
+  PhrasePairId pairId = nbTransCacheData.phrasePairId(srcId, t_);
+  PhrasePairIdCacheTable::iterator ppctIter = nbTransCacheData.cnbestTransScore.find(pairId);
   if (ppctIter != nbTransCacheData.cnbestTransScore.end())
   {
     // Score was previously stored in the cache table
@@ -2469,18 +2486,18 @@ Score _phraseBasedTransModel<HYPOTHESIS>::nbestTransScoreCached(const std::vecto
   else
   {
     // Score is not stored in the cache table
-    Score scr = nbestTransScore(s_, t_);
-    nbTransCacheData.cnbestTransScore[std::make_pair(s_, t_)] = scr;
+    Score scr = nbestTransScore(pairId, s_, t_);
+    nbTransCacheData.cnbestTransScore[pairId] = scr;
     return scr;
   }
 }
 
 template <class HYPOTHESIS>
-Score _phraseBasedTransModel<HYPOTHESIS>::nbestTransScoreLastCached(const std::vector<WordIndex>& s_,
+Score _phraseBasedTransModel<HYPOTHESIS>::nbestTransScoreLastCached(PhraseId srcId, const std::vector<WordIndex>& s_,
                                                                     const std::vector<WordIndex>& t_)
 {
-  PhrasePairCacheTable::iterator ppctIter;
-  ppctIter = nbTransCacheData.cnbestTransScoreLast.find(std::make_pair(s_, t_));
+  PhrasePairId pairId = nbTransCacheData.phrasePairId(srcId, t_);
+  PhrasePairIdCacheTable::iterator ppctIter = nbTransCacheData.cnbestTransScoreLast.find(pairId);
   if (ppctIter != nbTransCacheData.cnbestTransScoreLast.end())
   {
     // Score was previously stored in the cache table
@@ -2489,8 +2506,8 @@ Score _phraseBasedTransModel<HYPOTHESIS>::nbestTransScoreLastCached(const std::v
   else
   {
     // Score is not stored in the cache table
-    Score scr = nbestTransScoreLast(s_, t_);
-    nbTransCacheData.cnbestTransScoreLast[std::make_pair(s_, t_)] = scr;
+    Score scr = nbestTransScoreLast(pairId, s_, t_);
+    nbTransCacheData.cnbestTransScoreLast[pairId] = scr;
     return scr;
   }
 }
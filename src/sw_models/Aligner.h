@@ -21,12 +21,29 @@ public:
   // parameters are now string vectors)
   virtual LgProb getBestAlignment(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                                   WordAlignmentMatrix& bestWaMatrix) = 0;
+  // Obtains the best alignments for a batch of sentence pairs given as
+  // flat arrays of word indices (see encodeSrcSentences()). The words
+  // of pair k are srcWordIndices[srcOffsets[k], srcOffsets[k + 1]) and
+  // trgWordIndices[trgOffsets[k], trgOffsets[k + 1]). logProbs and
+  // waMatrices must have room for numPairs results. The pairs are
+  // aligned in parallel
+  virtual void getBestAlignments(const WordIndex* srcWordIndices, const size_t* srcOffsets,
+                                 const WordIndex* trgWordIndices, const size_t* trgOffsets, size_t numPairs,
+                                 LgProb* logProbs, WordAlignmentMatrix* waMatrices) = 0;
 
-  virtual WordIndex stringToSrcWordIndex(std::string s) const = 0;
-  virtual std::vector<WordIndex> strVectorToSrcIndexVector(std::vector<std::string> s) = 0;
+  virtual WordIndex stringToSrcWordIndex(const std::string& s) const = 0;
+  virtual std::vector<WordIndex> strVectorToSrcIndexVector(const std::vector<std::string>& s) = 0;
+  virtual void encodeSrcSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                  const size_t* wordOffsets, WordIndex* wordIndices) const = 0;
+  virtual void encodeSrcTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                               WordIndex* wordIndices) const = 0;
 
-  virtual WordIndex stringToTrgWordIndex(std::string t) const = 0;
-  virtual std::vector<WordIndex> strVectorToTrgIndexVector(std::vector<std::string> t) = 0;
+  virtual WordIndex stringToTrgWordIndex(const std::string& t) const = 0;
+  virtual std::vector<WordIndex> strVectorToTrgIndexVector(const std::vector<std::string>& t) = 0;
+  virtual void encodeTrgSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                  const size_t* wordOffsets, WordIndex* wordIndices) const = 0;
+  virtual void encodeTrgTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                               WordIndex* wordIndices) const = 0;
 
   virtual ~Aligner()
   {
@@ -7,6 +7,7 @@
 #include "nlp_common/WordClasses.h"
 #include "nlp_common/WordIndex.h"
 #include "sw_models/Aligner.h"
+#include "sw_models/TrainingMetrics.h"
 
 enum AlignmentModelType
 {
@@ -58,6 +59,29 @@ public:
   // loglikelihood for all sentences, and the second one, the same
   // loglikelihood normalized by the number of sentences
   virtual std::pair<double, double> loglikelihoodForAllSentences(int verbosity = 0) = 0;
+  // Runs up to maxIters calls to train() and returns the number of calls made. If
+  // minRelImprovement is greater than zero, training stops after the first iteration that
+  // improves the normalized log-likelihood of the held-out sentence pairs (of the training
+  // sentence pairs if there are none) by less than that fraction
+  virtual unsigned int trainIterations(unsigned int maxIters, double minRelImprovement = 0, int verbosity = 0) = 0;
+
+  // Functions to handle the held-out sentence pairs, which are only used to evaluate the
+  // model. Words that are not in the vocabulary are mapped to UNK_WORD
+  virtual bool readHeldOutSentencePairs(const char* srcFileName, const char* trgFileName, int verbose = 0) = 0;
+  virtual void addHeldOutSentencePair(const std::vector<std::string>& srcSentStr,
+                                      const std::vector<std::string>& trgSentStr) = 0;
+  virtual unsigned int numHeldOutSentencePairs() = 0;
+  virtual void clearHeldOutSentencePairs() = 0;
+  // Same as loglikelihoodForAllSentences() for the held-out sentence pairs
+  virtual std::pair<double, double> loglikelihoodForHeldOutSentences(int verbosity = 0) = 0;
+
+  // Training metrics functions. The metrics are accumulated until they are cleared, and
+  // if a metrics file is set, a JSON line with them is appended to it after each call to
+  // startTraining(), train(), incrTrain(), load() and print(). An empty file name stops
+  // the output
+  virtual TrainingMetrics getTrainingMetrics() = 0;
+  virtual void clearTrainingMetrics() = 0;
+  virtual bool setTrainingMetricsFile(const char* fileName) = 0;
 
   // Sentence length model functions
   virtual Prob sentenceLengthProb(unsigned int slen, unsigned int tlen) = 0;
@@ -86,6 +110,7 @@ public:
   // Best-alignment functions
   virtual bool getBestAlignments(const char* sourceTestFileName, const char* targetTestFilename,
                                  const char* outFileName) = 0;
+  using Aligner::getBestAlignments;
   using Aligner::getBestAlignment;
   virtual LgProb getBestAlignment(const char* srcSentence, const char* trgSentence,
                                   std::vector<PositionIndex>& bestAlignment) = 0;
@@ -95,6 +120,16 @@ public:
   virtual LgProb getBestAlignment(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                                   std::vector<PositionIndex>& bestAlignment) = 0;
 
+  // Posterior alignment functions. The posteriors of a sentence pair are written as a row-major
+  // slen x tlen matrix, cell (i, j) being the probability that target word j is aligned with
+  // source word i (the remaining mass of column j belongs to the NULL word)
+  virtual void getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence,
+                                      const std::vector<WordIndex>& trgSentence, float* posteriors) = 0;
+  // Batch version, pair k is written at posteriors + posteriorOffsets[k]
+  virtual void getAlignmentPosteriors(const WordIndex* srcWordIndices, const size_t* srcOffsets,
+                                      const WordIndex* trgWordIndices, const size_t* trgOffsets, size_t numPairs,
+                                      const size_t* posteriorOffsets, float* posteriors) = 0;
+
   // Obtains the best alignment for the given sentence pair
   // (input parameters are now index vectors) depending on the
   // value of the modelNumber data member.
@@ -109,6 +144,15 @@ public:
   // print() function
   virtual bool print(const char* prefFileName, int verbose = 0) = 0;
 
+  // Functions to load and print the model as a single container file
+  virtual bool loadContainer(const char* fileName, int verbose = 0) = 0;
+  virtual bool printContainer(const char* fileName, int verbose = 0) = 0;
+
+  // Functions to save the model together with the state kept between two calls to train(),
+  // so that training can be resumed without calling startTraining() again
+  virtual bool loadCheckpoint(const char* prefFileName, int verbose = 0) = 0;
+  virtual bool printCheckpoint(const char* prefFileName, int verbose = 0) = 0;
+
   // Functions for loading vocabularies
   virtual bool loadGIZASrcVocab(const char* srcInputVocabFileName, int verbose = 0) = 0;
   // Reads source vocabulary from a file in GIZA format
@@ -121,6 +165,11 @@ public:
   virtual bool printGIZATrgVocab(const char* trgOutputVocabFileName) = 0;
   // Reads target vocabulary from a file in GIZA format
 
+  // Freezes the source and target vocabularies into a compact read-only
+  // structure with faster lookups
+  virtual bool freezeVocab() = 0;
+  virtual bool isVocabFrozen() const = 0;
+
   // Source and target vocabulary functions
   virtual size_t getSrcVocabSize() const = 0;
   // Returns the source vocabulary size
@@ -3,6 +3,15 @@
 #include "nlp_common/ErrorDefs.h"
 #include "nlp_common/StrProcUtils.h"
 
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef _WIN32
 #define NOMINMAX
 #include <Windows.h>
@@ -12,13 +21,16 @@ using namespace std;
 
 AlignmentModelBase::AlignmentModelBase()
     : alpha{0.01}, variationalBayes{false}, swVocab{make_shared<SingleWordVocab>()},
-      sentenceHandler{make_shared<LightSentenceHandler>()}, wordClasses{std::make_shared<WordClasses>()}
+      sentenceHandler{make_shared<LightSentenceHandler>()}, encodedCorpus{make_shared<EncodedCorpus>()},
+      heldOutCorpus{make_shared<EncodedCorpus>()}, wordClasses{std::make_shared<WordClasses>()}
 {
 }
 
 AlignmentModelBase::AlignmentModelBase(AlignmentModelBase& model)
     : alpha{model.alpha}, variationalBayes{model.variationalBayes}, swVocab{model.swVocab},
-      sentenceHandler{model.sentenceHandler}, wordClasses{model.wordClasses}
+      sentenceHandler{model.sentenceHandler}, encodedCorpus{model.encodedCorpus}, heldOutCorpus{model.heldOutCorpus},
+      wordClasses{model.wordClasses}, trainingMetrics{model.trainingMetrics},
+      trainingMetricsFileName{model.trainingMetricsFileName}
 {
 }
 
@@ -43,6 +55,7 @@ bool AlignmentModelBase::getVariationalBayes()
 bool AlignmentModelBase::readSentencePairs(const char* srcFileName, const char* trgFileName, const char* sentCountsFile,
                                            pair<unsigned int, unsigned int>& sentRange, int verbose)
 {
+  encodedCorpus->clear();
   return sentenceHandler->readSentencePairs(srcFileName, trgFileName, sentCountsFile, sentRange, verbose);
 }
 
@@ -74,6 +87,230 @@ pair<double, double> AlignmentModelBase::loglikelihoodForAllSentences(int verbos
   return loglikelihoodForPairRange(sentPairRange, verbosity);
 }
 
+pair<double, double> AlignmentModelBase::loglikelihoodForPairRange(pair<unsigned int, unsigned int> sentPairRange,
+                                                                   int verbosity)
+{
+  return loglikelihoodForCorpus(getEncodedCorpus(), sentPairRange, verbosity);
+}
+
+unsigned int AlignmentModelBase::trainIterations(unsigned int maxIters, double minRelImprovement, int verbosity)
+{
+  bool earlyStopping = minRelImprovement > 0;
+  double prevLogLikelihood = 0;
+  for (unsigned int iter = 1; iter <= maxIters; ++iter)
+  {
+    train(verbosity);
+    if (!earlyStopping)
+      continue;
+
+    double logLikelihood;
+    if (numHeldOutSentencePairs() > 0)
+      logLikelihood = loglikelihoodForHeldOutSentences().second;
+    else
+      logLikelihood = loglikelihoodForAllSentences().second;
+    if (verbosity)
+      cerr << "Iteration " << iter << ", normalized log-likelihood= " << logLikelihood << endl;
+
+    if (iter > 1 && logLikelihood - prevLogLikelihood < minRelImprovement * fabs(prevLogLikelihood))
+      return iter;
+    prevLogLikelihood = logLikelihood;
+  }
+  return maxIters;
+}
+
+bool AlignmentModelBase::readHeldOutSentencePairs(const char* srcFileName, const char* trgFileName, int verbose)
+{
+  clearHeldOutSentencePairs();
+
+  LightSentenceHandler heldOutSentences;
+  pair<unsigned int, unsigned int> sentRange;
+  if (heldOutSentences.readSentencePairs(srcFileName, trgFileName, "", sentRange, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+
+  vector<string> srcSentStr, trgSentStr;
+  Count c;
+  for (unsigned int n = 0; n < heldOutSentences.numSentencePairs(); ++n)
+  {
+    heldOutSentences.getSentencePair(n, srcSentStr, trgSentStr, c);
+    addHeldOutSentencePair(srcSentStr, trgSentStr);
+  }
+  return THOT_OK;
+}
+
+void AlignmentModelBase::addHeldOutSentencePair(const vector<string>& srcSentStr, const vector<string>& trgSentStr)
+{
+  vector<WordIndex> srcSent, trgSent;
+  for (const string& word : srcSentStr)
+    srcSent.push_back(stringToSrcWordIndex(word));
+  for (const string& word : trgSentStr)
+    trgSent.push_back(stringToTrgWordIndex(word));
+  heldOutCorpus->addSentencePair(srcSent, trgSent);
+}
+
+unsigned int AlignmentModelBase::numHeldOutSentencePairs()
+{
+  return heldOutCorpus->numSentencePairs();
+}
+
+void AlignmentModelBase::clearHeldOutSentencePairs()
+{
+  heldOutCorpus->clear();
+}
+
+pair<double, double> AlignmentModelBase::loglikelihoodForHeldOutSentences(int verbosity)
+{
+  pair<unsigned int, unsigned int> sentPairRange = make_pair(0, numHeldOutSentencePairs() - 1);
+  return loglikelihoodForCorpus(*heldOutCorpus, sentPairRange, verbosity);
+}
+
+TrainingMetrics AlignmentModelBase::getTrainingMetrics()
+{
+  TrainingMetrics metrics = trainingMetrics;
+  metrics.peakRss = getPeakRss();
+  metrics.srcVocabSize = getSrcVocabSize();
+  metrics.trgVocabSize = getTrgVocabSize();
+  metrics.numSentencePairs = numSentencePairs();
+  metrics.numLexCounts = getNumLexCounts();
+  return metrics;
+}
+
+void AlignmentModelBase::clearTrainingMetrics()
+{
+  trainingMetrics = TrainingMetrics();
+}
+
+bool AlignmentModelBase::setTrainingMetricsFile(const char* fileName)
+{
+  trainingMetricsFileName = fileName;
+  if (trainingMetricsFileName.empty())
+    return THOT_OK;
+  ofstream metricsFile(trainingMetricsFileName, ios::app);
+  if (!metricsFile)
+  {
+    trainingMetricsFileName.clear();
+    return THOT_ERROR;
+  }
+  return THOT_OK;
+}
+
+size_t AlignmentModelBase::getNumLexCounts() const
+{
+  return 0;
+}
+
+AlignmentModelBase::TrainingEvent::TrainingEvent(AlignmentModelBase& model, TrainingPhaseMetrics& phase,
+                                                 const char* name)
+    : model{model}, timer{phase}, name{name}
+{
+}
+
+AlignmentModelBase::TrainingEvent::~TrainingEvent()
+{
+  timer.stop();
+  if (timer.isOutermost() && !model.trainingMetricsFileName.empty())
+  {
+    ofstream metricsFile(model.trainingMetricsFileName, ios::app);
+    model.getTrainingMetrics().printJsonLine(name, metricsFile);
+  }
+}
+
+const EncodedCorpus& AlignmentModelBase::getEncodedCorpus()
+{
+  unsigned int numPairs = numSentencePairs();
+  if (encodedCorpus->numSentencePairs() >= numPairs)
+    return *encodedCorpus;
+
+  TrainingPhaseTimer ioTimer(trainingMetrics.io);
+  // The words of each chunk are looked up in parallel, and only the words that are not in the
+  // vocabulary yet are added to it serially
+  const unsigned int chunkSize = min(10000u, numPairs - encodedCorpus->numSentencePairs());
+  vector<vector<string>> srcSentStrs(chunkSize), trgSentStrs(chunkSize);
+  vector<vector<WordIndex>> srcSents(chunkSize), trgSents(chunkSize);
+  vector<Count> counts(chunkSize);
+  for (unsigned int begin = encodedCorpus->numSentencePairs(); begin < numPairs; begin += chunkSize)
+  {
+    int chunkPairs = (int)min(chunkSize, numPairs - begin);
+    for (int k = 0; k < chunkPairs; ++k)
+      sentenceHandler->getSentencePair(begin + k, srcSentStrs[k], trgSentStrs[k], counts[k]);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < chunkPairs; ++k)
+    {
+      srcSents[k].resize(srcSentStrs[k].size());
+      for (size_t i = 0; i < srcSentStrs[k].size(); ++i)
+        srcSents[k][i] = stringToSrcWordIndex(srcSentStrs[k][i]);
+      trgSents[k].resize(trgSentStrs[k].size());
+      for (size_t j = 0; j < trgSentStrs[k].size(); ++j)
+        trgSents[k][j] = stringToTrgWordIndex(trgSentStrs[k][j]);
+    }
+
+    for (int k = 0; k < chunkPairs; ++k)
+    {
+      for (size_t i = 0; i < srcSents[k].size(); ++i)
+      {
+        if (srcSents[k][i] == UNK_WORD)
+          srcSents[k][i] = addSrcSymbol(srcSentStrs[k][i]);
+      }
+      for (size_t j = 0; j < trgSents[k].size(); ++j)
+      {
+        if (trgSents[k][j] == UNK_WORD)
+          trgSents[k][j] = addTrgSymbol(trgSentStrs[k][j]);
+      }
+      encodedCorpus->addSentencePair(srcSents[k], trgSents[k], counts[k]);
+    }
+  }
+  return *encodedCorpus;
+}
+
+pair<double, double> AlignmentModelBase::loglikelihoodForCorpus(const EncodedCorpus& corpus,
+                                                                pair<unsigned int, unsigned int> sentPairRange,
+                                                                int verbosity)
+{
+  double loglikelihood = 0;
+  unsigned int numSents = 0;
+  if (corpus.numSentencePairs() == 0)
+    return make_pair(loglikelihood, loglikelihood);
+
+  int first = (int)sentPairRange.first;
+  int last = (int)min(sentPairRange.second, corpus.numSentencePairs() - 1);
+  // computeSumLogProb() may throw, and exceptions cannot leave a parallel region
+  exception_ptr error;
+#pragma omp parallel if (modelReadsAreProcessSafe()) reduction(+ : loglikelihood, numSents)
+  {
+    vector<WordIndex> nthSrcSent, nthTrgSent;
+#pragma omp for schedule(dynamic)
+    for (int n = first; n <= last; ++n)
+    {
+      if (verbosity)
+      {
+#pragma omp critical(loglikelihood_verbose)
+        cerr << "* Calculating log-likelihood for sentence " << n << std::endl;
+      }
+      corpus.getSrcSent(n, nthSrcSent);
+      corpus.getTrgSent(n, nthTrgSent);
+      if (sentenceLengthIsOk(nthSrcSent) && sentenceLengthIsOk(nthTrgSent))
+      {
+        try
+        {
+          loglikelihood += (double)computeSumLogProb(nthSrcSent, nthTrgSent, verbosity);
+          ++numSents;
+        }
+        catch (...)
+        {
+#pragma omp critical(loglikelihood_error)
+          if (!error)
+            error = current_exception();
+        }
+      }
+    }
+  }
+  if (error)
+    rethrow_exception(error);
+  if (numSents == 0)
+    return make_pair(loglikelihood, loglikelihood);
+  return make_pair(loglikelihood, loglikelihood / (double)numSents);
+}
+
 LgProb AlignmentModelBase::computeLogProb(const char* srcSentence, const char* trgSentence,
                                           const WordAlignmentMatrix& aligMatrix, int verbose)
 {
@@ -122,9 +359,6 @@ bool AlignmentModelBase::getBestAlignments(const char* sourceTestFileName, const
                                            const char* outFileName)
 {
   AwkInputStream srcTest, trgTest;
-  WordAlignmentMatrix waMatrix;
-  vector<PositionIndex> bestAlig;
-  LgProb bestLgProb;
   ofstream outF;
 
   outF.open(outFileName, ios::out);
@@ -144,22 +378,70 @@ bool AlignmentModelBase::getBestAlignments(const char* sourceTestFileName, const
     cerr << "Error in target test file, file " << targetTestFilename << " does not exist.\n";
     return THOT_ERROR;
   }
-  while (srcTest.getln())
+
+  // The files are streamed in chunks: the words of a chunk are looked up serially, since unknown words are
+  // added to the vocabularies, and then the chunk is aligned in parallel by the batch version
+  const size_t chunkSize = 10000;
+  vector<string> srcLines, trgLines;
+  vector<unsigned int> lineNumbers;
+  vector<WordIndex> srcWordIndices, trgWordIndices;
+  vector<size_t> srcOffsets, trgOffsets;
+  vector<LgProb> logProbs;
+  vector<WordAlignmentMatrix> waMatrices;
+  vector<PositionIndex> bestAlig;
+  bool moreLines = true;
+  while (moreLines)
   {
-    if (trgTest.getln())
+    srcLines.clear();
+    trgLines.clear();
+    lineNumbers.clear();
+    while (srcLines.size() < chunkSize)
     {
+      if (!srcTest.getln())
+      {
+        moreLines = false;
+        break;
+      }
+      if (!trgTest.getln())
+      {
+        cerr << "Error: Source and target test files have not the same size." << endl;
+        moreLines = false;
+        break;
+      }
       if (srcTest.NF > 0 && trgTest.NF > 0)
       {
-        bestLgProb = getBestAlignment((char*)srcTest.dollar(0).c_str(), (char*)trgTest.dollar(0).c_str(), waMatrix);
-        outF << "# Sentence pair " << srcTest.FNR << " ";
-        waMatrix.getAligVec(bestAlig);
-        printAligInGizaFormat((char*)srcTest.dollar(0).c_str(), (char*)trgTest.dollar(0).c_str(), bestLgProb.get_p(),
-                              bestAlig, outF);
+        srcLines.push_back(srcTest.dollar(0));
+        trgLines.push_back(trgTest.dollar(0));
+        lineNumbers.push_back(srcTest.FNR);
       }
     }
-    else
+    if (srcLines.empty())
+      continue;
+
+    srcWordIndices.clear();
+    trgWordIndices.clear();
+    srcOffsets.assign(1, 0);
+    trgOffsets.assign(1, 0);
+    for (size_t k = 0; k < srcLines.size(); ++k)
+    {
+      vector<WordIndex> srcSentence = strVectorToSrcIndexVector(StrProcUtils::charItemsToVector(srcLines[k].c_str()));
+      vector<WordIndex> trgSentence = strVectorToTrgIndexVector(StrProcUtils::charItemsToVector(trgLines[k].c_str()));
+      srcWordIndices.insert(srcWordIndices.end(), srcSentence.begin(), srcSentence.end());
+      srcOffsets.push_back(srcWordIndices.size());
+      trgWordIndices.insert(trgWordIndices.end(), trgSentence.begin(), trgSentence.end());
+      trgOffsets.push_back(trgWordIndices.size());
+    }
+
+    logProbs.resize(srcLines.size());
+    waMatrices.resize(srcLines.size());
+    getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(), trgOffsets.data(),
+                      srcLines.size(), logProbs.data(), waMatrices.data());
+
+    for (size_t k = 0; k < srcLines.size(); ++k)
     {
-      cerr << "Error: Source and target test files have not the same size." << endl;
+      outF << "# Sentence pair " << lineNumbers[k] << " ";
+      waMatrices[k].getAligVec(bestAlig);
+      printAligInGizaFormat(srcLines[k].c_str(), trgLines[k].c_str(), logProbs[k].get_p(), bestAlig, outF);
     }
   }
   outF.close();
@@ -167,6 +449,19 @@ bool AlignmentModelBase::getBestAlignments(const char* sourceTestFileName, const
   return THOT_OK;
 }
 
+void AlignmentModelBase::getBestAlignments(const WordIndex* srcWordIndices, const size_t* srcOffsets,
+                                           const WordIndex* trgWordIndices, const size_t* trgOffsets, size_t numPairs,
+                                           LgProb* logProbs, WordAlignmentMatrix* waMatrices)
+{
+#pragma omp parallel for schedule(dynamic)
+  for (long long k = 0; k < (long long)numPairs; ++k)
+  {
+    vector<WordIndex> srcSentence(srcWordIndices + srcOffsets[k], srcWordIndices + srcOffsets[k + 1]);
+    vector<WordIndex> trgSentence(trgWordIndices + trgOffsets[k], trgWordIndices + trgOffsets[k + 1]);
+    logProbs[k] = getBestAlignment(srcSentence, trgSentence, waMatrices[k]);
+  }
+}
+
 LgProb AlignmentModelBase::getBestAlignment(const char* srcSentence, const char* trgSentence,
                                             WordAlignmentMatrix& bestWaMatrix)
 {
@@ -209,6 +504,35 @@ LgProb AlignmentModelBase::getBestAlignment(const vector<string>& srcSentence, c
   return getBestAlignment(srcWordIndexVector, trgWordIndexVector, bestAlignment);
 }
 
+void AlignmentModelBase::getAlignmentPosteriors(const vector<WordIndex>& srcSentence,
+                                                const vector<WordIndex>& trgSentence, float* posteriors)
+{
+  size_t slen = srcSentence.size();
+  size_t tlen = trgSentence.size();
+  fill(posteriors, posteriors + slen * tlen, 0.0f);
+
+  vector<PositionIndex> bestAlignment;
+  getBestAlignment(srcSentence, trgSentence, bestAlignment);
+  for (size_t j = 0; j < bestAlignment.size() && j < tlen; ++j)
+  {
+    if (bestAlignment[j] > 0 && bestAlignment[j] <= slen)
+      posteriors[(bestAlignment[j] - 1) * tlen + j] = 1.0f;
+  }
+}
+
+void AlignmentModelBase::getAlignmentPosteriors(const WordIndex* srcWordIndices, const size_t* srcOffsets,
+                                                const WordIndex* trgWordIndices, const size_t* trgOffsets,
+                                                size_t numPairs, const size_t* posteriorOffsets, float* posteriors)
+{
+#pragma omp parallel for schedule(dynamic)
+  for (long long k = 0; k < (long long)numPairs; ++k)
+  {
+    vector<WordIndex> srcSentence(srcWordIndices + srcOffsets[k], srcWordIndices + srcOffsets[k + 1]);
+    vector<WordIndex> trgSentence(trgWordIndices + trgOffsets[k], trgWordIndices + trgOffsets[k + 1]);
+    getAlignmentPosteriors(srcSentence, trgSentence, posteriors + posteriorOffsets[k]);
+  }
+}
+
 ostream& AlignmentModelBase::printAligInGizaFormat(const char* sourceSentence, const char* targetSentence, Prob p,
                                                    vector<PositionIndex> alig, ostream& outS)
 {
@@ -263,12 +587,22 @@ bool AlignmentModelBase::printSentencePairs(const char* srcSentFile, const char*
   return sentenceHandler->printSentencePairs(srcSentFile, trgSentFile, sentCountsFile);
 }
 
+bool AlignmentModelBase::freezeVocab()
+{
+  return swVocab->freeze();
+}
+
+bool AlignmentModelBase::isVocabFrozen() const
+{
+  return swVocab->isFrozen();
+}
+
 size_t AlignmentModelBase::getSrcVocabSize() const
 {
   return swVocab->getSrcVocabSize();
 }
 
-WordIndex AlignmentModelBase::stringToSrcWordIndex(string s) const
+WordIndex AlignmentModelBase::stringToSrcWordIndex(const string& s) const
 {
   return swVocab->stringToSrcWordIndex(s);
 }
@@ -283,11 +617,23 @@ bool AlignmentModelBase::existSrcSymbol(string s) const
   return swVocab->existSrcSymbol(s);
 }
 
-vector<WordIndex> AlignmentModelBase::strVectorToSrcIndexVector(vector<string> s)
+vector<WordIndex> AlignmentModelBase::strVectorToSrcIndexVector(const vector<string>& s)
 {
   return swVocab->strVectorToSrcIndexVector(s);
 }
 
+void AlignmentModelBase::encodeSrcSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                            const size_t* wordOffsets, WordIndex* wordIndices) const
+{
+  swVocab->encodeSrcSentences(buffer, sentenceOffsets, numSentences, wordOffsets, wordIndices);
+}
+
+void AlignmentModelBase::encodeSrcTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                                         WordIndex* wordIndices) const
+{
+  swVocab->encodeSrcTokens(tokens, tokenLengths, numTokens, wordIndices);
+}
+
 WordIndex AlignmentModelBase::addSrcSymbol(string s)
 {
   return swVocab->addSrcSymbol(s);
@@ -298,7 +644,7 @@ size_t AlignmentModelBase::getTrgVocabSize() const
   return swVocab->getTrgVocabSize();
 }
 
-WordIndex AlignmentModelBase::stringToTrgWordIndex(string t) const
+WordIndex AlignmentModelBase::stringToTrgWordIndex(const string& t) const
 {
   return swVocab->stringToTrgWordIndex(t);
 }
@@ -313,11 +659,23 @@ bool AlignmentModelBase::existTrgSymbol(string t) const
   return swVocab->existTrgSymbol(t);
 }
 
-vector<WordIndex> AlignmentModelBase::strVectorToTrgIndexVector(vector<string> t)
+vector<WordIndex> AlignmentModelBase::strVectorToTrgIndexVector(const vector<string>& t)
 {
   return swVocab->strVectorToTrgIndexVector(t);
 }
 
+void AlignmentModelBase::encodeTrgSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                            const size_t* wordOffsets, WordIndex* wordIndices) const
+{
+  swVocab->encodeTrgSentences(buffer, sentenceOffsets, numSentences, wordOffsets, wordIndices);
+}
+
+void AlignmentModelBase::encodeTrgTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                                         WordIndex* wordIndices) const
+{
+  swVocab->encodeTrgTokens(tokens, tokenLengths, numTokens, wordIndices);
+}
+
 WordIndex AlignmentModelBase::addTrgSymbol(string t)
 {
   return swVocab->addTrgSymbol(t);
@@ -336,6 +694,7 @@ void AlignmentModelBase::clearInfoAboutSentenceRange()
 {
   // Clear info about sentence range
   sentenceHandler->clear();
+  encodedCorpus->clear();
 }
 
 bool AlignmentModelBase::loadVariationalBayes(const string& filename)
@@ -427,10 +786,12 @@ void AlignmentModelBase::mapTrgWordToWordClass(WordIndex t, WordClassIndex c)
 
 bool AlignmentModelBase::load(const char* prefFileName, int verbose)
 {
+  TrainingEvent event(*this, trainingMetrics.load, "load");
   if (prefFileName[0] != 0)
   {
     bool retVal;
 
+    // The configuration is loaded first, since it determines how the other files are read
     try
     {
       string configFileName = prefFileName;
@@ -451,32 +812,9 @@ bool AlignmentModelBase::load(const char* prefFileName, int verbose)
         return THOT_ERROR;
     }
 
-    // Load vocabularies if they exist
-    string srcVocFileName = prefFileName;
-    srcVocFileName = srcVocFileName + ".svcb";
-    loadGIZASrcVocab(srcVocFileName.c_str(), verbose);
-
-    string trgVocFileName = prefFileName;
-    trgVocFileName = trgVocFileName + ".tvcb";
-    loadGIZATrgVocab(trgVocFileName.c_str(), verbose);
-
-    // Load files with source and target sentences
-    // Warning: this must be made before reading file with anji
-    // values
-    string srcsFile = prefFileName;
-    srcsFile = srcsFile + ".src";
-    string trgsFile = prefFileName;
-    trgsFile = trgsFile + ".trg";
-    string srctrgcFile = prefFileName;
-    srctrgcFile = srctrgcFile + ".srctrgc";
-    pair<unsigned int, unsigned int> pui;
-    retVal = readSentencePairs(srcsFile.c_str(), trgsFile.c_str(), srctrgcFile.c_str(), pui, verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
-
-    wordClasses->load(prefFileName, verbose);
-
-    return THOT_OK;
+    ModelTasks tasks;
+    addLoadTasks(prefFileName, verbose, tasks);
+    return runTasks(tasks);
   }
   else
     return THOT_ERROR;
@@ -484,8 +822,7 @@ bool AlignmentModelBase::load(const char* prefFileName, int verbose)
 
 bool AlignmentModelBase::print(const char* prefFileName, int verbose)
 {
-  bool retVal;
-
+  TrainingEvent event(*this, trainingMetrics.save, "save");
   YAML::Emitter out;
   out.SetDoublePrecision(std::numeric_limits<double>::digits10);
   out << YAML::BeginMap;
@@ -498,66 +835,305 @@ bool AlignmentModelBase::print(const char* prefFileName, int verbose)
   configFile << out.c_str();
   configFile.close();
 
-  // Print vocabularies
-  string srcVocFileName = prefFileName;
-  srcVocFileName = srcVocFileName + ".svcb";
-  retVal = printGIZASrcVocab(srcVocFileName.c_str());
-  if (retVal == THOT_ERROR)
+  ModelTasks tasks;
+  addPrintTasks(prefFileName, verbose, tasks);
+  return runTasks(tasks);
+}
+
+void AlignmentModelBase::addLoadTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
+{
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load vocabularies if they exist, preferring the frozen ones
+    string srcVocFileName = prefFileName + ".svcb";
+    if (swVocab->loadFrozenSrcVocab((srcVocFileName + ".bin").c_str()) == THOT_ERROR)
+      loadGIZASrcVocab(srcVocFileName.c_str(), verbose);
+
+    string trgVocFileName = prefFileName + ".tvcb";
+    if (swVocab->loadFrozenTrgVocab((trgVocFileName + ".bin").c_str()) == THOT_ERROR)
+      loadGIZATrgVocab(trgVocFileName.c_str(), verbose);
+    return THOT_OK;
+  });
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load files with source and target sentences
+    string srcsFile = prefFileName + ".src";
+    string trgsFile = prefFileName + ".trg";
+    string srctrgcFile = prefFileName + ".srctrgc";
+    pair<unsigned int, unsigned int> pui;
+    return readSentencePairs(srcsFile.c_str(), trgsFile.c_str(), srctrgcFile.c_str(), pui, verbose);
+  });
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    wordClasses->load(prefFileName.c_str(), verbose);
+    return THOT_OK;
+  });
+}
+
+void AlignmentModelBase::addPrintTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
+{
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print vocabularies
+    string srcVocFileName = prefFileName + ".svcb";
+    bool retVal = printGIZASrcVocab(srcVocFileName.c_str());
+    if (retVal == THOT_ERROR)
+      return THOT_ERROR;
+
+    string trgVocFileName = prefFileName + ".tvcb";
+    retVal = printGIZATrgVocab(trgVocFileName.c_str());
+    if (retVal == THOT_ERROR)
+      return THOT_ERROR;
+
+    // Print frozen vocabularies, or remove stale ones so that load() does not pick them up
+    string srcFrozenVocFileName = srcVocFileName + ".bin";
+    string trgFrozenVocFileName = trgVocFileName + ".bin";
+    if (swVocab->isFrozen())
+    {
+      if (swVocab->printFrozenSrcVocab(srcFrozenVocFileName.c_str()) == THOT_ERROR)
+        return THOT_ERROR;
+      if (swVocab->printFrozenTrgVocab(trgFrozenVocFileName.c_str()) == THOT_ERROR)
+        return THOT_ERROR;
+    }
+    else
+    {
+      remove(srcFrozenVocFileName.c_str());
+      remove(trgFrozenVocFileName.c_str());
+    }
+    return THOT_OK;
+  });
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Print files with source and target sentences to temp files
+    string srcsFileTemp = prefFileName + ".src.tmp";
+    string trgsFileTemp = prefFileName + ".trg.tmp";
+    string srctrgcFileTemp = prefFileName + ".srctrgc.tmp";
+    bool retVal = printSentencePairs(srcsFileTemp.c_str(), trgsFileTemp.c_str(), srctrgcFileTemp.c_str());
+    if (retVal == THOT_ERROR)
+      return THOT_ERROR;
+
+    // close sentence files
+    sentenceHandler->clear();
+
+    string srcsFile = prefFileName + ".src";
+    string trgsFile = prefFileName + ".trg";
+    string srctrgcFile = prefFileName + ".srctrgc";
+
+    // move temp files to real destination
+#ifdef _WIN32
+    if (!MoveFileExA(srcsFileTemp.c_str(), srcsFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+      return THOT_ERROR;
+    if (!MoveFileExA(trgsFileTemp.c_str(), trgsFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+      return THOT_ERROR;
+    if (!MoveFileExA(srctrgcFileTemp.c_str(), srctrgcFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+      return THOT_ERROR;
+#else
+    if (rename(srcsFileTemp.c_str(), srcsFile.c_str()) != 0)
+      return THOT_ERROR;
+    if (rename(trgsFileTemp.c_str(), trgsFile.c_str()) != 0)
+      return THOT_ERROR;
+    if (rename(srctrgcFileTemp.c_str(), srctrgcFile.c_str()) != 0)
+      return THOT_ERROR;
+#endif
+
+    // reload sentence files, their encoding is still valid
+    pair<unsigned int, unsigned int> pui;
+    return sentenceHandler->readSentencePairs(srcsFile.c_str(), trgsFile.c_str(), srctrgcFile.c_str(), pui, verbose);
+  });
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool { return wordClasses->print(prefFileName.c_str(), verbose); });
+}
+
+namespace
+{
+void spawnModelTasks(const vector<function<bool()>>& tasks, vector<char>& failed)
+{
+  for (size_t k = 0; k < tasks.size(); ++k)
+  {
+#pragma omp task shared(tasks, failed) firstprivate(k)
+    failed[k] = tasks[k]() == THOT_ERROR;
+  }
+#pragma omp taskwait
+}
+} // namespace
+
+bool AlignmentModelBase::runTasks(const ModelTasks& tasks)
+{
+  vector<char> failed(tasks.size(), 0);
+#ifdef _OPENMP
+  // When several models are loaded at the same time, the tasks join the enclosing team
+  if (omp_in_parallel())
+    spawnModelTasks(tasks, failed);
+  else
+#endif
+  {
+#pragma omp parallel
+#pragma omp single
+    spawnModelTasks(tasks, failed);
+  }
+
+  for (char f : failed)
+  {
+    if (f)
+      return THOT_ERROR;
+  }
+  return THOT_OK;
+}
+
+bool AlignmentModelBase::loadContainer(const char* fileName, int verbose)
+{
+  TrainingEvent event(*this, trainingMetrics.load, "load");
+  ModelContainer container;
+  if (container.open(fileName, verbose) == THOT_ERROR)
     return THOT_ERROR;
+  if (container.getModelType() != getModelTypeStr())
+  {
+    if (verbose)
+      cerr << "Error: " << fileName << " contains a " << container.getModelType() << " model, expected "
+           << getModelTypeStr() << endl;
+    return THOT_ERROR;
+  }
+
+  clear();
+  return loadSections(container, verbose);
+}
 
-  string trgVocFileName = prefFileName;
-  trgVocFileName = trgVocFileName + ".tvcb";
-  retVal = printGIZATrgVocab(trgVocFileName.c_str());
-  if (retVal == THOT_ERROR)
+bool AlignmentModelBase::printContainer(const char* fileName, int verbose)
+{
+  TrainingEvent event(*this, trainingMetrics.save, "save");
+  ModelContainer container;
+  container.setModelType(getModelTypeStr());
+  if (printSections(container) == THOT_ERROR)
     return THOT_ERROR;
+  return container.write(fileName, verbose);
+}
 
-  // Print files with source and target sentences to temp files
-  string srcsFileTemp = prefFileName;
-  srcsFileTemp = srcsFileTemp + ".src.tmp";
-  string trgsFileTemp = prefFileName;
-  trgsFileTemp = trgsFileTemp + ".trg.tmp";
-  string srctrgcFileTemp = prefFileName;
-  srctrgcFileTemp = srctrgcFileTemp + ".srctrgc.tmp";
-  retVal = printSentencePairs(srcsFileTemp.c_str(), trgsFileTemp.c_str(), srctrgcFileTemp.c_str());
-  if (retVal == THOT_ERROR)
+bool AlignmentModelBase::loadSections(const ModelContainer& container, int verbose)
+{
+  const char* data;
+  size_t size;
+
+  if (container.getSection(".yml", data, size) == THOT_OK)
+  {
+    try
+    {
+      YAML::Node config = YAML::Load(string(data, size));
+      loadConfig(config);
+    }
+    catch (const YAML::Exception&)
+    {
+      if (verbose)
+        cerr << "Error: invalid model configuration in container" << endl;
+      return THOT_ERROR;
+    }
+  }
+
+  // The frozen vocabularies are used directly from the mapped file
+  if (container.getSection(".svcb.bin", data, size) == THOT_ERROR
+      || swVocab->loadFrozenSrcVocab(container.getFile(), data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  if (container.getSection(".tvcb.bin", data, size) == THOT_ERROR
+      || swVocab->loadFrozenTrgVocab(container.getFile(), data, size) == THOT_ERROR)
     return THOT_ERROR;
 
-  // close sentence files
-  sentenceHandler->clear();
+  if (container.getSection(".classes", data, size) == THOT_OK)
+  {
+    MemoryInputStream in(data, size);
+    if (wordClasses->load(in) == THOT_ERROR)
+      return THOT_ERROR;
+  }
 
-  string srcsFile = prefFileName;
-  srcsFile = srcsFile + ".src";
-  string trgsFile = prefFileName;
-  trgsFile = trgsFile + ".trg";
-  string srctrgcFile = prefFileName;
-  srctrgcFile = srctrgcFile + ".srctrgc";
+  return THOT_OK;
+}
 
-  // move temp files to real destination
-#ifdef _WIN32
-  if (!MoveFileExA(srcsFileTemp.c_str(), srcsFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+bool AlignmentModelBase::printSections(ModelContainer& container)
+{
+  YAML::Emitter config;
+  config.SetDoublePrecision(std::numeric_limits<double>::digits10);
+  config << YAML::BeginMap;
+  createConfig(config);
+  config << YAML::EndMap;
+  container.addSection(".yml", config.c_str());
+
+  ostringstream srcVocab;
+  if (swVocab->printFrozenSrcVocab(srcVocab) == THOT_ERROR)
     return THOT_ERROR;
-  if (!MoveFileExA(trgsFileTemp.c_str(), trgsFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+  container.addSection(".svcb.bin", srcVocab.str());
+
+  ostringstream trgVocab;
+  if (swVocab->printFrozenTrgVocab(trgVocab) == THOT_ERROR)
     return THOT_ERROR;
-  if (!MoveFileExA(srctrgcFileTemp.c_str(), srctrgcFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+  container.addSection(".tvcb.bin", trgVocab.str());
+
+  ostringstream classes;
+  if (wordClasses->print(classes) == THOT_ERROR)
     return THOT_ERROR;
-#else
-  if (rename(srcsFileTemp.c_str(), srcsFile.c_str()) != 0)
+  container.addSection(".classes", classes.str());
+
+  return THOT_OK;
+}
+
+bool AlignmentModelBase::loadCheckpoint(const char* prefFileName, int verbose)
+{
+  if (load(prefFileName, verbose) == THOT_ERROR)
     return THOT_ERROR;
-  if (rename(trgsFileTemp.c_str(), trgsFile.c_str()) != 0)
+
+  string stateFileName = prefFileName;
+  stateFileName = stateFileName + ".train_state";
+  ModelContainer container;
+  if (container.open(stateFileName.c_str(), verbose) == THOT_ERROR)
     return THOT_ERROR;
-  if (rename(srctrgcFileTemp.c_str(), srctrgcFile.c_str()) != 0)
+  if (container.getModelType() != getModelTypeStr())
+  {
+    if (verbose)
+      cerr << "Error: " << stateFileName << " contains the training state of a " << container.getModelType()
+           << " model, expected " << getModelTypeStr() << endl;
     return THOT_ERROR;
-#endif
+  }
 
-  // reload sentence files
-  pair<unsigned int, unsigned int> pui;
-  retVal = readSentencePairs(srcsFile.c_str(), trgsFile.c_str(), srctrgcFile.c_str(), pui, verbose);
-  if (retVal == THOT_ERROR)
+  clearTempVars();
+  return loadTrainingState(container, verbose);
+}
+
+bool AlignmentModelBase::printCheckpoint(const char* prefFileName, int verbose)
+{
+  // The state is collected first, since printing the model reloads the sentence pairs
+  ModelContainer container;
+  container.setModelType(getModelTypeStr());
+  if (printTrainingState(container) == THOT_ERROR)
+  {
+    if (verbose)
+      cerr << "Error: the training state of the model cannot be checkpointed" << endl;
     return THOT_ERROR;
+  }
+
+  if (print(prefFileName, verbose) == THOT_ERROR)
+    return THOT_ERROR;
+
+  string stateFileName = prefFileName;
+  stateFileName = stateFileName + ".train_state";
+  return container.write(stateFileName.c_str(), verbose);
+}
 
-  retVal = wordClasses->print(prefFileName, verbose);
-  if (retVal == THOT_ERROR)
+bool AlignmentModelBase::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  const char* data;
+  size_t size;
+  unsigned int numSentPairs;
+  if (container.getSection(".num_sent_pairs", data, size) == THOT_ERROR || size != sizeof(unsigned int))
+    return THOT_ERROR;
+  memcpy(&numSentPairs, data, sizeof(unsigned int));
+  if (numSentPairs != numSentencePairs())
+  {
+    if (verbose)
+      cerr << "Error: the checkpoint was taken with " << numSentPairs << " sentence pairs, but the corpus has "
+           << numSentencePairs() << endl;
     return THOT_ERROR;
+  }
+  return THOT_OK;
+}
 
+bool AlignmentModelBase::printTrainingState(ModelContainer& container)
+{
+  unsigned int numSentPairs = numSentencePairs();
+  container.addSection(".num_sent_pairs", string((const char*)&numSentPairs, sizeof(unsigned int)));
   return THOT_OK;
 }
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "nlp_common/ModelContainer.h"
 #include "nlp_common/SingleWordVocab.h"
 #include "nlp_common/WordClasses.h"
 #include "sw_models/AlignmentModel.h"
+#include "sw_models/EncodedCorpus.h"
 #include "sw_models/LightSentenceHandler.h"
 
+#include <functional>
 #include <memory>
 #include <set>
 #include <yaml-cpp/yaml.h>
@@ -126,6 +129,79 @@ public:
   // loglikelihood normalized by the number of sentences
   std::pair<double, double> loglikelihoodForAllSentences(int verbosity = 0) override;
 
+  /**
+   * @brief Compute the log-likelihood of a range of sentence pairs
+   *
+   * @details
+   * The sentence pairs are read from the encoded corpus, and they are scored in parallel if
+   * modelReadsAreProcessSafe() returns true. Sentence pairs that are not used for training
+   * because of their length are skipped.
+   *
+   * @param sentPairRange the first and last index of the sentence pairs
+   * @param verbosity how much additional output should be printed
+   * @return the log-likelihood of the sentence pairs and the same log-likelihood normalized by
+   *         the number of sentence pairs
+   */
+  std::pair<double, double> loglikelihoodForPairRange(std::pair<unsigned int, unsigned int> sentPairRange,
+                                                      int verbosity = 0) override;
+
+  /**
+   * @brief Run several training iterations, optionally stopping when the model converges
+   *
+   * @details
+   * Convergence is measured after each iteration with the normalized log-likelihood of the
+   * held-out sentence pairs, or with that of the training sentence pairs if there are no held-out
+   * sentence pairs. Training stops after the first iteration that does not improve it by at
+   * least minRelImprovement times its absolute value.
+   *
+   * @param maxIters the maximum number of iterations
+   * @param minRelImprovement the minimum relative improvement, early stopping is disabled if it is
+   *        not greater than zero
+   * @param verbosity how much additional output should be printed
+   * @return the number of iterations that were run
+   */
+  unsigned int trainIterations(unsigned int maxIters, double minRelImprovement = 0, int verbosity = 0) override;
+
+  /**
+   * @brief Replace the held-out sentence pairs with the ones read from the given files
+   *
+   * @details
+   * Held-out sentence pairs are never trained on and do not modify the vocabulary, unknown
+   * words are mapped to UNK_WORD.
+   *
+   * @param srcFileName path to a file in the source language (newline and space delimited)
+   * @param trgFileName path to a file in the target language (newline and space delimited)
+   * @param verbose how much additional output should be printed [0/1]
+   * @return true if there was an error
+   * @return false if there was no error
+   */
+  bool readHeldOutSentencePairs(const char* srcFileName, const char* trgFileName, int verbose = 0) override;
+  void addHeldOutSentencePair(const std::vector<std::string>& srcSentStr,
+                              const std::vector<std::string>& trgSentStr) override;
+  unsigned int numHeldOutSentencePairs() override;
+  void clearHeldOutSentencePairs() override;
+  std::pair<double, double> loglikelihoodForHeldOutSentences(int verbosity = 0) override;
+
+  /**
+   * @brief Get the metrics collected while training, loading and saving the model
+   *
+   * @details
+   * The accumulated phase timings are completed with the current peak memory usage and table sizes.
+   *
+   * @return the training metrics
+   */
+  TrainingMetrics getTrainingMetrics() override;
+  void clearTrainingMetrics() override;
+
+  /**
+   * @brief Set the file to which the training metrics are appended as JSON lines
+   *
+   * @param fileName path of the metrics file, an empty path stops the output
+   * @return true if the file cannot be opened for appending
+   * @return false if the operation is completed successfully
+   */
+  bool setTrainingMetricsFile(const char* fileName) override;
+
   // Scoring functions for a given alignment
   using AlignmentModel::computeLogProb;
 
@@ -217,13 +293,60 @@ public:
                                  int verbose = 0) override;
 
   // Best-alignment functions
+  // Obtains the best alignments for the sentence pairs given in
+  // the files 'sourceTestFileName' and 'targetTestFilename'. The
+  // results are stored in the file 'outFileName'. The files are
+  // streamed in chunks of sentence pairs that are aligned in parallel
   bool getBestAlignments(const char* sourceTestFileName, const char* targetTestFilename,
                          const char* outFileName) override;
   using AlignmentModel::getBestAlignment;
-  // Obtains the best alignments for the sentence pairs given in
-  // the files 'sourceTestFileName' and 'targetTestFilename'. The
-  // results are stored in the file 'outFileName'
   
+  /**
+   * @brief Outputs the alignment log probabilities and best word alignment matrices for a batch of sentence pairs
+   *
+   * @details The sentences are given as flat arrays of word indexes, pair k being
+   * srcWordIndices[srcOffsets[k], srcOffsets[k + 1]) and trgWordIndices[trgOffsets[k], trgOffsets[k + 1]).
+   * The pairs are aligned in parallel with OpenMP.
+   * @see AlignmentModelBase::encodeSrcSentences
+   *
+   * @param srcWordIndices the word indexes of all the source sentences
+   * @param srcOffsets the numPairs + 1 boundaries of the source sentences in srcWordIndices
+   * @param trgWordIndices the word indexes of all the target sentences
+   * @param trgOffsets the numPairs + 1 boundaries of the target sentences in trgWordIndices
+   * @param numPairs the number of sentence pairs
+   * @param logProbs output array with room for numPairs log probabilities
+   * @param waMatrices output array with room for numPairs word alignment matrices
+   */
+  void getBestAlignments(const WordIndex* srcWordIndices, const size_t* srcOffsets, const WordIndex* trgWordIndices,
+                         const size_t* trgOffsets, size_t numPairs, LgProb* logProbs,
+                         WordAlignmentMatrix* waMatrices) override;
+
+  /**
+   * @brief Outputs the posterior alignment probabilities for a src and trg sentence
+   *
+   * @details The default implementation has no access to the model posteriors and puts all the
+   * probability mass on the Viterbi alignment. Models with tractable posteriors override it.
+   *
+   * @param srcSentence A vector of word indexes for the source sentence
+   * @param trgSentence A vector of word indexes for the target sentence
+   * @param posteriors output array with room for a row-major slen x tlen matrix
+   */
+  void getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
+                              float* posteriors) override;
+
+  /**
+   * @brief Outputs the posterior alignment probabilities for a batch of sentence pairs
+   *
+   * @details The sentences are given as in the batch version of getBestAlignments. The slen x tlen matrix of
+   * pair k is written at posteriors + posteriorOffsets[k]. The pairs are processed in parallel with OpenMP.
+   *
+   * @param posteriorOffsets the numPairs + 1 boundaries of the posterior matrices in posteriors
+   * @param posteriors output array with room for posteriorOffsets[numPairs] probabilities
+   */
+  void getAlignmentPosteriors(const WordIndex* srcWordIndices, const size_t* srcOffsets,
+                              const WordIndex* trgWordIndices, const size_t* trgOffsets, size_t numPairs,
+                              const size_t* posteriorOffsets, float* posteriors) override;
+
   /**
    * @brief Outputs an alignment log probability and the best word alignment matrix for a src and trg sentence 
    *
@@ -401,6 +524,29 @@ public:
    */
   bool printGIZATrgVocab(const char* trgOutputVocabFileName) override;
 
+  /**
+   * @brief Freezes the source and target vocabularies in swVocab
+   * 
+   * @details
+   * A frozen vocabulary keeps all of its words in a single arena and uses a
+   * minimal perfect hash for string lookups. Adding a new word thaws it again.
+   * When the model is printed with a frozen vocabulary, the frozen structures are
+   * also written to .svcb.bin and .tvcb.bin files, which load() memory maps.
+   * 
+   * @see SingleWordVocab::freeze
+   * 
+   * @return true if an error occurs
+   * @return false if the operation is completed successfully
+   */
+  bool freezeVocab() override;
+
+  /**
+   * @brief Check if the source and target vocabularies are frozen
+   * 
+   * @return true if both vocabularies are frozen
+   */
+  bool isVocabFrozen() const override;
+
   /**
    * @brief Get the number of words in the source vocab
    * 
@@ -419,7 +565,7 @@ public:
    * @param s The word token from the source language
    * @return WordIndex that uniquely identifies that word (1 if not found)
    */
-  WordIndex stringToSrcWordIndex(std::string s) const override;
+  WordIndex stringToSrcWordIndex(const std::string& s) const override;
 
   /**
    * @brief Get the word token (string) that goes with the given word index
@@ -453,7 +599,37 @@ public:
    * @param s a vector of word tokens (strings) in the source language
    * @return std::vector<WordIndex> 
    */
-  std::vector<WordIndex> strVectorToSrcIndexVector(std::vector<std::string> s) override;
+  std::vector<WordIndex> strVectorToSrcIndexVector(const std::vector<std::string>& s) override;
+
+  /**
+   * @brief Encode a batch of source sentences into a flat array of word indexes
+   *
+   * @details
+   * The sentences are stored in a single buffer, sentence s being
+   * buffer[sentenceOffsets[s], sentenceOffsets[s + 1]), and are split on blanks. Unknown words are mapped to
+   * UNK_WORD and the vocabulary is not modified, so the sentences are encoded in parallel.
+   * @see StrProcUtils::countSentenceWords
+   * @see SingleWordVocab::encodeSrcSentences
+   *
+   * @param buffer the UTF-8 text of the sentences
+   * @param sentenceOffsets the numSentences + 1 boundaries of the sentences in buffer
+   * @param numSentences the number of sentences
+   * @param wordOffsets the numSentences + 1 positions of the first word of each sentence in wordIndices
+   * @param wordIndices output array with room for wordOffsets[numSentences] word indexes
+   */
+  void encodeSrcSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                          const size_t* wordOffsets, WordIndex* wordIndices) const override;
+
+  /**
+   * @brief Encode a batch of source word tokens given as (pointer, length) pairs
+   *
+   * @param tokens pointers to the first character of each token
+   * @param tokenLengths the length in bytes of each token
+   * @param numTokens the number of tokens
+   * @param wordIndices output array with room for numTokens word indexes
+   */
+  void encodeSrcTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                       WordIndex* wordIndices) const override;
 
   /**
    * @brief Ensure a word token (string) is in the vocabulary of the source language
@@ -479,7 +655,7 @@ public:
    * @param t The word token (string) from the target vocabulary
    * @return WordIndex (unsigned int) that corresponds to that word (1 if not in vocab)
    */
-  WordIndex stringToTrgWordIndex(std::string t) const override;
+  WordIndex stringToTrgWordIndex(const std::string& t) const override;
 
   /**
    * @brief Convert the given word index (unsigned int) to its corresponding word token (string) in the target vocab
@@ -509,7 +685,37 @@ public:
    * @param t a vector of word tokens (strings) in the target language
    * @return std::vector<WordIndex> 
    */
-  std::vector<WordIndex> strVectorToTrgIndexVector(std::vector<std::string> t) override;
+  std::vector<WordIndex> strVectorToTrgIndexVector(const std::vector<std::string>& t) override;
+
+  /**
+   * @brief Encode a batch of target sentences into a flat array of word indexes
+   *
+   * @details
+   * The sentences are stored in a single buffer, sentence s being
+   * buffer[sentenceOffsets[s], sentenceOffsets[s + 1]), and are split on blanks. Unknown words are mapped to
+   * UNK_WORD and the vocabulary is not modified, so the sentences are encoded in parallel.
+   * @see StrProcUtils::countSentenceWords
+   * @see SingleWordVocab::encodeTrgSentences
+   *
+   * @param buffer the UTF-8 text of the sentences
+   * @param sentenceOffsets the numSentences + 1 boundaries of the sentences in buffer
+   * @param numSentences the number of sentences
+   * @param wordOffsets the numSentences + 1 positions of the first word of each sentence in wordIndices
+   * @param wordIndices output array with room for wordOffsets[numSentences] word indexes
+   */
+  void encodeTrgSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                          const size_t* wordOffsets, WordIndex* wordIndices) const override;
+
+  /**
+   * @brief Encode a batch of target word tokens given as (pointer, length) pairs
+   *
+   * @param tokens pointers to the first character of each token
+   * @param tokenLengths the length in bytes of each token
+   * @param numTokens the number of tokens
+   * @param wordIndices output array with room for numTokens word indexes
+   */
+  void encodeTrgTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                       WordIndex* wordIndices) const override;
 
   /**
    * @brief Ensure the given word token (string) is in the target vocabulary
@@ -545,6 +751,66 @@ public:
   bool load(const char* prefFileName, int verbose = 0) override;
   bool print(const char* prefFileName, int verbose = 0) override;
 
+  /**
+   * @brief Load the model from a single container file written by printContainer()
+   * 
+   * @details
+   * The container is memory mapped. The frozen vocabularies are used in place and the
+   * remaining components are parsed from their sections, which hold the same data as the
+   * files written by print(). The training corpus and the per-sentence training state
+   * are not stored in containers, so a model loaded this way can align sentences but
+   * has to be given new sentence pairs before it is trained again.
+   * 
+   * @param fileName the container file
+   * @param verbose how much additional output should be printed [0/1]
+   * @return true if an error occurs or the container holds another type of model
+   * @return false if the operation is completed successfully
+   */
+  bool loadContainer(const char* fileName, int verbose = 0) override;
+
+  /**
+   * @brief Print the model to a single container file
+   * 
+   * @details
+   * The vocabularies are always stored frozen, so loadContainer() leaves them frozen.
+   * 
+   * @param fileName the container file
+   * @param verbose how much additional output should be printed [0/1]
+   * @return true if an error occurs
+   * @return false if the operation is completed successfully
+   */
+  bool printContainer(const char* fileName, int verbose = 0) override;
+
+  /**
+   * @brief Load a training checkpoint written by printCheckpoint()
+   *
+   * @details
+   * The model and its training corpus are loaded with load(), and the counts kept between
+   * iterations are read from the ".train_state" file. Training is then resumed by calling
+   * train() directly, without calling startTraining().
+   *
+   * @param prefFileName the prefix of the checkpoint files
+   * @param verbose how much additional output should be printed [0/1]
+   * @return true if an error occurs or the checkpoint does not match the model or its corpus
+   * @return false if the operation is completed successfully
+   */
+  bool loadCheckpoint(const char* prefFileName, int verbose = 0) override;
+
+  /**
+   * @brief Print a training checkpoint
+   *
+   * @details
+   * Must be called between two calls to train(). The model is printed with print(), and
+   * the counts built by startTraining() and updated by train() are stored in a binary
+   * ".train_state" file, which has the same layout as a model container.
+   *
+   * @param prefFileName the prefix of the checkpoint files
+   * @param verbose how much additional output should be printed [0/1]
+   * @return true if an error occurs or the model is not in a state that can be checkpointed
+   * @return false if the operation is completed successfully
+   */
+  bool printCheckpoint(const char* prefFileName, int verbose = 0) override;
+
   void clear() override;
   // clear info about the whole sentence range without clearing
   // information about current model parameters
@@ -560,17 +826,63 @@ protected:
 
   bool loadVariationalBayes(const std::string& filename);
   bool sentenceLengthIsOk(const std::vector<WordIndex> sentence);
+  const EncodedCorpus& getEncodedCorpus();
+  std::pair<double, double> loglikelihoodForCorpus(const EncodedCorpus& corpus,
+                                                   std::pair<unsigned int, unsigned int> sentPairRange,
+                                                   int verbosity);
 
   virtual std::string getModelTypeStr() const = 0;
 
+  // Times a top-level event, such as startTraining(), an iteration of training or a
+  // load. When the outermost event of its phase ends, the metrics are appended to the
+  // metrics file
+  class TrainingEvent
+  {
+  public:
+    TrainingEvent(AlignmentModelBase& model, TrainingPhaseMetrics& phase, const char* name);
+    ~TrainingEvent();
+
+  private:
+    AlignmentModelBase& model;
+    TrainingPhaseTimer timer;
+    const char* name;
+  };
+
+  // Number of entries of the lexical counts, used for the training metrics
+  virtual std::size_t getNumLexCounts() const;
+
   virtual void loadConfig(const YAML::Node& config);
   virtual bool loadOldConfig(const char* prefFileName, int verbose = 0);
   virtual void createConfig(YAML::Emitter& out);
 
+  // load() and print() handle every component file in a separate task, and the tasks of
+  // the whole class hierarchy run concurrently. Each model class appends the tasks for its
+  // own files after calling the function of its base class
+  typedef std::vector<std::function<bool()>> ModelTasks;
+  virtual void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks);
+  virtual void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks);
+  static bool runTasks(const ModelTasks& tasks);
+
+  // Each model class loads and prints the sections of its own components, after
+  // calling the function of its base class
+  virtual bool loadSections(const ModelContainer& container, int verbose = 0);
+  virtual bool printSections(ModelContainer& container);
+
+  // Same pattern for the training state of checkpoints. Loading a section also reserves
+  // the table entries that startTraining() would have reserved for it
+  virtual bool loadTrainingState(const ModelContainer& container, int verbose = 0);
+  virtual bool printTrainingState(ModelContainer& container);
+
   PositionIndex maxSentenceLength = 1024;
   double alpha;
   bool variationalBayes; /* whether to use Variational Bayes for EM */
   std::shared_ptr<SingleWordVocab> swVocab;
   std::shared_ptr<LightSentenceHandler> sentenceHandler;
+  // Word indices of the sentence pairs of sentenceHandler, sentence pairs added after the last
+  // call to getEncodedCorpus() are encoded by the next call
+  std::shared_ptr<EncodedCorpus> encodedCorpus;
+  std::shared_ptr<EncodedCorpus> heldOutCorpus;
   std::shared_ptr<WordClasses> wordClasses;
+  TrainingMetrics trainingMetrics;
+  std::string trainingMetricsFileName;
 };
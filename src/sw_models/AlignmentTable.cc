@@ -116,9 +116,6 @@ bool AlignmentTable::loadPlainText(const char* aligNumDenFile, int verbose)
 
 bool AlignmentTable::loadBin(const char* aligNumDenFile, int verbose)
 {
-  // Clear data structures
-  clear();
-
   if (verbose)
     std::cerr << "Loading alignd file in binary format from " << aligNumDenFile << std::endl;
 
@@ -132,30 +129,37 @@ bool AlignmentTable::loadBin(const char* aligNumDenFile, int verbose)
   }
   else
   {
-    // Read register
-    bool end = false;
-    while (!end)
+    return load(inF);
+  }
+}
+
+bool AlignmentTable::load(std::istream& in)
+{
+  clear();
+
+  // Read register
+  bool end = false;
+  while (!end)
+  {
+    PositionIndex j;
+    PositionIndex slen;
+    PositionIndex tlen;
+    PositionIndex i;
+    float numer;
+    float denom;
+    if (in.read((char*)&j, sizeof(PositionIndex)))
     {
-      PositionIndex j;
-      PositionIndex slen;
-      PositionIndex tlen;
-      PositionIndex i;
-      float numer;
-      float denom;
-      if (inF.read((char*)&j, sizeof(PositionIndex)))
-      {
-        inF.read((char*)&slen, sizeof(PositionIndex));
-        inF.read((char*)&tlen, sizeof(PositionIndex));
-        inF.read((char*)&i, sizeof(PositionIndex));
-        inF.read((char*)&numer, sizeof(float));
-        inF.read((char*)&denom, sizeof(float));
-        set(j, slen, tlen, i, numer, denom);
-      }
-      else
-        end = true;
+      in.read((char*)&slen, sizeof(PositionIndex));
+      in.read((char*)&tlen, sizeof(PositionIndex));
+      in.read((char*)&i, sizeof(PositionIndex));
+      in.read((char*)&numer, sizeof(float));
+      in.read((char*)&denom, sizeof(float));
+      set(j, slen, tlen, i, numer, denom);
     }
-    return THOT_OK;
+    else
+      end = true;
   }
+  return THOT_OK;
 }
 
 bool AlignmentTable::print(const char* aligNumDenFile) const
@@ -208,23 +212,28 @@ bool AlignmentTable::printBin(const char* aligNumDenFile) const
   }
   else
   {
-    // print file with alignment nd values
-    for (auto& elem : numerators)
+    return print(outF);
+  }
+}
+
+bool AlignmentTable::print(std::ostream& out) const
+{
+  // print file with alignment nd values
+  for (auto& elem : numerators)
+  {
+    for (PositionIndex i = 0; i < elem.second.size(); ++i)
     {
-      for (PositionIndex i = 0; i < elem.second.size(); ++i)
-      {
-        outF.write((char*)&elem.first.j, sizeof(PositionIndex));
-        outF.write((char*)&elem.first.slen, sizeof(PositionIndex));
-        outF.write((char*)&elem.first.tlen, sizeof(PositionIndex));
-        outF.write((char*)&i, sizeof(PositionIndex));
-        outF.write((char*)&elem.second[i], sizeof(float));
-        bool found;
-        float denom = getDenominator(elem.first.j, elem.first.slen, elem.first.tlen, found);
-        outF.write((char*)&denom, sizeof(float));
-      }
+      out.write((char*)&elem.first.j, sizeof(PositionIndex));
+      out.write((char*)&elem.first.slen, sizeof(PositionIndex));
+      out.write((char*)&elem.first.tlen, sizeof(PositionIndex));
+      out.write((char*)&i, sizeof(PositionIndex));
+      out.write((char*)&elem.second[i], sizeof(float));
+      bool found;
+      float denom = getDenominator(elem.first.j, elem.first.slen, elem.first.tlen, found);
+      out.write((char*)&denom, sizeof(float));
     }
-    return THOT_OK;
   }
+  return THOT_OK;
 }
 
 void AlignmentTable::clear()
@@ -2,6 +2,7 @@
 
 #include "nlp_common/PositionIndex.h"
 
+#include <iostream>
 #include <unordered_map>
 #include <vector>
 
@@ -70,6 +71,9 @@ public:
 
   bool print(const char* aligNumDenFile) const;
 
+  bool load(std::istream& in);
+  bool print(std::ostream& out) const;
+
   void clear();
 
 private:
@@ -114,9 +114,6 @@ bool DistortionTable::loadPlainText(const char* distortionNumDenFile, int verbos
 
 bool DistortionTable::loadBin(const char* distortionNumDenFile, int verbose)
 {
-  // Clear data structures
-  clear();
-
   if (verbose)
     std::cerr << "Loading distortion nd file in binary format from " << distortionNumDenFile << std::endl;
 
@@ -130,30 +127,37 @@ bool DistortionTable::loadBin(const char* distortionNumDenFile, int verbose)
   }
   else
   {
-    // Read register
-    bool end = false;
-    while (!end)
+    return load(inF);
+  }
+}
+
+bool DistortionTable::load(std::istream& in)
+{
+  clear();
+
+  // Read register
+  bool end = false;
+  while (!end)
+  {
+    PositionIndex i;
+    PositionIndex slen;
+    PositionIndex tlen;
+    PositionIndex j;
+    float numer;
+    float denom;
+    if (in.read((char*)&i, sizeof(PositionIndex)))
     {
-      PositionIndex i;
-      PositionIndex slen;
-      PositionIndex tlen;
-      PositionIndex j;
-      float numer;
-      float denom;
-      if (inF.read((char*)&i, sizeof(PositionIndex)))
-      {
-        inF.read((char*)&slen, sizeof(PositionIndex));
-        inF.read((char*)&tlen, sizeof(PositionIndex));
-        inF.read((char*)&j, sizeof(PositionIndex));
-        inF.read((char*)&numer, sizeof(float));
-        inF.read((char*)&denom, sizeof(float));
-        set(i, slen, tlen, j, numer, denom);
-      }
-      else
-        end = true;
+      in.read((char*)&slen, sizeof(PositionIndex));
+      in.read((char*)&tlen, sizeof(PositionIndex));
+      in.read((char*)&j, sizeof(PositionIndex));
+      in.read((char*)&numer, sizeof(float));
+      in.read((char*)&denom, sizeof(float));
+      set(i, slen, tlen, j, numer, denom);
     }
-    return THOT_OK;
+    else
+      end = true;
   }
+  return THOT_OK;
 }
 
 bool DistortionTable::print(const char* distortionNumDenFile) const
@@ -206,23 +210,28 @@ bool DistortionTable::printBin(const char* distortionNumDenFile) const
   }
   else
   {
-    // print file with alignment nd values
-    for (auto& elem : numerators)
+    return print(outF);
+  }
+}
+
+bool DistortionTable::print(std::ostream& out) const
+{
+  // print file with alignment nd values
+  for (auto& elem : numerators)
+  {
+    for (PositionIndex j = 1; j <= elem.second.size(); ++j)
     {
-      for (PositionIndex j = 1; j <= elem.second.size(); ++j)
-      {
-        outF.write((char*)&elem.first.i, sizeof(PositionIndex));
-        outF.write((char*)&elem.first.slen, sizeof(PositionIndex));
-        outF.write((char*)&elem.first.tlen, sizeof(PositionIndex));
-        outF.write((char*)&j, sizeof(PositionIndex));
-        outF.write((char*)&elem.second[j - 1], sizeof(float));
-        bool found;
-        float denom = getDenominator(elem.first.i, elem.first.slen, elem.first.tlen, found);
-        outF.write((char*)&denom, sizeof(float));
-      }
+      out.write((char*)&elem.first.i, sizeof(PositionIndex));
+      out.write((char*)&elem.first.slen, sizeof(PositionIndex));
+      out.write((char*)&elem.first.tlen, sizeof(PositionIndex));
+      out.write((char*)&j, sizeof(PositionIndex));
+      out.write((char*)&elem.second[j - 1], sizeof(float));
+      bool found;
+      float denom = getDenominator(elem.first.i, elem.first.slen, elem.first.tlen, found);
+      out.write((char*)&denom, sizeof(float));
     }
-    return THOT_OK;
   }
+  return THOT_OK;
 }
 
 void DistortionTable::clear()
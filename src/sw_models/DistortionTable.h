@@ -4,6 +4,7 @@
 #include "nlp_common/ErrorDefs.h"
 #include "nlp_common/PositionIndex.h"
 
+#include <iostream>
 #include <unordered_map>
 #include <vector>
 
@@ -63,6 +64,9 @@ public:
 
   bool print(const char* distortionNumDenFile) const;
 
+  bool load(std::istream& in);
+  bool print(std::ostream& out) const;
+
   void clear();
 
 private:
@@ -0,0 +1,55 @@
+#include "sw_models/EncodedCorpus.h"
+
+using namespace std;
+
+EncodedCorpus::EncodedCorpus() : srcOffsets(1, 0), trgOffsets(1, 0)
+{
+}
+
+unsigned int EncodedCorpus::numSentencePairs() const
+{
+  return (unsigned int)srcOffsets.size() - 1;
+}
+
+void EncodedCorpus::addSentencePair(const vector<WordIndex>& srcSent, const vector<WordIndex>& trgSent, Count c)
+{
+  srcWords.insert(srcWords.end(), srcSent.begin(), srcSent.end());
+  srcOffsets.push_back(srcWords.size());
+  trgWords.insert(trgWords.end(), trgSent.begin(), trgSent.end());
+  trgOffsets.push_back(trgWords.size());
+  counts.push_back(c);
+}
+
+PositionIndex EncodedCorpus::getSrcLength(unsigned int n) const
+{
+  return (PositionIndex)(srcOffsets[n + 1] - srcOffsets[n]);
+}
+
+PositionIndex EncodedCorpus::getTrgLength(unsigned int n) const
+{
+  return (PositionIndex)(trgOffsets[n + 1] - trgOffsets[n]);
+}
+
+void EncodedCorpus::getSrcSent(unsigned int n, vector<WordIndex>& srcSent) const
+{
+  srcSent.assign(srcWords.begin() + srcOffsets[n], srcWords.begin() + srcOffsets[n + 1]);
+}
+
+void EncodedCorpus::getTrgSent(unsigned int n, vector<WordIndex>& trgSent) const
+{
+  trgSent.assign(trgWords.begin() + trgOffsets[n], trgWords.begin() + trgOffsets[n + 1]);
+}
+
+Count EncodedCorpus::getCount(unsigned int n) const
+{
+  return counts[n];
+}
+
+void EncodedCorpus::clear()
+{
+  srcWords.clear();
+  trgWords.clear();
+  srcOffsets.assign(1, 0);
+  trgOffsets.assign(1, 0);
+  counts.clear();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "nlp_common/Count.h"
+#include "nlp_common/PositionIndex.h"
+#include "nlp_common/WordIndex.h"
+
+#include <cstddef>
+#include <vector>
+
+// Sentence pairs kept as word indices in two flat arrays. Once a corpus has been encoded it
+// can be read from several threads without tokenizing it or looking words up again
+class EncodedCorpus
+{
+public:
+  EncodedCorpus();
+
+  unsigned int numSentencePairs() const;
+  void addSentencePair(const std::vector<WordIndex>& srcSent, const std::vector<WordIndex>& trgSent, Count c = 1);
+
+  PositionIndex getSrcLength(unsigned int n) const;
+  PositionIndex getTrgLength(unsigned int n) const;
+  void getSrcSent(unsigned int n, std::vector<WordIndex>& srcSent) const;
+  void getTrgSent(unsigned int n, std::vector<WordIndex>& trgSent) const;
+  Count getCount(unsigned int n) const;
+
+  void clear();
+
+private:
+  std::vector<WordIndex> srcWords;
+  std::vector<WordIndex> trgWords;
+  // Sentence pair n is srcWords[srcOffsets[n], srcOffsets[n + 1]) and the same for the target
+  std::vector<std::size_t> srcOffsets;
+  std::vector<std::size_t> trgOffsets;
+  std::vector<Count> counts;
+};
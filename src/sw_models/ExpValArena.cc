@@ -0,0 +1,442 @@
+#include "sw_models/ExpValArena.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/MathDefs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const std::size_t MinArenaCapacity = 1024;
+const uint16_t MaxHalfMagnitude = 0x7bff;
+const uint16_t LowestHalf = 0x8000 | MaxHalfMagnitude;
+
+std::size_t product(const unsigned int dims[3])
+{
+  return (std::size_t)dims[0] * dims[1] * dims[2];
+}
+} // namespace
+
+ExpValArena::ExpValArena()
+    : used{0}, garbage{0}, capacity{0}, base{nullptr}, halfPrecision{false}, spillFd{-1}
+{
+}
+
+ExpValArena::ExpValArena(ExpValArena&& other) : ExpValArena()
+{
+  takeStorage(other);
+}
+
+ExpValArena& ExpValArena::operator=(ExpValArena&& other)
+{
+  if (this != &other)
+  {
+    clear();
+    closeSpillFile();
+    takeStorage(other);
+  }
+  return *this;
+}
+
+void ExpValArena::setHalfPrecision(bool halfPrecision)
+{
+  clear();
+  this->halfPrecision = halfPrecision;
+}
+
+bool ExpValArena::getHalfPrecision() const
+{
+  return halfPrecision;
+}
+
+bool ExpValArena::setSpillFile(const std::string& fileName, int verbose)
+{
+  clear();
+  closeSpillFile();
+  spillFileName.clear();
+  if (fileName.empty())
+    return THOT_OK;
+
+#ifndef _WIN32
+  int fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd == -1)
+  {
+    if (verbose)
+      std::cerr << "Error: spill file " << fileName << " could not be created" << std::endl;
+    return THOT_ERROR;
+  }
+  // The file is removed from its directory right away, so that its space is
+  // given back once it is closed, even if the process does not end cleanly
+  ::unlink(fileName.c_str());
+  spillFd = fd;
+  spillFileName = fileName;
+  return THOT_OK;
+#else
+  if (verbose)
+    std::cerr << "Warning: spill files are not supported on this platform, expected values are kept in memory"
+              << std::endl;
+  return THOT_ERROR;
+#endif
+}
+
+const std::string& ExpValArena::getSpillFile() const
+{
+  return spillFileName;
+}
+
+unsigned int ExpValArena::size() const
+{
+  return (unsigned int)entries.size();
+}
+
+void ExpValArena::grow(unsigned int numEntries)
+{
+  if (entries.size() < numEntries)
+  {
+    Entry emptyEntry = {0, 0, {0, 0, 0}};
+    entries.resize(numEntries, emptyEntry);
+  }
+}
+
+unsigned int ExpValArena::dim(unsigned int np, unsigned int d) const
+{
+  return entries[np].dims[d];
+}
+
+void ExpValArena::allocate(unsigned int np, unsigned int dim0, unsigned int dim1, unsigned int dim2, float value)
+{
+  Entry& e = entries[np];
+  std::size_t count = (std::size_t)dim0 * dim1 * dim2;
+  if (count > e.capacity)
+  {
+    garbage += e.capacity;
+    e.capacity = 0;
+    e.offset = appendBlock(count);
+    e.capacity = count;
+  }
+  e.dims[0] = dim0;
+  e.dims[1] = dim1;
+  e.dims[2] = dim2;
+  fillRange(e.offset, count, value);
+}
+
+void ExpValArena::reshape(unsigned int np, unsigned int dim0, unsigned int dim1, unsigned int dim2, float value)
+{
+  Entry& e = entries[np];
+  if (e.dims[0] == dim0 && e.dims[1] == dim1 && e.dims[2] == dim2)
+    return;
+
+  std::size_t oldCount = product(e.dims);
+  std::size_t count = (std::size_t)dim0 * dim1 * dim2;
+  if (oldCount == 0)
+  {
+    allocate(np, dim0, dim1, dim2, value);
+    return;
+  }
+
+  if (e.dims[1] == dim1 && e.dims[2] == dim2 && count <= e.capacity)
+  {
+    // Only the first dimension changes, the block is extended or truncated in place
+    if (count > oldCount)
+      fillRange(e.offset + oldCount, count - oldCount, value);
+    e.dims[0] = dim0;
+    return;
+  }
+
+  // appendBlock() may compact the arena, so the old offset is read afterwards
+  std::size_t offset = appendBlock(count);
+  fillRange(offset, count, value);
+  unsigned int common0 = std::min(e.dims[0], dim0);
+  unsigned int common1 = std::min(e.dims[1], dim1);
+  unsigned int common2 = std::min(e.dims[2], dim2);
+  for (unsigned int j = 0; j < common0; ++j)
+  {
+    for (unsigned int i = 0; i < common1; ++i)
+    {
+      for (unsigned int ip = 0; ip < common2; ++ip)
+        copyValue(e.offset + ((std::size_t)j * e.dims[1] + i) * e.dims[2] + ip,
+                  offset + ((std::size_t)j * dim1 + i) * dim2 + ip);
+    }
+  }
+  garbage += e.capacity;
+  e.offset = offset;
+  e.capacity = count;
+  e.dims[0] = dim0;
+  e.dims[1] = dim1;
+  e.dims[2] = dim2;
+}
+
+void ExpValArena::release(unsigned int np)
+{
+  if (np >= entries.size())
+    return;
+
+  Entry& e = entries[np];
+  garbage += e.capacity;
+  e.offset = 0;
+  e.capacity = 0;
+  e.dims[0] = e.dims[1] = e.dims[2] = 0;
+}
+
+void ExpValArena::fill(float value)
+{
+  for (const Entry& e : entries)
+    fillRange(e.offset, product(e.dims), value);
+}
+
+std::size_t ExpValArena::numValues() const
+{
+  return used;
+}
+
+void ExpValArena::clear()
+{
+  entries.clear();
+  used = 0;
+  garbage = 0;
+  releaseStorage();
+}
+
+uint16_t ExpValArena::floatToHalf(float f)
+{
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+  uint32_t fexp = (x >> 23) & 0xff;
+  uint32_t mant = x & 0x7fffff;
+
+  if (fexp == 0xff)
+    return sign | (mant ? 0x7e00 : 0x7c00);
+
+  int exp = (int)fexp - 127 + 15;
+  if (exp >= 31)
+    return sign | MaxHalfMagnitude;
+  if (exp <= 0)
+  {
+    // Subnormal half, rounded to nearest even
+    if (exp < -10)
+      return sign;
+    mant |= 0x800000;
+    unsigned int shift = (unsigned int)(14 - exp);
+    uint32_t half = mant >> shift;
+    uint32_t rem = mant & ((1u << shift) - 1);
+    uint32_t mid = 1u << (shift - 1);
+    if (rem > mid || (rem == mid && (half & 1)))
+      ++half;
+    return sign | (uint16_t)half;
+  }
+
+  uint32_t half = ((uint32_t)exp << 10) | (mant >> 13);
+  uint32_t rem = mant & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+    ++half;
+  if (half >= 0x7c00)
+    half = MaxHalfMagnitude;
+  return sign | (uint16_t)half;
+}
+
+float ExpValArena::halfToFloat(uint16_t h)
+{
+  if (h == LowestHalf)
+    return SMALL_LG_NUM;
+
+  uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  uint32_t exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t x;
+  if (exp == 0)
+  {
+    float f = std::ldexp((float)mant, -24);
+    return sign ? -f : f;
+  }
+  else if (exp == 31)
+    x = sign | 0x7f800000 | (mant << 13);
+  else
+    x = sign | ((exp + 112) << 23) | (mant << 13);
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+ExpValArena::~ExpValArena()
+{
+  clear();
+  closeSpillFile();
+}
+
+void ExpValArena::takeStorage(ExpValArena& other)
+{
+  // Moving the buffer keeps its data in place, so base stays valid in both
+  // the memory and the spill file cases
+  entries = std::move(other.entries);
+  used = other.used;
+  garbage = other.garbage;
+  capacity = other.capacity;
+  base = other.base;
+  halfPrecision = other.halfPrecision;
+  buffer = std::move(other.buffer);
+  spillFileName = std::move(other.spillFileName);
+  spillFd = other.spillFd;
+
+  other.entries.clear();
+  other.used = 0;
+  other.garbage = 0;
+  other.capacity = 0;
+  other.base = nullptr;
+  other.buffer.clear();
+  other.spillFileName.clear();
+  other.spillFd = -1;
+}
+
+std::size_t ExpValArena::valueSize() const
+{
+  return halfPrecision ? sizeof(uint16_t) : sizeof(float);
+}
+
+std::size_t ExpValArena::appendBlock(std::size_t numValues)
+{
+  // Space of released blocks is only reclaimed when the arena would otherwise
+  // need to grow
+  if (used + numValues > capacity && garbage > 0 && garbage >= used / 2)
+    compact();
+  reserveValues(used + numValues);
+  std::size_t offset = used;
+  used += numValues;
+  return offset;
+}
+
+void ExpValArena::reserveValues(std::size_t numValues)
+{
+  if (numValues <= capacity)
+    return;
+
+  std::size_t newCapacity = std::max(std::max(numValues, 2 * capacity), MinArenaCapacity);
+  if (spillFd != -1)
+  {
+    if (remapSpillFile(newCapacity) == THOT_ERROR)
+      moveSpillToMemory(newCapacity);
+  }
+  else
+  {
+    buffer.resize(newCapacity * valueSize());
+    base = buffer.data();
+  }
+  capacity = newCapacity;
+}
+
+bool ExpValArena::remapSpillFile(std::size_t newCapacity)
+{
+#ifndef _WIN32
+  // The file is grown and mapped again before the old mapping is dropped, so
+  // that the arena is still usable if any of the steps fails
+  std::size_t newBytes = newCapacity * valueSize();
+  if (ftruncate(spillFd, (off_t)newBytes) == -1)
+    return THOT_ERROR;
+  void* p = mmap(nullptr, newBytes, PROT_READ | PROT_WRITE, MAP_SHARED, spillFd, 0);
+  if (p == MAP_FAILED)
+    return THOT_ERROR;
+  if (base != nullptr)
+    munmap(base, capacity * valueSize());
+  base = static_cast<char*>(p);
+  return THOT_OK;
+#else
+  return THOT_ERROR;
+#endif
+}
+
+void ExpValArena::moveSpillToMemory(std::size_t newCapacity)
+{
+  std::cerr << "Warning: spill file " << spillFileName
+            << " could not be grown, expected values will be kept in memory" << std::endl;
+  buffer.resize(newCapacity * valueSize());
+  if (base != nullptr)
+  {
+    std::memcpy(buffer.data(), base, used * valueSize());
+#ifndef _WIN32
+    munmap(base, capacity * valueSize());
+#endif
+  }
+  base = buffer.data();
+  closeSpillFile();
+  spillFileName.clear();
+}
+
+void ExpValArena::fillRange(std::size_t offset, std::size_t count, float value)
+{
+  if (count == 0)
+    return;
+  if (halfPrecision)
+    std::fill_n(reinterpret_cast<uint16_t*>(base) + offset, count, floatToHalf(value));
+  else
+    std::fill_n(reinterpret_cast<float*>(base) + offset, count, value);
+}
+
+void ExpValArena::copyValue(std::size_t from, std::size_t to)
+{
+  std::size_t vs = valueSize();
+  std::memcpy(base + to * vs, base + from * vs, vs);
+}
+
+void ExpValArena::compact()
+{
+  std::vector<unsigned int> liveEntries;
+  for (unsigned int np = 0; np < entries.size(); ++np)
+  {
+    if (entries[np].capacity > 0)
+      liveEntries.push_back(np);
+  }
+  std::sort(liveEntries.begin(), liveEntries.end(),
+            [this](unsigned int a, unsigned int b) { return entries[a].offset < entries[b].offset; });
+
+  // Blocks are only moved towards the beginning of the arena, so they can be
+  // moved in offset order without overwriting blocks that are still to be moved
+  std::size_t vs = valueSize();
+  std::size_t cursor = 0;
+  for (unsigned int np : liveEntries)
+  {
+    Entry& e = entries[np];
+    std::size_t count = product(e.dims);
+    if (count > 0 && e.offset != cursor)
+      std::memmove(base + cursor * vs, base + e.offset * vs, count * vs);
+    e.offset = cursor;
+    e.capacity = count;
+    cursor += count;
+  }
+  used = cursor;
+  garbage = 0;
+}
+
+void ExpValArena::releaseStorage()
+{
+#ifndef _WIN32
+  if (spillFd != -1)
+  {
+    if (base != nullptr)
+      munmap(base, capacity * valueSize());
+    if (ftruncate(spillFd, 0) == -1)
+      std::cerr << "Warning: spill file " << spillFileName << " could not be truncated" << std::endl;
+  }
+#endif
+  buffer.clear();
+  buffer.shrink_to_fit();
+  base = nullptr;
+  capacity = 0;
+}
+
+void ExpValArena::closeSpillFile()
+{
+#ifndef _WIN32
+  if (spillFd != -1)
+    ::close(spillFd);
+#endif
+  spillFd = -1;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Flat storage for the blocks of expected values kept by the incremental
+// trainers. Every entry is a dense dim0 x dim1 x dim2 block of values placed in
+// a single arena, so that an entry costs one allocation-free slot instead of a
+// nest of vectors. Values can be stored as half-precision floats, and the arena
+// can be kept in a memory-mapped spill file so that the expected values of the
+// whole training history do not need to fit in RAM.
+//
+// Entries can be read and written concurrently as long as no entry is being
+// allocated, reshaped or released at the same time.
+class ExpValArena
+{
+public:
+  ExpValArena();
+  ExpValArena(const ExpValArena&) = delete;
+  ExpValArena& operator=(const ExpValArena&) = delete;
+  ExpValArena(ExpValArena&& other);
+  ExpValArena& operator=(ExpValArena&& other);
+
+  // Storage options, changing them discards the stored entries
+  void setHalfPrecision(bool halfPrecision);
+  bool getHalfPrecision() const;
+  // An empty file name keeps the arena in memory. Spill files are only
+  // supported on POSIX systems
+  bool setSpillFile(const std::string& fileName, int verbose = 0);
+  const std::string& getSpillFile() const;
+
+  // Functions to handle entries
+  unsigned int size() const;
+  void grow(unsigned int numEntries);
+  unsigned int dim(unsigned int np, unsigned int d) const;
+  // Gives the entry the requested shape with all its values set to value
+  void allocate(unsigned int np, unsigned int dim0, unsigned int dim1, unsigned int dim2, float value);
+  // Gives the entry the requested shape keeping the values that fit in it,
+  // new positions are set to value
+  void reshape(unsigned int np, unsigned int dim0, unsigned int dim1, unsigned int dim2, float value);
+  void release(unsigned int np);
+  void fill(float value);
+
+  float get(unsigned int np, unsigned int j, unsigned int i, unsigned int ip) const
+  {
+    std::size_t idx = index(np, j, i, ip);
+    if (halfPrecision)
+      return halfToFloat(reinterpret_cast<const uint16_t*>(base)[idx]);
+    return reinterpret_cast<const float*>(base)[idx];
+  }
+
+  void set(unsigned int np, unsigned int j, unsigned int i, unsigned int ip, float value)
+  {
+    std::size_t idx = index(np, j, i, ip);
+    if (halfPrecision)
+      reinterpret_cast<uint16_t*>(base)[idx] = floatToHalf(value);
+    else
+      reinterpret_cast<float*>(base)[idx] = value;
+  }
+
+  // Number of values the arena occupies, including the space of released
+  // blocks that has not been compacted yet
+  std::size_t numValues() const;
+
+  void clear();
+
+  // Half-precision conversion. Values beyond the half range saturate, and the
+  // lowest half value is read back as SMALL_LG_NUM so that log-domain zeros
+  // survive the conversion
+  static uint16_t floatToHalf(float f);
+  static float halfToFloat(uint16_t h);
+
+  ~ExpValArena();
+
+private:
+  struct Entry
+  {
+    std::size_t offset;
+    std::size_t capacity;
+    unsigned int dims[3];
+  };
+
+  std::vector<Entry> entries;
+  std::size_t used;
+  std::size_t garbage;
+  std::size_t capacity;
+  char* base;
+  bool halfPrecision;
+
+  std::vector<char> buffer;
+  std::string spillFileName;
+  int spillFd;
+
+  std::size_t index(unsigned int np, unsigned int j, unsigned int i, unsigned int ip) const
+  {
+    const Entry& e = entries[np];
+    return e.offset + ((std::size_t)j * e.dims[1] + i) * e.dims[2] + ip;
+  }
+
+  void takeStorage(ExpValArena& other);
+  std::size_t valueSize() const;
+  std::size_t appendBlock(std::size_t numValues);
+  void reserveValues(std::size_t numValues);
+  bool remapSpillFile(std::size_t newCapacity);
+  void moveSpillToMemory(std::size_t newCapacity);
+  void fillRange(std::size_t offset, std::size_t count, float value);
+  void copyValue(std::size_t from, std::size_t to);
+  void compact();
+  void releaseStorage();
+  void closeSpillFile();
+};
@@ -7,6 +7,7 @@
 #include "sw_models/Md.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 #ifdef _WIN32
@@ -25,6 +26,19 @@ void FastAlignModel::set_expval_maxnsize(unsigned int _anji_maxnsize)
   anji.set_maxnsize(_anji_maxnsize);
 }
 
+void FastAlignModel::set_expval_half_precision(bool halfPrecision)
+{
+  // Same precision for both, as in IncrIbm1AlignmentTrainer
+  anji.set_half_precision(halfPrecision);
+  anji_aux.set_half_precision(halfPrecision);
+}
+
+bool FastAlignModel::set_expval_spill_file_prefix(const char* prefFileName)
+{
+  string spillFileName = prefFileName;
+  return anji.set_spill_file((spillFileName + ".anji.spill").c_str(), 1);
+}
+
 double FastAlignModel::getFastAlignP0() const
 {
   return fastAlignP0;
@@ -37,6 +51,7 @@ void FastAlignModel::setFastAlignP0(double value)
 
 unsigned int FastAlignModel::startTraining(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.startTraining, "start_training");
   clearTempVars();
   vector<vector<WordIndex>> insertBuffer;
   size_t insertBufferItems = 0;
@@ -90,33 +105,49 @@ unsigned int FastAlignModel::startTraining(int verbosity)
 
 void FastAlignModel::train(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.iteration, "iteration");
   empFeatSum = 0;
   vector<pair<vector<WordIndex>, vector<WordIndex>>> buffer;
-  for (unsigned int n = 0; n < numSentencePairs(); ++n)
+  unsigned int numPairs = numSentencePairs();
+  unsigned int n = 0;
+  while (n < numPairs)
   {
-    vector<WordIndex> src = getSrcSent(n);
-    vector<WordIndex> trg = getTrgSent(n);
-    if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
-      buffer.push_back(make_pair(src, trg));
+    TrainingPhaseTimer ioTimer(trainingMetrics.io);
+    for (; n < numPairs && buffer.size() < ThreadBufferSize; ++n)
+    {
+      vector<WordIndex> src = getSrcSent(n);
+      vector<WordIndex> trg = getTrgSent(n);
+      if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
+      {
+        trainingMetrics.numTokens += src.size() + trg.size();
+        buffer.push_back(make_pair(src, trg));
+      }
+    }
+    ioTimer.stop();
 
-    if (buffer.size() >= ThreadBufferSize)
+    if (buffer.size() > 0)
     {
+      TrainingPhaseTimer eStepTimer(trainingMetrics.eStep);
       batchUpdateCounts(buffer);
       buffer.clear();
     }
   }
-  if (buffer.size() > 0)
-  {
-    batchUpdateCounts(buffer);
-    buffer.clear();
-  }
 
+  TrainingPhaseTimer mStepTimer(trainingMetrics.mStep);
   if (iter > 0)
     optimizeDiagonalTension(8, verbosity);
   batchMaximizeProbs();
   iter++;
 }
 
+size_t FastAlignModel::getNumLexCounts() const
+{
+  size_t numLexCounts = 0;
+  for (const LexCountsElem& elem : lexCounts)
+    numLexCounts += elem.size();
+  return numLexCounts;
+}
+
 void FastAlignModel::endTraining()
 {
   clearTempVars();
@@ -269,8 +300,12 @@ void FastAlignModel::startIncrTraining(pair<unsigned int, unsigned int> sentPair
 
 void FastAlignModel::incrTrain(pair<unsigned int, unsigned int> sentPairRange, int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.iteration, "iteration");
+  TrainingPhaseTimer eStepTimer(trainingMetrics.eStep);
   calcNewLocalSuffStats(sentPairRange, verbosity);
+  eStepTimer.stop();
 
+  TrainingPhaseTimer mStepTimer(trainingMetrics.mStep);
   optimizeDiagonalTension(2, verbosity);
   incrMaximizeProbs();
   iter++;
@@ -295,6 +330,7 @@ void FastAlignModel::calcNewLocalSuffStats(pair<unsigned int, unsigned int> sent
 
     Count weight;
     sentenceHandler->getCount(n, weight);
+    trainingMetrics.numTokens += srcSent.size() + trgSent.size();
 
     // Calculate sufficient statistics for anji values
     calc_anji(n, nsrcSent, trgSent, weight);
@@ -560,6 +596,34 @@ LgProb FastAlignModel::getBestAlignment(const vector<WordIndex>& srcSentence, co
   }
 }
 
+void FastAlignModel::getAlignmentPosteriors(const vector<WordIndex>& srcSentence, const vector<WordIndex>& trgSentence,
+                                            float* posteriors)
+{
+  size_t tlen = trgSentence.size();
+  fill(posteriors, posteriors + srcSentence.size() * tlen, 0.0f);
+  if (!sentenceLengthIsOk(srcSentence) || !sentenceLengthIsOk(trgSentence))
+    return;
+
+  unsigned int slen = (unsigned int)srcSentence.size();
+  vector<double> probs(srcSentence.size() + 1);
+  for (PositionIndex j = 1; j <= tlen; ++j)
+  {
+    WordIndex t = trgSentence[j - 1];
+    probs[0] = translationProb(NULL_WORD, t) * (double)alignmentProb(j, slen, (unsigned int)tlen, 0);
+    double sum = probs[0];
+    double az = computeAZ(j, slen, (unsigned int)tlen);
+    for (PositionIndex i = 1; i <= slen; ++i)
+    {
+      probs[i] = translationProb(srcSentence[i - 1], t) * (double)alignmentProb(az, j, slen, (unsigned int)tlen, i);
+      sum += probs[i];
+    }
+    if (sum == 0)
+      continue;
+    for (PositionIndex i = 1; i <= slen; ++i)
+      posteriors[(i - 1) * tlen + j - 1] = (float)(probs[i] / sum);
+  }
+}
+
 Prob FastAlignModel::translationProb(WordIndex s, WordIndex t)
 {
   return translationLogProb(s, t).get_p();
@@ -651,25 +715,6 @@ bool FastAlignModel::getEntriesForSource(WordIndex s, NbestTableNode<WordIndex>&
   return true;
 }
 
-pair<double, double> FastAlignModel::loglikelihoodForPairRange(pair<unsigned int, unsigned int> sentPairRange,
-                                                               int verbosity)
-{
-  double loglikelihood = 0;
-  unsigned int numSents = 0;
-
-  for (unsigned int n = sentPairRange.first; n <= sentPairRange.second; ++n)
-  {
-    if (verbosity)
-      cerr << "* Calculating log-likelihood for sentence " << n << std::endl;
-    // Add log-likelihood
-    vector<WordIndex> nthSrcSent = getSrcSent(n);
-    vector<WordIndex> nthTrgSent = getTrgSent(n);
-    loglikelihood += (double)computeSumLogProb(nthSrcSent, nthTrgSent, verbosity);
-    ++numSents;
-  }
-  return make_pair(loglikelihood, loglikelihood / (double)numSents);
-}
-
 LgProb FastAlignModel::computeSumLogProb(const vector<WordIndex>& srcSentence, const vector<WordIndex>& trgSentence,
                                          int verbose)
 {
@@ -716,44 +761,27 @@ LgProb FastAlignModel::computeLogProb(const vector<WordIndex>& srcSentence, cons
   return logProb;
 }
 
-bool FastAlignModel::load(const char* prefFileName, int verbose)
+void FastAlignModel::addLoadTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  if (prefFileName[0] != 0)
-  {
-    bool retVal;
+  AlignmentModelBase::addLoadTasks(prefFileName, verbose, tasks);
 
-    retVal = AlignmentModelBase::load(prefFileName, verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
-
-    if (verbose)
-      cerr << "Loading FastAlign Model data..." << endl;
+  if (verbose)
+    cerr << "Loading FastAlign Model data..." << endl;
 
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
     // Load file with anji values
-    anji.load(prefFileName, verbose);
-
-    string lexNumDenFile = prefFileName;
-    lexNumDenFile = lexNumDenFile + ".fa_lexnd";
-    retVal = lexTable.load(lexNumDenFile.c_str(), verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
-
-    string sizeCountsFile = prefFileName;
-    sizeCountsFile = sizeCountsFile + ".size_counts";
-    retVal = loadSizeCounts(sizeCountsFile);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
-
-    string paramsFile = prefFileName;
-    paramsFile = paramsFile + ".params";
-    retVal = loadParams(paramsFile);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
-
+    anji.load(prefFileName.c_str(), verbose);
     return THOT_OK;
-  }
-  else
-    return THOT_ERROR;
+  });
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    string lexNumDenFile = prefFileName + ".fa_lexnd";
+    return lexTable.load(lexNumDenFile.c_str(), verbose);
+  });
+
+  tasks.push_back([this, prefFileName]() -> bool { return loadSizeCounts(prefFileName + ".size_counts"); });
+
+  tasks.push_back([this, prefFileName]() -> bool { return loadParams(prefFileName + ".params"); });
 }
 
 bool FastAlignModel::loadParams(const string& filename)
@@ -761,6 +789,11 @@ bool FastAlignModel::loadParams(const string& filename)
   ifstream in(filename);
   if (!in)
     return THOT_ERROR;
+  return loadParams(in);
+}
+
+bool FastAlignModel::loadParams(istream& in)
+{
   in >> empFeatSum >> diagonalTension;
 
   return THOT_OK;
@@ -771,7 +804,11 @@ bool FastAlignModel::loadSizeCounts(const string& filename)
   ifstream in(filename);
   if (!in)
     return THOT_ERROR;
+  return loadSizeCounts(in);
+}
 
+bool FastAlignModel::loadSizeCounts(istream& in)
+{
   trgTokenCount = 0;
   totLenRatio = 0;
   unsigned int tlen, slen, count;
@@ -785,45 +822,122 @@ bool FastAlignModel::loadSizeCounts(const string& filename)
   return THOT_OK;
 }
 
-bool FastAlignModel::print(const char* prefFileName, int verbose)
+void FastAlignModel::addPrintTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  bool retVal;
+  AlignmentModelBase::addPrintTasks(prefFileName, verbose, tasks);
+
+  // Print file anji values
+  tasks.push_back([this, prefFileName]() -> bool { return anji.print(prefFileName.c_str()); });
 
-  retVal = AlignmentModelBase::print(prefFileName);
+  tasks.push_back([this, prefFileName]() -> bool {
+    string lexNumDenFile = prefFileName + ".fa_lexnd";
+    return lexTable.print(lexNumDenFile.c_str());
+  });
+
+  tasks.push_back([this, prefFileName]() -> bool { return printSizeCounts(prefFileName + ".size_counts"); });
+
+  tasks.push_back([this, prefFileName]() -> bool { return printParams(prefFileName + ".params"); });
+}
+
+bool FastAlignModel::loadSections(const ModelContainer& container, int verbose)
+{
+  bool retVal = AlignmentModelBase::loadSections(container, verbose);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  // Print file anji values
-  retVal = anji.print(prefFileName);
+  const char* data;
+  size_t size;
+  if (container.getSection(".fa_lexnd", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream lexNumDenIn(data, size);
+  retVal = lexTable.load(lexNumDenIn);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  string lexNumDenFile = prefFileName;
-  lexNumDenFile = lexNumDenFile + ".fa_lexnd";
-  retVal = lexTable.print(lexNumDenFile.c_str());
+  if (container.getSection(".size_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream sizeCountsIn(data, size);
+  retVal = loadSizeCounts(sizeCountsIn);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  string sizeCountsFile = prefFileName;
-  sizeCountsFile = sizeCountsFile + ".size_counts";
-  retVal = printSizeCounts(sizeCountsFile);
+  if (container.getSection(".params", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream paramsIn(data, size);
+  return loadParams(paramsIn);
+}
+
+bool FastAlignModel::printSections(ModelContainer& container)
+{
+  bool retVal = AlignmentModelBase::printSections(container);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  string paramsFile = prefFileName;
-  paramsFile = paramsFile + ".params";
-  retVal = printParams(paramsFile);
+  ostringstream lexNumDenOut;
+  retVal = lexTable.print(lexNumDenOut);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  container.addSection(".fa_lexnd", lexNumDenOut.str());
+
+  ostringstream sizeCountsOut;
+  printSizeCounts(sizeCountsOut);
+  container.addSection(".size_counts", sizeCountsOut.str());
+
+  ostringstream paramsOut;
+  printParams(paramsOut);
+  container.addSection(".params", paramsOut.str());
 
   return THOT_OK;
 }
 
+bool FastAlignModel::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  bool retVal = AlignmentModelBase::loadTrainingState(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  // The size counts, which are also collected by startTraining(), are part of the model files
+  const char* data;
+  size_t size;
+  if (container.getSection(".iter", data, size) == THOT_ERROR || size != sizeof(int))
+    return THOT_ERROR;
+  memcpy(&iter, data, sizeof(int));
+
+  if (container.getSection(".lex_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream lexCountsIn(data, size);
+  retVal = loadLexCounts(lexCountsIn, getSrcVocabSize(), getTrgVocabSize(), lexCounts);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+  if (!lexCounts.empty())
+    lexTable.reserveSpace((WordIndex)lexCounts.size() - 1);
+  return THOT_OK;
+}
+
+bool FastAlignModel::printTrainingState(ModelContainer& container)
+{
+  bool retVal = AlignmentModelBase::printTrainingState(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  container.addSection(".iter", string((const char*)&iter, sizeof(int)));
+
+  ostringstream lexCountsOut;
+  printLexCounts(lexCountsOut, lexCounts);
+  container.addSection(".lex_counts", lexCountsOut.str());
+  return THOT_OK;
+}
+
 bool FastAlignModel::printParams(const string& filename)
 {
   ofstream out(filename);
   if (!out)
     return THOT_ERROR;
+  return printParams(out);
+}
+
+bool FastAlignModel::printParams(ostream& out)
+{
   out << setprecision(numeric_limits<double>::max_digits10) << empFeatSum << " " << diagonalTension;
   return THOT_OK;
 }
@@ -833,7 +947,11 @@ bool FastAlignModel::printSizeCounts(const string& filename)
   ofstream out(filename, ios::binary);
   if (!out)
     return THOT_ERROR;
+  return printSizeCounts(out);
+}
 
+bool FastAlignModel::printSizeCounts(ostream& out)
+{
   for (SizeCounts::iterator iter = sizeCounts.begin(); iter != sizeCounts.end(); ++iter)
     out << iter->first.first << " " << iter->first.second << " " << iter->second << endl;
 
@@ -29,6 +29,8 @@ public:
   }
 
   void set_expval_maxnsize(unsigned int _anji_maxnsize) override;
+  void set_expval_half_precision(bool halfPrecision) override;
+  bool set_expval_spill_file_prefix(const char* prefFileName) override;
   double getFastAlignP0() const;
   void setFastAlignP0(double value);
 
@@ -40,9 +42,6 @@ public:
   void incrTrain(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0) override;
   void endIncrTraining() override;
 
-  std::pair<double, double> loglikelihoodForPairRange(std::pair<unsigned int, unsigned int> sentPairRange,
-                                                      int verbosity = 0) override;
-
   Prob translationProb(WordIndex s, WordIndex t) override;
   LgProb translationLogProb(WordIndex s, WordIndex t) override;
 
@@ -58,6 +57,9 @@ public:
   using AlignmentModel::getBestAlignment;
   LgProb getBestAlignment(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                           std::vector<PositionIndex>& bestAlignment) override;
+  using AlignmentModel::getAlignmentPosteriors;
+  void getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
+                              float* posteriors) override;
   using AlignmentModel::computeLogProb;
   LgProb computeLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                         const WordAlignmentMatrix& aligMatrix, int verbose = 0) override;
@@ -65,9 +67,6 @@ public:
   LgProb computeSumLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                            int verbose = 0) override;
 
-  bool load(const char* prefFileName, int verbose = 0) override;
-  bool print(const char* prefFileName, int verbose = 0) override;
-
   void clearSentenceLengthModel() override;
   void clearTempVars() override;
   void clear() override;
@@ -99,9 +98,13 @@ private:
   double computeAZ(PositionIndex j, PositionIndex slen, PositionIndex tlen);
   Prob alignmentProb(double az, PositionIndex j, PositionIndex slen, PositionIndex tlen, PositionIndex i);
   bool printParams(const std::string& filename);
+  bool printParams(std::ostream& out);
   bool loadParams(const std::string& filename);
+  bool loadParams(std::istream& in);
   bool printSizeCounts(const std::string& filename);
+  bool printSizeCounts(std::ostream& out);
   bool loadSizeCounts(const std::string& filename);
+  bool loadSizeCounts(std::istream& in);
   void batchMaximizeProbs();
   void optimizeDiagonalTension(unsigned int nIters, int verbose);
   void incrementSizeCount(unsigned int tlen, unsigned int slen);
@@ -121,6 +124,13 @@ private:
 
   void loadConfig(const YAML::Node& config) override;
   void createConfig(YAML::Emitter& out) override;
+  void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  bool loadSections(const ModelContainer& container, int verbose = 0) override;
+  bool printSections(ModelContainer& container) override;
+  bool loadTrainingState(const ModelContainer& container, int verbose = 0) override;
+  bool printTrainingState(ModelContainer& container) override;
+  std::size_t getNumLexCounts() const override;
 
   double fastAlignP0 = DefaultFastAlignP0;
 
@@ -80,9 +80,6 @@ bool FertilityTable::load(const char* fertilityNumDenFile, int verbose)
 
 bool FertilityTable::loadBin(const char* fertilityNumDenFile, int verbose)
 {
-  // Clear data structures
-  clear();
-
   if (verbose)
     cerr << "Loading fertility nd file in binary format from " << fertilityNumDenFile << endl;
 
@@ -96,26 +93,33 @@ bool FertilityTable::loadBin(const char* fertilityNumDenFile, int verbose)
   }
   else
   {
-    // Read register
-    bool end = false;
-    while (!end)
+    return load(inF);
+  }
+}
+
+bool FertilityTable::load(istream& in)
+{
+  clear();
+
+  // Read register
+  bool end = false;
+  while (!end)
+  {
+    WordIndex s;
+    PositionIndex phi;
+    float numer;
+    float denom;
+    if (in.read((char*)&s, sizeof(WordIndex)))
     {
-      WordIndex s;
-      PositionIndex phi;
-      float numer;
-      float denom;
-      if (inF.read((char*)&s, sizeof(WordIndex)))
-      {
-        inF.read((char*)&phi, sizeof(PositionIndex));
-        inF.read((char*)&numer, sizeof(float));
-        inF.read((char*)&denom, sizeof(float));
-        set(s, phi, numer, denom);
-      }
-      else
-        end = true;
+      in.read((char*)&phi, sizeof(PositionIndex));
+      in.read((char*)&numer, sizeof(float));
+      in.read((char*)&denom, sizeof(float));
+      set(s, phi, numer, denom);
     }
-    return THOT_OK;
+    else
+      end = true;
   }
+  return THOT_OK;
 }
 
 bool FertilityTable::loadPlainText(const char* fertilityNumDenFile, int verbose)
@@ -171,21 +175,26 @@ bool FertilityTable::printBin(const char* fertilityNumDenFile) const
   }
   else
   {
-    // print file with fertility nd values
-    for (WordIndex s = 0; s < numerators.size(); ++s)
+    return print(outF);
+  }
+}
+
+bool FertilityTable::print(ostream& out) const
+{
+  // print file with fertility nd values
+  for (WordIndex s = 0; s < numerators.size(); ++s)
+  {
+    for (PositionIndex phi = 0; phi < numerators[s].size(); ++phi)
     {
-      for (PositionIndex phi = 0; phi < numerators[s].size(); ++phi)
-      {
-        bool found;
-        outF.write((char*)&s, sizeof(WordIndex));
-        outF.write((char*)&phi, sizeof(PositionIndex));
-        outF.write((char*)&numerators[s][phi], sizeof(float));
-        float denom = getDenominator(s, found);
-        outF.write((char*)&denom, sizeof(float));
-      }
+      bool found;
+      out.write((char*)&s, sizeof(WordIndex));
+      out.write((char*)&phi, sizeof(PositionIndex));
+      out.write((char*)&numerators[s][phi], sizeof(float));
+      float denom = getDenominator(s, found);
+      out.write((char*)&denom, sizeof(float));
     }
-    return THOT_OK;
   }
+  return THOT_OK;
 }
 
 bool FertilityTable::printPlainText(const char* fertilityNumDenFile) const
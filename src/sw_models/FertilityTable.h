@@ -6,6 +6,7 @@
 #include "nlp_common/WordIndex.h"
 
 #include <fstream>
+#include <iostream>
 #include <vector>
 
 class FertilityTable
@@ -23,6 +24,9 @@ public:
 
   bool print(const char* fertilityNumDenFile) const;
 
+  bool load(std::istream& in);
+  bool print(std::ostream& out) const;
+
   void reserveSpace(WordIndex s);
 
   void clear();
@@ -119,8 +119,6 @@ bool HeadDistortionTable::loadPlainText(const char* tableFile, int verbose)
 
 bool HeadDistortionTable::loadBin(const char* tableFile, int verbose)
 {
-  clear();
-
   if (verbose)
     std::cerr << "Loading head distortion nd file in binary format from " << tableFile << std::endl;
 
@@ -132,6 +130,13 @@ bool HeadDistortionTable::loadBin(const char* tableFile, int verbose)
     return THOT_ERROR;
   }
 
+  return load(inF);
+}
+
+bool HeadDistortionTable::load(std::istream& in)
+{
+  clear();
+
   bool end = false;
   while (!end)
   {
@@ -140,12 +145,12 @@ bool HeadDistortionTable::loadBin(const char* tableFile, int verbose)
     int dj;
     float numer;
     float denom;
-    if (inF.read((char*)&sourceWordClass, sizeof(WordClassIndex)))
+    if (in.read((char*)&sourceWordClass, sizeof(WordClassIndex)))
     {
-      inF.read((char*)&targetWordClass, sizeof(WordClassIndex));
-      inF.read((char*)&dj, sizeof(int));
-      inF.read((char*)&numer, sizeof(float));
-      inF.read((char*)&denom, sizeof(float));
+      in.read((char*)&targetWordClass, sizeof(WordClassIndex));
+      in.read((char*)&dj, sizeof(int));
+      in.read((char*)&numer, sizeof(float));
+      in.read((char*)&denom, sizeof(float));
       set(sourceWordClass, targetWordClass, dj, numer, denom);
     }
     else
@@ -190,17 +195,22 @@ bool HeadDistortionTable::printBin(const char* tableFile) const
     return THOT_ERROR;
   }
 
+  return print(outF);
+}
+
+bool HeadDistortionTable::print(std::ostream& out) const
+{
   for (auto& numElemPair : numerators)
   {
     for (auto& numPair : numElemPair.second)
     {
-      outF.write((char*)&numElemPair.first.srcWordClass, sizeof(WordClassIndex));
-      outF.write((char*)&numElemPair.first.trgWordClass, sizeof(WordClassIndex));
-      outF.write((char*)&numPair.first, sizeof(int));
-      outF.write((char*)&numPair.second, sizeof(float));
+      out.write((char*)&numElemPair.first.srcWordClass, sizeof(WordClassIndex));
+      out.write((char*)&numElemPair.first.trgWordClass, sizeof(WordClassIndex));
+      out.write((char*)&numPair.first, sizeof(int));
+      out.write((char*)&numPair.second, sizeof(float));
       bool found;
       float denom = getDenominator(numElemPair.first.srcWordClass, numElemPair.first.trgWordClass, found);
-      outF.write((char*)&denom, sizeof(float));
+      out.write((char*)&denom, sizeof(float));
     }
   }
   return THOT_OK;
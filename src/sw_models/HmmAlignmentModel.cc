@@ -3,6 +3,9 @@
 #include "nlp_common/ErrorDefs.h"
 #include "sw_models/SwDefs.h"
 
+#include <algorithm>
+#include <sstream>
+
 HmmAlignmentModel::HmmAlignmentModel() : hmmAlignmentTable{std::make_shared<HmmAlignmentTable>()}
 {
   lexNumDenFileExtension = ".hmm_lexnd";
@@ -56,45 +59,28 @@ void HmmAlignmentModel::setHmmP0(Prob p0)
 
 unsigned int HmmAlignmentModel::startTraining(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.startTraining, "start_training");
   clearTempVars();
-  std::vector<std::vector<unsigned>> insertBuffer;
-  size_t insertBufferItems = 0;
+  const EncodedCorpus& corpus = getEncodedCorpus();
   unsigned int count = 0;
-  for (unsigned int n = 0; n < numSentencePairs(); ++n)
+  std::vector<WordIndex> src, trg;
+  for (unsigned int n = 0; n < corpus.numSentencePairs(); ++n)
   {
-    std::vector<WordIndex> src = getSrcSent(n);
-    std::vector<WordIndex> trg = getTrgSent(n);
+    corpus.getSrcSent(n, src);
+    corpus.getTrgSent(n, trg);
 
     if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
     {
-      std::vector<WordIndex> nsrc = extendWithNullWord(src);
-
       PositionIndex slen = (PositionIndex)src.size();
       PositionIndex tlen = (PositionIndex)trg.size();
 
-      HmmAlignmentKey asHmm0{0, getCompactedSentenceLength(slen)};
-      hmmAlignmentTable->reserveSpace(asHmm0.prev_i, asHmm0.slen);
-      HmmAlignmentCountsElem& elem = hmmAlignmentCounts[asHmm0];
-      if (elem.size() < src.size())
-        elem.resize(src.size(), 0);
-
-      for (PositionIndex i = 1; i <= nsrc.size(); ++i)
+      for (PositionIndex i = 0; i <= slen; ++i)
       {
-        WordIndex s = nsrc[i - 1];
-        if (s >= insertBuffer.size())
-          insertBuffer.resize((size_t)s + 1);
-        for (const WordIndex t : trg)
-          insertBuffer[s].push_back(t);
-        insertBufferItems += trg.size();
-
-        if (i <= slen)
-        {
-          HmmAlignmentKey asHmm{i, getCompactedSentenceLength(slen)};
-          hmmAlignmentTable->reserveSpace(asHmm.prev_i, asHmm.slen);
-          HmmAlignmentCountsElem& elem = hmmAlignmentCounts[asHmm];
-          if (elem.size() < src.size())
-            elem.resize(src.size(), 0);
-        }
+        HmmAlignmentKey asHmm{i, getCompactedSentenceLength(slen)};
+        hmmAlignmentTable->reserveSpace(asHmm.prev_i, asHmm.slen);
+        HmmAlignmentCountsElem& elem = hmmAlignmentCounts[asHmm];
+        if (elem.size() < src.size())
+          elem.resize(src.size(), 0);
       }
 
       for (PositionIndex j = 1; j <= trg.size(); ++j)
@@ -106,23 +92,12 @@ unsigned int HmmAlignmentModel::startTraining(int verbosity)
         if (elem.size() < src.size() + 1)
           elem.resize(src.size() + 1, 0);
       }
-
-      if (insertBufferItems > ThreadBufferSize * 100)
-      {
-        insertBufferItems = 0;
-        addTranslationOptions(insertBuffer);
-      }
       ++count;
     }
   }
-  if (insertBufferItems > 0)
-    addTranslationOptions(insertBuffer);
 
-  if (numSentencePairs() > 0)
-  {
-    // Train sentence length model
-    sentLengthModel->trainSentencePairRange(std::make_pair(0, numSentencePairs() - 1), verbosity);
-  }
+  addCorpusTranslationOptions(corpus);
+  trainSentenceLengthModel(corpus);
   return count;
 }
 
@@ -366,6 +341,35 @@ LgProb HmmAlignmentModel::getBestAlignment(const std::vector<WordIndex>& srcSent
   return getBestAlignmentCached(srcSentence, trgSentence, cached_logap, bestAlignment);
 }
 
+void HmmAlignmentModel::getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence,
+                                               const std::vector<WordIndex>& trgSentence, float* posteriors)
+{
+  size_t tlen = trgSentence.size();
+  std::fill(posteriors, posteriors + srcSentence.size() * tlen, 0.0f);
+  if (!sentenceLengthIsOk(srcSentence) || !sentenceLengthIsOk(trgSentence))
+    return;
+
+  PositionIndex slen = (PositionIndex)srcSentence.size();
+  std::vector<WordIndex> nsrc = extendWithNullWord(srcSentence);
+  std::vector<std::vector<double>> lexProbs;
+  std::vector<std::vector<double>> alignProbs;
+  std::vector<std::vector<double>> alphaMatrix;
+  std::vector<std::vector<double>> betaMatrix;
+  calcAlphaBetaMatrices(nsrc, trgSentence, slen, lexProbs, alignProbs, alphaMatrix, betaMatrix);
+
+  // State i > slen is the NULL word, its mass is left out of the output
+  for (PositionIndex j = 1; j <= tlen; ++j)
+  {
+    double sum = 0;
+    for (PositionIndex i = 1; i <= nsrc.size(); ++i)
+      sum += alphaMatrix[i][j] * betaMatrix[i][j];
+    if (sum == 0)
+      continue;
+    for (PositionIndex i = 1; i <= slen; ++i)
+      posteriors[(i - 1) * tlen + j - 1] = (float)(alphaMatrix[i][j] * betaMatrix[i][j] / sum);
+  }
+}
+
 LgProb HmmAlignmentModel::computeLogProb(const std::vector<WordIndex>& srcSentence,
                                          const std::vector<WordIndex>& trgSentence,
                                          const WordAlignmentMatrix& aligMatrix, int verbose)
@@ -489,49 +493,131 @@ void HmmAlignmentModel::populateMoveSwapScores(const std::vector<WordIndex>& src
   }
 }
 
-bool HmmAlignmentModel::load(const char* prefFileName, int verbose)
+void HmmAlignmentModel::addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  if (prefFileName[0] != 0)
-  {
-    bool retVal;
-
-    // Load IBM 1 Model data
-    retVal = Ibm1AlignmentModel::load(prefFileName, verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
+  // Load IBM 1 Model data
+  Ibm1AlignmentModel::addLoadTasks(prefFileName, verbose, tasks);
 
-    if (verbose)
-      std::cerr << "Loading HMM Model data..." << std::endl;
+  if (verbose)
+    std::cerr << "Loading HMM Model data..." << std::endl;
 
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
     // Load file with alignment nd values
-    std::string aligNumDenFile = prefFileName;
-    aligNumDenFile = aligNumDenFile + ".hmm_alignd";
-    retVal = hmmAlignmentTable->load(aligNumDenFile.c_str(), verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
+    std::string aligNumDenFile = prefFileName + ".hmm_alignd";
+    return hmmAlignmentTable->load(aligNumDenFile.c_str(), verbose);
+  });
+}
 
-    return retVal;
-  }
-  else
+void HmmAlignmentModel::addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
+{
+  // Print IBM 1 Model data
+  Ibm1AlignmentModel::addPrintTasks(prefFileName, verbose, tasks);
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with alignment nd values
+    std::string aligNumDenFile = prefFileName + ".hmm_alignd";
+    return hmmAlignmentTable->print(aligNumDenFile.c_str());
+  });
+}
+
+bool HmmAlignmentModel::loadSections(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm1AlignmentModel::loadSections(container, verbose);
+  if (retVal == THOT_ERROR)
     return THOT_ERROR;
+
+  const char* data;
+  std::size_t size;
+  if (container.getSection(".hmm_alignd", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream aligNumDenIn(data, size);
+  return hmmAlignmentTable->load(aligNumDenIn);
 }
 
-bool HmmAlignmentModel::print(const char* prefFileName, int verbose)
+bool HmmAlignmentModel::printSections(ModelContainer& container)
 {
-  bool retVal;
+  bool retVal = Ibm1AlignmentModel::printSections(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
 
-  // Print IBM 1 Model data
-  retVal = Ibm1AlignmentModel::print(prefFileName);
+  std::ostringstream aligNumDenOut;
+  retVal = hmmAlignmentTable->print(aligNumDenOut);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  container.addSection(".hmm_alignd", aligNumDenOut.str());
 
-  // Print file with alignment nd values
-  std::string aligNumDenFile = prefFileName;
-  aligNumDenFile = aligNumDenFile + ".hmm_alignd";
-  retVal = hmmAlignmentTable->print(aligNumDenFile.c_str());
+  return THOT_OK;
+}
+
+bool HmmAlignmentModel::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  // The IBM2 alignment counts are also updated while training the HMM
+  bool retVal = Ibm2AlignmentModel::loadTrainingState(container, verbose);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
+  const char* data;
+  std::size_t size;
+  if (container.getSection(".hmm_alignment_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  // Training allocates one count for every source position. With a compacted table all
+  // the sentence lengths share a key, which covers the longest source sentence
+  PositionIndex maxSrcLength = 0;
+  if (compactAlignmentTable)
+  {
+    const EncodedCorpus& corpus = getEncodedCorpus();
+    for (unsigned int n = 0; n < corpus.numSentencePairs(); ++n)
+    {
+      PositionIndex slen = corpus.getSrcLength(n);
+      PositionIndex tlen = corpus.getTrgLength(n);
+      if (slen > 0 && slen <= getMaxSentenceLength() && tlen > 0 && tlen <= getMaxSentenceLength())
+        maxSrcLength = std::max(maxSrcLength, slen);
+    }
+  }
+
+  MemoryInputStream in(data, size);
+  unsigned int numKeys;
+  if (!in.read((char*)&numKeys, sizeof(unsigned int)))
+    return THOT_ERROR;
+  for (unsigned int k = 0; k < numKeys; ++k)
+  {
+    HmmAlignmentKey key;
+    unsigned int elemSize;
+    in.read((char*)&key.prev_i, sizeof(PositionIndex));
+    in.read((char*)&key.slen, sizeof(PositionIndex));
+    in.read((char*)&elemSize, sizeof(unsigned int));
+    // The positions size the rows of the HMM table
+    PositionIndex slen = compactAlignmentTable ? maxSrcLength : key.slen;
+    if (!in || key.slen != getCompactedSentenceLength(slen) || slen > getMaxSentenceLength() || key.prev_i > slen
+        || elemSize != slen || !in.canRead(elemSize, sizeof(double)))
+      return THOT_ERROR;
+    HmmAlignmentCountsElem elem(elemSize);
+    if (!in.read((char*)elem.data(), elemSize * sizeof(double)))
+      return THOT_ERROR;
+    hmmAlignmentTable->reserveSpace(key.prev_i, key.slen);
+    hmmAlignmentCounts[key] = elem;
+  }
+  return THOT_OK;
+}
+
+bool HmmAlignmentModel::printTrainingState(ModelContainer& container)
+{
+  bool retVal = Ibm2AlignmentModel::printTrainingState(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  std::ostringstream out;
+  unsigned int numKeys = (unsigned int)hmmAlignmentCounts.size();
+  out.write((char*)&numKeys, sizeof(unsigned int));
+  for (const std::pair<HmmAlignmentKey, HmmAlignmentCountsElem>& p : hmmAlignmentCounts)
+  {
+    unsigned int elemSize = (unsigned int)p.second.size();
+    out.write((char*)&p.first.prev_i, sizeof(PositionIndex));
+    out.write((char*)&p.first.slen, sizeof(PositionIndex));
+    out.write((char*)&elemSize, sizeof(unsigned int));
+    out.write((char*)p.second.data(), elemSize * sizeof(double));
+  }
+  container.addSection(".hmm_alignment_counts", out.str());
   return THOT_OK;
 }
 
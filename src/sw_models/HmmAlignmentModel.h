@@ -86,6 +86,9 @@ public:
   using AlignmentModel::getBestAlignment;
   LgProb getBestAlignment(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                           std::vector<PositionIndex>& bestAlignment) override;
+  using AlignmentModel::getAlignmentPosteriors;
+  void getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
+                              float* posteriors) override;
   using AlignmentModel::computeLogProb;
   LgProb computeLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                         const WordAlignmentMatrix& aligMatrix, int verbose = 0) override;
@@ -93,9 +96,6 @@ public:
   LgProb computeSumLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                            int verbose = 0) override;
 
-  bool load(const char* prefFileName, int verbose = 0) override;
-  bool print(const char* prefFileName, int verbose = 0) override;
-
   void clear() override;
   void clearTempVars() override;
 
@@ -183,6 +183,12 @@ protected:
   void loadConfig(const YAML::Node& config) override;
   bool loadOldConfig(const char* prefFileName, int verbose = 0) override;
   void createConfig(YAML::Emitter& out) override;
+  void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  bool loadSections(const ModelContainer& container, int verbose = 0) override;
+  bool printSections(ModelContainer& container) override;
+  bool loadTrainingState(const ModelContainer& container, int verbose = 0) override;
+  bool printTrainingState(ModelContainer& container) override;
 
   double hmmAlignmentSmoothFactor = DefaultHmmAlignmentSmoothFactor;
   double lexicalSmoothFactor = DefaultLexicalSmoothFactor;
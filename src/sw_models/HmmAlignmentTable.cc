@@ -114,9 +114,6 @@ bool HmmAlignmentTable::loadPlainText(const char* aligNumDenFile, int verbose)
 
 bool HmmAlignmentTable::loadBin(const char* aligNumDenFile, int verbose)
 {
-  // Clear data structures
-  clear();
-
   if (verbose)
     std::cerr << "Loading alignd file in binary format from " << aligNumDenFile << std::endl;
 
@@ -130,28 +127,35 @@ bool HmmAlignmentTable::loadBin(const char* aligNumDenFile, int verbose)
   }
   else
   {
-    // Read register
-    bool end = false;
-    while (!end)
+    return load(inF);
+  }
+}
+
+bool HmmAlignmentTable::load(istream& in)
+{
+  clear();
+
+  // Read register
+  bool end = false;
+  while (!end)
+  {
+    PositionIndex prev_i;
+    PositionIndex slen;
+    PositionIndex i;
+    float numer;
+    float denom;
+    if (in.read((char*)&prev_i, sizeof(PositionIndex)))
     {
-      PositionIndex prev_i;
-      PositionIndex slen;
-      PositionIndex i;
-      float numer;
-      float denom;
-      if (inF.read((char*)&prev_i, sizeof(PositionIndex)))
-      {
-        inF.read((char*)&slen, sizeof(PositionIndex));
-        inF.read((char*)&i, sizeof(PositionIndex));
-        inF.read((char*)&numer, sizeof(float));
-        inF.read((char*)&denom, sizeof(float));
-        set(prev_i, slen, i, numer, denom);
-      }
-      else
-        end = true;
+      in.read((char*)&slen, sizeof(PositionIndex));
+      in.read((char*)&i, sizeof(PositionIndex));
+      in.read((char*)&numer, sizeof(float));
+      in.read((char*)&denom, sizeof(float));
+      set(prev_i, slen, i, numer, denom);
     }
-    return THOT_OK;
+    else
+      end = true;
   }
+  return THOT_OK;
 }
 
 bool HmmAlignmentTable::print(const char* aligNumDenFile)
@@ -174,28 +178,33 @@ bool HmmAlignmentTable::printBin(const char* aligNumDenFile)
   }
   else
   {
-    // print file with alignment nd values
-    for (PositionIndex prev_i = 0; prev_i < numerators.size(); ++prev_i)
+    return print(outF);
+  }
+}
+
+bool HmmAlignmentTable::print(ostream& out)
+{
+  // print file with alignment nd values
+  for (PositionIndex prev_i = 0; prev_i < numerators.size(); ++prev_i)
+  {
+    for (PositionIndex slen = 0; slen < numerators[prev_i].size(); ++slen)
     {
-      for (PositionIndex slen = 0; slen < numerators[prev_i].size(); ++slen)
+      for (PositionIndex i = 0; i < numerators[prev_i][slen].size(); ++i)
       {
-        for (PositionIndex i = 0; i < numerators[prev_i][slen].size(); ++i)
+        if (numerators[prev_i][slen][i].first)
         {
-          if (numerators[prev_i][slen][i].first)
-          {
-            bool found;
-            outF.write((char*)&prev_i, sizeof(PositionIndex));
-            outF.write((char*)&slen, sizeof(PositionIndex));
-            outF.write((char*)&i, sizeof(PositionIndex));
-            outF.write((char*)&numerators[prev_i][slen][i].second, sizeof(float));
-            float denom = getDenominator(prev_i, slen, found);
-            outF.write((char*)&denom, sizeof(float));
-          }
+          bool found;
+          out.write((char*)&prev_i, sizeof(PositionIndex));
+          out.write((char*)&slen, sizeof(PositionIndex));
+          out.write((char*)&i, sizeof(PositionIndex));
+          out.write((char*)&numerators[prev_i][slen][i].second, sizeof(float));
+          float denom = getDenominator(prev_i, slen, found);
+          out.write((char*)&denom, sizeof(float));
         }
       }
     }
-    return THOT_OK;
   }
+  return THOT_OK;
 }
 
 bool HmmAlignmentTable::printPlainText(const char* aligNumDenFile)
@@ -2,6 +2,7 @@
 
 #include "nlp_common/PositionIndex.h"
 
+#include <iostream>
 #include <vector>
 
 class HmmAlignmentTable
@@ -21,6 +22,9 @@ public:
 
   bool print(const char* lexNumDenFile);
 
+  bool load(std::istream& in);
+  bool print(std::ostream& out);
+
   void clear();
 
 protected:
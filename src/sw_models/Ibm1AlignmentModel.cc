@@ -7,6 +7,9 @@
 #include "sw_models/SwDefs.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <omp.h>
+#include <sstream>
 
 using namespace std;
 
@@ -25,81 +28,178 @@ Ibm1AlignmentModel::Ibm1AlignmentModel(Ibm1AlignmentModel& model)
 
 unsigned int Ibm1AlignmentModel::startTraining(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.startTraining, "start_training");
   clearTempVars();
-  /// BW: insertBuffer[s] contains target words that occur in a target sentence paired with a source sentence containing s
-  vector<vector<WordIndex>> insertBuffer;   
-  size_t insertBufferItems = 0;
+  const EncodedCorpus& corpus = getEncodedCorpus();
+  int numPairs = (int)corpus.numSentencePairs();
+
   unsigned int count = 0;
-  for (unsigned int n = 0; n < numSentencePairs(); ++n)
+  if (hasTrainingHooks())
   {
-    vector<WordIndex> src = getSrcSent(n);
-    vector<WordIndex> trg = getTrgSent(n);
+    vector<WordIndex> src, trg;
+    for (int n = 0; n < numPairs; ++n)
+    {
+      corpus.getSrcSent(n, src);
+      corpus.getTrgSent(n, trg);
+      if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
+        initSentencePairHooks(src, trg);
+    }
+  }
+#pragma omp parallel for reduction(+ : count)
+  for (int n = 0; n < numPairs; ++n)
+  {
+    PositionIndex slen = corpus.getSrcLength(n);
+    PositionIndex tlen = corpus.getTrgLength(n);
+    if (slen > 0 && slen <= getMaxSentenceLength() && tlen > 0 && tlen <= getMaxSentenceLength())
+      ++count;
+  }
+
+  addCorpusTranslationOptions(corpus);
+  trainSentenceLengthModel(corpus);
+  return count;
+}
+
+bool Ibm1AlignmentModel::hasTrainingHooks()
+{
+  return false;
+}
 
-    if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
+void Ibm1AlignmentModel::initSentencePairHooks(const vector<WordIndex>& src, const vector<WordIndex>& trg)
+{
+  initSentencePair(src, trg);
+
+  vector<WordIndex> nsrc = extendWithNullWord(src);
+  PositionIndex slen = (PositionIndex)src.size();
+  PositionIndex tlen = (PositionIndex)trg.size();
+  for (PositionIndex i = 0; i <= slen; ++i)
+  {
+    initSourceWord(nsrc, trg, i);
+    for (PositionIndex j = 1; j <= tlen; ++j)
     {
-      initSentencePair(src, trg);
+      if (i == 0)
+        initTargetWord(nsrc, trg, j);
+      initWordPair(nsrc, trg, i, j);
+    }
+  }
+}
 
-      vector<WordIndex> nsrc = extendWithNullWord(src);
-      PositionIndex slen = (PositionIndex)src.size();
-      PositionIndex tlen = (PositionIndex)trg.size();
+void Ibm1AlignmentModel::addCorpusTranslationOptions(const EncodedCorpus& corpus)
+{
+  // Every thread keeps the (s, t) pairs of its sentence pairs in one bucket per partition of the
+  // source words. Each partition is then sorted and deduplicated by a different thread, which
+  // leaves the target words of insertBuffer[s] sorted and without repetitions
+  int numThreads = omp_get_max_threads();
+  vector<vector<vector<uint64_t>>> buckets(numThreads, vector<vector<uint64_t>>(numThreads));
+  vector<vector<WordIndex>> insertBuffer;
+  size_t maxChunkItems = ThreadBufferSize * 100 * numThreads;
+  unsigned int numPairs = corpus.numSentencePairs();
+  unsigned int begin = 0;
+  while (begin < numPairs)
+  {
+    unsigned int end = begin;
+    size_t chunkItems = 0;
+    while (end < numPairs && chunkItems < maxChunkItems)
+    {
+      chunkItems += ((size_t)corpus.getSrcLength(end) + 1) * corpus.getTrgLength(end);
+      ++end;
+    }
 
-      for (PositionIndex i = 0; i <= slen; ++i)
+    WordIndex maxSrcWordIndex = 0;
+#pragma omp parallel num_threads(numThreads) reduction(max : maxSrcWordIndex)
+    {
+      vector<vector<uint64_t>>& threadBuckets = buckets[omp_get_thread_num()];
+      vector<WordIndex> src, trg;
+#pragma omp for schedule(dynamic)
+      for (int n = (int)begin; n < (int)end; ++n)
       {
-        initSourceWord(nsrc, trg, i);
-        WordIndex s = nsrc[i];
-        if (s >= insertBuffer.size())
-          insertBuffer.resize((size_t)s + 1);
-        for (PositionIndex j = 1; j <= tlen; ++j)
+        corpus.getSrcSent(n, src);
+        corpus.getTrgSent(n, trg);
+        if (!sentenceLengthIsOk(src) || !sentenceLengthIsOk(trg))
+          continue;
+
+        for (WordIndex s : extendWithNullWord(src))
         {
-          if (i == 0)
-            initTargetWord(nsrc, trg, j);
-          initWordPair(nsrc, trg, i, j);
-          insertBuffer[s].push_back(trg[j - 1]);
+          maxSrcWordIndex = max(maxSrcWordIndex, s);
+          vector<uint64_t>& bucket = threadBuckets[s % numThreads];
+          for (WordIndex t : trg)
+            bucket.push_back(((uint64_t)s << 32) | t);
         }
-        insertBufferItems += trg.size();
       }
-      if (insertBufferItems > ThreadBufferSize * 100)
+    }
+    if (maxSrcWordIndex >= insertBuffer.size())
+      insertBuffer.resize((size_t)maxSrcWordIndex + 1);
+
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (int p = 0; p < numThreads; ++p)
+    {
+      vector<uint64_t>& partition = buckets[0][p];
+      for (int thread = 1; thread < numThreads; ++thread)
       {
-        insertBufferItems = 0;
-        addTranslationOptions(insertBuffer);
+        partition.insert(partition.end(), buckets[thread][p].begin(), buckets[thread][p].end());
+        buckets[thread][p].clear();
       }
-      ++count;
+      sort(partition.begin(), partition.end());
+      partition.erase(unique(partition.begin(), partition.end()), partition.end());
+      for (uint64_t pair : partition)
+        insertBuffer[pair >> 32].push_back((WordIndex)(pair & 0xffffffff));
+      partition.clear();
     }
-  }
-  if (insertBufferItems > 0)
+
     addTranslationOptions(insertBuffer);
+    begin = end;
+  }
+}
 
-  if (numSentencePairs() > 0)
+void Ibm1AlignmentModel::trainSentenceLengthModel(const EncodedCorpus& corpus)
+{
+  for (unsigned int n = 0; n < corpus.numSentencePairs(); ++n)
   {
-    // Train sentence length model
-    sentLengthModel->trainSentencePairRange(make_pair(0, numSentencePairs() - 1), verbosity);
+    PositionIndex slen = corpus.getSrcLength(n);
+    PositionIndex tlen = corpus.getTrgLength(n);
+    if (slen > 0 && tlen > 0)
+      sentLengthModel->trainSentencePair(slen, tlen, corpus.getCount(n));
   }
-  return count;
 }
 
 void Ibm1AlignmentModel::train(int verbosity)
+{
+  TrainingEvent event(*this, trainingMetrics.iteration, "iteration");
+  updateCountsInBuffers([this](const vector<pair<vector<WordIndex>, vector<WordIndex>>>& buffer, unsigned int) {
+    batchUpdateCounts(buffer);
+  });
+
+  TrainingPhaseTimer mStepTimer(trainingMetrics.mStep);
+  batchMaximizeProbs();
+}
+
+void Ibm1AlignmentModel::updateCountsInBuffers(
+    const function<void(const vector<pair<vector<WordIndex>, vector<WordIndex>>>&, unsigned int)>& updateCounts)
 {
   vector<pair<vector<WordIndex>, vector<WordIndex>>> buffer;
-  for (unsigned int n = 0; n < numSentencePairs(); ++n)
+  unsigned int numPairs = numSentencePairs();
+  unsigned int n = 0;
+  while (n < numPairs)
   {
-    vector<WordIndex> src = getSrcSent(n);
-    vector<WordIndex> trg = getTrgSent(n);
-    if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
-      buffer.push_back(make_pair(src, trg));
+    TrainingPhaseTimer ioTimer(trainingMetrics.io);
+    for (; n < numPairs && buffer.size() < ThreadBufferSize; ++n)
+    {
+      vector<WordIndex> src = getSrcSent(n);
+      vector<WordIndex> trg = getTrgSent(n);
+      if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
+      {
+        trainingMetrics.numTokens += src.size() + trg.size();
+        buffer.push_back(make_pair(src, trg));
+      }
+    }
+    ioTimer.stop();
 
-    if (buffer.size() >= ThreadBufferSize)
+    if (buffer.size() > 0)
     {
-      batchUpdateCounts(buffer);
+      TrainingPhaseTimer eStepTimer(trainingMetrics.eStep);
+      updateCounts(buffer, buffer.size() >= ThreadBufferSize ? n - 1 : numPairs);
       buffer.clear();
     }
   }
-  if (buffer.size() > 0)
-  {
-    batchUpdateCounts(buffer);
-    buffer.clear();
-  }
-
-  batchMaximizeProbs();
 }
 
 void Ibm1AlignmentModel::endTraining()
@@ -217,28 +317,6 @@ void Ibm1AlignmentModel::batchMaximizeProbs()
   }
 }
 
-pair<double, double> Ibm1AlignmentModel::loglikelihoodForPairRange(pair<unsigned int, unsigned int> sentPairRange,
-                                                                   int verbosity)
-{
-  double loglikelihood = 0;
-  unsigned int numSents = 0;
-
-  for (unsigned int n = sentPairRange.first; n <= sentPairRange.second; ++n)
-  {
-    if (verbosity)
-      cerr << "* Calculating log-likelihood for sentence " << n << std::endl;
-    // Add log-likelihood
-    vector<WordIndex> nthSrcSent = getSrcSent(n);
-    vector<WordIndex> nthTrgSent = getTrgSent(n);
-    if (sentenceLengthIsOk(nthSrcSent) && sentenceLengthIsOk(nthTrgSent))
-    {
-      loglikelihood += (double)computeSumLogProb(nthSrcSent, nthTrgSent, verbosity);
-      ++numSents;
-    }
-  }
-  return make_pair(loglikelihood, loglikelihood / (double)numSents);
-}
-
 vector<WordIndex> Ibm1AlignmentModel::getSrcSent(unsigned int n)
 {
   vector<string> srcsStr;
@@ -398,6 +476,34 @@ LgProb Ibm1AlignmentModel::getBestAlignment(const vector<WordIndex>& srcSentence
   }
 }
 
+void Ibm1AlignmentModel::getAlignmentPosteriors(const vector<WordIndex>& srcSentence,
+                                                const vector<WordIndex>& trgSentence, float* posteriors)
+{
+  size_t slen = srcSentence.size();
+  size_t tlen = trgSentence.size();
+  fill(posteriors, posteriors + slen * tlen, 0.0f);
+  if (!sentenceLengthIsOk(srcSentence) || !sentenceLengthIsOk(trgSentence))
+    return;
+
+  // The alignment positions of each target word are independent, so the posteriors are the
+  // normalized E-step counts
+  vector<WordIndex> nsrc = addNullWordToWidxVec(srcSentence);
+  vector<double> probs(nsrc.size());
+  for (PositionIndex j = 1; j <= tlen; ++j)
+  {
+    double sum = 0;
+    for (PositionIndex i = 0; i < nsrc.size(); ++i)
+    {
+      probs[i] = getCountNumerator(nsrc, trgSentence, i, j);
+      sum += probs[i];
+    }
+    if (sum == 0)
+      continue;
+    for (PositionIndex i = 1; i < nsrc.size(); ++i)
+      posteriors[(i - 1) * tlen + j - 1] = (float)(probs[i] / sum);
+  }
+}
+
 LgProb Ibm1AlignmentModel::computeLogProb(const vector<WordIndex>& srcSentence, const vector<WordIndex>& trgSentence,
                                           const WordAlignmentMatrix& aligMatrix, int verbose)
 {
@@ -520,61 +626,111 @@ LgProb Ibm1AlignmentModel::computeIbm1SumLogProb(const vector<WordIndex>& nsSent
   return lgProb;
 }
 
-bool Ibm1AlignmentModel::load(const char* prefFileName, int verbose)
+void Ibm1AlignmentModel::addLoadTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  if (prefFileName[0] != 0)
-  {
-    bool retVal;
+  AlignmentModelBase::addLoadTasks(prefFileName, verbose, tasks);
 
-    retVal = AlignmentModelBase::load(prefFileName, verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
-
-    if (verbose)
-      cerr << "Loading incremental IBM 1 Model data..." << endl;
+  if (verbose)
+    cerr << "Loading incremental IBM 1 Model data..." << endl;
 
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
     // Load file with lexical nd values
-    string lexNumDenFile = prefFileName;
-    lexNumDenFile = lexNumDenFile + lexNumDenFileExtension;
-    retVal = lexTable->load(lexNumDenFile.c_str(), verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
+    string lexNumDenFile = prefFileName + lexNumDenFileExtension;
+    return lexTable->load(lexNumDenFile.c_str(), verbose);
+  });
 
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
     // Load average sentence lengths
-    string slmodelFile = prefFileName;
-    slmodelFile = slmodelFile + ".slmodel";
-    retVal = sentLengthModel->load(slmodelFile.c_str(), verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
+    string slmodelFile = prefFileName + ".slmodel";
+    return sentLengthModel->load(slmodelFile.c_str(), verbose);
+  });
+}
 
-    return THOT_OK;
-  }
-  else
+void Ibm1AlignmentModel::addPrintTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
+{
+  AlignmentModelBase::addPrintTasks(prefFileName, verbose, tasks);
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with lexical nd values
+    string lexNumDenFile = prefFileName + lexNumDenFileExtension;
+    return lexTable->print(lexNumDenFile.c_str());
+  });
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with sentence length model
+    string slmodelFile = prefFileName + ".slmodel";
+    return sentLengthModel->print(slmodelFile.c_str());
+  });
+}
+
+bool Ibm1AlignmentModel::loadSections(const ModelContainer& container, int verbose)
+{
+  bool retVal = AlignmentModelBase::loadSections(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  size_t size;
+  if (container.getSection(lexNumDenFileExtension, data, size) == THOT_ERROR)
     return THOT_ERROR;
+  MemoryInputStream lexNumDenIn(data, size);
+  retVal = lexTable->load(lexNumDenIn);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  if (container.getSection(".slmodel", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream slmodelIn(data, size);
+  return sentLengthModel->load(slmodelIn, verbose);
 }
 
-bool Ibm1AlignmentModel::print(const char* prefFileName, int verbose)
+bool Ibm1AlignmentModel::printSections(ModelContainer& container)
 {
-  bool retVal;
+  bool retVal = AlignmentModelBase::printSections(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
 
-  retVal = AlignmentModelBase::print(prefFileName);
+  ostringstream lexNumDenOut;
+  retVal = lexTable->print(lexNumDenOut);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  container.addSection(lexNumDenFileExtension, lexNumDenOut.str());
 
-  // Print file with lexical nd values
-  string lexNumDenFile = prefFileName;
-  lexNumDenFile = lexNumDenFile + lexNumDenFileExtension;
-  retVal = lexTable->print(lexNumDenFile.c_str());
+  ostringstream slmodelOut;
+  sentLengthModel->print(slmodelOut);
+  container.addSection(".slmodel", slmodelOut.str());
+
+  return THOT_OK;
+}
+
+bool Ibm1AlignmentModel::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  bool retVal = AlignmentModelBase::loadTrainingState(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  size_t size;
+  if (container.getSection(".lex_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream lexCountsIn(data, size);
+  retVal = loadLexCounts(lexCountsIn, getSrcVocabSize(), getTrgVocabSize(), lexCounts);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  if (!lexCounts.empty())
+    lexTable->reserveSpace((WordIndex)lexCounts.size() - 1);
+  return THOT_OK;
+}
 
-  // Print file with sentence length model
-  string slmodelFile = prefFileName;
-  slmodelFile = slmodelFile + ".slmodel";
-  retVal = sentLengthModel->print(slmodelFile.c_str());
+bool Ibm1AlignmentModel::printTrainingState(ModelContainer& container)
+{
+  bool retVal = AlignmentModelBase::printTrainingState(container);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
+  ostringstream lexCountsOut;
+  printLexCounts(lexCountsOut, lexCounts);
+  container.addSection(".lex_counts", lexCountsOut.str());
   return THOT_OK;
 }
 
@@ -584,6 +740,14 @@ void Ibm1AlignmentModel::clear()
   lexTable->clear();
 }
 
+size_t Ibm1AlignmentModel::getNumLexCounts() const
+{
+  size_t numLexCounts = 0;
+  for (const LexCountsElem& elem : lexCounts)
+    numLexCounts += elem.size();
+  return numLexCounts;
+}
+
 void Ibm1AlignmentModel::clearTempVars()
 {
   lexCounts.clear();
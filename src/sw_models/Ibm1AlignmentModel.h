@@ -27,12 +27,6 @@ public:
   void train(int verbosity = 0) override;
   void endTraining() override;
 
-  // Returns log-likelihood. The first double contains the
-  // loglikelihood for all sentences, and the second one, the same
-  // loglikelihood normalized by the number of sentences
-  std::pair<double, double> loglikelihoodForPairRange(std::pair<unsigned int, unsigned int> sentPairRange,
-                                                      int verbosity = 0) override;
-
   // returns p(t|s)
   Prob translationProb(WordIndex s, WordIndex t) override;
   // returns log(p(t|s))
@@ -51,6 +45,9 @@ public:
   using AlignmentModel::getBestAlignment;
   LgProb getBestAlignment(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                           std::vector<PositionIndex>& bestAlignment) override;
+  using AlignmentModel::getAlignmentPosteriors;
+  void getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
+                              float* posteriors) override;
   using AlignmentModel::computeLogProb;
   LgProb computeLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                         const WordAlignmentMatrix& aligMatrix, int verbose = 0) override;
@@ -58,9 +55,6 @@ public:
   LgProb computeSumLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                            int verbose = 0) override;
 
-  bool load(const char* prefFileName, int verbose = 0) override;
-  bool print(const char* prefFileName, int verbose = 0) override;
-
   void clear() override;
   void clearTempVars() override;
   void clearSentenceLengthModel() override;
@@ -93,6 +87,12 @@ protected:
                                int verbose = 0);
 
   // Batch EM functions
+
+  // startTraining() calls the init functions for every sentence pair only if hasTrainingHooks()
+  // returns true, so models that override any of them must also override hasTrainingHooks().
+  // They are called serially and in corpus order
+  virtual bool hasTrainingHooks();
+  void initSentencePairHooks(const std::vector<WordIndex>& src, const std::vector<WordIndex>& trg);
   virtual void initSentencePair(const std::vector<WordIndex>& src, const std::vector<WordIndex>& trg);
   virtual void initSourceWord(const std::vector<WordIndex>& nsrc, const std::vector<WordIndex>& trg, PositionIndex i);
   virtual void initTargetWord(const std::vector<WordIndex>& nsrc, const std::vector<WordIndex>& trg, PositionIndex j);
@@ -104,6 +104,17 @@ protected:
   ///                       Specifically, insertBuffer[s] contains words that occur in some target sentence
   ///                       which is paired with a source sentence containing s
   virtual void addTranslationOptions(std::vector<std::vector<WordIndex>>& insertBuffer);
+  // Builds the translation options of every sentence pair of the corpus in parallel, and adds
+  // them with addTranslationOptions()
+  void addCorpusTranslationOptions(const EncodedCorpus& corpus);
+  void trainSentenceLengthModel(const EncodedCorpus& corpus);
+  // Reads the training sentence pairs that have a valid length in buffers of ThreadBufferSize
+  // pairs and passes every buffer to updateCounts, together with the index of the pair that
+  // filled it, or numSentencePairs() for the last buffer. Reads are timed as I/O and the
+  // updates as the E-step
+  void updateCountsInBuffers(
+      const std::function<void(const std::vector<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>>&,
+                               unsigned int)>& updateCounts);
   virtual void batchUpdateCounts(const std::vector<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>>& pairs);
   virtual double getCountNumerator(const std::vector<WordIndex>& nsrc, const std::vector<WordIndex>& trg,
                                    PositionIndex i, PositionIndex j);
@@ -111,6 +122,14 @@ protected:
                                        PositionIndex i, PositionIndex j, double count);
   virtual void batchMaximizeProbs();
 
+  void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  bool loadSections(const ModelContainer& container, int verbose = 0) override;
+  bool printSections(ModelContainer& container) override;
+  bool loadTrainingState(const ModelContainer& container, int verbose = 0) override;
+  bool printTrainingState(ModelContainer& container) override;
+  std::size_t getNumLexCounts() const override;
+
   std::string lexNumDenFileExtension = ".ibm_lexnd";
 
   // model parameters
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <map>
 #include <random>
+#include <sstream>
 #include <vector>
 
 using namespace std;
@@ -40,27 +41,12 @@ void Ibm1Eflomal::batchUpdateCounts(const vector<pair<vector<WordIndex>, vector<
 
 void Ibm1Eflomal::train(int verbosity)
 {
-  vector<pair<vector<WordIndex>, vector<WordIndex>>> buffer;
-  unsigned int n = 0;
-  for (; n < numSentencePairs(); ++n)
-  {
-    vector<WordIndex> src = getSrcSent(n);
-    vector<WordIndex> trg = getTrgSent(n);
-    if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
-      buffer.push_back(make_pair(src, trg));
-
-    if (buffer.size() >= ThreadBufferSize)
-    {
-      batchUpdateCountsEflomal(buffer, n / ThreadBufferSize);
-      buffer.clear();
-    }
-  }
-  if (buffer.size() > 0)
-  {
+  TrainingEvent event(*this, trainingMetrics.iteration, "iteration");
+  updateCountsInBuffers([this](const vector<pair<vector<WordIndex>, vector<WordIndex>>>& buffer, unsigned int n) {
     batchUpdateCountsEflomal(buffer, n / ThreadBufferSize);
-    buffer.clear();
-  }
+  });
 
+  TrainingPhaseTimer mStepTimer(trainingMetrics.mStep);
   batchMaximizeProbs();
 }
 
@@ -257,6 +243,11 @@ void Ibm1Eflomal::clearTempVars()
   links.clear();
 }
 
+bool Ibm1Eflomal::hasTrainingHooks()
+{
+  return true;
+}
+
 void Ibm1Eflomal::initSentencePair(const vector<WordIndex>& src, const vector<WordIndex>& trg)
 {
   vector<PositionIndex> newLink;
@@ -312,3 +303,133 @@ size_t Ibm1Eflomal::random_categorical_from_cumulative(vector<float> ps)
   }
   return ps.size() - 1;
 }
+
+bool Ibm1Eflomal::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm1AlignmentModel::loadTrainingState(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  size_t size;
+  if (container.getSection(".links", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream linksIn(data, size);
+  unsigned int numLinks;
+  // Every sentence pair stores at least the number of its links
+  if (!linksIn.read((char*)&numLinks, sizeof(unsigned int)) || numLinks != numSentencePairs()
+      || !linksIn.canRead(numLinks, sizeof(unsigned int)))
+    return THOT_ERROR;
+  links.resize(numLinks);
+  const EncodedCorpus& corpus = getEncodedCorpus();
+  for (unsigned int n = 0; n < numLinks; ++n)
+  {
+    // Training indexes the sentence pair with the links, which hold a source position
+    // for every target word
+    vector<PositionIndex>& link = links[n];
+    unsigned int tlen;
+    if (!linksIn.read((char*)&tlen, sizeof(unsigned int)) || tlen != corpus.getTrgLength(n)
+        || !linksIn.canRead(tlen, sizeof(PositionIndex)))
+      return THOT_ERROR;
+    link.resize(tlen);
+    if (!linksIn.read((char*)link.data(), tlen * sizeof(PositionIndex)))
+      return THOT_ERROR;
+    for (PositionIndex i : link)
+    {
+      if (i != NULL_LINK && i > corpus.getSrcLength(n))
+        return THOT_ERROR;
+    }
+  }
+
+  if (container.getSection(".eflomal_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream countsIn(data, size);
+  unsigned int numCounts;
+  if (!countsIn.read((char*)&numCounts, sizeof(unsigned int)))
+    return THOT_ERROR;
+  counts.clear();
+  for (unsigned int k = 0; k < numCounts; ++k)
+  {
+    pair<WordIndex, WordIndex> wordPair;
+    int count;
+    countsIn.read((char*)&wordPair.first, sizeof(WordIndex));
+    countsIn.read((char*)&wordPair.second, sizeof(WordIndex));
+    if (!countsIn.read((char*)&count, sizeof(int)) || wordPair.first >= getTrgVocabSize()
+        || wordPair.second >= getSrcVocabSize())
+      return THOT_ERROR;
+    counts[wordPair] = count;
+  }
+
+  if (container.getSection(".dirichlet", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream dirichletIn(data, size);
+  unsigned int numTrgWords;
+  if (!dirichletIn.read((char*)&numTrgWords, sizeof(unsigned int)) || numTrgWords > getTrgVocabSize()
+      || !dirichletIn.canRead(numTrgWords, sizeof(unsigned int)))
+    return THOT_ERROR;
+  dirichlet.clear();
+  dirichlet.resize(numTrgWords);
+  for (map<WordIndex, float>& elem : dirichlet)
+  {
+    unsigned int numEntries;
+    if (!dirichletIn.read((char*)&numEntries, sizeof(unsigned int)))
+      return THOT_ERROR;
+    for (unsigned int e = 0; e < numEntries; ++e)
+    {
+      WordIndex s;
+      float value;
+      dirichletIn.read((char*)&s, sizeof(WordIndex));
+      if (!dirichletIn.read((char*)&value, sizeof(float)) || s >= getSrcVocabSize())
+        return THOT_ERROR;
+      elem[s] = value;
+    }
+  }
+  return THOT_OK;
+}
+
+bool Ibm1Eflomal::printTrainingState(ModelContainer& container)
+{
+  bool retVal = Ibm1AlignmentModel::printTrainingState(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  // The sampled links of every sentence pair are part of the state of the sampler
+  ostringstream linksOut;
+  unsigned int numLinks = (unsigned int)links.size();
+  linksOut.write((char*)&numLinks, sizeof(unsigned int));
+  for (const vector<PositionIndex>& link : links)
+  {
+    unsigned int tlen = (unsigned int)link.size();
+    linksOut.write((char*)&tlen, sizeof(unsigned int));
+    linksOut.write((char*)link.data(), tlen * sizeof(PositionIndex));
+  }
+  container.addSection(".links", linksOut.str());
+
+  ostringstream countsOut;
+  unsigned int numCounts = (unsigned int)counts.size();
+  countsOut.write((char*)&numCounts, sizeof(unsigned int));
+  for (const pair<const pair<WordIndex, WordIndex>, int>& entry : counts)
+  {
+    countsOut.write((char*)&entry.first.first, sizeof(WordIndex));
+    countsOut.write((char*)&entry.first.second, sizeof(WordIndex));
+    countsOut.write((char*)&entry.second, sizeof(int));
+  }
+  container.addSection(".eflomal_counts", countsOut.str());
+
+  ostringstream dirichletOut;
+  unsigned int numTrgWords = (unsigned int)dirichlet.size();
+  dirichletOut.write((char*)&numTrgWords, sizeof(unsigned int));
+  for (const map<WordIndex, float>& elem : dirichlet)
+  {
+    unsigned int numEntries = (unsigned int)elem.size();
+    dirichletOut.write((char*)&numEntries, sizeof(unsigned int));
+    for (const pair<const WordIndex, float>& entry : elem)
+    {
+      dirichletOut.write((char*)&entry.first, sizeof(WordIndex));
+      dirichletOut.write((char*)&entry.second, sizeof(float));
+    }
+  }
+  container.addSection(".dirichlet", dirichletOut.str());
+
+  return THOT_OK;
+}
@@ -27,6 +27,11 @@ public:
   Ibm1Eflomal();
 
 protected:
+  std::string getModelTypeStr() const override
+  {
+    return "eflomal";
+  }
+
   virtual void batchUpdateCounts(const vector<pair<vector<WordIndex>, vector<WordIndex>>>& pairs) override;
 
   using Ibm1AlignmentModel::addTranslationOptions;
@@ -44,11 +49,15 @@ protected:
   using Ibm1AlignmentModel::clearTempVars;
   virtual void clearTempVars() override;
 
+  virtual bool hasTrainingHooks() override;
   using Ibm1AlignmentModel::initSentencePair;
   virtual void initSentencePair(const std::vector<WordIndex>& src, const std::vector<WordIndex>& trg) override;
 
   virtual size_t random_categorical_from_cumulative(vector<float> ps);
 
+  bool loadTrainingState(const ModelContainer& container, int verbose = 0) override;
+  bool printTrainingState(ModelContainer& container) override;
+
   /*
    * There is one links array per src-tgt sentence pair
    *
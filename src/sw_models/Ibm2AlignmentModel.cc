@@ -4,6 +4,8 @@
 #include "nlp_common/ErrorDefs.h"
 #include "sw_models/SwDefs.h"
 
+#include <sstream>
+
 using namespace std;
 
 Ibm2AlignmentModel::Ibm2AlignmentModel() : alignmentTable{make_shared<AlignmentTable>()}
@@ -31,6 +33,11 @@ void Ibm2AlignmentModel::setCompactAlignmentTable(bool value)
   compactAlignmentTable = value;
 }
 
+bool Ibm2AlignmentModel::hasTrainingHooks()
+{
+  return true;
+}
+
 void Ibm2AlignmentModel::initTargetWord(const vector<WordIndex>& nsrc, const vector<WordIndex>& trg, PositionIndex j)
 {
   Ibm1AlignmentModel::initTargetWord(nsrc, trg, j);
@@ -271,49 +278,116 @@ LgProb Ibm2AlignmentModel::getIbm2SumLogProb(const vector<WordIndex>& nsSent, co
   return lgProb;
 }
 
-bool Ibm2AlignmentModel::load(const char* prefFileName, int verbose)
+void Ibm2AlignmentModel::addLoadTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  if (prefFileName[0] != 0)
-  {
-    bool retVal;
+  // Load IBM 1 Model data
+  Ibm1AlignmentModel::addLoadTasks(prefFileName, verbose, tasks);
 
-    // Load IBM 1 Model data
-    retVal = Ibm1AlignmentModel::load(prefFileName, verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
-
-    if (verbose)
-      cerr << "Loading incremental IBM 2 Model data..." << endl;
+  if (verbose)
+    cerr << "Loading incremental IBM 2 Model data..." << endl;
 
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
     // Load file with alignment nd values
-    string aligNumDenFile = prefFileName;
-    aligNumDenFile = aligNumDenFile + ".ibm2_alignd";
-    retVal = alignmentTable->load(aligNumDenFile.c_str(), verbose);
-    if (retVal == THOT_ERROR)
-      return THOT_ERROR;
+    string aligNumDenFile = prefFileName + ".ibm2_alignd";
+    return alignmentTable->load(aligNumDenFile.c_str(), verbose);
+  });
+}
 
-    return THOT_OK;
-  }
-  else
+void Ibm2AlignmentModel::addPrintTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
+{
+  // Print IBM 1 Model data
+  Ibm1AlignmentModel::addPrintTasks(prefFileName, verbose, tasks);
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with alignment nd values
+    string aligNumDenFile = prefFileName + ".ibm2_alignd";
+    return alignmentTable->print(aligNumDenFile.c_str());
+  });
+}
+
+bool Ibm2AlignmentModel::loadSections(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm1AlignmentModel::loadSections(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  size_t size;
+  if (container.getSection(".ibm2_alignd", data, size) == THOT_ERROR)
     return THOT_ERROR;
+  MemoryInputStream aligNumDenIn(data, size);
+  return alignmentTable->load(aligNumDenIn);
 }
 
-bool Ibm2AlignmentModel::print(const char* prefFileName, int verbose)
+bool Ibm2AlignmentModel::printSections(ModelContainer& container)
 {
-  bool retVal;
+  bool retVal = Ibm1AlignmentModel::printSections(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
 
-  // Print IBM 1 Model data
-  retVal = Ibm1AlignmentModel::print(prefFileName);
+  ostringstream aligNumDenOut;
+  retVal = alignmentTable->print(aligNumDenOut);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  container.addSection(".ibm2_alignd", aligNumDenOut.str());
+
+  return THOT_OK;
+}
+
+bool Ibm2AlignmentModel::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm1AlignmentModel::loadTrainingState(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  size_t size;
+  if (container.getSection(".alignment_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream in(data, size);
+  unsigned int numKeys;
+  if (!in.read((char*)&numKeys, sizeof(unsigned int)))
+    return THOT_ERROR;
+  for (unsigned int k = 0; k < numKeys; ++k)
+  {
+    AlignmentKey key;
+    unsigned int elemSize;
+    in.read((char*)&key.j, sizeof(PositionIndex));
+    in.read((char*)&key.slen, sizeof(PositionIndex));
+    in.read((char*)&key.tlen, sizeof(PositionIndex));
+    in.read((char*)&elemSize, sizeof(unsigned int));
+    // Training allocates one count for every source position and the null word
+    if (!in || key.j == 0 || key.j > getMaxSentenceLength() || key.slen > getMaxSentenceLength()
+        || key.tlen > getMaxSentenceLength() || elemSize != key.slen + 1 || !in.canRead(elemSize, sizeof(double)))
+      return THOT_ERROR;
+    AlignmentCountsElem elem(elemSize);
+    if (!in.read((char*)elem.data(), elemSize * sizeof(double)))
+      return THOT_ERROR;
+    alignmentTable->reserveSpace(key.j, key.slen, key.tlen);
+    alignmentCounts[key] = elem;
+  }
+  return THOT_OK;
+}
 
-  // Print file with alignment nd values
-  string aligNumDenFile = prefFileName;
-  aligNumDenFile = aligNumDenFile + ".ibm2_alignd";
-  retVal = alignmentTable->print(aligNumDenFile.c_str());
+bool Ibm2AlignmentModel::printTrainingState(ModelContainer& container)
+{
+  bool retVal = Ibm1AlignmentModel::printTrainingState(container);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
+  ostringstream out;
+  unsigned int numKeys = (unsigned int)alignmentCounts.size();
+  out.write((char*)&numKeys, sizeof(unsigned int));
+  for (const pair<AlignmentKey, AlignmentCountsElem>& p : alignmentCounts)
+  {
+    unsigned int elemSize = (unsigned int)p.second.size();
+    out.write((char*)&p.first.j, sizeof(PositionIndex));
+    out.write((char*)&p.first.slen, sizeof(PositionIndex));
+    out.write((char*)&p.first.tlen, sizeof(PositionIndex));
+    out.write((char*)&elemSize, sizeof(unsigned int));
+    out.write((char*)p.second.data(), elemSize * sizeof(double));
+  }
+  container.addSection(".alignment_counts", out.str());
   return THOT_OK;
 }
 
@@ -38,9 +38,6 @@ public:
   LgProb computeSumLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                            int verbose = 0) override;
 
-  bool load(const char* prefFileName, int verbose = 0) override;
-  bool print(const char* prefFileName, int verbose = 0) override;
-
   void clear() override;
   void clearTempVars() override;
 
@@ -65,6 +62,7 @@ protected:
                             const std::vector<PositionIndex>& alig, int verbose = 0);
   LgProb getIbm2SumLogProb(const std::vector<WordIndex>& nsSent, const std::vector<WordIndex>& tSent, int verbose = 0);
 
+  bool hasTrainingHooks() override;
   void initTargetWord(const std::vector<WordIndex>& nsrc, const std::vector<WordIndex>& trg, PositionIndex j) override;
   double getCountNumerator(const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
                            unsigned int i, unsigned int j) override;
@@ -76,6 +74,12 @@ protected:
   void loadConfig(const YAML::Node& config) override;
   bool loadOldConfig(const char* prefFileName, int verbose = 0) override;
   void createConfig(YAML::Emitter& out) override;
+  void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  bool loadSections(const ModelContainer& container, int verbose = 0) override;
+  bool printSections(ModelContainer& container) override;
+  bool loadTrainingState(const ModelContainer& container, int verbose = 0) override;
+  bool printTrainingState(ModelContainer& container) override;
 
   bool compactAlignmentTable = true;
 
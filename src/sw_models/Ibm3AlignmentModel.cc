@@ -3,6 +3,8 @@
 #include "nlp_common/MathFuncs.h"
 #include "sw_models/SwDefs.h"
 
+#include <sstream>
+
 Ibm3AlignmentModel::Ibm3AlignmentModel()
     : p1{std::make_shared<Prob>(DefaultP1)}, distortionTable{std::make_shared<DistortionTable>()},
       fertilityTable{std::make_shared<FertilityTable>()}
@@ -56,11 +58,10 @@ void Ibm3AlignmentModel::setFertilitySmoothFactor(double factor)
 
 unsigned int Ibm3AlignmentModel::startTraining(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.startTraining, "start_training");
   unsigned int count = Ibm2AlignmentModel::startTraining(verbosity);
 
-  maxSrcWordLen = 0;
-  for (WordIndex s = 3; s < getSrcVocabSize(); ++s)
-    maxSrcWordLen = std::max(maxSrcWordLen, wordIndexToSrcString(s).length());
+  computeMaxSrcWordLen();
 
   if (performIbm2Transfer)
   {
@@ -70,6 +71,13 @@ unsigned int Ibm3AlignmentModel::startTraining(int verbosity)
   return count;
 }
 
+void Ibm3AlignmentModel::computeMaxSrcWordLen()
+{
+  maxSrcWordLen = 0;
+  for (WordIndex s = 3; s < getSrcVocabSize(); ++s)
+    maxSrcWordLen = std::max(maxSrcWordLen, wordIndexToSrcString(s).length());
+}
+
 void Ibm3AlignmentModel::ibm2Transfer()
 {
   std::vector<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>> buffer;
@@ -187,6 +195,7 @@ void Ibm3AlignmentModel::ibm2TransferUpdateCounts(
 
 void Ibm3AlignmentModel::train(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.iteration, "iteration");
   if (hmmModel)
   {
     hmmTransfer();
@@ -214,26 +223,11 @@ void Ibm3AlignmentModel::hmmTransfer()
     return prob;
   };
 
-  std::vector<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>> buffer;
-  for (unsigned int n = 0; n < numSentencePairs(); ++n)
-  {
-    std::vector<WordIndex> src = getSrcSent(n);
-    std::vector<WordIndex> trg = getTrgSent(n);
-    if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
-      buffer.push_back(make_pair(src, trg));
-
-    if (buffer.size() >= ThreadBufferSize)
-    {
-      batchUpdateCounts(buffer, search);
-      buffer.clear();
-    }
-  }
-  if (buffer.size() > 0)
-  {
-    batchUpdateCounts(buffer, search);
-    buffer.clear();
-  }
+  updateCountsInBuffers(
+      [this, &search](const std::vector<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>>& buffer,
+                      unsigned int) { batchUpdateCounts(buffer, search); });
 
+  TrainingPhaseTimer mStepTimer(trainingMetrics.mStep);
   batchMaximizeProbs();
 }
 
@@ -720,6 +714,14 @@ LgProb Ibm3AlignmentModel::getBestAlignment(const std::vector<WordIndex>& srcSen
   }
 }
 
+void Ibm3AlignmentModel::getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence,
+                                                const std::vector<WordIndex>& trgSentence, float* posteriors)
+{
+  // Summing over the alignments of a fertility model is intractable, so the IBM-2 posteriors
+  // inherited from the base class would not describe this model; use the Viterbi alignment instead
+  AlignmentModelBase::getAlignmentPosteriors(srcSentence, trgSentence, posteriors);
+}
+
 LgProb Ibm3AlignmentModel::computeLogProb(const std::vector<WordIndex>& srcSentence,
                                           const std::vector<WordIndex>& trgSentence,
                                           const WordAlignmentMatrix& aligMatrix, int verbose)
@@ -851,33 +853,27 @@ LgProb Ibm3AlignmentModel::computeSumLogProb(const std::vector<WordIndex>& srcSe
   return lgProb;
 }
 
-bool Ibm3AlignmentModel::load(const char* prefFileName, int verbose)
+void Ibm3AlignmentModel::addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
 {
   // Load IBM 2 Model data
-  bool retVal = Ibm2AlignmentModel::load(prefFileName, verbose);
-  if (retVal == THOT_ERROR)
-    return retVal;
+  Ibm2AlignmentModel::addLoadTasks(prefFileName, verbose, tasks);
 
   if (verbose)
     std::cerr << "Loading IBM 3 Model data..." << std::endl;
 
-  std::string p1File = prefFileName;
-  p1File = p1File + ".p1";
-  retVal = loadP1(p1File);
-  if (retVal == THOT_ERROR)
-    return THOT_ERROR;
+  tasks.push_back([this, prefFileName]() -> bool { return loadP1(prefFileName + ".p1"); });
 
-  // Load file with distortion nd values
-  std::string distortionNumDenFile = prefFileName;
-  distortionNumDenFile = distortionNumDenFile + ".distnd";
-  retVal = distortionTable->load(distortionNumDenFile.c_str(), verbose);
-  if (retVal == THOT_ERROR)
-    return THOT_ERROR;
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load file with distortion nd values
+    std::string distortionNumDenFile = prefFileName + ".distnd";
+    return distortionTable->load(distortionNumDenFile.c_str(), verbose);
+  });
 
-  // Load file with fertility nd values
-  std::string fertilityNumDenFile = prefFileName;
-  fertilityNumDenFile = fertilityNumDenFile + ".fertnd";
-  return fertilityTable->load(fertilityNumDenFile.c_str(), verbose);
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load file with fertility nd values
+    std::string fertilityNumDenFile = prefFileName + ".fertnd";
+    return fertilityTable->load(fertilityNumDenFile.c_str(), verbose);
+  });
 }
 
 bool Ibm3AlignmentModel::loadP1(const std::string& filename)
@@ -885,35 +881,187 @@ bool Ibm3AlignmentModel::loadP1(const std::string& filename)
   std::ifstream in(filename);
   if (!in)
     return THOT_ERROR;
+  return loadP1(in);
+}
+
+bool Ibm3AlignmentModel::loadP1(std::istream& in)
+{
   in >> *p1;
 
   return THOT_OK;
 }
 
-bool Ibm3AlignmentModel::print(const char* prefFileName, int verbose)
+void Ibm3AlignmentModel::addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
 {
   // Print IBM 2 Model data
-  bool retVal = Ibm2AlignmentModel::print(prefFileName);
+  Ibm2AlignmentModel::addPrintTasks(prefFileName, verbose, tasks);
+
+  tasks.push_back([this, prefFileName]() -> bool { return printP1(prefFileName + ".p1"); });
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with distortion nd values
+    std::string distortionNumDenFile = prefFileName + ".distnd";
+    return distortionTable->print(distortionNumDenFile.c_str());
+  });
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with fertility nd values
+    std::string fertilityNumDenFile = prefFileName + ".fertnd";
+    return fertilityTable->print(fertilityNumDenFile.c_str());
+  });
+}
+
+bool Ibm3AlignmentModel::loadSections(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm2AlignmentModel::loadSections(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  std::size_t size;
+  if (container.getSection(".p1", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream p1In(data, size);
+  retVal = loadP1(p1In);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  if (container.getSection(".distnd", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream distortionNumDenIn(data, size);
+  retVal = distortionTable->load(distortionNumDenIn);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  std::string p1File = prefFileName;
-  p1File = p1File + ".p1";
-  retVal = printP1(p1File);
+  if (container.getSection(".fertnd", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream fertilityNumDenIn(data, size);
+  return fertilityTable->load(fertilityNumDenIn);
+}
+
+bool Ibm3AlignmentModel::printSections(ModelContainer& container)
+{
+  bool retVal = Ibm2AlignmentModel::printSections(container);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  // Print file with distortion nd values
-  std::string distortionNumDenFile = prefFileName;
-  distortionNumDenFile = distortionNumDenFile + ".distnd";
-  retVal = distortionTable->print(distortionNumDenFile.c_str());
+  std::ostringstream p1Out;
+  printP1(p1Out);
+  container.addSection(".p1", p1Out.str());
+
+  std::ostringstream distortionNumDenOut;
+  retVal = distortionTable->print(distortionNumDenOut);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+  container.addSection(".distnd", distortionNumDenOut.str());
+
+  std::ostringstream fertilityNumDenOut;
+  retVal = fertilityTable->print(fertilityNumDenOut);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  container.addSection(".fertnd", fertilityNumDenOut.str());
 
-  // Load file with fertility nd values
-  std::string fertilityNumDenFile = prefFileName;
-  fertilityNumDenFile = fertilityNumDenFile + ".fertnd";
-  return fertilityTable->print(fertilityNumDenFile.c_str());
+  return THOT_OK;
+}
+
+bool Ibm3AlignmentModel::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm2AlignmentModel::loadTrainingState(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  std::size_t size;
+  if (container.getSection(".distortion_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream distortionCountsIn(data, size);
+  unsigned int numKeys;
+  if (!distortionCountsIn.read((char*)&numKeys, sizeof(unsigned int)))
+    return THOT_ERROR;
+  for (unsigned int k = 0; k < numKeys; ++k)
+  {
+    DistortionKey key;
+    unsigned int elemSize;
+    distortionCountsIn.read((char*)&key.i, sizeof(PositionIndex));
+    distortionCountsIn.read((char*)&key.slen, sizeof(PositionIndex));
+    distortionCountsIn.read((char*)&key.tlen, sizeof(PositionIndex));
+    distortionCountsIn.read((char*)&elemSize, sizeof(unsigned int));
+    // Training allocates one count for every target position
+    if (!distortionCountsIn || key.i > getMaxSentenceLength() || key.slen > getMaxSentenceLength()
+        || key.tlen > getMaxSentenceLength() || elemSize != key.tlen
+        || !distortionCountsIn.canRead(elemSize, sizeof(double)))
+      return THOT_ERROR;
+    DistortionCountsElem elem(elemSize);
+    if (!distortionCountsIn.read((char*)elem.data(), elemSize * sizeof(double)))
+      return THOT_ERROR;
+    distortionTable->reserveSpace(key.i, key.slen, key.tlen);
+    distortionCounts[key] = elem;
+  }
+
+  if (container.getSection(".fertility_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream fertilityCountsIn(data, size);
+  unsigned int numSrcWords;
+  // Every source word stores at least the size of its counts
+  if (!fertilityCountsIn.read((char*)&numSrcWords, sizeof(unsigned int)) || numSrcWords > getSrcVocabSize()
+      || !fertilityCountsIn.canRead(numSrcWords, sizeof(unsigned int)))
+    return THOT_ERROR;
+  fertilityCounts.resize(numSrcWords);
+  for (FertilityCountsElem& elem : fertilityCounts)
+  {
+    unsigned int elemSize;
+    if (!fertilityCountsIn.read((char*)&elemSize, sizeof(unsigned int)) || elemSize != MaxFertility
+        || !fertilityCountsIn.canRead(elemSize, sizeof(double)))
+      return THOT_ERROR;
+    elem.resize(elemSize);
+    if (!fertilityCountsIn.read((char*)elem.data(), elemSize * sizeof(double)))
+      return THOT_ERROR;
+  }
+  if (numSrcWords > 0)
+    fertilityTable->reserveSpace(numSrcWords - 1);
+
+  computeMaxSrcWordLen();
+  performIbm2Transfer = false;
+  return THOT_OK;
+}
+
+bool Ibm3AlignmentModel::printTrainingState(ModelContainer& container)
+{
+  // The transfer from the HMM model is done by the first call to train(), and its
+  // state is not stored
+  if (hmmModel)
+    return THOT_ERROR;
+
+  bool retVal = Ibm2AlignmentModel::printTrainingState(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  std::ostringstream distortionCountsOut;
+  unsigned int numKeys = (unsigned int)distortionCounts.size();
+  distortionCountsOut.write((char*)&numKeys, sizeof(unsigned int));
+  for (const std::pair<DistortionKey, DistortionCountsElem>& p : distortionCounts)
+  {
+    unsigned int elemSize = (unsigned int)p.second.size();
+    distortionCountsOut.write((char*)&p.first.i, sizeof(PositionIndex));
+    distortionCountsOut.write((char*)&p.first.slen, sizeof(PositionIndex));
+    distortionCountsOut.write((char*)&p.first.tlen, sizeof(PositionIndex));
+    distortionCountsOut.write((char*)&elemSize, sizeof(unsigned int));
+    distortionCountsOut.write((char*)p.second.data(), elemSize * sizeof(double));
+  }
+  container.addSection(".distortion_counts", distortionCountsOut.str());
+
+  std::ostringstream fertilityCountsOut;
+  unsigned int numSrcWords = (unsigned int)fertilityCounts.size();
+  fertilityCountsOut.write((char*)&numSrcWords, sizeof(unsigned int));
+  for (const FertilityCountsElem& elem : fertilityCounts)
+  {
+    unsigned int elemSize = (unsigned int)elem.size();
+    fertilityCountsOut.write((char*)&elemSize, sizeof(unsigned int));
+    fertilityCountsOut.write((char*)elem.data(), elemSize * sizeof(double));
+  }
+  container.addSection(".fertility_counts", fertilityCountsOut.str());
+
+  return THOT_OK;
 }
 
 bool Ibm3AlignmentModel::printP1(const std::string& filename)
@@ -921,6 +1069,11 @@ bool Ibm3AlignmentModel::printP1(const std::string& filename)
   std::ofstream out(filename);
   if (!out)
     return THOT_ERROR;
+  return printP1(out);
+}
+
+bool Ibm3AlignmentModel::printP1(std::ostream& out)
+{
   out << std::setprecision(std::numeric_limits<double>::max_digits10) << *p1;
   return THOT_OK;
 }
@@ -43,6 +43,9 @@ public:
   using AlignmentModel::getBestAlignment;
   LgProb getBestAlignment(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                           std::vector<PositionIndex>& bestAlignment) override;
+  using AlignmentModel::getAlignmentPosteriors;
+  void getAlignmentPosteriors(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
+                              float* posteriors) override;
   using AlignmentModel::computeLogProb;
   LgProb computeLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                         const WordAlignmentMatrix& aligMatrix, int verbose = 0) override;
@@ -50,9 +53,6 @@ public:
   LgProb computeSumLogProb(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                            int verbose = 0) override;
 
-  bool load(const char* prefFileName, int verbose = 0) override;
-  bool print(const char* prefFileName, int verbose = 0) override;
-
   void clear() override;
   void clearTempVars() override;
 
@@ -96,6 +96,7 @@ protected:
                            PositionIndex j, AlignmentInfo& alignment, double& cachedAlignmentValue);
 
   // batch EM functions
+  void computeMaxSrcWordLen();
   void ibm2Transfer();
 
   /// @brief Adds to distortionCounts and fertilityCounts from the batch of sentence pairs
@@ -117,10 +118,18 @@ protected:
   void batchMaximizeProbs() override;
 
   bool loadP1(const std::string& filename);
+  bool loadP1(std::istream& in);
   bool printP1(const std::string& filename);
+  bool printP1(std::ostream& out);
 
   void loadConfig(const YAML::Node& config) override;
   void createConfig(YAML::Emitter& out) override;
+  void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  bool loadSections(const ModelContainer& container, int verbose = 0) override;
+  bool printSections(ModelContainer& container) override;
+  bool loadTrainingState(const ModelContainer& container, int verbose = 0) override;
+  bool printTrainingState(ModelContainer& container) override;
 
   double countThreshold = DefaultCountThreshold;
   double fertilitySmoothFactor = DefaultFertilitySmoothFactor;
@@ -4,6 +4,8 @@
 #include "nlp_common/MathFuncs.h"
 #include "sw_models/SwDefs.h"
 
+#include <sstream>
+
 Ibm4AlignmentModel::Ibm4AlignmentModel()
     : headDistortionTable{std::make_shared<HeadDistortionTable>()}, nonheadDistortionTable{
                                                                         std::make_shared<NonheadDistortionTable>()}
@@ -30,6 +32,7 @@ Ibm4AlignmentModel::Ibm4AlignmentModel(Ibm4AlignmentModel& model)
 
 unsigned int Ibm4AlignmentModel::startTraining(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.startTraining, "start_training");
   unsigned int count = Ibm3AlignmentModel::startTraining(verbosity);
 
   nonheadDistortionCounts.resize(wordClasses->getTrgWordClassCount());
@@ -140,6 +143,7 @@ void Ibm4AlignmentModel::incrementDistortionCounts(const std::vector<WordIndex>&
 
 void Ibm4AlignmentModel::train(int verbosity)
 {
+  TrainingEvent event(*this, trainingMetrics.iteration, "iteration");
   if (ibm3Model)
   {
     ibm3Transfer();
@@ -369,53 +373,191 @@ Prob Ibm4AlignmentModel::calcDistortionProbOfAlignment(const std::vector<WordInd
   return prob;
 }
 
-bool Ibm4AlignmentModel::load(const char* prefFileName, int verbose)
+void Ibm4AlignmentModel::addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
 {
   // Load IBM 3 Model data
-  bool retVal = Ibm3AlignmentModel::load(prefFileName, verbose);
-  if (retVal == THOT_ERROR)
-    return retVal;
+  Ibm3AlignmentModel::addLoadTasks(prefFileName, verbose, tasks);
 
   if (verbose)
     std::cerr << "Loading IBM 4 Model data..." << std::endl;
 
-  // Load file with head distortion nd values
-  std::string headDistortionNumDenFile = prefFileName;
-  headDistortionNumDenFile = headDistortionNumDenFile + ".h_distnd";
-  retVal = headDistortionTable->load(headDistortionNumDenFile.c_str(), verbose);
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load file with head distortion nd values
+    std::string headDistortionNumDenFile = prefFileName + ".h_distnd";
+    return headDistortionTable->load(headDistortionNumDenFile.c_str(), verbose);
+  });
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load file with nonhead distortion nd values
+    std::string nonheadDistortionNumDenFile = prefFileName + ".nh_distnd";
+    return nonheadDistortionTable->load(nonheadDistortionNumDenFile.c_str(), verbose);
+  });
+}
+
+void Ibm4AlignmentModel::addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
+{
+  // Print IBM 3 Model data
+  Ibm3AlignmentModel::addPrintTasks(prefFileName, verbose, tasks);
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with head distortion nd values
+    std::string headDistortionNumDenFile = prefFileName + ".h_distnd";
+    return headDistortionTable->print(headDistortionNumDenFile.c_str());
+  });
+
+  tasks.push_back([this, prefFileName]() -> bool {
+    // Print file with nonhead distortion nd values
+    std::string nonheadDistortionNumDenFile = prefFileName + ".nh_distnd";
+    return nonheadDistortionTable->print(nonheadDistortionNumDenFile.c_str());
+  });
+}
+
+bool Ibm4AlignmentModel::loadSections(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm3AlignmentModel::loadSections(container, verbose);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  // Load file with nonhead distortion nd values
-  std::string nonheadDistortionNumDenFile = prefFileName;
-  nonheadDistortionNumDenFile = nonheadDistortionNumDenFile + ".nh_distnd";
-  retVal = nonheadDistortionTable->load(nonheadDistortionNumDenFile.c_str(), verbose);
+  const char* data;
+  std::size_t size;
+  if (container.getSection(".h_distnd", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream headDistortionNumDenIn(data, size);
+  retVal = headDistortionTable->load(headDistortionNumDenIn);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  return THOT_OK;
+  if (container.getSection(".nh_distnd", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream nonheadDistortionNumDenIn(data, size);
+  return nonheadDistortionTable->load(nonheadDistortionNumDenIn);
 }
 
-bool Ibm4AlignmentModel::print(const char* prefFileName, int verbose)
+bool Ibm4AlignmentModel::printSections(ModelContainer& container)
 {
-  // Print IBM 3 Model data
-  bool retVal = Ibm3AlignmentModel::print(prefFileName);
+  bool retVal = Ibm3AlignmentModel::printSections(container);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
 
-  // Print file with head distortion nd values
-  std::string headDistortionNumDenFile = prefFileName;
-  headDistortionNumDenFile = headDistortionNumDenFile + ".h_distnd";
-  retVal = headDistortionTable->print(headDistortionNumDenFile.c_str());
+  std::ostringstream headDistortionNumDenOut;
+  retVal = headDistortionTable->print(headDistortionNumDenOut);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  container.addSection(".h_distnd", headDistortionNumDenOut.str());
 
-  // Print file with nonhead distortion nd values
-  std::string nonheadDistortionNumDenFile = prefFileName;
-  nonheadDistortionNumDenFile = nonheadDistortionNumDenFile + ".nh_distnd";
-  retVal = nonheadDistortionTable->print(nonheadDistortionNumDenFile.c_str());
+  std::ostringstream nonheadDistortionNumDenOut;
+  retVal = nonheadDistortionTable->print(nonheadDistortionNumDenOut);
   if (retVal == THOT_ERROR)
     return THOT_ERROR;
+  container.addSection(".nh_distnd", nonheadDistortionNumDenOut.str());
+
+  return THOT_OK;
+}
+
+bool Ibm4AlignmentModel::loadTrainingState(const ModelContainer& container, int verbose)
+{
+  bool retVal = Ibm3AlignmentModel::loadTrainingState(container, verbose);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  const char* data;
+  std::size_t size;
+  if (container.getSection(".head_distortion_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream headDistortionCountsIn(data, size);
+  unsigned int numKeys;
+  if (!headDistortionCountsIn.read((char*)&numKeys, sizeof(unsigned int)))
+    return THOT_ERROR;
+  for (unsigned int k = 0; k < numKeys; ++k)
+  {
+    HeadDistortionKey key;
+    unsigned int numEntries;
+    headDistortionCountsIn.read((char*)&key.srcWordClass, sizeof(WordClassIndex));
+    headDistortionCountsIn.read((char*)&key.trgWordClass, sizeof(WordClassIndex));
+    if (!headDistortionCountsIn.read((char*)&numEntries, sizeof(unsigned int)))
+      return THOT_ERROR;
+    headDistortionTable->reserveSpace(key.srcWordClass, key.trgWordClass);
+    HeadDistortionCountsElem& elem = headDistortionCounts[key];
+    for (unsigned int e = 0; e < numEntries; ++e)
+    {
+      int dj;
+      double count;
+      headDistortionCountsIn.read((char*)&dj, sizeof(int));
+      if (!headDistortionCountsIn.read((char*)&count, sizeof(double)))
+        return THOT_ERROR;
+      elem[dj] = count;
+    }
+  }
+
+  if (container.getSection(".nonhead_distortion_counts", data, size) == THOT_ERROR)
+    return THOT_ERROR;
+  MemoryInputStream nonheadDistortionCountsIn(data, size);
+  unsigned int numTrgWordClasses;
+  if (!nonheadDistortionCountsIn.read((char*)&numTrgWordClasses, sizeof(unsigned int))
+      || !nonheadDistortionCountsIn.canRead(numTrgWordClasses, sizeof(unsigned int)))
+    return THOT_ERROR;
+  nonheadDistortionCounts.resize(numTrgWordClasses);
+  for (NonheadDistortionCountsElem& elem : nonheadDistortionCounts)
+  {
+    unsigned int numEntries;
+    if (!nonheadDistortionCountsIn.read((char*)&numEntries, sizeof(unsigned int)))
+      return THOT_ERROR;
+    for (unsigned int e = 0; e < numEntries; ++e)
+    {
+      int dj;
+      double count;
+      nonheadDistortionCountsIn.read((char*)&dj, sizeof(int));
+      if (!nonheadDistortionCountsIn.read((char*)&count, sizeof(double)))
+        return THOT_ERROR;
+      elem[dj] = count;
+    }
+  }
+  if (numTrgWordClasses > 0)
+    nonheadDistortionTable->reserveSpace(numTrgWordClasses - 1);
+
+  return THOT_OK;
+}
+
+bool Ibm4AlignmentModel::printTrainingState(ModelContainer& container)
+{
+  if (ibm3Model)
+    return THOT_ERROR;
+
+  bool retVal = Ibm3AlignmentModel::printTrainingState(container);
+  if (retVal == THOT_ERROR)
+    return THOT_ERROR;
+
+  std::ostringstream headDistortionCountsOut;
+  unsigned int numKeys = (unsigned int)headDistortionCounts.size();
+  headDistortionCountsOut.write((char*)&numKeys, sizeof(unsigned int));
+  for (const std::pair<HeadDistortionKey, HeadDistortionCountsElem>& p : headDistortionCounts)
+  {
+    unsigned int numEntries = (unsigned int)p.second.size();
+    headDistortionCountsOut.write((char*)&p.first.srcWordClass, sizeof(WordClassIndex));
+    headDistortionCountsOut.write((char*)&p.first.trgWordClass, sizeof(WordClassIndex));
+    headDistortionCountsOut.write((char*)&numEntries, sizeof(unsigned int));
+    for (const std::pair<int, double>& entry : p.second)
+    {
+      headDistortionCountsOut.write((char*)&entry.first, sizeof(int));
+      headDistortionCountsOut.write((char*)&entry.second, sizeof(double));
+    }
+  }
+  container.addSection(".head_distortion_counts", headDistortionCountsOut.str());
+
+  std::ostringstream nonheadDistortionCountsOut;
+  unsigned int numTrgWordClasses = (unsigned int)nonheadDistortionCounts.size();
+  nonheadDistortionCountsOut.write((char*)&numTrgWordClasses, sizeof(unsigned int));
+  for (const NonheadDistortionCountsElem& elem : nonheadDistortionCounts)
+  {
+    unsigned int numEntries = (unsigned int)elem.size();
+    nonheadDistortionCountsOut.write((char*)&numEntries, sizeof(unsigned int));
+    for (const std::pair<int, double>& entry : elem)
+    {
+      nonheadDistortionCountsOut.write((char*)&entry.first, sizeof(int));
+      nonheadDistortionCountsOut.write((char*)&entry.second, sizeof(double));
+    }
+  }
+  container.addSection(".nonhead_distortion_counts", nonheadDistortionCountsOut.str());
 
   return THOT_OK;
 }
@@ -513,26 +655,11 @@ void Ibm4AlignmentModel::ibm3Transfer()
     return ibm3Model->searchForBestAlignment(src, trg, bestAlignment, &moveScores, &swapScores);
   };
 
-  std::vector<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>> buffer;
-  for (unsigned int n = 0; n < numSentencePairs(); ++n)
-  {
-    std::vector<WordIndex> src = getSrcSent(n);
-    std::vector<WordIndex> trg = getTrgSent(n);
-    if (sentenceLengthIsOk(src) && sentenceLengthIsOk(trg))
-      buffer.push_back(make_pair(src, trg));
-
-    if (buffer.size() >= ThreadBufferSize)
-    {
-      batchUpdateCounts(buffer, search);
-      buffer.clear();
-    }
-  }
-  if (buffer.size() > 0)
-  {
-    batchUpdateCounts(buffer, search);
-    buffer.clear();
-  }
+  updateCountsInBuffers(
+      [this, &search](const std::vector<std::pair<std::vector<WordIndex>, std::vector<WordIndex>>>& buffer,
+                      unsigned int) { batchUpdateCounts(buffer, search); });
 
+  TrainingPhaseTimer mStepTimer(trainingMetrics.mStep);
   batchMaximizeProbs();
 }
 
@@ -38,9 +38,6 @@ public:
   double getDistortionSmoothFactor();
   void setDistortionSmoothFactor(double distortionSmoothFactor);
 
-  bool load(const char* prefFileName, int verbose = 0) override;
-  bool print(const char* prefFileName, int verbose = 0) override;
-
   void clear() override;
   void clearTempVars() override;
 
@@ -86,6 +83,12 @@ protected:
 
   void loadConfig(const YAML::Node& config) override;
   void createConfig(YAML::Emitter& out) override;
+  void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  bool loadSections(const ModelContainer& container, int verbose = 0) override;
+  bool printSections(ModelContainer& container) override;
+  bool loadTrainingState(const ModelContainer& container, int verbose = 0) override;
+  bool printTrainingState(ModelContainer& container) override;
 
   double distortionSmoothFactor = DefaultDistortionSmoothFactor;
 
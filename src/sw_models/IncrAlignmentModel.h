@@ -9,6 +9,13 @@ public:
   // values anji (by default the size is not restricted)
   virtual void set_expval_maxnsize(unsigned int _anji_maxnsize) = 0;
 
+  // Functions to choose how expected values are stored: as half
+  // precision floating-point numbers, and/or in memory-mapped spill
+  // files named after the given prefix instead of in RAM. Both
+  // options discard the expected values stored so far
+  virtual void set_expval_half_precision(bool halfPrecision) = 0;
+  virtual bool set_expval_spill_file_prefix(const char* prefFileName) = 0;
+
   virtual void startIncrTraining(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0) = 0;
 
   virtual void incrTrain(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0) = 0;
@@ -12,6 +12,19 @@ void IncrHmmAlignmentModel::set_expval_maxnsize(unsigned int _expval_maxnsize)
   lanjm1ip_anji.set_maxnsize(_expval_maxnsize);
 }
 
+void IncrHmmAlignmentModel::set_expval_half_precision(bool halfPrecision)
+{
+  trainer.setHalfPrecision(halfPrecision);
+}
+
+bool IncrHmmAlignmentModel::set_expval_spill_file_prefix(const char* prefFileName)
+{
+  std::string spillFileName = prefFileName;
+  if (lanji.set_spill_file((spillFileName + ".lanji.spill").c_str(), 1) == THOT_ERROR)
+    return THOT_ERROR;
+  return lanjm1ip_anji.set_spill_file((spillFileName + ".lanjm1ip_anji.spill").c_str(), 1);
+}
+
 void IncrHmmAlignmentModel::startIncrTraining(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity)
 {
   clearTempVars();
@@ -29,36 +42,32 @@ void IncrHmmAlignmentModel::endIncrTraining()
   clearTempVars();
 }
 
-bool IncrHmmAlignmentModel::load(const char* prefFileName, int verbose)
+void IncrHmmAlignmentModel::addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  bool retVal = HmmAlignmentModel::load(prefFileName, verbose);
-  if (retVal == THOT_ERROR)
-    return retVal;
-
-  // Load file with lanji values
-  lanji.load(prefFileName, verbose);
-
-  // Load file with lanjm1ip_anji values
-  lanjm1ip_anji.load(prefFileName, verbose);
-
-  return THOT_OK;
+  HmmAlignmentModel::addLoadTasks(prefFileName, verbose, tasks);
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load file with lanji values
+    lanji.load(prefFileName.c_str(), verbose);
+    return THOT_OK;
+  });
+
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load file with lanjm1ip_anji values
+    lanjm1ip_anji.load(prefFileName.c_str(), verbose);
+    return THOT_OK;
+  });
 }
 
-bool IncrHmmAlignmentModel::print(const char* prefFileName, int verbose)
+void IncrHmmAlignmentModel::addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  bool retVal = HmmAlignmentModel::print(prefFileName, verbose);
-  if (retVal == THOT_ERROR)
-    return retVal;
+  HmmAlignmentModel::addPrintTasks(prefFileName, verbose, tasks);
 
   // Print file lanji values
-  retVal = lanji.print(prefFileName);
-  if (retVal == THOT_ERROR)
-    return THOT_ERROR;
+  tasks.push_back([this, prefFileName]() -> bool { return lanji.print(prefFileName.c_str()); });
 
   // Print file with lanjm1ip_anji values
-  retVal = lanjm1ip_anji.print(prefFileName);
-
-  return retVal;
+  tasks.push_back([this, prefFileName]() -> bool { return lanjm1ip_anji.print(prefFileName.c_str()); });
 }
 
 void IncrHmmAlignmentModel::clear()
@@ -18,14 +18,13 @@ public:
   // Function to set a maximum size for the vector of expected
   // values anji (by default the size is not restricted)
   void set_expval_maxnsize(unsigned int _anji_maxnsize) override;
+  void set_expval_half_precision(bool halfPrecision) override;
+  bool set_expval_spill_file_prefix(const char* prefFileName) override;
 
   void startIncrTraining(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0) override;
   void incrTrain(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0) override;
   void endIncrTraining() override;
 
-  bool load(const char* prefFileName, int verbose = 0) override;
-  bool print(const char* prefFileName, int verbose = 0) override;
-
   void clear() override;
   void clearTempVars() override;
 
@@ -34,6 +33,14 @@ public:
   }
 
 protected:
+  std::string getModelTypeStr() const override
+  {
+    return "incrHmm";
+  }
+
+  void addLoadTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+  void addPrintTasks(const std::string& prefFileName, int verbose, ModelTasks& tasks) override;
+
   anjiMatrix lanji;
   anjm1ip_anjiMatrix lanjm1ip_anji;
   IncrHmmAlignmentTrainer trainer;
@@ -1,5 +1,9 @@
 #include "sw_models/IncrHmmAlignmentTrainer.h"
 
+#include "sw_models/SwDefs.h"
+
+#include <omp.h>
+
 using namespace std;
 
 IncrHmmAlignmentTrainer::IncrHmmAlignmentTrainer(HmmAlignmentModel& model, anjiMatrix& lanji,
@@ -10,100 +14,183 @@ IncrHmmAlignmentTrainer::IncrHmmAlignmentTrainer(HmmAlignmentModel& model, anjiM
 
 void IncrHmmAlignmentTrainer::incrTrain(pair<unsigned int, unsigned int> sentPairRange, int verbosity)
 {
+  HmmAlignmentModel::TrainingEvent event(model, model.trainingMetrics.iteration, "iteration");
   // EM algorithm
 #ifdef THOT_ENABLE_VITERBI_TRAINING
   calcNewLocalSuffStatsVit(sentPairRange, verbosity);
 #else
   calcNewLocalSuffStats(sentPairRange, verbosity);
 #endif
+  TrainingPhaseTimer mStepTimer(model.trainingMetrics.mStep);
   incrMaximizeProbs();
 }
 
+void IncrHmmAlignmentTrainer::setHalfPrecision(bool halfPrecision)
+{
+  // See IncrIbm1AlignmentTrainer::setHalfPrecision()
+  lanji.set_half_precision(halfPrecision);
+  lanjm1ip_anji.set_half_precision(halfPrecision);
+  for (anjiMatrix& matrix : lanji_aux)
+    matrix.set_half_precision(halfPrecision);
+  for (anjm1ip_anjiMatrix& matrix : lanjm1ip_anji_aux)
+    matrix.set_half_precision(halfPrecision);
+}
+
 void IncrHmmAlignmentTrainer::clear()
 {
-  lanji_aux.clear();
-  lanjm1ip_anji_aux.clear();
+  for (anjiMatrix& matrix : lanji_aux)
+    matrix.clear();
+  for (anjm1ip_anjiMatrix& matrix : lanjm1ip_anji_aux)
+    matrix.clear();
   incrLexCounts.clear();
   incrHmmAlignmentCounts.clear();
 }
 
 void IncrHmmAlignmentTrainer::calcNewLocalSuffStats(pair<unsigned int, unsigned int> sentPairRange, int verbosity)
 {
-  // Iterate over the training samples
-  for (unsigned int n = sentPairRange.first; n <= sentPairRange.second; ++n)
+  initThreadData(omp_get_max_threads());
+
+  unsigned int chunkSize = getChunkSize();
+  for (unsigned int first = sentPairRange.first; first <= sentPairRange.second; first += chunkSize)
   {
-    // Init vars for n'th sample
-    vector<WordIndex> srcSent = model.getSrcSent(n);
-    vector<WordIndex> nsrcSent = model.extendWithNullWord(srcSent);
-    vector<WordIndex> trgSent = model.getTrgSent(n);
+    unsigned int last = min(sentPairRange.second, first + (chunkSize - 1));
+    vector<IncrTrainSample> samples;
+    initChunkSamples(first, last, verbosity, samples);
 
-    // Do not process sentence pair if sentences are empty or exceed the maximum length
-    if (model.sentenceLengthIsOk(srcSent) && model.sentenceLengthIsOk(trgSent))
+    TrainingPhaseTimer eStepTimer(model.trainingMetrics.eStep);
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < (int)samples.size(); ++k)
     {
-      Count weight;
-      model.sentenceHandler->getCount(n, weight);
-
-      PositionIndex slen = (PositionIndex)srcSent.size();
+      const IncrTrainSample& sample = samples[k];
+      PositionIndex slen = (PositionIndex)sample.srcSent.size();
 
       // Calculate alpha and beta matrices
       vector<vector<double>> lexProbs;
       vector<vector<double>> alignProbs;
       vector<vector<double>> alphaMatrix;
       vector<vector<double>> betaMatrix;
-      model.calcAlphaBetaMatrices(nsrcSent, trgSent, slen, lexProbs, alignProbs, alphaMatrix, betaMatrix);
+      model.calcAlphaBetaMatrices(sample.nsrcSent, sample.trgSent, slen, lexProbs, alignProbs, alphaMatrix,
+                                  betaMatrix);
 
       // Calculate sufficient statistics for anji values
-      calc_lanji(n, nsrcSent, trgSent, slen, weight, alphaMatrix, betaMatrix);
+      calc_lanji(sample.mapped_n, sample.nsrcSent, sample.trgSent, slen, sample.weight, alphaMatrix, betaMatrix);
 
       // Calculate sufficient statistics for anjm1ip_anji values
-      calc_lanjm1ip_anji(n, srcSent, trgSent, slen, weight, lexProbs, alignProbs, alphaMatrix, betaMatrix);
+      calc_lanjm1ip_anji(sample.mapped_n_lanjm1ip, sample.srcSent, sample.trgSent, slen, sample.weight, lexProbs,
+                         alignProbs, alphaMatrix, betaMatrix);
     }
-    else
+
+    if (last == sentPairRange.second)
+      break;
+  }
+}
+
+void IncrHmmAlignmentTrainer::calcNewLocalSuffStatsVit(pair<unsigned int, unsigned int> sentPairRange, int verbosity)
+{
+  initThreadData(omp_get_max_threads());
+
+  unsigned int chunkSize = getChunkSize();
+  for (unsigned int first = sentPairRange.first; first <= sentPairRange.second; first += chunkSize)
+  {
+    unsigned int last = min(sentPairRange.second, first + (chunkSize - 1));
+    vector<IncrTrainSample> samples;
+    initChunkSamples(first, last, verbosity, samples);
+
+    TrainingPhaseTimer eStepTimer(model.trainingMetrics.eStep);
+#pragma omp parallel
     {
-      if (verbosity)
+      // Define variable to cache alignment log probs
+      CachedHmmAligLgProb cached_logap;
+
+#pragma omp for schedule(dynamic)
+      for (int k = 0; k < (int)samples.size(); ++k)
       {
-        cerr << "Warning, training pair " << n + 1 << " discarded due to sentence length (slen: " << srcSent.size()
-             << " , tlen: " << trgSent.size() << ")" << endl;
+        const IncrTrainSample& sample = samples[k];
+        PositionIndex slen = (PositionIndex)sample.srcSent.size();
+
+        // Execute Viterbi algorithm
+        vector<vector<double>> vitMatrix;
+        vector<vector<PositionIndex>> predMatrix;
+        model.viterbiAlgorithmCached(sample.nsrcSent, sample.trgSent, cached_logap, vitMatrix, predMatrix);
+
+        // Obtain Viterbi alignment
+        vector<PositionIndex> bestAlig;
+        model.bestAligGivenVitMatricesRaw(vitMatrix, predMatrix, bestAlig);
+
+        // Calculate sufficient statistics for anji values
+        calc_lanji_vit(sample.mapped_n, sample.nsrcSent, sample.trgSent, bestAlig, sample.weight);
+
+        // Calculate sufficient statistics for anjm1ip_anji values
+        calc_lanjm1ip_anji_vit(sample.mapped_n_lanjm1ip, sample.srcSent, sample.trgSent, slen, bestAlig,
+                               sample.weight);
       }
     }
+
+    if (last == sentPairRange.second)
+      break;
   }
 }
 
-void IncrHmmAlignmentTrainer::calcNewLocalSuffStatsVit(pair<unsigned int, unsigned int> sentPairRange, int verbosity)
+void IncrHmmAlignmentTrainer::initThreadData(unsigned int numThreads)
+{
+  if (lanji_aux.size() < numThreads)
+    lanji_aux.resize(numThreads);
+  for (anjiMatrix& matrix : lanji_aux)
+  {
+    if (matrix.get_half_precision() != lanji.get_half_precision())
+      matrix.set_half_precision(lanji.get_half_precision());
+  }
+  if (lanjm1ip_anji_aux.size() < numThreads)
+    lanjm1ip_anji_aux.resize(numThreads);
+  for (anjm1ip_anjiMatrix& matrix : lanjm1ip_anji_aux)
+  {
+    if (matrix.get_half_precision() != lanjm1ip_anji.get_half_precision())
+      matrix.set_half_precision(lanjm1ip_anji.get_half_precision());
+  }
+  if (incrLexCounts.size() < numThreads)
+    incrLexCounts.resize(numThreads);
+  if (incrHmmAlignmentCounts.size() < numThreads)
+    incrHmmAlignmentCounts.resize(numThreads);
+}
+
+unsigned int IncrHmmAlignmentTrainer::getChunkSize()
 {
-  // Define variable to cache alignment log probs
-  CachedHmmAligLgProb cached_logap;
+  // A chunk cannot be larger than the number of entries kept in the
+  // matrices, otherwise its samples would reuse each other's entries
+  unsigned int chunkSize = SW_INCR_TRAIN_CHUNK_SIZE;
+  if (lanji.get_maxnsize() > 0)
+    chunkSize = min(chunkSize, lanji.get_maxnsize());
+  if (lanjm1ip_anji.get_maxnsize() > 0)
+    chunkSize = min(chunkSize, lanjm1ip_anji.get_maxnsize());
+  return chunkSize;
+}
 
-  // Iterate over the training samples
-  for (unsigned int n = sentPairRange.first; n <= sentPairRange.second; ++n)
+void IncrHmmAlignmentTrainer::initChunkSamples(unsigned int first, unsigned int last, int verbosity,
+                                               vector<IncrTrainSample>& samples)
+{
+  // Entries are initialized serially, since they may replace the entries of
+  // older samples when the size of the matrices is restricted
+  TrainingPhaseTimer ioTimer(model.trainingMetrics.io);
+  for (unsigned int n = first; n <= last; ++n)
   {
     // Init vars for n'th sample
     vector<WordIndex> srcSent = model.getSrcSent(n);
-    vector<WordIndex> nsrcSent = model.extendWithNullWord(srcSent);
     vector<WordIndex> trgSent = model.getTrgSent(n);
 
     // Do not process sentence pair if sentences are empty or exceed the maximum length
     if (model.sentenceLengthIsOk(srcSent) && model.sentenceLengthIsOk(trgSent))
     {
-      Count weight;
-      model.sentenceHandler->getCount(n, weight);
-
-      PositionIndex slen = (PositionIndex)srcSent.size();
-
-      // Execute Viterbi algorithm
-      vector<vector<double>> vitMatrix;
-      vector<vector<PositionIndex>> predMatrix;
-      model.viterbiAlgorithmCached(nsrcSent, trgSent, cached_logap, vitMatrix, predMatrix);
-
-      // Obtain Viterbi alignment
-      vector<PositionIndex> bestAlig;
-      model.bestAligGivenVitMatricesRaw(vitMatrix, predMatrix, bestAlig);
-
-      // Calculate sufficient statistics for anji values
-      calc_lanji_vit(n, nsrcSent, trgSent, bestAlig, weight);
-
-      // Calculate sufficient statistics for anjm1ip_anji values
-      calc_lanjm1ip_anji_vit(n, srcSent, trgSent, slen, bestAlig, weight);
+      IncrTrainSample sample;
+      sample.nsrcSent = model.extendWithNullWord(srcSent);
+      sample.srcSent = srcSent;
+      sample.trgSent = trgSent;
+      model.sentenceHandler->getCount(n, sample.weight);
+      sample.mapped_n = 0;
+      lanji.init_nth_entry(n, sample.nsrcSent.size(), trgSent.size(), sample.mapped_n);
+      sample.mapped_n_lanjm1ip = 0;
+      lanjm1ip_anji.init_nth_entry(n, srcSent.size(), trgSent.size(), sample.mapped_n_lanjm1ip);
+      model.trainingMetrics.numTokens += srcSent.size() + trgSent.size();
+      samples.push_back(sample);
     }
     else
     {
@@ -116,15 +203,14 @@ void IncrHmmAlignmentTrainer::calcNewLocalSuffStatsVit(pair<unsigned int, unsign
   }
 }
 
-void IncrHmmAlignmentTrainer::calc_lanji(unsigned int n, const vector<WordIndex>& nsrcSent,
+void IncrHmmAlignmentTrainer::calc_lanji(unsigned int mapped_n, const vector<WordIndex>& nsrcSent,
                                          const vector<WordIndex>& trgSent, PositionIndex slen, const Count& weight,
                                          const vector<vector<double>>& alphaMatrix,
                                          const vector<vector<double>>& betaMatrix)
 {
-  // Initialize data structures
-  unsigned int mapped_n;
-  lanji.init_nth_entry(n, nsrcSent.size(), trgSent.size(), mapped_n);
+  anjiMatrix& lanji_aux = this->lanji_aux[omp_get_thread_num()];
 
+  // Initialize data structures
   unsigned int n_aux = 1;
   unsigned int mapped_n_aux;
   lanji_aux.init_nth_entry(n_aux, nsrcSent.size(), trgSent.size(), mapped_n_aux);
@@ -167,14 +253,13 @@ void IncrHmmAlignmentTrainer::calc_lanji(unsigned int n, const vector<WordIndex>
   lanji_aux.clear();
 }
 
-void IncrHmmAlignmentTrainer::calc_lanji_vit(unsigned int n, const vector<WordIndex>& nsrcSent,
+void IncrHmmAlignmentTrainer::calc_lanji_vit(unsigned int mapped_n, const vector<WordIndex>& nsrcSent,
                                              const vector<WordIndex>& trgSent, const vector<PositionIndex>& bestAlig,
                                              const Count& weight)
 {
-  // Initialize data structures
-  unsigned int mapped_n;
-  lanji.init_nth_entry(n, nsrcSent.size(), trgSent.size(), mapped_n);
+  anjiMatrix& lanji_aux = this->lanji_aux[omp_get_thread_num()];
 
+  // Initialize data structures
   unsigned int n_aux = 1;
   unsigned int mapped_n_aux;
   lanji_aux.init_nth_entry(n_aux, nsrcSent.size(), trgSent.size(), mapped_n_aux);
@@ -202,17 +287,16 @@ void IncrHmmAlignmentTrainer::calc_lanji_vit(unsigned int n, const vector<WordIn
   lanji_aux.clear();
 }
 
-void IncrHmmAlignmentTrainer::calc_lanjm1ip_anji(unsigned int n, const vector<WordIndex>& srcSent,
+void IncrHmmAlignmentTrainer::calc_lanjm1ip_anji(unsigned int mapped_n, const vector<WordIndex>& srcSent,
                                                  const vector<WordIndex>& trgSent, PositionIndex slen,
                                                  const Count& weight, const vector<vector<double>>& lexLogProbs,
                                                  const vector<vector<double>>& alignProbs,
                                                  const vector<vector<double>>& alphaMatrix,
                                                  const vector<vector<double>>& betaMatrix)
 {
-  // Initialize data structures
-  unsigned int mapped_n;
-  lanjm1ip_anji.init_nth_entry(n, srcSent.size(), trgSent.size(), mapped_n);
+  anjm1ip_anjiMatrix& lanjm1ip_anji_aux = this->lanjm1ip_anji_aux[omp_get_thread_num()];
 
+  // Initialize data structures
   unsigned int n_aux = 1;
   unsigned int mapped_n_aux;
   lanjm1ip_anji_aux.init_nth_entry(n_aux, srcSent.size(), trgSent.size(), mapped_n_aux);
@@ -317,14 +401,13 @@ void IncrHmmAlignmentTrainer::calc_lanjm1ip_anji(unsigned int n, const vector<Wo
   lanjm1ip_anji_aux.clear();
 }
 
-void IncrHmmAlignmentTrainer::calc_lanjm1ip_anji_vit(unsigned int n, const vector<WordIndex>& srcSent,
+void IncrHmmAlignmentTrainer::calc_lanjm1ip_anji_vit(unsigned int mapped_n, const vector<WordIndex>& srcSent,
                                                      const vector<WordIndex>& trgSent, PositionIndex slen,
                                                      const vector<PositionIndex>& bestAlig, const Count& weight)
 {
-  // Initialize data structures
-  unsigned int mapped_n;
-  lanjm1ip_anji.init_nth_entry(n, srcSent.size(), trgSent.size(), mapped_n);
+  anjm1ip_anjiMatrix& lanjm1ip_anji_aux = this->lanjm1ip_anji_aux[omp_get_thread_num()];
 
+  // Initialize data structures
   unsigned int n_aux = 1;
   unsigned int mapped_n_aux;
   lanjm1ip_anji_aux.init_nth_entry(n_aux, srcSent.size(), trgSent.size(), mapped_n_aux);
@@ -371,6 +454,8 @@ void IncrHmmAlignmentTrainer::gatherLexSuffStats(unsigned int mapped_n, unsigned
                                                  const vector<WordIndex>& nsrcSent, const vector<WordIndex>& trgSent,
                                                  const Count& weight)
 {
+  anjiMatrix& lanji_aux = this->lanji_aux[omp_get_thread_num()];
+
   // Gather lexical sufficient statistics
   for (unsigned int j = 1; j <= trgSent.size(); ++j)
   {
@@ -389,6 +474,9 @@ void IncrHmmAlignmentTrainer::incrUpdateCountsLex(unsigned int mapped_n, unsigne
                                                   PositionIndex j, const vector<WordIndex>& nsrcSent,
                                                   const vector<WordIndex>& trgSent, const Count& weight)
 {
+  anjiMatrix& lanji_aux = this->lanji_aux[omp_get_thread_num()];
+  IncrLexCounts& incrLexCounts = this->incrLexCounts[omp_get_thread_num()];
+
   // Init vars
   float curr_lanji = lanji.get_fast(mapped_n, j, i);
   float weighted_curr_lanji = SMALL_LG_NUM;
@@ -432,6 +520,8 @@ void IncrHmmAlignmentTrainer::gatherAligSuffStats(unsigned int mapped_n, unsigne
                                                   const vector<WordIndex>& srcSent, const vector<WordIndex>& trgSent,
                                                   PositionIndex slen, const Count& weight)
 {
+  anjm1ip_anjiMatrix& lanjm1ip_anji_aux = this->lanjm1ip_anji_aux[omp_get_thread_num()];
+
   // Maximize alignment parameters
   for (unsigned int j = 1; j <= trgSent.size(); ++j)
   {
@@ -468,6 +558,9 @@ void IncrHmmAlignmentTrainer::incrUpdateCountsAlig(unsigned int mapped_n, unsign
                                                    PositionIndex ip, PositionIndex i, PositionIndex j,
                                                    const Count& weight)
 {
+  anjm1ip_anjiMatrix& lanjm1ip_anji_aux = this->lanjm1ip_anji_aux[omp_get_thread_num()];
+  IncrHmmAlignmentCounts& incrHmmAlignmentCounts = this->incrHmmAlignmentCounts[omp_get_thread_num()];
+
   // Init vars
   float curr_lanjm1ip_anji = lanjm1ip_anji.get_fast(mapped_n, j, i, ip);
   float weighted_curr_lanjm1ip_anji = SMALL_LG_NUM;
@@ -505,8 +598,43 @@ void IncrHmmAlignmentTrainer::incrUpdateCountsAlig(unsigned int mapped_n, unsign
   }
 }
 
+void IncrHmmAlignmentTrainer::mergeIncrHmmAlignmentCounts()
+{
+  if (incrHmmAlignmentCounts.empty())
+    return;
+
+  // Add the local sufficient statistics of every thread to the ones of the first thread
+  IncrHmmAlignmentCounts& counts = incrHmmAlignmentCounts[0];
+  for (size_t k = 1; k < incrHmmAlignmentCounts.size(); ++k)
+  {
+    for (const auto& entry : incrHmmAlignmentCounts[k])
+    {
+      IncrHmmAlignmentCounts::iterator aligAuxVarIter = counts.find(entry.first);
+      if (aligAuxVarIter != counts.end())
+      {
+        if (entry.second.first != SMALL_LG_NUM)
+          aligAuxVarIter->second.first = MathFuncs::lns_sumlog_float(aligAuxVarIter->second.first, entry.second.first);
+        aligAuxVarIter->second.second =
+            MathFuncs::lns_sumlog_float(aligAuxVarIter->second.second, entry.second.second);
+      }
+      else
+      {
+        counts[entry.first] = entry.second;
+      }
+    }
+    incrHmmAlignmentCounts[k].clear();
+  }
+}
+
 void IncrHmmAlignmentTrainer::incrMaximizeProbs()
 {
+  TrainingPhaseTimer reductionTimer(model.trainingMetrics.reduction);
+  mergeIncrLexCounts(this->incrLexCounts);
+  mergeIncrHmmAlignmentCounts();
+  reductionTimer.stop();
+  IncrLexCounts& incrLexCounts = this->incrLexCounts[0];
+  IncrHmmAlignmentCounts& incrHmmAlignmentCounts = this->incrHmmAlignmentCounts[0];
+
   float initialNumer = model.variationalBayes ? (float)log(model.alpha) : SMALL_LG_NUM;
   // Update parameters
   for (unsigned int i = 0; i < incrLexCounts.size(); ++i)
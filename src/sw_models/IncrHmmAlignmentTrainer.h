@@ -31,25 +31,40 @@ public:
 
   void incrTrain(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity);
   void clear();
+  void setHalfPrecision(bool halfPrecision);
 
   virtual ~IncrHmmAlignmentTrainer()
   {
   }
 
 protected:
+  // Sentence pair whose entries in lanji and lanjm1ip_anji have already been initialized
+  struct IncrTrainSample
+  {
+    unsigned int mapped_n;
+    unsigned int mapped_n_lanjm1ip;
+    std::vector<WordIndex> srcSent;
+    std::vector<WordIndex> nsrcSent;
+    std::vector<WordIndex> trgSent;
+    Count weight;
+  };
+
   void calcNewLocalSuffStats(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0);
   void calcNewLocalSuffStatsVit(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0);
-  void calc_lanji(unsigned int n, const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
+  void initThreadData(unsigned int numThreads);
+  unsigned int getChunkSize();
+  void initChunkSamples(unsigned int first, unsigned int last, int verbosity, std::vector<IncrTrainSample>& samples);
+  void calc_lanji(unsigned int mapped_n, const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
                   PositionIndex slen, const Count& weight, const std::vector<std::vector<double>>& alphaMatrix,
                   const std::vector<std::vector<double>>& betaMatrix);
-  void calc_lanji_vit(unsigned int n, const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
+  void calc_lanji_vit(unsigned int mapped_n, const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
                       const std::vector<PositionIndex>& bestAlig, const Count& weight);
-  void calc_lanjm1ip_anji(unsigned int n, const std::vector<WordIndex>& srcSent, const std::vector<WordIndex>& trgSent,
+  void calc_lanjm1ip_anji(unsigned int mapped_n, const std::vector<WordIndex>& srcSent, const std::vector<WordIndex>& trgSent,
                           PositionIndex slen, const Count& weight, const std::vector<std::vector<double>>& logProbs,
                           const std::vector<std::vector<double>>& alignProbs,
                           const std::vector<std::vector<double>>& alphaMatrix,
                           const std::vector<std::vector<double>>& betaMatrix);
-  void calc_lanjm1ip_anji_vit(unsigned int n, const std::vector<WordIndex>& srcSent,
+  void calc_lanjm1ip_anji_vit(unsigned int mapped_n, const std::vector<WordIndex>& srcSent,
                               const std::vector<WordIndex>& trgSent, PositionIndex slen,
                               const std::vector<PositionIndex>& bestAlig, const Count& weight);
   void gatherLexSuffStats(unsigned int mapped_n, unsigned int mapped_n_aux, const std::vector<WordIndex>& nsrcSent,
@@ -62,6 +77,7 @@ protected:
   void incrUpdateCountsAlig(unsigned int mapped_n, unsigned int mapped_n_aux, PositionIndex slen, PositionIndex ip,
                             PositionIndex i, PositionIndex j, const Count& weight);
   void incrMaximizeProbs();
+  void mergeIncrHmmAlignmentCounts();
   float obtainLogNewSuffStat(float lcurrSuffStat, float lLocalSuffStatCurr, float lLocalSuffStatNew);
 
 private:
@@ -69,12 +85,14 @@ private:
   typedef std::unordered_map<IncrHmmAlignmentCountsKey, std::pair<float, float>, IncrHmmAlignmentCountsKeyHash>
       IncrHmmAlignmentCounts;
 
+  // The auxiliary matrices and the local sufficient statistics are kept
+  // per thread
   anjiMatrix& lanji;
-  anjiMatrix lanji_aux;
+  std::vector<anjiMatrix> lanji_aux;
   anjm1ip_anjiMatrix& lanjm1ip_anji;
-  anjm1ip_anjiMatrix lanjm1ip_anji_aux;
+  std::vector<anjm1ip_anjiMatrix> lanjm1ip_anji_aux;
 
   HmmAlignmentModel& model;
-  IncrLexCounts incrLexCounts;
-  IncrHmmAlignmentCounts incrHmmAlignmentCounts;
+  std::vector<IncrLexCounts> incrLexCounts;
+  std::vector<IncrHmmAlignmentCounts> incrHmmAlignmentCounts;
 };
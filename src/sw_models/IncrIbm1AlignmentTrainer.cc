@@ -2,6 +2,8 @@
 
 #include "sw_models/SwDefs.h"
 
+#include <omp.h>
+
 using namespace std;
 
 IncrIbm1AlignmentTrainer::IncrIbm1AlignmentTrainer(Ibm1AlignmentModel& model, anjiMatrix& anji)
@@ -11,50 +13,92 @@ IncrIbm1AlignmentTrainer::IncrIbm1AlignmentTrainer(Ibm1AlignmentModel& model, an
 
 void IncrIbm1AlignmentTrainer::incrTrain(pair<unsigned int, unsigned int> sentPairRange, int verbosity)
 {
+  Ibm1AlignmentModel::TrainingEvent event(model, model.trainingMetrics.iteration, "iteration");
   // EM algorithm
   calcNewLocalSuffStats(sentPairRange, verbosity);
+  TrainingPhaseTimer mStepTimer(model.trainingMetrics.mStep);
   incrMaximizeProbs();
 }
 
 void IncrIbm1AlignmentTrainer::calcNewLocalSuffStats(pair<unsigned int, unsigned int> sentPairRange, int verbosity)
 {
-  // Iterate over the training samples
-  for (unsigned int n = sentPairRange.first; n <= sentPairRange.second; ++n)
-  {
-    // Calculate sufficient statistics
+  initThreadData(omp_get_max_threads());
 
-    // Init vars for n'th sample
-    vector<WordIndex> srcSent = model.getSrcSent(n);
-    vector<WordIndex> nsrcSent = model.extendWithNullWord(srcSent);
-    vector<WordIndex> trgSent = model.getTrgSent(n);
+  // The training samples are processed in chunks. The entries of a chunk are
+  // initialized serially, since doing so may reuse the entries of older
+  // samples when the size of anji is restricted, and then the sufficient
+  // statistics of the chunk are calculated in parallel
+  unsigned int chunkSize = SW_INCR_TRAIN_CHUNK_SIZE;
+  if (anji.get_maxnsize() > 0)
+    chunkSize = min(chunkSize, anji.get_maxnsize());
 
-    Count weight;
-    model.sentenceHandler->getCount(n, weight);
+  for (unsigned int first = sentPairRange.first; first <= sentPairRange.second; first += chunkSize)
+  {
+    unsigned int last = min(sentPairRange.second, first + (chunkSize - 1));
 
-    // Process sentence pair only if both sentences are not empty
-    if (model.sentenceLengthIsOk(srcSent) && model.sentenceLengthIsOk(trgSent))
+    TrainingPhaseTimer ioTimer(model.trainingMetrics.io);
+    vector<IncrTrainSample> samples;
+    for (unsigned int n = first; n <= last; ++n)
     {
-      // Calculate sufficient statistics for anji values
-      calc_anji(n, nsrcSent, trgSent, weight);
-    }
-    else
-    {
-      if (verbosity)
+      // Init vars for n'th sample
+      vector<WordIndex> srcSent = model.getSrcSent(n);
+      vector<WordIndex> trgSent = model.getTrgSent(n);
+
+      // Process sentence pair only if both sentences are not empty
+      if (model.sentenceLengthIsOk(srcSent) && model.sentenceLengthIsOk(trgSent))
       {
-        cerr << "Warning, training pair " << n + 1 << " discarded due to sentence length (slen: " << srcSent.size()
-             << " , tlen: " << trgSent.size() << ")" << endl;
+        IncrTrainSample sample;
+        sample.nsrcSent = model.extendWithNullWord(srcSent);
+        sample.trgSent = trgSent;
+        model.sentenceHandler->getCount(n, sample.weight);
+        sample.mapped_n = 0;
+        anji.init_nth_entry(n, (PositionIndex)sample.nsrcSent.size(), (PositionIndex)trgSent.size(),
+                            sample.mapped_n);
+        model.trainingMetrics.numTokens += srcSent.size() + trgSent.size();
+        samples.push_back(sample);
+      }
+      else
+      {
+        if (verbosity)
+        {
+          cerr << "Warning, training pair " << n + 1 << " discarded due to sentence length (slen: " << srcSent.size()
+               << " , tlen: " << trgSent.size() << ")" << endl;
+        }
       }
     }
+
+    ioTimer.stop();
+
+    // Calculate sufficient statistics for anji values
+    TrainingPhaseTimer eStepTimer(model.trainingMetrics.eStep);
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < (int)samples.size(); ++k)
+      calc_anji(samples[k].mapped_n, samples[k].nsrcSent, samples[k].trgSent, samples[k].weight);
+
+    if (last == sentPairRange.second)
+      break;
   }
 }
 
-void IncrIbm1AlignmentTrainer::calc_anji(unsigned int n, const vector<WordIndex>& nsrcSent,
+void IncrIbm1AlignmentTrainer::initThreadData(unsigned int numThreads)
+{
+  if (anji_aux.size() < numThreads)
+    anji_aux.resize(numThreads);
+  for (anjiMatrix& matrix : anji_aux)
+  {
+    if (matrix.get_half_precision() != anji.get_half_precision())
+      matrix.set_half_precision(anji.get_half_precision());
+  }
+  if (incrLexCounts.size() < numThreads)
+    incrLexCounts.resize(numThreads);
+}
+
+void IncrIbm1AlignmentTrainer::calc_anji(unsigned int mapped_n, const vector<WordIndex>& nsrcSent,
                                          const vector<WordIndex>& trgSent, const Count& weight)
 {
-  // Initialize anji and anji_aux
-  unsigned int mapped_n;
-  anji.init_nth_entry(n, (PositionIndex)nsrcSent.size(), (PositionIndex)trgSent.size(), mapped_n);
+  anjiMatrix& anji_aux = this->anji_aux[omp_get_thread_num()];
 
+  // Initialize anji_aux
   unsigned int n_aux = 1;
   unsigned int mapped_n_aux;
   anji_aux.init_nth_entry(n_aux, (PositionIndex)nsrcSent.size(), (PositionIndex)trgSent.size(), mapped_n_aux);
@@ -104,6 +148,9 @@ void IncrIbm1AlignmentTrainer::incrUpdateCounts(unsigned int mapped_n, unsigned
                                                 PositionIndex j, const vector<WordIndex>& nsrcSent,
                                                 const vector<WordIndex>& trgSent, const Count& weight)
 {
+  anjiMatrix& anji_aux = this->anji_aux[omp_get_thread_num()];
+  IncrLexCounts& incrLexCounts = this->incrLexCounts[omp_get_thread_num()];
+
   // Init vars
   float weighted_curr_anji = 0;
   float curr_anji = anji.get_fast(mapped_n, j, i);
@@ -150,6 +197,11 @@ void IncrIbm1AlignmentTrainer::incrUpdateCounts(unsigned int mapped_n, unsigned
 
 void IncrIbm1AlignmentTrainer::incrMaximizeProbs()
 {
+  TrainingPhaseTimer reductionTimer(model.trainingMetrics.reduction);
+  mergeIncrLexCounts(this->incrLexCounts);
+  reductionTimer.stop();
+  IncrLexCounts& incrLexCounts = this->incrLexCounts[0];
+
   float initialNumer = model.variationalBayes ? (float)log(model.alpha) : SMALL_LG_NUM;
   // Update parameters
   for (unsigned int i = 0; i < incrLexCounts.size(); ++i)
@@ -202,8 +254,16 @@ float IncrIbm1AlignmentTrainer::obtainLogNewSuffStat(float lcurrSuffStat, float
   return lresult;
 }
 
+void IncrIbm1AlignmentTrainer::setHalfPrecision(bool halfPrecision)
+{
+  anji.set_half_precision(halfPrecision);
+  for (anjiMatrix& matrix : anji_aux)
+    matrix.set_half_precision(halfPrecision);
+}
+
 void IncrIbm1AlignmentTrainer::clear()
 {
-  anji_aux.clear();
+  for (anjiMatrix& matrix : anji_aux)
+    matrix.clear();
   incrLexCounts.clear();
 }
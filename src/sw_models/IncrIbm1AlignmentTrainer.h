@@ -11,15 +11,28 @@ public:
 
   void incrTrain(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity);
   virtual void clear();
+  // The auxiliary matrices use the same precision as anji, so that the
+  // statistics subtracted in later updates match the ones added now
+  void setHalfPrecision(bool halfPrecision);
 
   virtual ~IncrIbm1AlignmentTrainer()
   {
   }
 
 protected:
+  // Sentence pair whose entry in anji has already been initialized
+  struct IncrTrainSample
+  {
+    unsigned int mapped_n;
+    std::vector<WordIndex> nsrcSent;
+    std::vector<WordIndex> trgSent;
+    Count weight;
+  };
+
   // Incremental EM functions
   void calcNewLocalSuffStats(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity = 0);
-  void calc_anji(unsigned int n, const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
+  virtual void initThreadData(unsigned int numThreads);
+  void calc_anji(unsigned int mapped_n, const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
                  const Count& weight);
   virtual void incrUpdateCounts(unsigned int mapped_n, unsigned int mapped_n_aux, PositionIndex i, PositionIndex j,
                                 const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
@@ -27,11 +40,13 @@ protected:
   virtual void incrMaximizeProbs();
   float obtainLogNewSuffStat(float lcurrSuffStat, float lLocalSuffStatCurr, float lLocalSuffStatNew);
 
-  // Data structures for manipulating expected values
+  // Data structures for manipulating expected values, each thread
+  // has its own auxiliary matrix
   anjiMatrix& anji;
-  anjiMatrix anji_aux;
+  std::vector<anjiMatrix> anji_aux;
 
 private:
   Ibm1AlignmentModel& model;
-  IncrLexCounts incrLexCounts;
+  // Local sufficient statistics gathered by each thread
+  std::vector<IncrLexCounts> incrLexCounts;
 };
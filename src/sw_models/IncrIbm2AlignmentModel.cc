@@ -13,6 +13,17 @@ void IncrIbm2AlignmentModel::set_expval_maxnsize(unsigned int _anji_maxnsize)
   anji.set_maxnsize(_anji_maxnsize);
 }
 
+void IncrIbm2AlignmentModel::set_expval_half_precision(bool halfPrecision)
+{
+  trainer.setHalfPrecision(halfPrecision);
+}
+
+bool IncrIbm2AlignmentModel::set_expval_spill_file_prefix(const char* prefFileName)
+{
+  string spillFileName = prefFileName;
+  return anji.set_spill_file((spillFileName + ".anji.spill").c_str(), 1);
+}
+
 void IncrIbm2AlignmentModel::startIncrTraining(std::pair<unsigned int, unsigned int> sentPairRange, int verbosity)
 {
   clearTempVars();
@@ -30,26 +41,23 @@ void IncrIbm2AlignmentModel::endIncrTraining()
   clearTempVars();
 }
 
-bool IncrIbm2AlignmentModel::load(const char* prefFileName, int verbose)
+void IncrIbm2AlignmentModel::addLoadTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  bool retVal = Ibm2AlignmentModel::load(prefFileName, verbose);
-  if (retVal == THOT_ERROR)
-    return retVal;
-
-  // Load file with anji values
-  anji.load(prefFileName, verbose);
+  Ibm2AlignmentModel::addLoadTasks(prefFileName, verbose, tasks);
 
-  return THOT_OK;
+  tasks.push_back([this, prefFileName, verbose]() -> bool {
+    // Load file with anji values
+    anji.load(prefFileName.c_str(), verbose);
+    return THOT_OK;
+  });
 }
 
-bool IncrIbm2AlignmentModel::print(const char* prefFileName, int verbose)
+void IncrIbm2AlignmentModel::addPrintTasks(const string& prefFileName, int verbose, ModelTasks& tasks)
 {
-  bool retVal = Ibm2AlignmentModel::print(prefFileName, verbose);
-  if (retVal == THOT_ERROR)
-    return retVal;
+  Ibm2AlignmentModel::addPrintTasks(prefFileName, verbose, tasks);
 
   // Print file anji values
-  return anji.print(prefFileName);
+  tasks.push_back([this, prefFileName]() -> bool { return anji.print(prefFileName.c_str()); });
 }
 
 void IncrIbm2AlignmentModel::clear()
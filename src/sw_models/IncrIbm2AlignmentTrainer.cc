@@ -2,6 +2,8 @@
 
 #include "sw_models/SwDefs.h"
 
+#include <omp.h>
+
 using namespace std;
 
 IncrIbm2AlignmentTrainer::IncrIbm2AlignmentTrainer(Ibm2AlignmentModel& model, anjiMatrix& anji)
@@ -9,6 +11,13 @@ IncrIbm2AlignmentTrainer::IncrIbm2AlignmentTrainer(Ibm2AlignmentModel& model, an
 {
 }
 
+void IncrIbm2AlignmentTrainer::initThreadData(unsigned int numThreads)
+{
+  IncrIbm1AlignmentTrainer::initThreadData(numThreads);
+  if (incrAlignmentCounts.size() < numThreads)
+    incrAlignmentCounts.resize(numThreads);
+}
+
 void IncrIbm2AlignmentTrainer::incrUpdateCounts(unsigned int mapped_n, unsigned int mapped_n_aux, PositionIndex i,
                                                 PositionIndex j, const vector<WordIndex>& nsrcSent,
                                                 const vector<WordIndex>& trgSent, const Count& weight)
@@ -22,6 +31,9 @@ void IncrIbm2AlignmentTrainer::incrUpdateCountsAlig(unsigned int mapped_n, unsig
                                                     PositionIndex j, PositionIndex slen, PositionIndex tlen,
                                                     const Count& weight)
 {
+  anjiMatrix& anji_aux = this->anji_aux[omp_get_thread_num()];
+  IncrAlignmentCounts& incrAlignmentCounts = this->incrAlignmentCounts[omp_get_thread_num()];
+
   // Init vars
   float curr_anji = anji.get_fast(mapped_n, j, i);
   float weighted_curr_anji = 0;
@@ -69,8 +81,49 @@ void IncrIbm2AlignmentTrainer::incrMaximizeProbs()
   incrMaximizeProbsAlig();
 }
 
+void IncrIbm2AlignmentTrainer::mergeIncrAlignmentCounts()
+{
+  if (incrAlignmentCounts.empty())
+    return;
+
+  // Add the local sufficient statistics of every thread to the ones of the first thread
+  IncrAlignmentCounts& counts = incrAlignmentCounts[0];
+  for (size_t k = 1; k < incrAlignmentCounts.size(); ++k)
+  {
+    for (const auto& entry : incrAlignmentCounts[k])
+    {
+      IncrAlignmentCountsElem& elem = counts[entry.first];
+      while (elem.size() < entry.second.size())
+        elem.push_back(make_pair((float)SMALL_LG_NUM, (float)SMALL_LG_NUM));
+      for (PositionIndex i = 0; i < entry.second.size(); ++i)
+      {
+        const pair<float, float>& local = entry.second[i];
+        if (local.first == SMALL_LG_NUM && local.second == SMALL_LG_NUM)
+          continue;
+        pair<float, float>& p = elem[i];
+        if (p.first != SMALL_LG_NUM || p.second != SMALL_LG_NUM)
+        {
+          if (local.first != SMALL_LG_NUM)
+            p.first = MathFuncs::lns_sumlog_float(p.first, local.first);
+          p.second = MathFuncs::lns_sumlog_float(p.second, local.second);
+        }
+        else
+        {
+          p = local;
+        }
+      }
+    }
+    incrAlignmentCounts[k].clear();
+  }
+}
+
 void IncrIbm2AlignmentTrainer::incrMaximizeProbsAlig()
 {
+  TrainingPhaseTimer reductionTimer(model.trainingMetrics.reduction);
+  mergeIncrAlignmentCounts();
+  reductionTimer.stop();
+  IncrAlignmentCounts& incrAlignmentCounts = this->incrAlignmentCounts[0];
+
   // Update parameters
   for (IncrAlignmentCounts::iterator iter = incrAlignmentCounts.begin(); iter != incrAlignmentCounts.end(); ++iter)
   {
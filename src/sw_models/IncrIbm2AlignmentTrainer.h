@@ -15,6 +15,7 @@ public:
   }
 
 protected:
+  void initThreadData(unsigned int numThreads) override;
   void incrUpdateCounts(unsigned int mapped_n, unsigned int mapped_n_aux, PositionIndex i, PositionIndex j,
                         const std::vector<WordIndex>& nsrcSent, const std::vector<WordIndex>& trgSent,
                         const Count& weight) override;
@@ -22,11 +23,13 @@ protected:
                             PositionIndex slen, PositionIndex tlen, const Count& weight);
   void incrMaximizeProbs() override;
   void incrMaximizeProbsAlig();
+  void mergeIncrAlignmentCounts();
 
 private:
   typedef std::vector<std::pair<float, float>> IncrAlignmentCountsElem;
   typedef OrderedVector<AlignmentKey, IncrAlignmentCountsElem> IncrAlignmentCounts;
 
   Ibm2AlignmentModel& model;
-  IncrAlignmentCounts incrAlignmentCounts;
+  // Local sufficient statistics gathered by each thread
+  std::vector<IncrAlignmentCounts> incrAlignmentCounts;
 };
@@ -0,0 +1,47 @@
+#include "sw_models/LexCounts.h"
+
+#include "nlp_common/MathDefs.h"
+#include "nlp_common/MathFuncs.h"
+
+#include <algorithm>
+
+void mergeIncrLexCounts(std::vector<IncrLexCounts>& threadCounts)
+{
+  if (threadCounts.empty())
+    return;
+
+  IncrLexCounts& counts = threadCounts[0];
+  size_t numSrcWords = 0;
+  for (const IncrLexCounts& localCounts : threadCounts)
+    numSrcWords = std::max(numSrcWords, localCounts.size());
+  if (counts.size() < numSrcWords)
+    counts.resize(numSrcWords);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int s = 0; s < (int)numSrcWords; ++s)
+  {
+    for (size_t k = 1; k < threadCounts.size(); ++k)
+    {
+      if ((size_t)s >= threadCounts[k].size())
+        continue;
+
+      for (const auto& entry : threadCounts[k][s])
+      {
+        IncrLexCountsElem::iterator iter = counts[s].find(entry.first);
+        if (iter != counts[s].end())
+        {
+          if (entry.second.first != SMALL_LG_NUM)
+            iter->second.first = MathFuncs::lns_sumlog_float(iter->second.first, entry.second.first);
+          iter->second.second = MathFuncs::lns_sumlog_float(iter->second.second, entry.second.second);
+        }
+        else
+        {
+          counts[s][entry.first] = entry.second;
+        }
+      }
+    }
+  }
+
+  for (size_t k = 1; k < threadCounts.size(); ++k)
+    threadCounts[k].clear();
+}
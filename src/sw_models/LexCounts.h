@@ -1,7 +1,13 @@
 #pragma once
 
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/ModelContainer.h"
 #include "nlp_common/WordIndex.h"
 
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
 #ifdef THOT_DISABLE_SPACE_EFFICIENT_LEXDATA_STRUCTURES
 #include <unordered_map>
 #else
@@ -19,3 +25,55 @@ typedef std::vector<IncrLexCountsElem> IncrLexCounts;
 typedef OrderedVector<WordIndex, double> LexCountsElem;
 typedef std::vector<LexCountsElem> LexCounts;
 #endif
+
+// Binary format of the lexical counts in training checkpoints: the number of source
+// words, and for each one the number of entries followed by (target word, count) pairs
+inline void printLexCounts(std::ostream& out, const LexCounts& lexCounts)
+{
+  unsigned int numSrcWords = (unsigned int)lexCounts.size();
+  out.write((char*)&numSrcWords, sizeof(unsigned int));
+  for (const LexCountsElem& elem : lexCounts)
+  {
+    unsigned int numEntries = (unsigned int)elem.size();
+    out.write((char*)&numEntries, sizeof(unsigned int));
+    for (const auto& entry : elem)
+    {
+      out.write((char*)&entry.first, sizeof(WordIndex));
+      out.write((char*)&entry.second, sizeof(double));
+    }
+  }
+}
+
+// Word ids outside the vocabularies of the model are rejected, since training indexes
+// its tables with them
+inline bool loadLexCounts(MemoryInputStream& in, std::size_t srcVocabSize, std::size_t trgVocabSize,
+                          LexCounts& lexCounts)
+{
+  // Every source word stores at least the number of its entries
+  unsigned int numSrcWords;
+  if (!in.read((char*)&numSrcWords, sizeof(unsigned int)) || numSrcWords > srcVocabSize
+      || !in.canRead(numSrcWords, sizeof(unsigned int)))
+    return THOT_ERROR;
+  lexCounts.clear();
+  lexCounts.resize(numSrcWords);
+  for (LexCountsElem& elem : lexCounts)
+  {
+    unsigned int numEntries;
+    if (!in.read((char*)&numEntries, sizeof(unsigned int)))
+      return THOT_ERROR;
+    for (unsigned int k = 0; k < numEntries; ++k)
+    {
+      WordIndex t;
+      double count;
+      in.read((char*)&t, sizeof(WordIndex));
+      if (!in.read((char*)&count, sizeof(double)) || t >= trgVocabSize)
+        return THOT_ERROR;
+      elem[t] = count;
+    }
+  }
+  return THOT_OK;
+}
+
+// Adds the local sufficient statistics of an incremental E-step gathered by
+// each thread to the ones of the first thread, leaving the others empty
+void mergeIncrLexCounts(std::vector<IncrLexCounts>& threadCounts);
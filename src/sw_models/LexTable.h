@@ -2,6 +2,7 @@
 
 #include "nlp_common/WordIndex.h"
 
+#include <iostream>
 #include <set>
 #include <vector>
 
@@ -22,6 +23,10 @@ public:
 
   virtual bool print(const char* lexNumDenFile, int verbose = 0) const = 0;
 
+  // Binary format, whatever the format of the files is
+  virtual bool load(std::istream& in) = 0;
+  virtual bool print(std::ostream& out) const = 0;
+
   virtual void reserveSpace(WordIndex s) = 0;
 
   virtual void clear() = 0;
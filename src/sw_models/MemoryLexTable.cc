@@ -1,8 +1,10 @@
 #include "sw_models/MemoryLexTable.h"
 
-#include "nlp_common/AwkInputStream.h"
 #include "nlp_common/ErrorDefs.h"
+#include "nlp_common/MappedFile.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 
 using namespace std;
@@ -97,9 +99,6 @@ bool MemoryLexTable::load(const char* lexNumDenFile, int verbose)
 
 bool MemoryLexTable::loadBin(const char* lexNumDenFile, int verbose)
 {
-  // Clear data structures
-  clear();
-
   if (verbose)
     cerr << "Loading lexnd file in binary format from " << lexNumDenFile << endl;
 
@@ -113,26 +112,33 @@ bool MemoryLexTable::loadBin(const char* lexNumDenFile, int verbose)
   }
   else
   {
-    // Read register
-    bool end = false;
-    while (!end)
+    return load(inF);
+  }
+}
+
+bool MemoryLexTable::load(istream& in)
+{
+  clear();
+
+  // Read register
+  bool end = false;
+  while (!end)
+  {
+    WordIndex s;
+    WordIndex t;
+    float numer;
+    float denom;
+    if (in.read((char*)&s, sizeof(WordIndex)))
     {
-      WordIndex s;
-      WordIndex t;
-      float numer;
-      float denom;
-      if (inF.read((char*)&s, sizeof(WordIndex)))
-      {
-        inF.read((char*)&t, sizeof(WordIndex));
-        inF.read((char*)&numer, sizeof(float));
-        inF.read((char*)&denom, sizeof(float));
-        set(s, t, numer, denom);
-      }
-      else
-        end = true;
+      in.read((char*)&t, sizeof(WordIndex));
+      in.read((char*)&numer, sizeof(float));
+      in.read((char*)&denom, sizeof(float));
+      set(s, t, numer, denom);
     }
-    return THOT_OK;
+    else
+      end = true;
   }
+  return THOT_OK;
 }
 
 bool MemoryLexTable::loadPlainText(const char* lexNumDenFile, int verbose)
@@ -143,28 +149,75 @@ bool MemoryLexTable::loadPlainText(const char* lexNumDenFile, int verbose)
   if (verbose)
     cerr << "Loading lexnd file in plain text format from " << lexNumDenFile << endl;
 
-  AwkInputStream awk;
-  if (awk.open(lexNumDenFile) == THOT_ERROR)
+  MappedFile file;
+  if (file.open(lexNumDenFile) == THOT_ERROR)
   {
     if (verbose)
       cerr << "Error in file with lexical parameters, file " << lexNumDenFile << " does not exist.\n";
     return THOT_ERROR;
   }
-  else
+
+  // The file is split into chunks on line boundaries. The chunks are parsed in parallel, and
+  // their entries are then inserted in file order
+  const char* data = file.data();
+  size_t size = file.size();
+  size_t numChunks = size / PlainTextChunkSize + 1;
+  vector<size_t> chunkStarts(numChunks + 1, size);
+  chunkStarts[0] = 0;
+  for (size_t k = 1; k < numChunks; ++k)
   {
-    // Read gaussian parameters
-    while (awk.getln())
+    size_t pos = max(k * PlainTextChunkSize, chunkStarts[k - 1]);
+    while (pos < size && data[pos - 1] != '\n')
+      ++pos;
+    chunkStarts[k] = pos;
+  }
+
+  vector<vector<LexNumDenEntry>> chunkEntries(numChunks);
+#pragma omp parallel for schedule(dynamic)
+  for (long long k = 0; k < (long long)numChunks; ++k)
+    parsePlainTextLines(data + chunkStarts[k], data + chunkStarts[k + 1], chunkEntries[k]);
+
+  for (const vector<LexNumDenEntry>& entries : chunkEntries)
+  {
+    for (const LexNumDenEntry& entry : entries)
+      set(entry.s, entry.t, entry.numer, entry.denom);
+  }
+  return THOT_OK;
+}
+
+void MemoryLexTable::parsePlainTextLines(const char* begin, const char* end, vector<LexNumDenEntry>& entries)
+{
+  string fields[4];
+  const char* pos = begin;
+  while (pos < end)
+  {
+    // Split line into fields, only lines with four fields are taken into account
+    unsigned int numFields = 0;
+    while (pos < end && *pos != '\n')
     {
-      if (awk.NF == 4)
+      if (*pos == ' ' || *pos == '\t' || *pos == '\r')
       {
-        WordIndex s = atoi(awk.dollar(1).c_str());
-        WordIndex t = atoi(awk.dollar(2).c_str());
-        float numer = (float)atof(awk.dollar(3).c_str());
-        float denom = (float)atof(awk.dollar(4).c_str());
-        set(s, t, numer, denom);
+        ++pos;
+        continue;
       }
+      const char* fieldStart = pos;
+      while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n')
+        ++pos;
+      if (numFields < 4)
+        fields[numFields].assign(fieldStart, pos);
+      ++numFields;
+    }
+    ++pos;
+
+    if (numFields == 4)
+    {
+      LexNumDenEntry entry;
+      entry.s = atoi(fields[0].c_str());
+      entry.t = atoi(fields[1].c_str());
+      entry.numer = (float)atof(fields[2].c_str());
+      entry.denom = (float)atof(fields[3].c_str());
+      entries.push_back(entry);
     }
-    return THOT_OK;
   }
 }
 
@@ -189,22 +242,27 @@ bool MemoryLexTable::printBin(const char* lexNumDenFile, int verbose) const
   }
   else
   {
-    // print file with lexical nd values
-    for (WordIndex s = 0; s < numerators.size(); ++s)
+    return print(outF);
+  }
+}
+
+bool MemoryLexTable::print(ostream& out) const
+{
+  // print file with lexical nd values
+  for (WordIndex s = 0; s < numerators.size(); ++s)
+  {
+    NumeratorsElem::const_iterator numElemIter;
+    for (numElemIter = numerators[s].begin(); numElemIter != numerators[s].end(); ++numElemIter)
     {
-      NumeratorsElem::const_iterator numElemIter;
-      for (numElemIter = numerators[s].begin(); numElemIter != numerators[s].end(); ++numElemIter)
-      {
-        bool found;
-        outF.write((char*)&s, sizeof(WordIndex));
-        outF.write((char*)&numElemIter->first, sizeof(WordIndex));
-        outF.write((char*)&numElemIter->second, sizeof(float));
-        float denom = getDenominator(s, found);
-        outF.write((char*)&denom, sizeof(float));
-      }
+      bool found;
+      out.write((char*)&s, sizeof(WordIndex));
+      out.write((char*)&numElemIter->first, sizeof(WordIndex));
+      out.write((char*)&numElemIter->second, sizeof(float));
+      float denom = getDenominator(s, found);
+      out.write((char*)&denom, sizeof(float));
     }
-    return THOT_OK;
   }
+  return THOT_OK;
 }
 
 bool MemoryLexTable::printPlainText(const char* lexNumDenFile, int verbose) const
@@ -28,6 +28,9 @@ public:
 
   bool print(const char* lexNumDenFile, int verbose = 0) const override;
 
+  bool load(std::istream& in) override;
+  bool print(std::ostream& out) const override;
+
   void reserveSpace(WordIndex s) override;
 
   void clear() override;
@@ -48,9 +51,21 @@ protected:
   Numerators numerators;
   Denominators denominators;
 
+  struct LexNumDenEntry
+  {
+    WordIndex s;
+    WordIndex t;
+    float numer;
+    float denom;
+  };
+
+  // Size of the chunks of plain text files that are parsed in parallel
+  static const std::size_t PlainTextChunkSize = 1 << 20;
+
   // load and print auxiliary functions
   bool loadBin(const char* lexNumDenFile, int verbose);
   bool loadPlainText(const char* lexNumDenFile, int verbose);
+  static void parsePlainTextLines(const char* begin, const char* end, std::vector<LexNumDenEntry>& entries);
   bool printBin(const char* lexNumDenFile, int verbose) const;
   bool printPlainText(const char* lexNumDenFile, int verbose) const;
 };
@@ -90,8 +90,6 @@ void NonheadDistortionTable::clear()
 
 bool NonheadDistortionTable::loadBin(const char* tableFile, int verbose)
 {
-  clear();
-
   if (verbose)
     std::cerr << "Loading nonhead distortion nd file in binary format from " << tableFile << std::endl;
 
@@ -103,6 +101,13 @@ bool NonheadDistortionTable::loadBin(const char* tableFile, int verbose)
     return THOT_ERROR;
   }
 
+  return load(inF);
+}
+
+bool NonheadDistortionTable::load(std::istream& in)
+{
+  clear();
+
   bool end = false;
   while (!end)
   {
@@ -110,11 +115,11 @@ bool NonheadDistortionTable::loadBin(const char* tableFile, int verbose)
     int dj;
     float numer;
     float denom;
-    if (inF.read((char*)&targetWordClass, sizeof(WordClassIndex)))
+    if (in.read((char*)&targetWordClass, sizeof(WordClassIndex)))
     {
-      inF.read((char*)&dj, sizeof(int));
-      inF.read((char*)&numer, sizeof(float));
-      inF.read((char*)&denom, sizeof(float));
+      in.read((char*)&dj, sizeof(int));
+      in.read((char*)&numer, sizeof(float));
+      in.read((char*)&denom, sizeof(float));
       set(targetWordClass, dj, numer, denom);
     }
     else
@@ -162,16 +167,21 @@ bool NonheadDistortionTable::printBin(const char* tableFile) const
     return THOT_ERROR;
   }
 
+  return print(outF);
+}
+
+bool NonheadDistortionTable::print(std::ostream& out) const
+{
   for (WordClassIndex targetWordClass = 0; targetWordClass < numerators.size(); ++targetWordClass)
   {
     for (auto& numPair : numerators[targetWordClass])
     {
-      outF.write((char*)&targetWordClass, sizeof(WordClassIndex));
-      outF.write((char*)&numPair.first, sizeof(int));
-      outF.write((char*)&numPair.second, sizeof(float));
+      out.write((char*)&targetWordClass, sizeof(WordClassIndex));
+      out.write((char*)&numPair.first, sizeof(int));
+      out.write((char*)&numPair.second, sizeof(float));
       bool found;
       float denom = getDenominator(targetWordClass, found);
-      outF.write((char*)&denom, sizeof(float));
+      out.write((char*)&denom, sizeof(float));
     }
   }
   return THOT_OK;
@@ -4,6 +4,7 @@
 #include "nlp_common/PositionIndex.h"
 #include "nlp_common/WordClasses.h"
 
+#include <iostream>
 #include <unordered_map>
 #include <vector>
 
@@ -22,6 +23,8 @@ public:
 
   bool load(const char* tableFile, int verbose = 0);
   bool print(const char* tableFile) const;
+  bool load(std::istream& in);
+  bool print(std::ostream& out) const;
 
   void clear();
 
@@ -55,6 +55,42 @@ bool NormalSentenceLengthModel::print(const char* filename)
   }
 }
 
+bool NormalSentenceLengthModel::load(std::istream& in, int verbose)
+{
+  clear();
+
+  std::string line;
+  if (!std::getline(in, line))
+    return THOT_OK;
+  if (line.compare(0, 8, "Weighted") != 0)
+  {
+    if (verbose)
+      std::cerr << "Anomalous sentence length model stream\n";
+    return THOT_ERROR;
+  }
+
+  // Read average lengths from second line
+  std::string numSentsLabel, slenSumLabel, tlenSumLabel, sep;
+  if (!(in >> numSentsLabel >> numSents >> sep >> slenSumLabel >> slenSum >> sep >> tlenSumLabel >> tlenSum))
+  {
+    if (verbose)
+      std::cerr << "Anomalous sentence length model stream!" << std::endl;
+    return THOT_ERROR;
+  }
+
+  // Read gaussian parameters
+  unsigned int slen, k_slen;
+  double swk_slen, mk_slen, sk_slen;
+  while (in >> slen >> k_slen >> swk_slen >> mk_slen >> sk_slen)
+  {
+    set_k(slen, k_slen);
+    set_swk(slen, (float)swk_slen);
+    set_mk(slen, (float)mk_slen);
+    set_sk(slen, (float)sk_slen);
+  }
+  return THOT_OK;
+}
+
 std::ostream& NormalSentenceLengthModel::print(std::ostream& outS)
 {
   // print header
@@ -20,6 +20,10 @@ public:
   // Print model parameters
   bool print(const char* filename) override;
 
+  // Stream versions, using the same text format as the files
+  bool load(std::istream& in, int verbose = 0);
+  std::ostream& print(std::ostream& outS);
+
   // Sentence length model functions
 
   // returns p(tl=tlen|sl=slen)
@@ -48,7 +52,6 @@ protected:
   std::vector<float> skVec;
 
   // Auxiliary functions
-  std::ostream& print(std::ostream& outS);
   LgProb sentLenLgProbNorm(unsigned int slen, unsigned int tlen);
   Prob sumSentLenProbNorm(unsigned int slen, unsigned int tlen);
   bool readNormalPars(const char* normParsFileName, int verbose);
@@ -4,3 +4,7 @@
 
 constexpr double SW_PROB_SMOOTH = 1e-7;
 const double SW_LOG_PROB_SMOOTH = log(SW_PROB_SMOOTH);
+
+// Maximum number of sentence pairs processed in parallel at a time by the
+// incremental trainers
+constexpr unsigned int SW_INCR_TRAIN_CHUNK_SIZE = 10000;
@@ -45,51 +45,118 @@ LgProb SymmetrizedAligner::getBestAlignment(const vector<WordIndex>& srcSentence
   WordAlignmentMatrix invMatrix;
   LgProb invLogProb = inverseAligner->getBestAlignment(trgSentence, srcSentence, invMatrix);
   invMatrix.transpose();
+  symmetrize(bestWaMatrix, invMatrix);
+  return max(logProb, invLogProb);
+}
+
+void SymmetrizedAligner::getBestAlignments(const WordIndex* srcWordIndices, const size_t* srcOffsets,
+                                           const WordIndex* trgWordIndices, const size_t* trgOffsets, size_t numPairs,
+                                           LgProb* logProbs, WordAlignmentMatrix* waMatrices)
+{
+  if (heuristic == SymmetrizationHeuristic::None)
+  {
+    directAligner->getBestAlignments(srcWordIndices, srcOffsets, trgWordIndices, trgOffsets, numPairs, logProbs,
+                                     waMatrices);
+    return;
+  }
+
+  vector<LgProb> invLogProbs(numPairs);
+  vector<WordAlignmentMatrix> invMatrices(numPairs);
+#pragma omp parallel
+  {
+    // Even jobs run the direct aligner and odd jobs the inverse one
+#pragma omp for schedule(dynamic)
+    for (long long job = 0; job < 2 * (long long)numPairs; ++job)
+    {
+      size_t k = (size_t)job / 2;
+      vector<WordIndex> srcSentence(srcWordIndices + srcOffsets[k], srcWordIndices + srcOffsets[k + 1]);
+      vector<WordIndex> trgSentence(trgWordIndices + trgOffsets[k], trgWordIndices + trgOffsets[k + 1]);
+      if (job % 2 == 0)
+        logProbs[k] = directAligner->getBestAlignment(srcSentence, trgSentence, waMatrices[k]);
+      else
+        invLogProbs[k] = inverseAligner->getBestAlignment(trgSentence, srcSentence, invMatrices[k]);
+    }
+
+#pragma omp for schedule(dynamic)
+    for (long long k = 0; k < (long long)numPairs; ++k)
+    {
+      invMatrices[k].transpose();
+      symmetrize(waMatrices[k], invMatrices[k]);
+      logProbs[k] = max(logProbs[k], invLogProbs[k]);
+    }
+  }
+}
+
+void SymmetrizedAligner::symmetrize(WordAlignmentMatrix& waMatrix, const WordAlignmentMatrix& invWaMatrix) const
+{
   switch (heuristic)
   {
   case SymmetrizationHeuristic::Union:
-    bestWaMatrix |= invMatrix;
+    waMatrix |= invWaMatrix;
     break;
   case SymmetrizationHeuristic::Intersection:
-    bestWaMatrix &= invMatrix;
+    waMatrix &= invWaMatrix;
     break;
   case SymmetrizationHeuristic::Och:
-    bestWaMatrix.symmetr1(invMatrix);
+    waMatrix.symmetr1(invWaMatrix);
     break;
   case SymmetrizationHeuristic::Grow:
-    bestWaMatrix.grow(invMatrix);
+    waMatrix.grow(invWaMatrix);
     break;
   case SymmetrizationHeuristic::GrowDiag:
-    bestWaMatrix.growDiag(invMatrix);
+    waMatrix.growDiag(invWaMatrix);
     break;
   case SymmetrizationHeuristic::GrowDiagFinal:
-    bestWaMatrix.growDiagFinal(invMatrix);
+    waMatrix.growDiagFinal(invWaMatrix);
     break;
   case SymmetrizationHeuristic::GrowDiagFinalAnd:
-    bestWaMatrix.growDiagFinalAnd(invMatrix);
+    waMatrix.growDiagFinalAnd(invWaMatrix);
     break;
   case SymmetrizationHeuristic::None:
     break;
   }
-  return max(logProb, invLogProb);
 }
 
-WordIndex SymmetrizedAligner::stringToSrcWordIndex(string s) const
+WordIndex SymmetrizedAligner::stringToSrcWordIndex(const string& s) const
 {
   return directAligner->stringToSrcWordIndex(s);
 }
 
-vector<WordIndex> SymmetrizedAligner::strVectorToSrcIndexVector(vector<string> s)
+vector<WordIndex> SymmetrizedAligner::strVectorToSrcIndexVector(const vector<string>& s)
 {
   return directAligner->strVectorToSrcIndexVector(s);
 }
 
-WordIndex SymmetrizedAligner::stringToTrgWordIndex(string t) const
+void SymmetrizedAligner::encodeSrcSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                            const size_t* wordOffsets, WordIndex* wordIndices) const
+{
+  directAligner->encodeSrcSentences(buffer, sentenceOffsets, numSentences, wordOffsets, wordIndices);
+}
+
+void SymmetrizedAligner::encodeSrcTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                                         WordIndex* wordIndices) const
+{
+  directAligner->encodeSrcTokens(tokens, tokenLengths, numTokens, wordIndices);
+}
+
+WordIndex SymmetrizedAligner::stringToTrgWordIndex(const string& t) const
 {
   return directAligner->stringToTrgWordIndex(t);
 }
 
-vector<WordIndex> SymmetrizedAligner::strVectorToTrgIndexVector(vector<string> t)
+vector<WordIndex> SymmetrizedAligner::strVectorToTrgIndexVector(const vector<string>& t)
 {
   return directAligner->strVectorToTrgIndexVector(t);
 }
+
+void SymmetrizedAligner::encodeTrgSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                                            const size_t* wordOffsets, WordIndex* wordIndices) const
+{
+  directAligner->encodeTrgSentences(buffer, sentenceOffsets, numSentences, wordOffsets, wordIndices);
+}
+
+void SymmetrizedAligner::encodeTrgTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                                         WordIndex* wordIndices) const
+{
+  directAligner->encodeTrgTokens(tokens, tokenLengths, numTokens, wordIndices);
+}
@@ -27,18 +27,33 @@ public:
                           WordAlignmentMatrix& bestWaMatrix) override;
   LgProb getBestAlignment(const std::vector<WordIndex>& srcSentence, const std::vector<WordIndex>& trgSentence,
                           WordAlignmentMatrix& bestWaMatrix) override;
-
-  WordIndex stringToSrcWordIndex(std::string s) const override;
-  std::vector<WordIndex> strVectorToSrcIndexVector(std::vector<std::string> s) override;
-
-  WordIndex stringToTrgWordIndex(std::string t) const override;
-  std::vector<WordIndex> strVectorToTrgIndexVector(std::vector<std::string> t) override;
+  // Direct and inverse alignments of all the pairs are scheduled as
+  // independent jobs on the same OpenMP thread team, then symmetrized
+  void getBestAlignments(const WordIndex* srcWordIndices, const size_t* srcOffsets, const WordIndex* trgWordIndices,
+                         const size_t* trgOffsets, size_t numPairs, LgProb* logProbs,
+                         WordAlignmentMatrix* waMatrices) override;
+
+  WordIndex stringToSrcWordIndex(const std::string& s) const override;
+  std::vector<WordIndex> strVectorToSrcIndexVector(const std::vector<std::string>& s) override;
+  void encodeSrcSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                          const size_t* wordOffsets, WordIndex* wordIndices) const override;
+  void encodeSrcTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                       WordIndex* wordIndices) const override;
+
+  WordIndex stringToTrgWordIndex(const std::string& t) const override;
+  std::vector<WordIndex> strVectorToTrgIndexVector(const std::vector<std::string>& t) override;
+  void encodeTrgSentences(const char* buffer, const size_t* sentenceOffsets, size_t numSentences,
+                          const size_t* wordOffsets, WordIndex* wordIndices) const override;
+  void encodeTrgTokens(const char* const* tokens, const size_t* tokenLengths, size_t numTokens,
+                       WordIndex* wordIndices) const override;
 
   virtual ~SymmetrizedAligner()
   {
   }
 
 private:
+  void symmetrize(WordAlignmentMatrix& waMatrix, const WordAlignmentMatrix& invWaMatrix) const;
+
   std::shared_ptr<Aligner> directAligner;
   std::shared_ptr<Aligner> inverseAligner;
 
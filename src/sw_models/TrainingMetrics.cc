@@ -0,0 +1,101 @@
+#include "sw_models/TrainingMetrics.h"
+
+#include "nlp_common/ctimer.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+void readTimes(double& wallTime, double& cpuTime)
+{
+  double ucpu = 0;
+  double scpu = 0;
+  ctimer(&wallTime, &ucpu, &scpu);
+  cpuTime = ucpu + scpu;
+}
+
+void printPhase(const char* name, const TrainingPhaseMetrics& phase, ostream& out)
+{
+  out << ",\"" << name << "\":{\"count\":" << phase.count << ",\"wall_time\":" << phase.wallTime
+      << ",\"cpu_time\":" << phase.cpuTime << "}";
+}
+} // namespace
+
+double TrainingMetrics::tokensPerSecond() const
+{
+  if (eStep.wallTime <= 0)
+    return 0;
+  return numTokens / eStep.wallTime;
+}
+
+void TrainingMetrics::printJsonLine(const char* event, ostream& out) const
+{
+  streamsize precision = out.precision(10);
+  out << "{\"event\":\"" << event << "\"";
+  printPhase("start_training", startTraining, out);
+  printPhase("iteration", iteration, out);
+  printPhase("io", io, out);
+  printPhase("e_step", eStep, out);
+  printPhase("m_step", mStep, out);
+  printPhase("reduction", reduction, out);
+  printPhase("load", load, out);
+  printPhase("save", save, out);
+  out << ",\"num_tokens\":" << numTokens << ",\"tokens_per_second\":" << tokensPerSecond()
+      << ",\"peak_rss\":" << peakRss << ",\"src_vocab_size\":" << srcVocabSize << ",\"trg_vocab_size\":" << trgVocabSize
+      << ",\"num_sentence_pairs\":" << numSentencePairs << ",\"num_lex_counts\":" << numLexCounts << "}\n";
+  out.precision(precision);
+}
+
+TrainingPhaseTimer::TrainingPhaseTimer(TrainingPhaseMetrics& phase)
+    : phase{phase}, outermost{phase.depth == 0}, running{true}, startWallTime{0}, startCpuTime{0}
+{
+  ++phase.depth;
+  if (outermost)
+    readTimes(startWallTime, startCpuTime);
+}
+
+void TrainingPhaseTimer::stop()
+{
+  if (!running)
+    return;
+  running = false;
+  --phase.depth;
+  if (outermost)
+  {
+    double wallTime, cpuTime;
+    readTimes(wallTime, cpuTime);
+    ++phase.count;
+    phase.wallTime += wallTime - startWallTime;
+    phase.cpuTime += cpuTime - startCpuTime;
+  }
+}
+
+bool TrainingPhaseTimer::isOutermost() const
+{
+  return outermost;
+}
+
+TrainingPhaseTimer::~TrainingPhaseTimer()
+{
+  stop();
+}
+
+size_t getPeakRss()
+{
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return (size_t)usage.ru_maxrss;
+#else
+  return (size_t)usage.ru_maxrss * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+// Time spent in one phase of training, added up over all the runs of the phase
+struct TrainingPhaseMetrics
+{
+  unsigned int count = 0;
+  // Elapsed time in seconds
+  double wallTime = 0;
+  // User and system time in seconds of all the threads of the process
+  double cpuTime = 0;
+  // Timers of the phase that are running, only the outermost one is added
+  unsigned int depth = 0;
+};
+
+// Instrumentation of the training of an alignment model
+struct TrainingMetrics
+{
+  TrainingPhaseMetrics startTraining;
+  // One run per call to train() or incrTrain()
+  TrainingPhaseMetrics iteration;
+  // Reading and encoding of the training sentence pairs
+  TrainingPhaseMetrics io;
+  TrainingPhaseMetrics eStep;
+  TrainingPhaseMetrics mStep;
+  // Merging of the statistics gathered by every thread, it is a part of the M-step
+  // of the incremental trainers
+  TrainingPhaseMetrics reduction;
+  TrainingPhaseMetrics load;
+  TrainingPhaseMetrics save;
+
+  // Source and target tokens processed by the E-steps
+  unsigned long long numTokens = 0;
+  // Peak resident set size of the process in bytes, 0 where it cannot be measured
+  std::size_t peakRss = 0;
+  std::size_t srcVocabSize = 0;
+  std::size_t trgVocabSize = 0;
+  std::size_t numSentencePairs = 0;
+  // Entries of the lexical counts kept between startTraining() and endTraining()
+  std::size_t numLexCounts = 0;
+
+  // Tokens processed per second of E-step
+  double tokensPerSecond() const;
+  // Prints the metrics as a single-line JSON object, tagged with the given event name
+  void printJsonLine(const char* event, std::ostream& out) const;
+};
+
+// Adds the wall and CPU time measured with ctimer() between its construction and
+// stop() to a phase. A timer started while another timer of the same phase is
+// running, as happens when a model class calls the function of its base class, adds
+// nothing
+class TrainingPhaseTimer
+{
+public:
+  TrainingPhaseTimer(TrainingPhaseMetrics& phase);
+  TrainingPhaseTimer(const TrainingPhaseTimer&) = delete;
+  TrainingPhaseTimer& operator=(const TrainingPhaseTimer&) = delete;
+
+  void stop();
+  bool isOutermost() const;
+
+  ~TrainingPhaseTimer();
+
+private:
+  TrainingPhaseMetrics& phase;
+  bool outermost;
+  bool running;
+  double startWallTime;
+  double startCpuTime;
+};
+
+// Returns the peak resident set size of the process in bytes, or 0 if it is not
+// available
+std::size_t getPeakRss();
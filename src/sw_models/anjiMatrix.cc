@@ -30,6 +30,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 #include "nlp_common/ErrorDefs.h"
 #include "nlp_common/MathDefs.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -59,19 +60,13 @@ bool anjiMatrix::init_nth_entry(unsigned int n, PositionIndex nslen, PositionInd
     map_n_in_matrix(n, mapped_n);
 
     // Check if it is required to grow in the dimension of n
-    if (anji.size() <= mapped_n)
-    {
-      anji.resize(mapped_n + 1);
-    }
+    anji.grow(mapped_n + 1);
 
     // Check if entry has enough room
     if (resizeIsRequired(mapped_n, nslen, tlen))
     {
-      anji[mapped_n].clear();
-
       // Initialize data structure for entry
-      std::vector<float> floatVec(nslen + 1, INVALID_ANJI_VAL);
-      anji[mapped_n].resize(tlen + 1, floatVec);
+      anji.allocate(mapped_n, tlen + 1, nslen + 1, 1, INVALID_ANJI_VAL);
     }
 
     return THOT_OK;
@@ -86,10 +81,10 @@ bool anjiMatrix::resizeIsRequired(unsigned int mapped_n, PositionIndex nslen, Po
   if (anji.size() <= mapped_n)
     return true;
 
-  if (anji[mapped_n].size() <= tlen)
+  if (anji.dim(mapped_n, 0) <= tlen)
     return true;
 
-  if (anji[mapped_n][0].size() <= nslen)
+  if (anji.dim(mapped_n, 1) <= nslen)
     return true;
 
   return false;
@@ -101,13 +96,7 @@ bool anjiMatrix::reset_entries(void)
   if (anji_maxnsize > 0)
   {
     // Reset values
-    for (unsigned int n = 0; n < anji.size(); ++n)
-    {
-      for (unsigned int j = 0; j < anji[n].size(); ++j)
-      {
-        std::fill(anji[n][j].begin(), anji[n][j].end(), (float)INVALID_ANJI_VAL);
-      }
-    }
+    anji.fill(INVALID_ANJI_VAL);
 
     return THOT_OK;
   }
@@ -128,6 +117,26 @@ unsigned int anjiMatrix::get_maxnsize(void)
   return anji_maxnsize;
 }
 
+//-------------------------
+void anjiMatrix::set_half_precision(bool halfPrecision)
+{
+  clear();
+  anji.setHalfPrecision(halfPrecision);
+}
+
+//-------------------------
+bool anjiMatrix::get_half_precision(void)
+{
+  return anji.getHalfPrecision();
+}
+
+//-------------------------
+bool anjiMatrix::set_spill_file(const char* spillFileName, int verbose /*=0*/)
+{
+  clear();
+  return anji.setSpillFile(spillFileName, verbose);
+}
+
 //-------------------------
 unsigned int anjiMatrix::n_size(void)
 {
@@ -137,13 +146,13 @@ unsigned int anjiMatrix::n_size(void)
 //-------------------------
 unsigned int anjiMatrix::nj_size(unsigned int n)
 {
-  return anji[n].size();
+  return anji.dim(n, 0);
 }
 
 //-------------------------
 unsigned int anjiMatrix::nji_size(unsigned int n, unsigned int j)
 {
-  return anji[n][j].size();
+  return anji.dim(n, 1);
 }
 
 //-------------------------
@@ -188,24 +197,29 @@ bool anjiMatrix::load_anji_values(const char* anjiFile, int verbose)
   }
   else
   {
-    // Read register
+    // Read registers, the registers of each sample are stored
+    // together in a single block of the arena
+    std::vector<AnjiRegister> registers;
     bool end = false;
     while (!end)
     {
-      unsigned int n;
-      unsigned int j;
-      unsigned int i;
-      float f;
-      if (inF.read((char*)&n, sizeof(unsigned int)))
+      AnjiRegister reg;
+      if (inF.read((char*)&reg.n, sizeof(unsigned int)))
       {
-        inF.read((char*)&j, sizeof(unsigned int));
-        inF.read((char*)&i, sizeof(unsigned int));
-        inF.read((char*)&f, sizeof(float));
-        set(n, j, i, f);
+        inF.read((char*)&reg.j, sizeof(unsigned int));
+        inF.read((char*)&reg.i, sizeof(unsigned int));
+        inF.read((char*)&reg.f, sizeof(float));
+        if (!registers.empty() && registers.back().n != reg.n)
+        {
+          set_registers(registers);
+          registers.clear();
+        }
+        registers.push_back(reg);
       }
       else
         end = true;
     }
+    set_registers(registers);
     return THOT_OK;
   }
 }
@@ -284,14 +298,15 @@ bool anjiMatrix::print_anji_values(const char* anjiFile)
     // print file with anji values
     for (unsigned int n = 0; n < anji.size(); ++n)
     {
-      for (unsigned int j = 0; j < anji[n].size(); ++j)
+      for (unsigned int j = 0; j < anji.dim(n, 0); ++j)
       {
-        for (unsigned int i = 0; i < anji[n][j].size(); ++i)
+        for (unsigned int i = 0; i < anji.dim(n, 1); ++i)
         {
+          float f = anji.get(n, j, i, 0);
           outF.write((char*)&n, sizeof(unsigned int));
           outF.write((char*)&j, sizeof(unsigned int));
           outF.write((char*)&i, sizeof(unsigned int));
-          outF.write((char*)&anji[n][j][i], sizeof(float));
+          outF.write((char*)&f, sizeof(float));
         }
       }
     }
@@ -334,26 +349,41 @@ void anjiMatrix::set(unsigned int n, unsigned int j, unsigned int i, float f)
     map_n_in_matrix(n, np);
 
     // Grow in the dimension of np if necessary
-    while (anji.size() <= np)
-    {
-      std::vector<std::vector<float>> aji;
-      anji.push_back(aji);
-    }
+    anji.grow(np + 1);
 
-    // Grow in the dimension of j if necessary
-    while (anji[np].size() <= j)
+    // Grow in the dimensions of j and i if necessary
+    if (anji.dim(np, 0) <= j || anji.dim(np, 1) <= i)
     {
-      std::vector<float> ai;
-      anji[np].push_back(ai);
+      anji.reshape(np, std::max(anji.dim(np, 0), j + 1), std::max(anji.dim(np, 1), i + 1), 1, INVALID_ANJI_VAL);
     }
 
-    // Grow in the dimension of i if necessary
-    while (anji[np][j].size() <= i)
+    // Set value
+    anji.set(np, j, i, 0, f);
+  }
+}
+
+//-------------------------
+void anjiMatrix::set_registers(const std::vector<AnjiRegister>& registers)
+{
+  if (anji_maxnsize > 0 && !registers.empty())
+  {
+    unsigned int np;
+    map_n_in_matrix(registers[0].n, np);
+    anji.grow(np + 1);
+
+    // Grow the entry once for all the registers
+    unsigned int jsize = anji.dim(np, 0);
+    unsigned int isize = anji.dim(np, 1);
+    for (const AnjiRegister& reg : registers)
     {
-      anji[np][j].push_back(INVALID_ANJI_VAL);
+      jsize = std::max(jsize, reg.j + 1);
+      isize = std::max(isize, reg.i + 1);
     }
-    // Set value
-    anji[np][j][i] = f;
+    anji.reshape(np, jsize, isize, 1, INVALID_ANJI_VAL);
+
+    // Set values
+    for (const AnjiRegister& reg : registers)
+      anji.set(np, reg.j, reg.i, 0, reg.f);
   }
 }
 
@@ -361,7 +391,7 @@ void anjiMatrix::set(unsigned int n, unsigned int j, unsigned int i, float f)
 void anjiMatrix::set_fast(unsigned int mapped_n, unsigned int j, unsigned int i, float f)
 {
   if (anji_maxnsize > 0)
-    anji[mapped_n][j][i] = f;
+    anji.set(mapped_n, j, i, 0, f);
 }
 
 //-------------------------
@@ -374,19 +404,19 @@ float anjiMatrix::get(unsigned int n, unsigned int j, unsigned int i)
   // Check boundaries
   if (anji.size() <= np)
     return INVALID_ANJI_VAL;
-  if (anji[np].size() <= j)
+  if (anji.dim(np, 0) <= j)
     return INVALID_ANJI_VAL;
-  if (anji[np][j].size() <= i)
+  if (anji.dim(np, 1) <= i)
     return INVALID_ANJI_VAL;
   // anji[np][j][i] is defined
-  return anji[np][j][i];
+  return anji.get(np, j, i, 0);
 }
 
 //-------------------------
 float anjiMatrix::get_fast(unsigned int mapped_n, unsigned int j, unsigned int i)
 {
   if (anji_maxnsize > 0)
-    return anji[mapped_n][j][i];
+    return anji.get(mapped_n, j, i, 0);
   else
     return INVALID_ANJI_VAL;
 }
@@ -484,7 +514,7 @@ void anjiMatrix::map_n_in_matrix(unsigned int n, unsigned int& np)
         // Update old n to np correspondence
         update_n_to_np_vector(pbui.second, std::make_pair(false, 0));
         // Clear anji entry for old index
-        anji[np].clear();
+        anji.release(np);
       }
 
       // Update np to n mapping
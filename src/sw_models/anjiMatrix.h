@@ -30,6 +30,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 //--------------- Include files --------------------------------------
 
 #include "nlp_common/PositionIndex.h"
+#include "sw_models/ExpValArena.h"
 
 #include <climits>
 #include <vector>
@@ -60,6 +61,9 @@ public:
   // Functions to handle anji
   void set_maxnsize(unsigned int _anji_maxnsize);
   unsigned int get_maxnsize(void);
+  void set_half_precision(bool halfPrecision);
+  bool get_half_precision(void);
+  bool set_spill_file(const char* spillFileName, int verbose = 0);
   unsigned int n_size(void);
   unsigned int nj_size(unsigned int n);
   unsigned int nji_size(unsigned int n, unsigned int j);
@@ -84,9 +88,9 @@ public:
 protected:
   unsigned int anji_maxnsize;
   unsigned int anji_pointer;
-  std::vector<std::vector<std::vector<float>>> anji;
-  // Use simple precission floating-point numbers for expected
-  // values
+  ExpValArena anji;
+  // Each entry is a (tlen+1) x (nslen+1) block of the arena, stored
+  // as single or half precision floating-point numbers
   std::vector<std::pair<bool, unsigned int>> np_to_n_vector;
   // For each index of anji stores if it is already used and the
   // real index of the sample
@@ -106,7 +110,15 @@ protected:
   void update_n_to_np_vector(unsigned int n, std::pair<bool, unsigned int> pbui);
 
   // Functions to load and print anji matrices
+  struct AnjiRegister
+  {
+    unsigned int n;
+    unsigned int j;
+    unsigned int i;
+    float f;
+  };
   bool load_anji_values(const char* anjiFile, int verbose);
+  void set_registers(const std::vector<AnjiRegister>& registers);
   bool print_anji_values(const char* anjiFile);
 
   // Functions to load and print maximum size data
@@ -30,6 +30,7 @@ along with this program; If not, see <http://www.gnu.org/licenses/>.
 #include "nlp_common/ErrorDefs.h"
 #include "nlp_common/MathDefs.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -57,20 +58,13 @@ bool anjm1ip_anjiMatrix::init_nth_entry(unsigned int n, PositionIndex nslen, Pos
     map_n_in_matrix(n, mapped_n);
 
     // Check if it is required to grow in the dimension of n
-    if (anjm1ip_anji.size() <= mapped_n)
-    {
-      anjm1ip_anji.resize(mapped_n + 1);
-    }
+    anjm1ip_anji.grow(mapped_n + 1);
 
     // Check if entry has enough room
     if (resizeIsRequired(mapped_n, nslen, tlen))
     {
-      anjm1ip_anji[mapped_n].clear();
-
       // Initialize data structure for entry
-      std::vector<float> floatVec(nslen + 1, INVALID_ANJM1IP_ANJI_VAL);
-      std::vector<std::vector<float>> floatVecVec(nslen + 1, floatVec);
-      anjm1ip_anji[mapped_n].resize(tlen + 1, floatVecVec);
+      anjm1ip_anji.allocate(mapped_n, tlen + 1, nslen + 1, nslen + 1, INVALID_ANJM1IP_ANJI_VAL);
     }
 
     return THOT_OK;
@@ -85,13 +79,13 @@ bool anjm1ip_anjiMatrix::resizeIsRequired(unsigned int mapped_n, PositionIndex n
   if (anjm1ip_anji.size() <= mapped_n)
     return true;
 
-  if (anjm1ip_anji[mapped_n].size() <= tlen)
+  if (anjm1ip_anji.dim(mapped_n, 0) <= tlen)
     return true;
 
-  if (anjm1ip_anji[mapped_n][0].size() <= nslen)
+  if (anjm1ip_anji.dim(mapped_n, 1) <= nslen)
     return true;
 
-  if (anjm1ip_anji[mapped_n][0][0].size() <= nslen)
+  if (anjm1ip_anji.dim(mapped_n, 2) <= nslen)
     return true;
 
   return false;
@@ -103,16 +97,7 @@ bool anjm1ip_anjiMatrix::reset_entries(void)
   if (anjm1ip_anji_maxnsize > 0)
   {
     // Reset values
-    for (unsigned int n = 0; n < anjm1ip_anji.size(); ++n)
-    {
-      for (unsigned int j = 0; j < anjm1ip_anji[n].size(); ++j)
-      {
-        for (unsigned int i = 0; i < anjm1ip_anji[n][j].size(); ++i)
-        {
-          std::fill(anjm1ip_anji[n][j][i].begin(), anjm1ip_anji[n][j][i].end(), (float)INVALID_ANJM1IP_ANJI_VAL);
-        }
-      }
-    }
+    anjm1ip_anji.fill(INVALID_ANJM1IP_ANJI_VAL);
 
     return THOT_OK;
   }
@@ -133,6 +118,26 @@ unsigned int anjm1ip_anjiMatrix::get_maxnsize(void)
   return anjm1ip_anji_maxnsize;
 }
 
+//-------------------------
+void anjm1ip_anjiMatrix::set_half_precision(bool halfPrecision)
+{
+  clear();
+  anjm1ip_anji.setHalfPrecision(halfPrecision);
+}
+
+//-------------------------
+bool anjm1ip_anjiMatrix::get_half_precision(void)
+{
+  return anjm1ip_anji.getHalfPrecision();
+}
+
+//-------------------------
+bool anjm1ip_anjiMatrix::set_spill_file(const char* spillFileName, int verbose /*=0*/)
+{
+  clear();
+  return anjm1ip_anji.setSpillFile(spillFileName, verbose);
+}
+
 //-------------------------
 unsigned int anjm1ip_anjiMatrix::n_size(void)
 {
@@ -142,19 +147,19 @@ unsigned int anjm1ip_anjiMatrix::n_size(void)
 //-------------------------
 unsigned int anjm1ip_anjiMatrix::nj_size(unsigned int n)
 {
-  return anjm1ip_anji[n].size();
+  return anjm1ip_anji.dim(n, 0);
 }
 
 //-------------------------
 unsigned int anjm1ip_anjiMatrix::nji_size(unsigned int n, unsigned int j)
 {
-  return anjm1ip_anji[n][j].size();
+  return anjm1ip_anji.dim(n, 1);
 }
 
 //-------------------------
 unsigned int anjm1ip_anjiMatrix::njiip_size(unsigned int n, unsigned int j, unsigned int i)
 {
-  return anjm1ip_anji[n][j][i].size();
+  return anjm1ip_anji.dim(n, 2);
 }
 
 //-------------------------
@@ -166,34 +171,44 @@ void anjm1ip_anjiMatrix::set(unsigned int n, unsigned int j, unsigned int i, uns
     map_n_in_matrix(n, np);
 
     // Grow in the dimension of np if necessary
-    while (anjm1ip_anji.size() <= np)
-    {
-      std::vector<std::vector<std::vector<float>>> ajiip;
-      anjm1ip_anji.push_back(ajiip);
-    }
+    anjm1ip_anji.grow(np + 1);
 
-    // Grow in the dimension of j if necessary
-    while (anjm1ip_anji[np].size() <= j)
+    // Grow in the dimensions of j, i and ip if necessary
+    if (anjm1ip_anji.dim(np, 0) <= j || anjm1ip_anji.dim(np, 1) <= i || anjm1ip_anji.dim(np, 2) <= ip)
     {
-      std::vector<std::vector<float>> aiip;
-      anjm1ip_anji[np].push_back(aiip);
+      anjm1ip_anji.reshape(np, std::max(anjm1ip_anji.dim(np, 0), j + 1), std::max(anjm1ip_anji.dim(np, 1), i + 1),
+                           std::max(anjm1ip_anji.dim(np, 2), ip + 1), INVALID_ANJM1IP_ANJI_VAL);
     }
 
-    // Grow in the dimension of i if necessary
-    while (anjm1ip_anji[np][j].size() <= i)
-    {
-      std::vector<float> aip;
-      anjm1ip_anji[np][j].push_back(aip);
-    }
+    // Set value
+    anjm1ip_anji.set(np, j, i, ip, f);
+  }
+}
 
-    // Grow in the dimension of ip if necessary
-    while (anjm1ip_anji[np][j][i].size() <= ip)
+//-------------------------
+void anjm1ip_anjiMatrix::set_registers(const std::vector<MatrixRegister>& registers)
+{
+  if (anjm1ip_anji_maxnsize > 0 && !registers.empty())
+  {
+    unsigned int np;
+    map_n_in_matrix(registers[0].n, np);
+    anjm1ip_anji.grow(np + 1);
+
+    // Grow the entry once for all the registers
+    unsigned int jsize = anjm1ip_anji.dim(np, 0);
+    unsigned int isize = anjm1ip_anji.dim(np, 1);
+    unsigned int ipsize = anjm1ip_anji.dim(np, 2);
+    for (const MatrixRegister& reg : registers)
     {
-      anjm1ip_anji[np][j][i].push_back(INVALID_ANJM1IP_ANJI_VAL);
+      jsize = std::max(jsize, reg.j + 1);
+      isize = std::max(isize, reg.i + 1);
+      ipsize = std::max(ipsize, reg.ip + 1);
     }
+    anjm1ip_anji.reshape(np, jsize, isize, ipsize, INVALID_ANJM1IP_ANJI_VAL);
 
-    // Set value
-    anjm1ip_anji[np][j][i][ip] = f;
+    // Set values
+    for (const MatrixRegister& reg : registers)
+      anjm1ip_anji.set(np, reg.j, reg.i, reg.ip, reg.f);
   }
 }
 
@@ -201,7 +216,7 @@ void anjm1ip_anjiMatrix::set(unsigned int n, unsigned int j, unsigned int i, uns
 void anjm1ip_anjiMatrix::set_fast(unsigned int mapped_n, unsigned int j, unsigned int i, unsigned int ip, float f)
 {
   if (anjm1ip_anji_maxnsize > 0)
-    anjm1ip_anji[mapped_n][j][i][ip] = f;
+    anjm1ip_anji.set(mapped_n, j, i, ip, f);
 }
 
 //-------------------------
@@ -214,21 +229,21 @@ float anjm1ip_anjiMatrix::get(unsigned int n, unsigned int j, unsigned int i, un
   // Check boundaries
   if (anjm1ip_anji.size() <= np)
     return INVALID_ANJM1IP_ANJI_VAL;
-  if (anjm1ip_anji[np].size() <= j)
+  if (anjm1ip_anji.dim(np, 0) <= j)
     return INVALID_ANJM1IP_ANJI_VAL;
-  if (anjm1ip_anji[np][j].size() <= i)
+  if (anjm1ip_anji.dim(np, 1) <= i)
     return INVALID_ANJM1IP_ANJI_VAL;
-  if (anjm1ip_anji[np][j][i].size() <= ip)
+  if (anjm1ip_anji.dim(np, 2) <= ip)
     return INVALID_ANJM1IP_ANJI_VAL;
   // anjm1ip_anji[np][j][i][ip] is defined
-  return anjm1ip_anji[np][j][i][ip];
+  return anjm1ip_anji.get(np, j, i, ip);
 }
 
 //-------------------------
 float anjm1ip_anjiMatrix::get_fast(unsigned int mapped_n, unsigned int j, unsigned int i, unsigned int ip)
 {
   if (anjm1ip_anji_maxnsize > 0)
-    return anjm1ip_anji[mapped_n][j][i][ip];
+    return anjm1ip_anji.get(mapped_n, j, i, ip);
   else
     return INVALID_ANJM1IP_ANJI_VAL;
 }
@@ -326,7 +341,7 @@ void anjm1ip_anjiMatrix::map_n_in_matrix(unsigned int n, unsigned int& np)
         // Update old n to np correspondence
         update_n_to_np_vector(pbui.second, std::make_pair(false, 0));
         // Clear anji entry for old index
-        anjm1ip_anji[np].clear();
+        anjm1ip_anji.release(np);
       }
 
       // Update np to n mapping
@@ -424,26 +439,30 @@ bool anjm1ip_anjiMatrix::load_matrix_values(const char* matrixFile, int verbose)
   }
   else
   {
-    // Read register
+    // Read registers, the registers of each sample are stored
+    // together in a single block of the arena
+    std::vector<MatrixRegister> registers;
     bool end = false;
     while (!end)
     {
-      unsigned int n;
-      unsigned int j;
-      unsigned int i;
-      unsigned int ip;
-      float f;
-      if (inF.read((char*)&n, sizeof(unsigned int)))
+      MatrixRegister reg;
+      if (inF.read((char*)&reg.n, sizeof(unsigned int)))
       {
-        inF.read((char*)&j, sizeof(unsigned int));
-        inF.read((char*)&i, sizeof(unsigned int));
-        inF.read((char*)&ip, sizeof(unsigned int));
-        inF.read((char*)&f, sizeof(float));
-        set(n, j, i, ip, f);
+        inF.read((char*)&reg.j, sizeof(unsigned int));
+        inF.read((char*)&reg.i, sizeof(unsigned int));
+        inF.read((char*)&reg.ip, sizeof(unsigned int));
+        inF.read((char*)&reg.f, sizeof(float));
+        if (!registers.empty() && registers.back().n != reg.n)
+        {
+          set_registers(registers);
+          registers.clear();
+        }
+        registers.push_back(reg);
       }
       else
         end = true;
     }
+    set_registers(registers);
     return THOT_OK;
   }
 }
@@ -522,17 +541,18 @@ bool anjm1ip_anjiMatrix::print_matrix_values(const char* matrixFile)
     // print file with anji values
     for (unsigned int n = 0; n < anjm1ip_anji.size(); ++n)
     {
-      for (unsigned int j = 0; j < anjm1ip_anji[n].size(); ++j)
+      for (unsigned int j = 0; j < anjm1ip_anji.dim(n, 0); ++j)
       {
-        for (unsigned int i = 0; i < anjm1ip_anji[n][j].size(); ++i)
+        for (unsigned int i = 0; i < anjm1ip_anji.dim(n, 1); ++i)
         {
-          for (unsigned int ip = 0; ip < anjm1ip_anji[n][j][i].size(); ++ip)
+          for (unsigned int ip = 0; ip < anjm1ip_anji.dim(n, 2); ++ip)
           {
+            float f = anjm1ip_anji.get(n, j, i, ip);
             outF.write((char*)&n, sizeof(unsigned int));
             outF.write((char*)&j, sizeof(unsigned int));
             outF.write((char*)&i, sizeof(unsigned int));
             outF.write((char*)&ip, sizeof(unsigned int));
-            outF.write((char*)&anjm1ip_anji[n][j][i][ip], sizeof(float));
+            outF.write((char*)&f, sizeof(float));
           }
         }
       }
@@ -0,0 +1,142 @@
+#include "nlp_common/SingleWordVocab.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/StrProcUtils.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+
+SingleWordVocab createVocab()
+{
+  SingleWordVocab vocab;
+  vocab.strVectorToSrcIndexVector({"isthay", "isyay", "ayay", "esttay-N", "."});
+  vocab.strVectorToTrgIndexVector({"this", "is", "a", "test", "N", "."});
+  return vocab;
+}
+
+TEST(SingleWordVocabTest, freeze)
+{
+  SingleWordVocab vocab = createVocab();
+  WordIndex ayay = vocab.stringToSrcWordIndex("ayay");
+  WordIndex test = vocab.stringToTrgWordIndex("test");
+  size_t srcVocabSize = vocab.getSrcVocabSize();
+
+  EXPECT_EQ(vocab.freeze(), THOT_OK);
+  ASSERT_TRUE(vocab.isFrozen());
+
+  EXPECT_EQ(vocab.getSrcVocabSize(), srcVocabSize);
+  EXPECT_EQ(vocab.stringToSrcWordIndex("ayay"), ayay);
+  EXPECT_EQ(vocab.stringToTrgWordIndex("test"), test);
+  EXPECT_EQ(vocab.wordIndexToSrcString(ayay), "ayay");
+  EXPECT_EQ(vocab.wordIndexToTrgString(test), "test");
+  EXPECT_EQ(vocab.stringToSrcWordIndex(NULL_WORD_STR), NULL_WORD);
+  EXPECT_EQ(vocab.stringToSrcWordIndex("ayayay"), UNK_WORD);
+  EXPECT_EQ(vocab.wordIndexToSrcString(1000), UNK_WORD_STR);
+  EXPECT_TRUE(vocab.existSrcSymbol(UNK_WORD_STR));
+  EXPECT_FALSE(vocab.existTrgSymbol("tes"));
+}
+
+TEST(SingleWordVocabTest, addSymbolThaws)
+{
+  SingleWordVocab vocab = createVocab();
+  size_t srcVocabSize = vocab.getSrcVocabSize();
+  vocab.freeze();
+
+  EXPECT_EQ(vocab.addSrcSymbol("isyay"), vocab.stringToSrcWordIndex("isyay"));
+  EXPECT_TRUE(vocab.isFrozen());
+
+  WordIndex otnay = vocab.addSrcSymbol("otnay");
+  EXPECT_FALSE(vocab.isFrozen());
+  EXPECT_EQ(otnay, srcVocabSize);
+  EXPECT_EQ(vocab.getSrcVocabSize(), srcVocabSize + 1);
+  EXPECT_EQ(vocab.stringToSrcWordIndex("isthay"), (WordIndex)3);
+}
+
+TEST(SingleWordVocabTest, printAndLoadFrozen)
+{
+  SingleWordVocab vocab = createVocab();
+  vocab.freeze();
+  ASSERT_EQ(vocab.printFrozenSrcVocab("frozen_vocab_test.svcb.bin"), THOT_OK);
+
+  SingleWordVocab loadedVocab;
+  ASSERT_EQ(loadedVocab.loadFrozenSrcVocab("frozen_vocab_test.svcb.bin"), THOT_OK);
+  EXPECT_EQ(loadedVocab.getSrcVocabSize(), vocab.getSrcVocabSize());
+  for (WordIndex w = 0; w < vocab.getSrcVocabSize(); ++w)
+    EXPECT_EQ(loadedVocab.stringToSrcWordIndex(vocab.wordIndexToSrcString(w)), w);
+
+  std::remove("frozen_vocab_test.svcb.bin");
+}
+
+TEST(SingleWordVocabTest, loadCorruptFrozen)
+{
+  SingleWordVocab vocab = createVocab();
+  vocab.freeze();
+  std::ostringstream out;
+  ASSERT_EQ(vocab.printFrozenSrcVocab(out), THOT_OK);
+  std::string image = out.str();
+
+  // A word offset beyond the arena, right after the 40-byte header, and a truncated file
+  std::string corruptImage = image;
+  uint64_t offset = 0xffffffff;
+  std::memcpy(&corruptImage[48], &offset, sizeof(offset));
+  for (const std::string& data : {corruptImage, image.substr(0, image.size() - 8)})
+  {
+    std::ofstream outF("frozen_vocab_test.svcb.bin", std::ios::binary);
+    outF << data;
+    outF.close();
+    SingleWordVocab loadedVocab;
+    EXPECT_EQ(loadedVocab.loadFrozenSrcVocab("frozen_vocab_test.svcb.bin"), THOT_ERROR);
+  }
+
+  std::remove("frozen_vocab_test.svcb.bin");
+}
+
+TEST(SingleWordVocabTest, encodeSentences)
+{
+  SingleWordVocab vocab = createVocab();
+  const char* buffer = "isthay isyay ayay esttay-N .  ayay  otnay";
+  size_t sentenceOffsets[3] = {0, 28, strlen(buffer)};
+  size_t wordOffsets[3];
+  ASSERT_EQ(StrProcUtils::countSentenceWords(buffer, sentenceOffsets, 2, wordOffsets), (size_t)7);
+  EXPECT_EQ(wordOffsets[1], (size_t)5);
+
+  for (int frozen = 0; frozen < 2; ++frozen)
+  {
+    if (frozen)
+      vocab.freeze();
+    WordIndex wordIndices[7];
+    vocab.encodeSrcSentences(buffer, sentenceOffsets, 2, wordOffsets, wordIndices);
+    EXPECT_EQ(wordIndices[0], vocab.stringToSrcWordIndex("isthay"));
+    EXPECT_EQ(wordIndices[4], vocab.stringToSrcWordIndex("."));
+    EXPECT_EQ(wordIndices[5], vocab.stringToSrcWordIndex("ayay"));
+    EXPECT_EQ(wordIndices[6], (WordIndex)UNK_WORD);
+
+    const char* tokens[2] = {buffer + 7, buffer + 36};
+    size_t tokenLengths[2] = {5, 5};
+    vocab.encodeSrcTokens(tokens, tokenLengths, 2, wordIndices);
+    EXPECT_EQ(wordIndices[0], vocab.stringToSrcWordIndex("isyay"));
+    EXPECT_EQ(wordIndices[1], (WordIndex)UNK_WORD);
+  }
+}
+
+TEST(SingleWordVocabTest, encodeSentencesSplitsLikeStringToStringVector)
+{
+  SingleWordVocab vocab = createVocab();
+  const char* buffer = "isthay\tisyay ayay\r esttay-N\n.";
+  size_t sentenceOffsets[2] = {0, strlen(buffer)};
+  size_t wordOffsets[2];
+  std::vector<std::string> words = StrProcUtils::stringToStringVector(buffer);
+  ASSERT_EQ(words.size(), (size_t)4);
+  ASSERT_EQ(StrProcUtils::countSentenceWords(buffer, sentenceOffsets, 1, wordOffsets), words.size());
+
+  WordIndex wordIndices[4];
+  vocab.encodeSrcSentences(buffer, sentenceOffsets, 1, wordOffsets, wordIndices);
+  for (size_t i = 0; i < words.size(); ++i)
+    EXPECT_EQ(wordIndices[i], vocab.stringToSrcWordIndex(words[i]));
+  EXPECT_EQ(wordIndices[1], vocab.stringToSrcWordIndex("isyay"));
+  EXPECT_EQ(wordIndices[2], (WordIndex)UNK_WORD);
+}
@@ -157,3 +157,61 @@ TEST(WordAlignmentMatrixTest, growDiagFinalAnd)
   expected.set(6, 8);
   EXPECT_EQ(x, expected);
 }
+
+TEST(WordAlignmentMatrixTest, subtract)
+{
+  WordAlignmentMatrix x, y;
+  std::tie(x, y) = createMatrices();
+
+  x -= y;
+
+  WordAlignmentMatrix expected{7, 9};
+  expected.set(1, 5);
+  expected.set(3, 2);
+  expected.set(3, 3);
+  expected.set(4, 5);
+  expected.set(5, 3);
+  EXPECT_EQ(x, expected);
+}
+
+TEST(WordAlignmentMatrixTest, growDiagFinalAndAcrossWords)
+{
+  // Same alignments as createMatrices(), but starting at column 60 so that
+  // the neighbors of some cells are stored in the next 64-bit word
+  WordAlignmentMatrix x, y;
+  std::tie(x, y) = createMatrices();
+  WordAlignmentMatrix wideX{7, 130};
+  WordAlignmentMatrix wideY{7, 130};
+  for (unsigned int i = 0; i < 7; ++i)
+  {
+    for (unsigned int j = 0; j < 9; ++j)
+    {
+      wideX.setValue(i, j + 60, x.getValue(i, j));
+      wideY.setValue(i, j + 60, y.getValue(i, j));
+    }
+  }
+
+  x.growDiagFinalAnd(y);
+  wideX.growDiagFinalAnd(wideY);
+
+  for (unsigned int i = 0; i < 7; ++i)
+  {
+    for (unsigned int j = 0; j < 130; ++j)
+      EXPECT_EQ(wideX.getValue(i, j), j >= 60 && j < 69 && x.getValue(i, j - 60));
+  }
+  EXPECT_TRUE(wideX.isHorizontalNeighborAligned(3, 64));
+  EXPECT_FALSE(wideX.isHorizontalNeighborAligned(0, 129));
+}
+
+TEST(WordAlignmentMatrixTest, getAlignedCells)
+{
+  WordAlignmentMatrix x{3, 130};
+  x.set(0, 129);
+  x.set(2, 0);
+  x.set(0, 3);
+  x.set(2, 64);
+
+  std::vector<std::pair<unsigned int, unsigned int>> cells;
+  x.getAlignedCells(cells);
+  EXPECT_EQ(cells, (std::vector<std::pair<unsigned int, unsigned int>>{{0, 3}, {0, 129}, {2, 0}, {2, 64}}));
+}
@@ -0,0 +1,159 @@
+#include "phrase_models/ExternalPhraseTableBuilder.h"
+
+#include "nlp_common/ErrorDefs.h"
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+void addPhrasePairs(ExternalPhraseTableBuilder& builder, unsigned int numReps)
+{
+  for (unsigned int i = 0; i < numReps; ++i)
+  {
+    EXPECT_EQ(builder.addPhrasePair({"jezioro", "Narie"}, {"Narie", "lake"}, 2), THOT_OK);
+    EXPECT_EQ(builder.addPhrasePair({"jezioro"}, {"lake"}, 1), THOT_OK);
+    EXPECT_EQ(builder.addPhrasePair({"jezioro", "Narie"}, {"lake"}, 1), THOT_OK);
+    EXPECT_EQ(builder.addPhrasePair({"jezioro"}, {"lake", "Narie"}, 0.5), THOT_OK);
+  }
+}
+
+#ifndef _WIN32
+std::vector<std::string> listFiles(const std::string& dir)
+{
+  std::vector<std::string> fileNames;
+  DIR* d = opendir(dir.c_str());
+  if (d == NULL)
+    return fileNames;
+  while (dirent* entry = readdir(d))
+  {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..")
+      fileNames.push_back(dir + "/" + name);
+  }
+  closedir(d);
+  return fileNames;
+}
+#endif
+
+const char* EXPECTED_TABLE = "jezioro ||| lake ||| 300.00000000 200.00000000\n"
+                             "jezioro ||| lake Narie ||| 300.00000000 100.00000000\n"
+                             "jezioro Narie ||| Narie lake ||| 600.00000000 400.00000000\n"
+                             "jezioro Narie ||| lake ||| 600.00000000 200.00000000\n";
+} // namespace
+
+TEST(ExternalPhraseTableBuilderTest, inMemory)
+{
+  ExternalPhraseTableBuilder builder;
+  addPhrasePairs(builder, 200);
+
+  std::ostringstream out;
+  ASSERT_EQ(builder.print(out), THOT_OK);
+  EXPECT_EQ(EXPECTED_TABLE, out.str());
+  EXPECT_EQ(1u, builder.numRuns());
+}
+
+TEST(ExternalPhraseTableBuilderTest, sortedRuns)
+{
+  ExternalPhraseTableBuilder builder;
+  builder.setMemoryLimit(128);
+  addPhrasePairs(builder, 200);
+  EXPECT_LT(128u, builder.numRuns());
+
+  std::ostringstream out;
+  ASSERT_EQ(builder.print(out), THOT_OK);
+  EXPECT_EQ(EXPECTED_TABLE, out.str());
+  EXPECT_GE(128u, builder.numRuns());
+
+  builder.clear();
+  EXPECT_EQ(0u, builder.numRuns());
+}
+
+TEST(ExternalPhraseTableBuilderTest, pruning)
+{
+  ExternalPhraseTableBuilder builder;
+  builder.setMemoryLimit(128);
+  PhraseTablePruningParameters params;
+  params.maxTrgPhrasesPerSrc = 1;
+  params.minSignificance = 1;
+  params.numSentencePairs = 1000;
+  builder.setPruningParameters(params);
+  addPhrasePairs(builder, 200);
+  EXPECT_EQ(builder.addPhrasePair({"Narie"}, {"lake"}, 1), THOT_OK);
+
+  std::ostringstream out;
+  ASSERT_EQ(builder.print(out), THOT_OK);
+  EXPECT_EQ("jezioro ||| lake ||| 300.00000000 200.00000000\n"
+            "jezioro Narie ||| Narie lake ||| 600.00000000 400.00000000\n",
+            out.str());
+  EXPECT_EQ(5u, builder.getPruningStats().numPairs);
+  EXPECT_EQ(2u, builder.getPruningStats().numPrunedBySignificance);
+  EXPECT_EQ(1u, builder.getPruningStats().numPrunedByRank);
+
+  // The target counts sorted on disk match the ones added up in memory
+  ExternalPhraseTableBuilder inMemoryBuilder;
+  inMemoryBuilder.setPruningParameters(params);
+  addPhrasePairs(inMemoryBuilder, 200);
+  EXPECT_EQ(inMemoryBuilder.addPhrasePair({"Narie"}, {"lake"}, 1), THOT_OK);
+  std::ostringstream inMemoryOut;
+  ASSERT_EQ(inMemoryBuilder.print(inMemoryOut), THOT_OK);
+  EXPECT_EQ(out.str(), inMemoryOut.str());
+  EXPECT_EQ(2u, inMemoryBuilder.getPruningStats().numPrunedBySignificance);
+
+  params.numSentencePairs = 0;
+  builder.setPruningParameters(params);
+  EXPECT_EQ(builder.print(out), THOT_ERROR);
+}
+
+TEST(ExternalPhraseTableBuilderTest, invalidTempDir)
+{
+  ExternalPhraseTableBuilder builder;
+  builder.setTempDir("external_phrase_table_builder_test/missing");
+  EXPECT_EQ(builder.addPhrasePair({"jezioro"}, {"lake"}, 1), THOT_OK);
+
+  std::ostringstream out;
+  EXPECT_EQ(builder.print(out), THOT_ERROR);
+}
+
+#ifndef _WIN32
+TEST(ExternalPhraseTableBuilderTest, truncatedRun)
+{
+  const std::string tempDir = "external_phrase_table_builder_test_runs";
+  mkdir(tempDir.c_str(), 0755);
+  {
+    ExternalPhraseTableBuilder builder;
+    builder.setTempDir(tempDir);
+    builder.setMemoryLimit(128);
+    addPhrasePairs(builder, 4);
+    std::vector<std::string> runs = listFiles(tempDir);
+    ASSERT_LT(1u, runs.size());
+
+    // A run cut in the middle of a pair is an error, not the end of the run
+    std::string data;
+    {
+      std::ifstream in(runs[0], std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::ofstream out(runs[0], std::ios::binary | std::ios::trunc);
+    out << data.substr(0, data.size() - 1);
+    out.close();
+
+    std::ostringstream table;
+    EXPECT_EQ(builder.print(table), THOT_ERROR);
+  }
+  for (const std::string& fileName : listFiles(tempDir))
+    std::remove(fileName.c_str());
+  rmdir(tempDir.c_str());
+}
+#endif
@@ -125,13 +125,13 @@ TEST_F(HatTriePhraseTableTest, iteratorsOperatorsPlusPlusStar)
   // Check if the results returned by iterator are correct
   // and operators work as expected
   HatTriePhraseTable::const_iterator iter = getTable()->begin();
-  EXPECT_EQ(t2, iter->first);
-  EXPECT_NEAR(60, iter->second.get_c_s(), EPSILON);
+  EXPECT_EQ(t1, iter->first);
+  EXPECT_NEAR(41, iter->second.get_c_s(), EPSILON);
 
   found = ++iter;
   EXPECT_TRUE(found);
-  EXPECT_EQ(t1, (*iter).first);
-  EXPECT_NEAR(41, (*iter).second.get_c_s(), EPSILON);
+  EXPECT_EQ(t2, (*iter).first);
+  EXPECT_NEAR(60, (*iter).second.get_c_s(), EPSILON);
 
   found = (iter++);
   EXPECT_TRUE(found);
@@ -165,3 +165,193 @@ TEST_F(HatTriePhraseTableTest, iteratorsOperatorsEqualNotEqual)
   EXPECT_FALSE(iter1 == iter2);
   EXPECT_TRUE(iter1 != iter2);
 }
+
+TEST_F(HatTriePhraseTableTest, getEntriesForSourceWithSharedPrefix)
+{
+  /* TEST:
+    Check that the entries of a source phrase do not include the entries
+    of the longer source phrases that start with it
+  */
+  BasePhraseTable::TrgTableNode node;
+  std::vector<WordIndex> s1 = getVector("jezioro");
+  std::vector<WordIndex> t1 = getVector("lake");
+  std::vector<WordIndex> s2 = getVector("jezioro Narie");
+  std::vector<WordIndex> t2 = getVector("Narie lake");
+
+  getTable()->clear();
+  getTable()->incrCountsOfEntry(s1, t1, Count(2));
+  getTable()->incrCountsOfEntry(s2, t2, Count(3));
+  getTable()->incrCountsOfEntry(s2, t1, Count(1));
+
+  EXPECT_TRUE(getTable()->getEntriesForSource(s1, node));
+  ASSERT_EQ((size_t)1, node.size());
+  EXPECT_EQ(t1, node.begin()->first);
+  EXPECT_NEAR(2, node.begin()->second.second.get_c_s(), EPSILON);
+
+  EXPECT_TRUE(getTable()->getEntriesForSource(s2, node));
+  ASSERT_EQ((size_t)2, node.size());
+  EXPECT_NEAR(1, node[t1].second.get_c_s(), EPSILON);
+  EXPECT_NEAR(3, node[t2].second.get_c_s(), EPSILON);
+
+  EXPECT_FALSE(getTable()->getEntriesForSource(t1, node));
+}
+
+TEST_F(HatTriePhraseTableTest, largeWordIndices)
+{
+  /* TEST:
+    Check that word indices of any size are stored and retrieved,
+    including the ones that do not fit in a single key byte
+  */
+  std::vector<WordIndex> s = {0, 126, 127, 16383};
+  std::vector<WordIndex> t1 = {254 * 254 * 254, 4294967295u};
+  std::vector<WordIndex> t2 = {128, 1};
+
+  getTable()->clear();
+  getTable()->incrCountsOfEntry(s, t1, Count(2));
+  getTable()->incrCountsOfEntry(s, t2, Count(3));
+
+  EXPECT_NEAR(2, getTable()->cSrcTrg(s, t1).get_c_s(), EPSILON);
+  EXPECT_NEAR(5, getTable()->cSrc(s).get_c_s(), EPSILON);
+
+  BasePhraseTable::TrgTableNode trgNode;
+  EXPECT_TRUE(getTable()->getEntriesForSource(s, trgNode));
+  ASSERT_EQ((size_t)2, trgNode.size());
+  EXPECT_NEAR(2, trgNode[t1].second.get_c_s(), EPSILON);
+  EXPECT_NEAR(3, trgNode[t2].second.get_c_s(), EPSILON);
+
+  BasePhraseTable::SrcTableNode srcNode;
+  EXPECT_TRUE(getTable()->getEntriesForTarget(t1, srcNode));
+  ASSERT_EQ((size_t)1, srcNode.size());
+  EXPECT_EQ(s, srcNode.begin()->first);
+}
+
+TEST_F(HatTriePhraseTableTest, nbestListsFollowCountUpdates)
+{
+  /* TEST:
+    Check that the sorted n-best lists kept by the table are rebuilt
+    when the counts they depend on change
+  */
+  std::vector<WordIndex> s = getVector("jezioro");
+  std::vector<WordIndex> t1 = getVector("lake");
+  std::vector<WordIndex> t2 = getVector("pond");
+
+  getTable()->clear();
+  getTable()->incrCountsOfEntry(s, t1, Count(3));
+  getTable()->incrCountsOfEntry(s, t2, Count(1));
+
+  NbestTableNode<PhraseTransTableNodeData> nbt;
+  EXPECT_TRUE(getTable()->getNbestForSrc(s, nbt));
+  ASSERT_EQ(2u, nbt.size());
+  EXPECT_EQ(t1, nbt.getBestElem());
+  EXPECT_NEAR(log(0.75), nbt.getScoreOfBestElem(), EPSILON);
+  EXPECT_FALSE(getTable()->getNbestForSrc(t1, nbt));
+
+  getTable()->incrCountsOfEntry(s, t2, Count(4));
+  EXPECT_TRUE(getTable()->getNbestForSrc(s, nbt));
+  EXPECT_EQ(t2, nbt.getBestElem());
+  EXPECT_NEAR(log(5.0 / 8), nbt.getScoreOfBestElem(), EPSILON);
+
+  EXPECT_TRUE(getTable()->getNbestForTrg(t2, nbt, 1));
+  EXPECT_EQ(1u, nbt.size());
+  getTable()->incrCountsOfEntry(t1, t2, Count(10));
+  EXPECT_TRUE(getTable()->getNbestForTrg(t2, nbt));
+  ASSERT_EQ(2u, nbt.size());
+  EXPECT_EQ(t1, nbt.getBestElem());
+
+  getTable()->setNbestScoreFunction([](Count pairCount, Count) { return -(float)pairCount.get_c_st(); });
+  EXPECT_TRUE(getTable()->getNbestForTrg(t2, nbt));
+  EXPECT_EQ(s, nbt.getBestElem());
+  EXPECT_NEAR(-5, nbt.getScoreOfBestElem(), EPSILON);
+
+  getTable()->setNbestCacheSize(0);
+  getTable()->incrCountsOfEntry(s, t2, Count(10));
+  EXPECT_TRUE(getTable()->getNbestForTrg(t2, nbt));
+  EXPECT_EQ(t1, nbt.getBestElem());
+}
+
+TEST_F(HatTriePhraseTableTest, nbestViews)
+{
+  /* TEST:
+    Check that views are truncated without changing the cached lists,
+    that N = 0 still reports known phrases and that a full cache only
+    drops its least recently used list
+  */
+  std::vector<WordIndex> s1 = getVector("jezioro");
+  std::vector<WordIndex> s2 = getVector("Narie");
+  std::vector<WordIndex> t1 = getVector("lake");
+  std::vector<WordIndex> t2 = getVector("pond");
+
+  getTable()->clear();
+  getTable()->setNbestCacheSize(1);
+  getTable()->incrCountsOfEntry(s1, t1, Count(3));
+  getTable()->incrCountsOfEntry(s1, t2, Count(1));
+  getTable()->incrCountsOfEntry(s2, t1, Count(2));
+
+  PhraseNbestListView view;
+  EXPECT_TRUE(getTable()->getNbestViewForSrc(s1, view, 1));
+  ASSERT_EQ(1u, view.size());
+  EXPECT_EQ(t1, view.begin()->second);
+  EXPECT_TRUE(getTable()->getNbestViewForSrc(s1, view));
+  EXPECT_EQ(2u, view.size());
+
+  // The view keeps its list after it is dropped from the cache
+  EXPECT_TRUE(getTable()->getNbestViewForSrc(s2, view));
+  getTable()->incrCountsOfEntry(s2, t2, Count(5));
+  ASSERT_EQ(1u, view.size());
+  EXPECT_EQ(t1, view.begin()->second);
+  EXPECT_TRUE(getTable()->getNbestViewForSrc(s2, view));
+  EXPECT_EQ(t2, view.begin()->second);
+
+  NbestTableNode<PhraseTransTableNodeData> nbt;
+  EXPECT_TRUE(getTable()->getNbestForTrg(t1, nbt, 0));
+  EXPECT_EQ(0u, nbt.size());
+  EXPECT_FALSE(getTable()->getNbestForTrg(s1, nbt, 0));
+
+  getTable()->setNbestCacheSize(DEFAULT_NBEST_CACHE_SIZE);
+}
+
+TEST_F(HatTriePhraseTableTest, phraseIds)
+{
+  /* TEST:
+    Check that the id-based functions give the same results as the
+    ones that take the phrases
+  */
+  std::vector<WordIndex> s = getVector("jezioro Narie");
+  std::vector<WordIndex> t = getVector("Narie lake");
+
+  getTable()->clear();
+  getTable()->incrCountsOfEntry(s, t, Count(2));
+  getTable()->incrCountsOfEntry(s, getVector("lake"), Count(2));
+
+  PhraseId sId = getTable()->getSrcPhraseId(s);
+  PhraseId tId = getTable()->getTrgPhraseId(t);
+  EXPECT_EQ(sId, getTable()->getSrcPhraseId(s));
+  EXPECT_EQ(s, getTable()->getSrcPhrase(sId));
+  EXPECT_EQ(t, getTable()->getTrgPhrase(tId));
+
+  EXPECT_NEAR(2, getTable()->cSrcTrgById(sId, tId).get_c_st(), EPSILON);
+  EXPECT_NEAR(4, getTable()->cSrcById(sId).get_c_s(), EPSILON);
+  EXPECT_NEAR(2, getTable()->cTrgById(tId).get_c_s(), EPSILON);
+  EXPECT_NEAR(0.5, getTable()->pTrgGivenSrcById(sId, tId), EPSILON);
+  EXPECT_NEAR(1, getTable()->pSrcGivenTrgById(sId, tId), EPSILON);
+
+  NbestTableNode<PhraseTransTableNodeData> nbt;
+  EXPECT_TRUE(getTable()->getNbestForSrcById(sId, nbt));
+  EXPECT_EQ(2u, nbt.size());
+
+  // Ids that the table did not give are treated as unknown phrases
+  PhraseId unknownId = sId + 1;
+  EXPECT_FALSE(getTable()->existSrcPhraseId(unknownId));
+  EXPECT_TRUE(getTable()->getSrcPhrase(unknownId).empty());
+  EXPECT_NEAR(0, getTable()->cSrcById(unknownId).get_c_s(), EPSILON);
+  EXPECT_NEAR(PHRASE_PROB_SMOOTH, getTable()->pTrgGivenSrcById(unknownId, tId), EPSILON);
+  EXPECT_FALSE(getTable()->getNbestForSrcById(unknownId, nbt));
+  EXPECT_EQ(0u, nbt.size());
+
+  // Ids are reset when the table is cleared
+  getTable()->clear();
+  EXPECT_FALSE(getTable()->existSrcPhraseId(sId));
+  EXPECT_FALSE(getTable()->existTrgPhraseId(tId));
+  EXPECT_NEAR(0, getTable()->cSrcTrgById(sId, tId).get_c_st(), EPSILON);
+  EXPECT_EQ(0u, getTable()->getSrcPhraseId(t));
+}
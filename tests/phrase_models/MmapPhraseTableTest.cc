@@ -0,0 +1,277 @@
+#include "phrase_models/MmapPhraseTable.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/ModelContainer.h"
+#include "phrase_models/HatTriePhraseTable.h"
+#include "phrase_models/IncrPhraseModel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace
+{
+std::vector<WordIndex> getVector(const std::string& phrase)
+{
+  return std::vector<WordIndex>(phrase.begin(), phrase.end());
+}
+
+void addTableEntries(MmapPhraseTableBuilder& builder, BasePhraseTable& table)
+{
+  const char* entries[][2] = {{"jezioro Narie", "Narie lake"}, {"jezioro Narie", "Narie"},
+                              {"jezioro", "lake"},             {"jezioro Jeziorak", "Jeziorak lake"},
+                              {"Jeziorak", "Jeziorak"},        {"jezioro Jeziorak", "Jeziorak"},
+                              {"jezioro Narie", "lake"}};
+  float counts[] = {4, 2, 7, 3, 1, 3, 1};
+  for (size_t k = 0; k < sizeof(counts) / sizeof(float); ++k)
+  {
+    PhrasePairInfo inf;
+    inf.first = 10;
+    inf.second = counts[k];
+    builder.addTableEntry(getVector(entries[k][0]), getVector(entries[k][1]), inf);
+    table.addTableEntry(getVector(entries[k][0]), getVector(entries[k][1]), inf);
+  }
+}
+
+// Sorted lines of a printed phrase table, since each table prints its target phrases in
+// its own order
+std::vector<std::string> readTableEntries(const char* fileName)
+{
+  std::ifstream in(fileName);
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(in, line))
+    lines.push_back(line);
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+
+// Writes the image with a 32-bit value replaced and tries to load it. The offsets
+// of the source arrays are taken from the header
+bool loadCorruptImage(std::string image, const char* array, uint64_t index, uint32_t value)
+{
+  uint64_t numPairs, numPhrases, numWords;
+  memcpy(&numPairs, &image[16], sizeof(uint64_t));
+  memcpy(&numPhrases, &image[24], sizeof(uint64_t));
+  memcpy(&numWords, &image[32], sizeof(uint64_t));
+  auto aligned = [](uint64_t size) { return (size + 7) & ~(uint64_t)7; };
+  uint64_t wordOffsetsPos = 56;
+  uint64_t pairOffsetsPos = wordOffsetsPos + 8 * (numPhrases + 1) + aligned(4 * numWords) + aligned(4 * numPhrases);
+  uint64_t partnersPos = pairOffsetsPos + 8 * (numPhrases + 1);
+  uint64_t nbestOrderPos = partnersPos + 2 * aligned(4 * numPairs);
+
+  uint64_t pos = 0;
+  if (std::string(array) == "wordOffsets")
+    pos = wordOffsetsPos + 8 * index;
+  else if (std::string(array) == "pairOffsets")
+    pos = pairOffsetsPos + 8 * index;
+  else if (std::string(array) == "partners")
+    pos = partnersPos + 4 * index;
+  else
+    pos = nbestOrderPos + 4 * index;
+  memcpy(&image[pos], &value, sizeof(uint32_t));
+
+  std::ofstream outF("mmap_phrase_table_test.bin", std::ios::binary);
+  outF << image;
+  outF.close();
+  MmapPhraseTable table;
+  bool ret = table.load("mmap_phrase_table_test.bin");
+  EXPECT_EQ(ret == THOT_OK, table.isLoaded());
+  return ret;
+}
+
+std::vector<std::pair<float, std::vector<WordIndex>>> getNbestList(NbestTableNode<PhraseTransTableNodeData>& nbt)
+{
+  std::vector<std::pair<float, std::vector<WordIndex>>> nbestList;
+  for (NbestTableNode<PhraseTransTableNodeData>::iterator iter = nbt.begin(); iter != nbt.end(); ++iter)
+    nbestList.push_back(std::make_pair((float)iter->first, iter->second));
+  return nbestList;
+}
+} // namespace
+
+TEST(MmapPhraseTableTest, sameQueriesAsHatTriePhraseTable)
+{
+  MmapPhraseTableBuilder builder;
+  HatTriePhraseTable expected;
+  addTableEntries(builder, expected);
+  ASSERT_EQ(builder.print("mmap_phrase_table_test.bin"), THOT_OK);
+
+  MmapPhraseTable table;
+  ASSERT_EQ(table.load("mmap_phrase_table_test.bin"), THOT_OK);
+  EXPECT_EQ(expected.size(), table.size());
+
+  std::vector<std::string> phrases{"jezioro Narie", "jezioro", "jezioro Jeziorak", "Jeziorak", "Narie lake", "lake",
+                                   "Narie",         "unknown"};
+  for (const std::string& phrase : phrases)
+  {
+    std::vector<WordIndex> p = getVector(phrase);
+    EXPECT_NEAR(expected.cSrc(p), table.cSrc(p), EPSILON);
+    EXPECT_NEAR(expected.cTrg(p), table.cTrg(p), EPSILON);
+
+    BasePhraseTable::TrgTableNode expectedTrgNode, trgNode;
+    EXPECT_EQ(expected.getEntriesForSource(p, expectedTrgNode), table.getEntriesForSource(p, trgNode));
+    ASSERT_EQ(expectedTrgNode.size(), trgNode.size());
+    for (BasePhraseTable::TrgTableNode::iterator iter = expectedTrgNode.begin(); iter != expectedTrgNode.end(); ++iter)
+    {
+      EXPECT_NEAR(iter->second.first.get_c_s(), trgNode[iter->first].first.get_c_s(), EPSILON);
+      EXPECT_NEAR(iter->second.second.get_c_st(), trgNode[iter->first].second.get_c_st(), EPSILON);
+      EXPECT_NEAR(expected.pTrgGivenSrc(p, iter->first), table.pTrgGivenSrc(p, iter->first), EPSILON);
+    }
+
+    BasePhraseTable::SrcTableNode expectedSrcNode, srcNode;
+    EXPECT_EQ(expected.getEntriesForTarget(p, expectedSrcNode), table.getEntriesForTarget(p, srcNode));
+    ASSERT_EQ(expectedSrcNode.size(), srcNode.size());
+    for (BasePhraseTable::SrcTableNode::iterator iter = expectedSrcNode.begin(); iter != expectedSrcNode.end(); ++iter)
+    {
+      EXPECT_NEAR(iter->second.first.get_c_s(), srcNode[iter->first].first.get_c_s(), EPSILON);
+      EXPECT_NEAR(iter->second.second.get_c_st(), srcNode[iter->first].second.get_c_st(), EPSILON);
+      EXPECT_NEAR(expected.pSrcGivenTrg(iter->first, p), table.pSrcGivenTrg(iter->first, p), EPSILON);
+    }
+
+    NbestTableNode<PhraseTransTableNodeData> expectedNbt, nbt;
+    EXPECT_EQ(expected.getNbestForSrc(p, expectedNbt), table.getNbestForSrc(p, nbt));
+    EXPECT_EQ(getNbestList(expectedNbt), getNbestList(nbt));
+    for (int n : {-1, 1, 2})
+    {
+      EXPECT_EQ(expected.getNbestForTrg(p, expectedNbt, n), table.getNbestForTrg(p, nbt, n));
+      EXPECT_EQ(getNbestList(expectedNbt), getNbestList(nbt));
+    }
+  }
+
+  std::vector<WordIndex> t;
+  table.getTrgPhraseAt(table.getNumTrgPhrases() - 1, t);
+  EXPECT_FALSE(t.empty());
+  table.getTrgPhraseAt(table.getNumTrgPhrases(), t);
+  EXPECT_TRUE(t.empty());
+
+  table.clear();
+  EXPECT_FALSE(table.isLoaded());
+  EXPECT_EQ((size_t)0, table.size());
+  std::remove("mmap_phrase_table_test.bin");
+}
+
+TEST(MmapPhraseTableTest, invalidImage)
+{
+  std::ofstream outF("mmap_phrase_table_test.bin");
+  outF << "jezioro ||| lake ||| 1 1\n";
+  outF.close();
+
+  MmapPhraseTable table;
+  EXPECT_EQ(table.load("mmap_phrase_table_test.bin"), THOT_ERROR);
+  EXPECT_FALSE(table.isLoaded());
+  std::remove("mmap_phrase_table_test.bin");
+}
+
+TEST(MmapPhraseTableTest, corruptImage)
+{
+  MmapPhraseTableBuilder builder;
+  HatTriePhraseTable hatTrieTable;
+  addTableEntries(builder, hatTrieTable);
+  std::ostringstream out;
+  ASSERT_EQ(builder.print(out), THOT_OK);
+  std::string image = out.str();
+
+  // "jezioro Jeziorak", the third source phrase, has pairs 2 and 3, with target phrases 0 and 1
+  EXPECT_EQ(loadCorruptImage(image, "partners", 0, 0), THOT_OK);
+  EXPECT_EQ(loadCorruptImage(image, "partners", 0, 1000), THOT_ERROR);
+  EXPECT_EQ(loadCorruptImage(image, "partners", 2, 1), THOT_ERROR);
+  EXPECT_EQ(loadCorruptImage(image, "pairOffsets", 1, 1000), THOT_ERROR);
+  EXPECT_EQ(loadCorruptImage(image, "pairOffsets", 0, 1), THOT_ERROR);
+  EXPECT_EQ(loadCorruptImage(image, "wordOffsets", 1, 1000), THOT_ERROR);
+  EXPECT_EQ(loadCorruptImage(image, "nbestOrder", 0, 2), THOT_ERROR);
+
+  std::remove("mmap_phrase_table_test.bin");
+}
+
+TEST(MmapPhraseTableTest, loadBinaryTtable)
+{
+  std::ofstream outF("mmap_phrase_table_test.ttable");
+  outF << "jezioro Narie ||| Narie lake ||| 3 2\n";
+  outF << "jezioro Narie ||| lake ||| 3 1\n";
+  outF << "jezioro ||| lake ||| 5 5\n";
+  outF.close();
+
+  IncrPhraseModel builder;
+  ASSERT_EQ(builder.buildBinaryPhraseTable("mmap_phrase_table_test.ttable", "mmap_phrase_table_test.ttable.bin"),
+            THOT_OK);
+
+  IncrPhraseModel model;
+  ASSERT_EQ(model.load_ttable("mmap_phrase_table_test.ttable.bin"), THOT_OK);
+  std::vector<WordIndex> s = model.strVectorToSrcIndexVector({"jezioro", "Narie"});
+  std::vector<WordIndex> t = model.strVectorToTrgIndexVector({"lake"});
+  EXPECT_NEAR(3, model.cSrc(s).get_c_s(), EPSILON);
+  EXPECT_NEAR(6, model.cTrg(t).get_c_s(), EPSILON);
+  EXPECT_NEAR(1, model.cSrcTrg(s, t).get_c_st(), EPSILON);
+
+  NbestTableNode<PhraseTransTableNodeData> nbt;
+  EXPECT_TRUE(model.getNbestTransFor_t_(t, nbt, 1));
+  ASSERT_EQ(1u, nbt.size());
+  EXPECT_EQ(model.strVectorToSrcIndexVector({"jezioro"}), nbt.begin()->second);
+
+  // The binary table is printed as the plain text one it was built from
+  IncrPhraseModel textModel;
+  ASSERT_EQ(textModel.load_ttable("mmap_phrase_table_test.ttable"), THOT_OK);
+  for (int n : {-1, 1})
+  {
+    ASSERT_EQ(textModel.printPhraseTable("mmap_phrase_table_test.expected", n), THOT_OK);
+    ASSERT_EQ(model.printPhraseTable("mmap_phrase_table_test.printed", n), THOT_OK);
+    std::vector<std::string> entries = readTableEntries("mmap_phrase_table_test.printed");
+    EXPECT_EQ(3u, entries.size());
+    EXPECT_EQ(readTableEntries("mmap_phrase_table_test.expected"), entries);
+  }
+  std::remove("mmap_phrase_table_test.expected");
+  std::remove("mmap_phrase_table_test.printed");
+
+  // The table created by the model is used again after clearing it
+  model.clear();
+  model.strIncrCountsOfEntry({"jezioro"}, {"lake"}, 2);
+  EXPECT_NEAR(2, model.cSrcTrg(model.strVectorToSrcIndexVector({"jezioro"}), model.strVectorToTrgIndexVector({"lake"}))
+                     .get_c_st(),
+              EPSILON);
+
+  std::remove("mmap_phrase_table_test.ttable");
+  std::remove("mmap_phrase_table_test.ttable.bin");
+}
+
+TEST(MmapPhraseTableTest, loadCorruptBinaryTtable)
+{
+  std::ofstream outF("mmap_phrase_table_test.ttable");
+  outF << "jezioro ||| lake ||| 5 5\n";
+  outF.close();
+  IncrPhraseModel builder;
+  ASSERT_EQ(builder.buildBinaryPhraseTable("mmap_phrase_table_test.ttable", "mmap_phrase_table_test.ttable.bin"),
+            THOT_OK);
+
+  // The target vocabulary is the last section that is loaded
+  {
+    ModelContainer container;
+    ASSERT_EQ(container.open("mmap_phrase_table_test.ttable.bin"), THOT_OK);
+    ModelContainer corruptContainer;
+    corruptContainer.setModelType(container.getModelType());
+    for (const char* name : {".ttable.bin", ".svcb.bin"})
+    {
+      const char* data;
+      std::size_t size;
+      ASSERT_EQ(container.getSection(name, data, size), THOT_OK);
+      corruptContainer.addSection(name, std::string(data, size));
+    }
+    corruptContainer.addSection(".tvcb.bin", "corrupt");
+    ASSERT_EQ(corruptContainer.write("mmap_phrase_table_test.corrupt.bin"), THOT_OK);
+  }
+
+  // A failed load leaves the model as it was
+  IncrPhraseModel model;
+  model.strIncrCountsOfEntry({"Narie"}, {"Narie"}, 2);
+  EXPECT_EQ(model.load_ttable("mmap_phrase_table_test.corrupt.bin"), THOT_ERROR);
+  EXPECT_TRUE(model.existSrcSymbol("Narie"));
+  EXPECT_FALSE(model.existSrcSymbol("jezioro"));
+  std::vector<WordIndex> narie = model.strVectorToSrcIndexVector({"Narie"});
+  EXPECT_NEAR(2, model.cSrcTrg(narie, model.strVectorToTrgIndexVector({"Narie"})).get_c_st(), EPSILON);
+
+  std::remove("mmap_phrase_table_test.ttable");
+  std::remove("mmap_phrase_table_test.ttable.bin");
+  std::remove("mmap_phrase_table_test.corrupt.bin");
+}
@@ -0,0 +1,93 @@
+#include "phrase_models/PhraseTablePruner.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "phrase_models/IncrPhraseModel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+
+TEST(PhraseTablePrunerTest, fisherSignificance)
+{
+  // Phrases that only occur once and together
+  EXPECT_NEAR(std::log(1000.0), fisherSignificance(1, 1, 1, 1000), 1e-9);
+  // Phrases that always occur together are more significant the more they occur
+  EXPECT_LT(fisherSignificance(1, 1, 1, 1000), fisherSignificance(2, 2, 2, 1000));
+  // Phrases that occur together as often as expected by chance are not significant
+  EXPECT_EQ(0, fisherSignificance(10, 100, 100, 1000));
+  EXPECT_EQ(0, fisherSignificance(5, 100, 100, 1000));
+  EXPECT_LT(0, fisherSignificance(11, 100, 100, 1000));
+  EXPECT_EQ(0, fisherSignificance(0, 100, 100, 1000));
+}
+
+TEST(PhraseTablePrunerTest, pruneSrcPhrase)
+{
+  PhraseTablePruningParameters params;
+  params.maxTrgPhrasesPerSrc = 2;
+  params.minPairCount = 2;
+  params.minSignificance = std::log(1000.0) + 0.01;
+  params.numSentencePairs = 1000;
+  PhraseTablePruner pruner(params);
+  ASSERT_TRUE(pruner.isEnabled());
+  ASSERT_TRUE(pruner.needsTrgCounts());
+
+  std::vector<bool> keep;
+  pruner.pruneSrcPhrase(20, {1, 5, 8, 5, 3}, {1, 6, 9, 500, 3}, keep);
+  EXPECT_EQ((std::vector<bool>{false, true, true, false, false}), keep);
+
+  const PhraseTablePruningStats& stats = pruner.getStats();
+  EXPECT_EQ(5u, stats.numPairs);
+  EXPECT_EQ(1u, stats.numPrunedByCount);
+  EXPECT_EQ(1u, stats.numPrunedBySignificance);
+  EXPECT_EQ(1u, stats.numPrunedByRank);
+  EXPECT_EQ(3u, stats.numPruned());
+  EXPECT_EQ(0u, stats.numCountsAboveSentencePairs);
+
+  // Pair counts of phrases extracted several times from a sentence pair can exceed
+  // the number of sentence pairs
+  pruner.clearStats();
+  pruner.pruneSrcPhrase(2000, {900, 1100}, {1000, 1500}, keep);
+  EXPECT_EQ(2u, pruner.getStats().numCountsAboveSentencePairs);
+
+  pruner.clearStats();
+  EXPECT_EQ(0u, pruner.getStats().numPairs);
+  EXPECT_FALSE(PhraseTablePruner().isEnabled());
+  EXPECT_TRUE(PhraseTablePruner().hasValidParameters());
+}
+
+TEST(PhraseTablePrunerTest, loadPrunedTtable)
+{
+  std::ofstream outF("phrase_table_pruner_test.ttable");
+  outF << "jezioro ||| lake ||| 10 6\n";
+  outF << "jezioro Narie ||| Narie lake ||| 3 2\n";
+  outF << "jezioro ||| Narie ||| 10 1\n";
+  outF << "jezioro ||| the lake ||| 10 3\n";
+  outF << "jezioro Narie ||| lake ||| 3 1\n";
+  outF.close();
+
+  PhraseTablePruningParameters params;
+  params.maxTrgPhrasesPerSrc = 1;
+  IncrPhraseModel model;
+  model.setPruningParameters(params);
+  ASSERT_EQ(model.load_ttable("phrase_table_pruner_test.ttable"), THOT_OK);
+  EXPECT_EQ(3u, model.getPruningStats().numPruned());
+
+  std::vector<WordIndex> s = model.strVectorToSrcIndexVector({"jezioro"});
+  EXPECT_NEAR(10, model.cSrc(s).get_c_s(), EPSILON);
+  EXPECT_NEAR(6, model.cSrcTrg(s, model.strVectorToTrgIndexVector({"lake"})).get_c_st(), EPSILON);
+  EXPECT_NEAR(0, model.cSrcTrg(s, model.strVectorToTrgIndexVector({"the", "lake"})).get_c_st(), EPSILON);
+  s = model.strVectorToSrcIndexVector({"jezioro", "Narie"});
+  EXPECT_NEAR(2, model.cSrcTrg(s, model.strVectorToTrgIndexVector({"Narie", "lake"})).get_c_st(), EPSILON);
+  EXPECT_NEAR(0, model.cSrcTrg(s, model.strVectorToTrgIndexVector({"lake"})).get_c_st(), EPSILON);
+
+  // The significance test cannot be applied without the size of the corpus
+  params.minSignificance = 1;
+  model.setPruningParameters(params);
+  EXPECT_EQ(model.load_ttable("phrase_table_pruner_test.ttable"), THOT_ERROR);
+  EXPECT_EQ(model.buildBinaryPhraseTable("phrase_table_pruner_test.ttable", "phrase_table_pruner_test.bin"),
+            THOT_ERROR);
+
+  std::remove("phrase_table_pruner_test.ttable");
+  std::remove("phrase_table_pruner_test.bin");
+}
@@ -0,0 +1,54 @@
+#include "phrase_models/PhraseVocabulary.h"
+
+#include <gtest/gtest.h>
+
+TEST(PhraseVocabularyTest, addAndFind)
+{
+  PhraseVocabulary vocab;
+  EXPECT_EQ(0u, vocab.add({1, 2}));
+  EXPECT_EQ(1u, vocab.add({2}));
+  EXPECT_EQ(0u, vocab.add({1, 2}));
+  EXPECT_EQ(2u, vocab.add({2, 1}));
+  EXPECT_EQ(3u, vocab.size());
+  EXPECT_EQ(std::vector<WordIndex>({2, 1}), vocab.getPhrase(2));
+
+  PhraseId id;
+  EXPECT_TRUE(vocab.find({2}, id));
+  EXPECT_EQ(1u, id);
+  EXPECT_FALSE(vocab.find({1}, id));
+
+  // Moving the vocabulary keeps the phrases in place
+  PhraseVocabulary moved(std::move(vocab));
+  EXPECT_EQ(std::vector<WordIndex>({1, 2}), moved.getPhrase(0));
+  EXPECT_EQ(3u, moved.add({2, 1, 2}));
+
+  moved.clear();
+  EXPECT_EQ(0u, moved.size());
+  EXPECT_EQ(0u, moved.add({2}));
+}
+
+TEST(PhraseVocabularyTest, phrasePairIds)
+{
+  BasicPhraseVocabulary<std::string> srcVocab, trgVocab;
+  PhraseId srcId = srcVocab.add({"jezioro", "Narie"});
+  PhraseId trgId = trgVocab.add({"lake"});
+  trgId = trgVocab.add({"Narie", "lake"});
+
+  PhrasePairId pairId = makePhrasePairId(srcId, trgId);
+  EXPECT_EQ(srcId, phrasePairSrcId(pairId));
+  EXPECT_EQ(trgId, phrasePairTrgId(pairId));
+  EXPECT_NE(pairId, makePhrasePairId(trgId, srcId));
+  EXPECT_EQ(std::vector<std::string>({"Narie", "lake"}), trgVocab.getPhrase(phrasePairTrgId(pairId)));
+}
+
+TEST(PhraseVocabularyTest, copy)
+{
+  PhraseVocabulary vocab;
+  vocab.add({3});
+  vocab.add({1, 2});
+  PhraseVocabulary copy(vocab);
+  vocab.clear();
+  EXPECT_EQ(2u, copy.size());
+  EXPECT_EQ(std::vector<WordIndex>({1, 2}), copy.getPhrase(1));
+  EXPECT_EQ(2u, copy.add({4}));
+}
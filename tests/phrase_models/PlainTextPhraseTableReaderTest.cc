@@ -0,0 +1,120 @@
+#include "phrase_models/PlainTextPhraseTableReader.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "phrase_models/IncrPhraseModel.h"
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <sstream>
+
+namespace
+{
+// Returns the entries as text, with the words taken from the vocabularies of the reader
+bool readEntries(PlainTextPhraseTableReader& reader, const char* fileName, std::string& entries)
+{
+  std::ostringstream out;
+  bool ret = reader.read(fileName, [&reader, &out](const std::vector<WordIndex>& s, const std::vector<WordIndex>& t,
+                                                   PhrasePairInfo inf) {
+    for (WordIndex w : s)
+      out << reader.getSrcWord(w) << " ";
+    out << "|||";
+    for (WordIndex w : t)
+      out << " " << reader.getTrgWord(w);
+    out << " ||| " << inf.first.get_c_s() << " " << inf.second.get_c_st() << "\n";
+  });
+  entries = out.str();
+  return ret;
+}
+} // namespace
+
+TEST(PlainTextPhraseTableReaderTest, read)
+{
+  std::ofstream outF("plain_text_phrase_table_reader_test.ttable");
+  outF << "jezioro ||| lake ||| 10 6\n";
+  outF << "\n";
+  outF << "jezioro   Narie ||| Narie lake ||| 3 2\n";
+  outF << "anomalous ||| entry\n";
+  outF << "||| empty ||| 1 1\n";
+  outF << "jezioro ||| the lake ||| 10 3";
+  outF.close();
+
+  PlainTextPhraseTableReader reader;
+  std::string entries;
+  ASSERT_EQ(readEntries(reader, "plain_text_phrase_table_reader_test.ttable", entries), THOT_OK);
+  EXPECT_EQ("jezioro ||| lake ||| 10 6\n"
+            "jezioro Narie ||| Narie lake ||| 3 2\n"
+            "jezioro ||| the lake ||| 10 3\n",
+            entries);
+
+  // Words are numbered in the order of their first occurrence in a valid entry
+  ASSERT_EQ(2u, reader.getSrcVocabSize());
+  EXPECT_EQ("jezioro", reader.getSrcWord(0));
+  EXPECT_EQ("Narie", reader.getSrcWord(1));
+  ASSERT_EQ(3u, reader.getTrgVocabSize());
+  EXPECT_EQ("lake", reader.getTrgWord(0));
+  EXPECT_EQ("Narie", reader.getTrgWord(1));
+  EXPECT_EQ("the", reader.getTrgWord(2));
+
+  EXPECT_EQ(THOT_ERROR, reader.read("plain_text_phrase_table_reader_test.missing", nullptr));
+
+  std::remove("plain_text_phrase_table_reader_test.ttable");
+}
+
+TEST(PlainTextPhraseTableReaderTest, parallelRounds)
+{
+  std::ofstream outF("plain_text_phrase_table_reader_test.ttable");
+  for (unsigned int i = 0; i < 500; ++i)
+  {
+    outF << "s" << i % 37 << " s" << i % 11 << " ||| t" << i % 23 << " ||| " << i << " 1\n";
+    if (i % 50 == 0)
+      outF << "s" << i << " ||| t" << i << "\n";
+  }
+  outF.close();
+
+  PlainTextPhraseTableReader reader;
+  std::string expected;
+  int numThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  ASSERT_EQ(readEntries(reader, "plain_text_phrase_table_reader_test.ttable", expected), THOT_OK);
+  EXPECT_EQ(37u, reader.getSrcVocabSize());
+  EXPECT_EQ(23u, reader.getTrgVocabSize());
+
+  // Rounds that are shorter than a line and chunks without lines give the same result
+  PlainTextPhraseTableReader parallelReader;
+  parallelReader.setRoundSize(16);
+  omp_set_num_threads(4);
+  std::string entries;
+  ASSERT_EQ(readEntries(parallelReader, "plain_text_phrase_table_reader_test.ttable", entries), THOT_OK);
+  omp_set_num_threads(numThreads);
+  EXPECT_EQ(expected, entries);
+  for (WordIndex w = 0; w < reader.getSrcVocabSize(); ++w)
+    EXPECT_EQ(reader.getSrcWord(w), parallelReader.getSrcWord(w));
+
+  parallelReader.setRoundSize(1000);
+  parallelReader.clear();
+  ASSERT_EQ(readEntries(parallelReader, "plain_text_phrase_table_reader_test.ttable", entries), THOT_OK);
+  EXPECT_EQ(expected, entries);
+
+  std::remove("plain_text_phrase_table_reader_test.ttable");
+}
+
+TEST(PlainTextPhraseTableReaderTest, loadTtable)
+{
+  std::ofstream outF("plain_text_phrase_table_reader_test.ttable");
+  outF << "jezioro ||| lake ||| 10 6\n";
+  outF << "anomalous ||| entry\n";
+  outF << "jezioro Narie ||| Narie lake ||| 3 2\n";
+  outF.close();
+
+  IncrPhraseModel model;
+  ASSERT_EQ(model.load_ttable("plain_text_phrase_table_reader_test.ttable"), THOT_OK);
+  EXPECT_FALSE(model.existSrcSymbol("anomalous"));
+  EXPECT_FALSE(model.existTrgSymbol("entry"));
+  std::vector<WordIndex> s = model.strVectorToSrcIndexVector({"jezioro", "Narie"});
+  EXPECT_NEAR(3, model.cSrc(s).get_c_s(), EPSILON);
+  EXPECT_NEAR(2, model.cSrcTrg(s, model.strVectorToTrgIndexVector({"Narie", "lake"})).get_c_st(), EPSILON);
+
+  std::remove("plain_text_phrase_table_reader_test.ttable");
+}
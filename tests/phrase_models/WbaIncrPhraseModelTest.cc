@@ -0,0 +1,216 @@
+#include "phrase_models/WbaIncrPhraseModel.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/StrProcUtils.h"
+#include "sw_models/FastAlignModel.h"
+#include "sw_models/SymmetrizedAligner.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <omp.h>
+#include <sstream>
+
+namespace
+{
+void writeAlignmentFile(const char* fileName)
+{
+  std::ofstream outF(fileName);
+  outF << "# Sentence pair (1)\n"
+       << "this is a test\n"
+       << "NULL ({ }) isthay ({ 1 }) isyay ({ 2 }) ayay ({ 3 }) esttay ({ 4 })\n";
+  outF << "# 2\n"
+       << "this is not a test\n"
+       << "NULL ({ }) isthay ({ 1 }) isyay ({ 2 }) otnay ({ 3 }) ayay ({ 4 }) esttay ({ 5 })\n";
+  outF << "# Sentence pair (3)\n"
+       << "a hard test\n"
+       << "NULL ({ }) ayay ({ 1 }) esttay ({ 3 }) ardhay ({ 2 })\n";
+  outF << "# Sentence pair (4)\n"
+       << "this is hard\n"
+       << "NULL ({ }) isthay ({ 1 }) isyay ({ 2 }) ardhay ({ 3 })\n";
+  outF << "# Sentence pair (5)\n"
+       << "not this\n"
+       << "NULL ({ }) otnay ({ 1 }) isthay ({ 2 })\n";
+}
+
+std::string buildPhraseTable(unsigned int batchSize)
+{
+  WbaIncrPhraseModel model;
+  model.setExtractionBatchSize(batchSize);
+  PhraseExtractParameters phePars;
+  EXPECT_EQ(model.generateWbaIncrPhraseModel("wba_incr_phrase_model_test.A3.final", phePars, false), THOT_OK);
+  EXPECT_EQ(model.printPhraseTable("wba_incr_phrase_model_test.ttable"), THOT_OK);
+
+  std::ifstream inF("wba_incr_phrase_model_test.ttable");
+  std::stringstream table;
+  table << inF.rdbuf();
+  return table.str();
+}
+
+const std::vector<std::pair<std::string, std::string>> CORPUS = {
+    {"isthay isyay ayay esttay .", "this is a test ."},
+    {"isyay isthay orkingway ?", "is this working ?"},
+    {"isthay isyay ayay ordway !", "this is a word !"},
+    {"ityay isyay orkingway .", "it is working ."},
+    {"", "empty source"},
+    {"ayay esttay ancay ebay ardhay .", "a test can be hard ."}};
+
+std::shared_ptr<SymmetrizedAligner> createAligner()
+{
+  auto directModel = std::make_shared<FastAlignModel>();
+  auto inverseModel = std::make_shared<FastAlignModel>();
+  for (auto& pair : CORPUS)
+  {
+    std::vector<std::string> src = StrProcUtils::stringToStringVector(pair.first);
+    std::vector<std::string> trg = StrProcUtils::stringToStringVector(pair.second);
+    if (src.empty())
+      continue;
+    directModel->addSentencePair(src, trg, 1);
+    inverseModel->addSentencePair(trg, src, 1);
+  }
+  for (auto model : {directModel, inverseModel})
+  {
+    model->startTraining();
+    model->train();
+    model->train();
+    model->endTraining();
+  }
+  auto aligner = std::make_shared<SymmetrizedAligner>(directModel, inverseModel);
+  aligner->setHeuristic(SymmetrizationHeuristic::GrowDiagFinalAnd);
+  return aligner;
+}
+
+std::vector<std::string> readSortedLines(const char* fileName)
+{
+  std::ifstream inF(fileName);
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(inF, line))
+    lines.push_back(line);
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+} // namespace
+
+TEST(WbaIncrPhraseModelTest, parallelExtractionMatchesSerialExtraction)
+{
+  writeAlignmentFile("wba_incr_phrase_model_test.A3.final");
+  int numThreads = omp_get_max_threads();
+  omp_set_num_threads(3);
+
+  std::string expected = buildPhraseTable(0);
+  EXPECT_NE(expected.find("isthay isyay ||| this is ||| 4.00000000 4.00000000"), std::string::npos);
+  EXPECT_EQ(expected, buildPhraseTable(2));
+  EXPECT_EQ(expected, buildPhraseTable(DEFAULT_EXTRACTION_BATCH_SIZE));
+
+  omp_set_num_threads(numThreads);
+  std::remove("wba_incr_phrase_model_test.A3.final");
+  std::remove("wba_incr_phrase_model_test.ttable");
+}
+
+TEST(WbaIncrPhraseModelTest, parallelExtractionKeepsPairsWithEmptySentences)
+{
+  // Pairs read from an alignment file go through the same extraction in both
+  // modes, whatever their length
+  writeAlignmentFile("wba_incr_phrase_model_test.A3.final");
+  std::ofstream outF("wba_incr_phrase_model_test.A3.final", std::ios::app);
+  outF << "# Sentence pair (6)\n"
+       << "\n"
+       << "NULL ({ }) isthay ({ }) isyay ({ })\n";
+  outF << "# Sentence pair (7)\n"
+       << "this is\n"
+       << "NULL ({ 1 2 })\n";
+  outF.close();
+
+  std::string expected = buildPhraseTable(0);
+  EXPECT_EQ(expected, buildPhraseTable(2));
+
+  std::remove("wba_incr_phrase_model_test.A3.final");
+  std::remove("wba_incr_phrase_model_test.ttable");
+}
+
+TEST(WbaIncrPhraseModelTest, buildPhraseTableWithSortedRuns)
+{
+  writeAlignmentFile("wba_incr_phrase_model_test.A3.final");
+  PhraseExtractParameters phePars;
+  WbaIncrPhraseModel model;
+  ASSERT_EQ(model.generateWbaIncrPhraseModel("wba_incr_phrase_model_test.A3.final", phePars, false), THOT_OK);
+  ASSERT_EQ(model.printPhraseTable("wba_incr_phrase_model_test.ttable"), THOT_OK);
+
+  WbaIncrPhraseModel extractor;
+  extractor.setExtractionBatchSize(2);
+  ExternalPhraseTableBuilder builder;
+  builder.setMemoryLimit(1024);
+  ASSERT_EQ(extractor.buildPhraseTable("wba_incr_phrase_model_test.A3.final", phePars, false, builder,
+                                       "wba_incr_phrase_model_test.sorted.ttable"),
+            THOT_OK);
+  EXPECT_EQ(0u, builder.numRuns());
+
+  std::vector<std::string> expected = readSortedLines("wba_incr_phrase_model_test.ttable");
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(expected, readSortedLines("wba_incr_phrase_model_test.sorted.ttable"));
+
+  std::remove("wba_incr_phrase_model_test.A3.final");
+  std::remove("wba_incr_phrase_model_test.ttable");
+  std::remove("wba_incr_phrase_model_test.sorted.ttable");
+}
+
+TEST(WbaIncrPhraseModelTest, extendModelFromAligner)
+{
+  std::shared_ptr<SymmetrizedAligner> aligner = createAligner();
+  std::ofstream srcF("wba_incr_phrase_model_test.src");
+  std::ofstream trgF("wba_incr_phrase_model_test.trg");
+  std::ofstream aligF("wba_incr_phrase_model_test.A3.final");
+  for (auto& pair : CORPUS)
+  {
+    srcF << pair.first << "\n";
+    trgF << pair.second << "\n";
+    std::vector<std::string> src = StrProcUtils::stringToStringVector(pair.first);
+    std::vector<std::string> trg = StrProcUtils::stringToStringVector(pair.second);
+    if (src.empty())
+      continue;
+    WordAlignmentMatrix waMatrix;
+    aligner->getBestAlignment(src, trg, waMatrix);
+    src.insert(src.begin(), NULL_WORD_STR);
+    printAlignmentInGIZAFormat(aligF, src, trg, waMatrix, "# 1");
+  }
+  srcF.close();
+  trgF.close();
+  aligF.close();
+
+  PhraseExtractParameters phePars;
+  WbaIncrPhraseModel expected;
+  ASSERT_EQ(expected.generateWbaIncrPhraseModel("wba_incr_phrase_model_test.A3.final", phePars, false), THOT_OK);
+  ASSERT_EQ(expected.printPhraseTable("wba_incr_phrase_model_test.ttable"), THOT_OK);
+
+  WbaIncrPhraseModel model;
+  model.setExtractionBatchSize(4);
+  ASSERT_EQ(model.extendModelFromAligner(*aligner, "wba_incr_phrase_model_test.src", "wba_incr_phrase_model_test.trg",
+                                         phePars, false),
+            THOT_OK);
+  ASSERT_EQ(model.printPhraseTable("wba_incr_phrase_model_test.aligner.ttable"), THOT_OK);
+  std::vector<std::string> expectedLines = readSortedLines("wba_incr_phrase_model_test.ttable");
+  EXPECT_FALSE(expectedLines.empty());
+  EXPECT_EQ(expectedLines, readSortedLines("wba_incr_phrase_model_test.aligner.ttable"));
+
+  ExternalPhraseTableBuilder builder;
+  ASSERT_EQ(model.buildPhraseTableFromAligner(*aligner, "wba_incr_phrase_model_test.src",
+                                              "wba_incr_phrase_model_test.trg", phePars, false, builder,
+                                              "wba_incr_phrase_model_test.aligner.ttable"),
+            THOT_OK);
+  EXPECT_EQ(expectedLines, readSortedLines("wba_incr_phrase_model_test.aligner.ttable"));
+
+  std::ofstream shortTrgF("wba_incr_phrase_model_test.trg");
+  shortTrgF << "this is a test .\n";
+  shortTrgF.close();
+  EXPECT_EQ(model.extendModelFromAligner(*aligner, "wba_incr_phrase_model_test.src", "wba_incr_phrase_model_test.trg",
+                                         phePars, false),
+            THOT_ERROR);
+
+  for (const char* fileName : {"wba_incr_phrase_model_test.src", "wba_incr_phrase_model_test.trg",
+                               "wba_incr_phrase_model_test.A3.final", "wba_incr_phrase_model_test.ttable",
+                               "wba_incr_phrase_model_test.aligner.ttable"})
+    std::remove(fileName);
+}
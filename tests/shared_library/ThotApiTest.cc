@@ -0,0 +1,132 @@
+#include "shared_library/thot.h"
+
+#include "sw_models/AlignmentModel.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+const char* SOURCE_SENTENCES[] = {"isthay isyay ayay esttay-N .", "isyay isthay orkingway ?", "",
+                                  "ityay isyay orkingway ."};
+const char* TARGET_SENTENCES[] = {"this is a test N .", "is this working ?", "empty source", "it is working ."};
+const unsigned int COUNT = 4;
+const unsigned int NUM_TARGET_WORDS = 16;
+const unsigned int MAX_LENGTH = 8;
+
+void* createTrainedModel()
+{
+  void* handle = swAlignModel_create(AlignmentModelType::Ibm1, NULL);
+  swAlignModel_addSentencePair(handle, "isthay isyay ayay esttay-N .", "this is a test N .");
+  swAlignModel_addSentencePair(handle, "isyay isthay orkingway ?", "is this working ?");
+  swAlignModel_addSentencePair(handle, "ityay isyay orkingway .", "it is working .");
+  swAlignModel_addSentencePair(handle, "isthay isyay ayay ordway !", "this is a word !");
+  swAlignModel_startTraining(handle);
+  swAlignModel_train(handle, 2);
+  swAlignModel_endTraining(handle);
+  return handle;
+}
+
+// Word indices of the sentences, one after the other, and the offsets of the sentences
+void encode(void* handle, const char** sentences, bool source, std::vector<unsigned int>& wordIndices,
+            std::vector<unsigned int>& offsets)
+{
+  wordIndices.clear();
+  offsets.assign(1, 0);
+  for (unsigned int k = 0; k < COUNT; ++k)
+  {
+    std::string sentence = sentences[k];
+    size_t begin = 0;
+    while (begin < sentence.size())
+    {
+      size_t end = sentence.find(' ', begin);
+      if (end == std::string::npos)
+        end = sentence.size();
+      std::string word = sentence.substr(begin, end - begin);
+      wordIndices.push_back(source ? swAlignModel_getSourceWordIndex(handle, word.c_str())
+                                   : swAlignModel_getTargetWordIndex(handle, word.c_str()));
+      begin = end + 1;
+    }
+    offsets.push_back(wordIndices.size());
+  }
+}
+} // namespace
+
+TEST(ThotApiTest, getBestAlignmentVectors)
+{
+  void* handle = createTrainedModel();
+
+  // Nothing is written when the vectors do not fit, and the size tells how much room they need
+  std::vector<double> logProbs(COUNT, 1);
+  std::vector<unsigned int> targetOffsets(COUNT + 1, 99);
+  std::vector<unsigned int> alignments(NUM_TARGET_WORDS, 99);
+  unsigned int size = 0;
+  EXPECT_FALSE(swAlignModel_getBestAlignmentVectors(handle, SOURCE_SENTENCES, TARGET_SENTENCES, COUNT, 1,
+                                                    logProbs.data(), targetOffsets.data(), alignments.data(),
+                                                    NUM_TARGET_WORDS - 1, &size));
+  EXPECT_EQ(NUM_TARGET_WORDS, size);
+  EXPECT_EQ(std::vector<unsigned int>(NUM_TARGET_WORDS, 99), alignments);
+  EXPECT_EQ(std::vector<double>(COUNT, 1), logProbs);
+
+  size = 0;
+  ASSERT_TRUE(swAlignModel_getBestAlignmentVectors(handle, SOURCE_SENTENCES, TARGET_SENTENCES, COUNT, 2,
+                                                   logProbs.data(), targetOffsets.data(), alignments.data(),
+                                                   NUM_TARGET_WORDS, &size));
+  EXPECT_EQ(NUM_TARGET_WORDS, size);
+  EXPECT_EQ(std::vector<unsigned int>({0, 6, 10, 12, 16}), targetOffsets);
+
+  // Every sentence gets the alignment of the single sentence entry point
+  for (unsigned int k = 0; k < COUNT; ++k)
+  {
+    bool matrixData[MAX_LENGTH][MAX_LENGTH] = {};
+    bool* matrix[MAX_LENGTH];
+    for (unsigned int i = 0; i < MAX_LENGTH; ++i)
+      matrix[i] = matrixData[i];
+    unsigned int iLen = MAX_LENGTH, jLen = MAX_LENGTH;
+    double logProb =
+        swAlignModel_getBestAlignment(handle, SOURCE_SENTENCES[k], TARGET_SENTENCES[k], matrix, &iLen, &jLen);
+    EXPECT_NEAR(logProb, logProbs[k], 0.0001) << k;
+    ASSERT_EQ(targetOffsets[k + 1] - targetOffsets[k], jLen) << k;
+    for (unsigned int j = 0; j < jLen; ++j)
+    {
+      unsigned int expected = 0;
+      for (unsigned int i = 0; i < iLen; ++i)
+      {
+        if (matrix[i][j])
+          expected = i + 1;
+      }
+      EXPECT_EQ(expected, alignments[targetOffsets[k] + j]) << k << " " << j;
+    }
+  }
+
+  swAlignModel_close(handle);
+}
+
+TEST(ThotApiTest, getBestAlignmentVectorsByIndex)
+{
+  void* handle = createTrainedModel();
+
+  std::vector<double> expectedLogProbs(COUNT);
+  std::vector<unsigned int> expectedOffsets(COUNT + 1);
+  std::vector<unsigned int> expectedAlignments(NUM_TARGET_WORDS);
+  unsigned int size;
+  ASSERT_TRUE(swAlignModel_getBestAlignmentVectors(handle, SOURCE_SENTENCES, TARGET_SENTENCES, COUNT, 1,
+                                                   expectedLogProbs.data(), expectedOffsets.data(),
+                                                   expectedAlignments.data(), NUM_TARGET_WORDS, &size));
+
+  std::vector<unsigned int> srcWordIndices, srcOffsets, trgWordIndices, trgOffsets;
+  encode(handle, SOURCE_SENTENCES, true, srcWordIndices, srcOffsets);
+  encode(handle, TARGET_SENTENCES, false, trgWordIndices, trgOffsets);
+  EXPECT_EQ(expectedOffsets, trgOffsets);
+
+  std::vector<double> logProbs(COUNT);
+  std::vector<unsigned int> alignments(NUM_TARGET_WORDS, 99);
+  swAlignModel_getBestAlignmentVectorsByIndex(handle, srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(),
+                                              trgOffsets.data(), COUNT, 2, logProbs.data(), alignments.data());
+  for (unsigned int k = 0; k < COUNT; ++k)
+    EXPECT_NEAR(expectedLogProbs[k], logProbs[k], 0.0001) << k;
+  EXPECT_EQ(expectedAlignments, alignments);
+
+  swAlignModel_close(handle);
+}
@@ -0,0 +1,74 @@
+#include "sw_models/ExpValArena.h"
+
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/MathDefs.h"
+
+#include <gtest/gtest.h>
+
+TEST(ExpValArenaTest, reshapeKeepsValues)
+{
+  ExpValArena arena;
+  arena.grow(2);
+  arena.allocate(0, 2, 3, 1, 99);
+  arena.allocate(1, 2, 2, 1, 99);
+  for (unsigned int j = 0; j < 2; ++j)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+      arena.set(0, j, i, 0, (float)(10 * j + i));
+  }
+
+  arena.reshape(0, 3, 4, 1, 99);
+  EXPECT_EQ(arena.dim(0, 0), 3u);
+  EXPECT_EQ(arena.dim(0, 1), 4u);
+  for (unsigned int j = 0; j < 2; ++j)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+      EXPECT_EQ(arena.get(0, j, i, 0), (float)(10 * j + i));
+    EXPECT_EQ(arena.get(0, j, 3, 0), 99.0f);
+  }
+  EXPECT_EQ(arena.get(0, 2, 0, 0), 99.0f);
+  EXPECT_EQ(arena.get(1, 1, 1, 0), 99.0f);
+}
+
+TEST(ExpValArenaTest, releasedSpaceIsReused)
+{
+  ExpValArena arena;
+  arena.grow(4);
+  for (unsigned int round = 0; round < 100; ++round)
+  {
+    unsigned int np = round % 4;
+    arena.release(np);
+    arena.allocate(np, 20 + round % 7, 20, 1, (float)round);
+  }
+  for (unsigned int np = 0; np < 4; ++np)
+    EXPECT_EQ(arena.get(np, 19, 19, 0), (float)(96 + np));
+  EXPECT_LT(arena.numValues(), 4 * 2 * 26 * 20u);
+}
+
+TEST(ExpValArenaTest, halfPrecision)
+{
+  EXPECT_EQ(ExpValArena::halfToFloat(ExpValArena::floatToHalf(99)), 99.0f);
+  EXPECT_EQ(ExpValArena::halfToFloat(ExpValArena::floatToHalf(0)), 0.0f);
+  EXPECT_EQ(ExpValArena::halfToFloat(ExpValArena::floatToHalf(SMALL_LG_NUM)), SMALL_LG_NUM);
+  EXPECT_NEAR(ExpValArena::halfToFloat(ExpValArena::floatToHalf(0.3f)), 0.3f, 1e-3f);
+  EXPECT_NEAR(ExpValArena::halfToFloat(ExpValArena::floatToHalf(-12.345f)), -12.345f, 1e-2f);
+  EXPECT_NEAR(ExpValArena::halfToFloat(ExpValArena::floatToHalf(1e-6f)), 1e-6f, 1e-7f);
+}
+
+TEST(ExpValArenaTest, spillFile)
+{
+  ExpValArena arena;
+  arena.setHalfPrecision(true);
+  ASSERT_EQ(arena.setSpillFile("exp_val_arena_test.spill"), THOT_OK);
+  arena.grow(100);
+  for (unsigned int np = 0; np < 100; ++np)
+  {
+    arena.allocate(np, 10, 10, 1, 99);
+    arena.set(np, 9, 9, 0, (float)np);
+  }
+  for (unsigned int np = 0; np < 100; ++np)
+  {
+    EXPECT_EQ(arena.get(np, 9, 9, 0), (float)np);
+    EXPECT_EQ(arena.get(np, 0, 0, 0), 99.0f);
+  }
+}
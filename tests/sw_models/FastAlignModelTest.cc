@@ -1,9 +1,14 @@
 #include "sw_models/FastAlignModel.h"
 
 #include "TestUtils.h"
+#include "nlp_common/ErrorDefs.h"
 #include "nlp_common/MathDefs.h"
 
+#include <cstdio>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <omp.h>
+#include <sstream>
 
 TEST(FastAlignModelTest, trainEmpty)
 {
@@ -58,3 +63,129 @@ TEST(FastAlignModelTest, computeLogProb)
   LgProb logProb = model.computeLogProb("isthay isyay ayay esttay-N .", "this is a test N NULL .", waMatrix);
   EXPECT_NEAR(logProb, expectedLogProb, EPSILON);
 }
+
+TEST(FastAlignModelTest, getAlignmentPosteriors)
+{
+  FastAlignModel model;
+  addTrainingData(model);
+  train(model, 2);
+
+  std::vector<WordIndex> srcSentence = model.strVectorToSrcIndexVector({"isthay", "isyay", "ayay", "esttay-N", "."});
+  std::vector<WordIndex> trgSentence = model.strVectorToTrgIndexVector({"this", "is", "a", "test", "N", "."});
+  size_t slen = srcSentence.size();
+  size_t tlen = trgSentence.size();
+  std::vector<float> posteriors(slen * tlen);
+  model.getAlignmentPosteriors(srcSentence, trgSentence, posteriors.data());
+
+  // With independent alignment positions, the Viterbi alignment picks the most probable source word
+  std::vector<PositionIndex> alignment;
+  model.getBestAlignment(srcSentence, trgSentence, alignment);
+  for (size_t j = 0; j < tlen; ++j)
+  {
+    float sum = 0;
+    size_t best_i = 0;
+    for (size_t i = 0; i < slen; ++i)
+    {
+      sum += posteriors[i * tlen + j];
+      if (posteriors[i * tlen + j] > posteriors[best_i * tlen + j])
+        best_i = i;
+    }
+    EXPECT_LE(sum, 1.0f + EPSILON);
+    EXPECT_EQ(best_i + 1, alignment[j]);
+  }
+
+  std::vector<WordIndex> srcWordIndices = srcSentence;
+  srcWordIndices.insert(srcWordIndices.end(), srcSentence.begin(), srcSentence.begin() + 2);
+  std::vector<WordIndex> trgWordIndices = trgSentence;
+  trgWordIndices.insert(trgWordIndices.end(), trgSentence.begin(), trgSentence.begin() + 3);
+  size_t srcOffsets[3] = {0, slen, slen + 2};
+  size_t trgOffsets[3] = {0, tlen, tlen + 3};
+  size_t posteriorOffsets[3] = {0, slen * tlen, slen * tlen + 6};
+  std::vector<float> batchPosteriors(posteriorOffsets[2]);
+  model.getAlignmentPosteriors(srcWordIndices.data(), srcOffsets, trgWordIndices.data(), trgOffsets, 2,
+                               posteriorOffsets, batchPosteriors.data());
+  EXPECT_EQ(std::vector<float>(batchPosteriors.begin(), batchPosteriors.begin() + slen * tlen), posteriors);
+  model.getAlignmentPosteriors(std::vector<WordIndex>(srcSentence.begin(), srcSentence.begin() + 2),
+                               std::vector<WordIndex>(trgSentence.begin(), trgSentence.begin() + 3),
+                               posteriors.data());
+  EXPECT_EQ(std::vector<float>(batchPosteriors.begin() + slen * tlen, batchPosteriors.end()),
+            std::vector<float>(posteriors.begin(), posteriors.begin() + 6));
+}
+
+TEST(FastAlignModelTest, loglikelihoodForAllSentences)
+{
+  FastAlignModel model;
+  addTrainingData(model);
+  train(model, 2);
+
+  double expectedLogLikelihood = 0;
+  for (unsigned int n = 0; n < model.numSentencePairs(); ++n)
+  {
+    std::vector<std::string> srcSentence, trgSentence;
+    Count c;
+    model.getSentencePair(n, srcSentence, trgSentence, c);
+    expectedLogLikelihood += (double)model.computeSumLogProb(srcSentence, trgSentence);
+  }
+
+  int maxThreads = omp_get_max_threads();
+  omp_set_num_threads(4);
+  std::pair<double, double> logLikelihood = model.loglikelihoodForAllSentences();
+  omp_set_num_threads(maxThreads);
+  EXPECT_NEAR(logLikelihood.first, expectedLogLikelihood, 0.001);
+  EXPECT_NEAR(logLikelihood.second, expectedLogLikelihood / model.numSentencePairs(), 0.001);
+}
+
+TEST(FastAlignModelTest, trainWithEarlyStopping)
+{
+  FastAlignModel model;
+  addTrainingData(model);
+  model.addHeldOutSentencePair({"isthay", "isyay", "ayay", "esttay-N", "."}, {"this", "is", "a", "test", "N", "."});
+  model.addHeldOutSentencePair({"isthay", "isyay", "unknownyay", "."}, {"this", "is", "unknown", "."});
+  EXPECT_EQ(model.numHeldOutSentencePairs(), 2u);
+
+  model.startTraining();
+  unsigned int numIters = model.trainIterations(100, 0.01);
+  model.endTraining();
+  EXPECT_GE(numIters, 2u);
+  EXPECT_LT(numIters, 100u);
+  EXPECT_FALSE(model.existSrcSymbol("unknownyay"));
+  EXPECT_LT(model.loglikelihoodForHeldOutSentences().second, 0);
+}
+
+TEST(FastAlignModelTest, getBestAlignmentsForFiles)
+{
+  FastAlignModel model;
+  addTrainingData(model);
+  train(model, 2);
+
+  std::vector<std::string> srcSentences{"isthay isyay ayay esttay-N .", "", "isthay isyay otnay ayay esttay-N ."};
+  std::vector<std::string> trgSentences{"this is a test N .", "this is", "this is not a test N ."};
+  std::ofstream srcFile("fast_align_test.src"), trgFile("fast_align_test.trg");
+  for (size_t k = 0; k < srcSentences.size(); ++k)
+  {
+    srcFile << srcSentences[k] << "\n";
+    trgFile << trgSentences[k] << "\n";
+  }
+  srcFile.close();
+  trgFile.close();
+
+  std::ostringstream expected;
+  for (size_t k : {0, 2})
+  {
+    std::vector<PositionIndex> alignment;
+    LgProb logProb = model.getBestAlignment(srcSentences[k].c_str(), trgSentences[k].c_str(), alignment);
+    expected << "# Sentence pair " << k + 1 << " ";
+    model.printAligInGizaFormat(srcSentences[k].c_str(), trgSentences[k].c_str(), logProb.get_p(), alignment,
+                                expected);
+  }
+
+  ASSERT_EQ(model.getBestAlignments("fast_align_test.src", "fast_align_test.trg", "fast_align_test.A3.final"),
+            THOT_OK);
+  std::ifstream outFile("fast_align_test.A3.final");
+  std::ostringstream output;
+  output << outFile.rdbuf();
+  EXPECT_EQ(output.str(), expected.str());
+
+  for (const char* ext : {".src", ".trg", ".A3.final"})
+    std::remove((std::string("fast_align_test") + ext).c_str());
+}
@@ -1,10 +1,14 @@
 #include "sw_models/Ibm4AlignmentModel.h"
 
 #include "TestUtils.h"
+#include "nlp_common/ErrorDefs.h"
 #include "nlp_common/MathDefs.h"
 #include "nlp_common/StrProcUtils.h"
+#include "sw_models/FastAlignModel.h"
 #include "sw_models/SwDefs.h"
 
+#include <cstdio>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <memory>
 
@@ -104,6 +108,90 @@ TEST_F(Ibm4AlignmentModelTest, computeLogProb)
   EXPECT_NEAR(logProb.get_p(), 0.2905, 0.0001);
 }
 
+TEST_F(Ibm4AlignmentModelTest, printAndLoad)
+{
+  createTrainedModel();
+  std::vector<PositionIndex> alignment;
+  LgProb logProb = model->getBestAlignment("ich esse ja gern räucherschinken", "i love to eat smoked ham", alignment);
+  ASSERT_EQ(model->print("ibm4_print_test"), THOT_OK);
+
+  Ibm4AlignmentModel loadedModel;
+  ASSERT_EQ(loadedModel.load("ibm4_print_test"), THOT_OK);
+  std::vector<PositionIndex> loadedAlignment;
+  LgProb loadedLogProb =
+      loadedModel.getBestAlignment("ich esse ja gern räucherschinken", "i love to eat smoked ham", loadedAlignment);
+  EXPECT_EQ(loadedAlignment, alignment);
+  EXPECT_NEAR(loadedLogProb, logProb, EPSILON);
+
+  for (const char* ext : {".yml", ".svcb", ".tvcb", ".src", ".trg", ".srctrgc", ".src_class_names", ".src_classes",
+                          ".trg_class_names", ".trg_classes", ".ibm_lexnd", ".slmodel", ".ibm2_alignd", ".p1",
+                          ".distnd", ".fertnd", ".h_distnd", ".nh_distnd"})
+    std::remove((std::string("ibm4_print_test") + ext).c_str());
+}
+
+TEST_F(Ibm4AlignmentModelTest, printAndLoadContainer)
+{
+  createTrainedModel();
+  std::vector<PositionIndex> alignment;
+  LgProb logProb = model->getBestAlignment("ich esse ja gern räucherschinken", "i love to eat smoked ham", alignment);
+  ASSERT_EQ(model->printContainer("ibm4_container_test.bin"), THOT_OK);
+
+  Ibm4AlignmentModel loadedModel;
+  ASSERT_EQ(loadedModel.loadContainer("ibm4_container_test.bin"), THOT_OK);
+  EXPECT_TRUE(loadedModel.isVocabFrozen());
+  std::vector<PositionIndex> loadedAlignment;
+  LgProb loadedLogProb =
+      loadedModel.getBestAlignment("ich esse ja gern räucherschinken", "i love to eat smoked ham", loadedAlignment);
+  EXPECT_EQ(loadedAlignment, alignment);
+  EXPECT_NEAR(loadedLogProb, logProb, EPSILON);
+
+  FastAlignModel otherModel;
+  EXPECT_EQ(otherModel.loadContainer("ibm4_container_test.bin"), THOT_ERROR);
+
+  std::remove("ibm4_container_test.bin");
+}
+
+TEST_F(Ibm4AlignmentModelTest, trainFromCheckpoint)
+{
+  Ibm1AlignmentModel model1;
+  addTrainingDataWordClasses(model1);
+  addTrainingData(model1);
+  train(model1, 1);
+  Ibm2AlignmentModel model2{model1};
+  train(model2, 1);
+  Ibm3AlignmentModel model3{model2};
+  train(model3, 1);
+
+  model.reset(new Ibm4AlignmentModel{model3});
+  model->startTraining();
+  EXPECT_EQ(model->printCheckpoint("ibm4_checkpoint_test"), THOT_ERROR);
+  model->train();
+  ASSERT_EQ(model->printCheckpoint("ibm4_checkpoint_test"), THOT_OK);
+  model->train();
+
+  Ibm4AlignmentModel resumedModel;
+  ASSERT_EQ(resumedModel.loadCheckpoint("ibm4_checkpoint_test"), THOT_OK);
+  resumedModel.train();
+
+  for (const std::pair<const char*, const char*>& sentencePair :
+       {std::make_pair("isthay isyay ayay esttay-N .", "this is a test N ."),
+        std::make_pair("isthay isyay otnay ayay esttay-N .", "this is not a test N ."),
+        std::make_pair("isthay isyay ayay esttay-N ardhay .", "this is a hard test N .")})
+  {
+    std::vector<PositionIndex> alignment;
+    LgProb logProb = model->getBestAlignment(sentencePair.first, sentencePair.second, alignment);
+    std::vector<PositionIndex> resumedAlignment;
+    LgProb resumedLogProb = resumedModel.getBestAlignment(sentencePair.first, sentencePair.second, resumedAlignment);
+    EXPECT_EQ(resumedAlignment, alignment);
+    EXPECT_NEAR(resumedLogProb, logProb, 0.001);
+  }
+
+  for (const char* ext : {".yml", ".svcb", ".tvcb", ".src", ".trg", ".srctrgc", ".src_class_names", ".src_classes",
+                          ".trg_class_names", ".trg_classes", ".ibm_lexnd", ".slmodel", ".ibm2_alignd", ".p1",
+                          ".distnd", ".fertnd", ".h_distnd", ".nh_distnd", ".train_state"})
+    std::remove((std::string("ibm4_checkpoint_test") + ext).c_str());
+}
+
 TEST_F(Ibm4AlignmentModelTest, trainIbm2)
 {
   Ibm1AlignmentModel model1;
@@ -272,3 +360,39 @@ TEST_F(Ibm4AlignmentModelTest, nonheadDistortionProbDefaultNoSmoothing)
   Prob prob = model->nonheadDistortionProb(1, 6, 0);
   EXPECT_NEAR(prob, SW_PROB_SMOOTH, EPSILON);
 }
+
+TEST_F(Ibm4AlignmentModelTest, trainingMetrics)
+{
+  model.reset(new Ibm4AlignmentModel);
+  addTrainingDataWordClasses(*model);
+  addTrainingData(*model);
+  std::remove("ibm4_metrics_test.jsonl");
+  ASSERT_EQ(model->setTrainingMetricsFile("ibm4_metrics_test.jsonl"), THOT_OK);
+  train(*model, 2);
+
+  // The base class functions called by Ibm4AlignmentModel are not counted again
+  TrainingMetrics metrics = model->getTrainingMetrics();
+  EXPECT_EQ(metrics.startTraining.count, 1u);
+  EXPECT_EQ(metrics.iteration.count, 2u);
+  EXPECT_EQ(metrics.mStep.count, 2u);
+  EXPECT_GE(metrics.eStep.count, 2u);
+  EXPECT_GE(metrics.iteration.wallTime, metrics.eStep.wallTime);
+  EXPECT_GT(metrics.numTokens, 0u);
+  EXPECT_EQ(metrics.numSentencePairs, model->numSentencePairs());
+  EXPECT_EQ(metrics.srcVocabSize, model->getSrcVocabSize());
+
+  std::ifstream metricsFile("ibm4_metrics_test.jsonl");
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(metricsFile, line))
+    lines.push_back(line);
+  metricsFile.close();
+  ASSERT_EQ(lines.size(), 3u);
+  EXPECT_EQ(lines[0].find("{\"event\":\"start_training\""), 0u);
+  EXPECT_EQ(lines[2].find("{\"event\":\"iteration\",\"start_training\":{\"count\":1,"), 0u);
+  EXPECT_NE(lines[2].find("\"iteration\":{\"count\":2,"), std::string::npos);
+
+  model->clearTrainingMetrics();
+  EXPECT_EQ(model->getTrainingMetrics().iteration.count, 0u);
+  std::remove("ibm4_metrics_test.jsonl");
+}
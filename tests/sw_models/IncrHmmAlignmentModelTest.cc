@@ -1,8 +1,10 @@
 #include "sw_models/IncrHmmAlignmentModel.h"
 
 #include "TestUtils.h"
+#include "nlp_common/ErrorDefs.h"
 
 #include <gtest/gtest.h>
+#include <omp.h>
 
 TEST(IncrHmmAlignmentModelTest, train)
 {
@@ -40,6 +42,55 @@ TEST(IncrHmmAlignmentModelTest, incrTrain)
   EXPECT_EQ(alignment, (std::vector<PositionIndex>{1, 2, 3, 5, 4, 4, 4}));
 }
 
+TEST(IncrHmmAlignmentModelTest, incrTrainHalfPrecisionSpillFile)
+{
+  IncrHmmAlignmentModel model;
+  model.setHmmP0(0.1);
+  model.set_expval_half_precision(true);
+  ASSERT_EQ(model.set_expval_spill_file_prefix("incr_hmm_spill_test"), THOT_OK);
+  addTrainingData(model);
+  incrTrain(model, std::make_pair(0, model.numSentencePairs() - 1), 2);
+
+  std::vector<PositionIndex> alignment;
+  model.getBestAlignment("isthay isyay ayay esttay-N .", "this is a test N .", alignment);
+  EXPECT_EQ(alignment, (std::vector<PositionIndex>{1, 2, 3, 4, 4, 5}));
+
+  model.getBestAlignment("isthay isyay otnay ayay esttay-N .", "this is not a test N .", alignment);
+  EXPECT_EQ(alignment, (std::vector<PositionIndex>{1, 2, 4, 4, 5, 5, 5}));
+
+  model.getBestAlignment("isthay isyay ayay esttay-N ardhay .", "this is a hard test N .", alignment);
+  EXPECT_EQ(alignment, (std::vector<PositionIndex>{1, 2, 3, 5, 4, 4, 4}));
+}
+
+TEST(IncrHmmAlignmentModelTest, incrTrainMultipleThreads)
+{
+  int maxThreads = omp_get_max_threads();
+  IncrHmmAlignmentModel serialModel;
+  serialModel.setHmmP0(0.1);
+  addTrainingData(serialModel);
+  omp_set_num_threads(1);
+  incrTrain(serialModel, std::make_pair(0, serialModel.numSentencePairs() - 1), 2);
+
+  IncrHmmAlignmentModel parallelModel;
+  parallelModel.setHmmP0(0.1);
+  addTrainingData(parallelModel);
+  omp_set_num_threads(4);
+  incrTrain(parallelModel, std::make_pair(0, parallelModel.numSentencePairs() - 1), 2);
+  omp_set_num_threads(maxThreads);
+
+  for (const char* src : {"isthay", "esttay-N", "ayay"})
+  {
+    for (const char* trg : {"this", "test", "a", "N"})
+    {
+      WordIndex s = serialModel.addSrcSymbol(src);
+      WordIndex t = serialModel.addTrgSymbol(trg);
+      EXPECT_NEAR(parallelModel.translationLogProb(s, t), serialModel.translationLogProb(s, t), 0.001);
+    }
+  }
+  for (PositionIndex i = 1; i <= 5; ++i)
+    EXPECT_NEAR(parallelModel.hmmAlignmentLogProb(0, 5, i), serialModel.hmmAlignmentLogProb(0, 5, i), 0.001);
+}
+
 TEST(IncrHmmAlignmentModelTest, computeLogProb)
 {
   IncrHmmAlignmentModel model;
@@ -54,3 +105,34 @@ TEST(IncrHmmAlignmentModelTest, computeLogProb)
   LgProb logProb = model.computeLogProb("isthay isyay ayay esttay-N .", "this is a test N NULL .", waMatrix);
   EXPECT_NEAR(logProb, expectedLogProb, EPSILON);
 }
+
+TEST(IncrHmmAlignmentModelTest, getAlignmentPosteriors)
+{
+  IncrHmmAlignmentModel model;
+  model.setHmmP0(0.1);
+  addTrainingData(model);
+  train(model, 2);
+
+  std::vector<WordIndex> srcSentence = model.strVectorToSrcIndexVector({"isthay", "isyay", "ayay", "esttay-N", "."});
+  std::vector<WordIndex> trgSentence = model.strVectorToTrgIndexVector({"this", "is", "a", "test", "N", "."});
+  size_t slen = srcSentence.size();
+  size_t tlen = trgSentence.size();
+  std::vector<float> posteriors(slen * tlen);
+  model.getAlignmentPosteriors(srcSentence, trgSentence, posteriors.data());
+
+  std::vector<PositionIndex> alignment;
+  for (size_t j = 0; j < tlen; ++j)
+  {
+    float sum = 0;
+    size_t best_i = 0;
+    for (size_t i = 0; i < slen; ++i)
+    {
+      sum += posteriors[i * tlen + j];
+      if (posteriors[i * tlen + j] > posteriors[best_i * tlen + j])
+        best_i = i;
+    }
+    EXPECT_LE(sum, 1.0f + 1e-4f);
+    alignment.push_back((PositionIndex)best_i + 1);
+  }
+  EXPECT_EQ(alignment, (std::vector<PositionIndex>{1, 2, 3, 4, 4, 5}));
+}
@@ -0,0 +1,78 @@
+#include "sw_models/SymmetrizedAligner.h"
+
+#include "TestUtils.h"
+#include "nlp_common/StrProcUtils.h"
+#include "sw_models/FastAlignModel.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace
+{
+std::shared_ptr<SymmetrizedAligner> createAligner()
+{
+  auto directModel = std::make_shared<FastAlignModel>();
+  addTrainingData(*directModel);
+  train(*directModel, 2);
+  auto inverseModel = std::make_shared<FastAlignModel>();
+  addInverseTrainingData(*inverseModel);
+  train(*inverseModel, 2);
+  return std::make_shared<SymmetrizedAligner>(directModel, inverseModel);
+}
+
+void encode(const Aligner& aligner, const std::vector<std::string>& sentences, bool source,
+            std::vector<WordIndex>& wordIndices, std::vector<size_t>& wordOffsets)
+{
+  std::string buffer;
+  std::vector<size_t> sentenceOffsets{0};
+  for (auto& sentence : sentences)
+  {
+    buffer += sentence;
+    sentenceOffsets.push_back(buffer.size());
+  }
+  wordOffsets.resize(sentences.size() + 1);
+  wordIndices.resize(
+      StrProcUtils::countSentenceWords(buffer.data(), sentenceOffsets.data(), sentences.size(), wordOffsets.data()));
+  if (source)
+    aligner.encodeSrcSentences(buffer.data(), sentenceOffsets.data(), sentences.size(), wordOffsets.data(),
+                               wordIndices.data());
+  else
+    aligner.encodeTrgSentences(buffer.data(), sentenceOffsets.data(), sentences.size(), wordOffsets.data(),
+                               wordIndices.data());
+}
+} // namespace
+
+TEST(SymmetrizedAlignerTest, getBestAlignments)
+{
+  std::shared_ptr<SymmetrizedAligner> aligner = createAligner();
+  std::vector<std::string> srcSentences{"isthay isyay ayay esttay-N .", "isthay isyay otnay ayay esttay-N .",
+                                        "isthay isyay ayay esttay-N ardhay ."};
+  std::vector<std::string> trgSentences{"this is a test N .", "this is not a test N .", "this is a hard test N ."};
+
+  std::vector<WordIndex> srcWordIndices, trgWordIndices;
+  std::vector<size_t> srcOffsets, trgOffsets;
+  encode(*aligner, srcSentences, true, srcWordIndices, srcOffsets);
+  encode(*aligner, trgSentences, false, trgWordIndices, trgOffsets);
+
+  for (SymmetrizationHeuristic heuristic :
+       {SymmetrizationHeuristic::None, SymmetrizationHeuristic::Och, SymmetrizationHeuristic::GrowDiagFinalAnd})
+  {
+    aligner->setHeuristic(heuristic);
+    std::vector<LgProb> logProbs(srcSentences.size());
+    std::vector<WordAlignmentMatrix> waMatrices(srcSentences.size());
+    aligner->getBestAlignments(srcWordIndices.data(), srcOffsets.data(), trgWordIndices.data(), trgOffsets.data(),
+                               srcSentences.size(), logProbs.data(), waMatrices.data());
+
+    for (size_t k = 0; k < srcSentences.size(); ++k)
+    {
+      std::vector<WordIndex> srcSentence(srcWordIndices.begin() + srcOffsets[k],
+                                         srcWordIndices.begin() + srcOffsets[k + 1]);
+      std::vector<WordIndex> trgSentence(trgWordIndices.begin() + trgOffsets[k],
+                                         trgWordIndices.begin() + trgOffsets[k + 1]);
+      WordAlignmentMatrix waMatrix;
+      LgProb logProb = aligner->getBestAlignment(srcSentence, trgSentence, waMatrix);
+      EXPECT_EQ(waMatrices[k], waMatrix);
+      EXPECT_DOUBLE_EQ((double)logProbs[k], (double)logProb);
+    }
+  }
+}
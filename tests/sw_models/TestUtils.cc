@@ -12,16 +12,29 @@ pair<unsigned int, unsigned int> addSentencePair(AlignmentModel& model, const st
   return model.addSentencePair(srcTokens, trgTokens, 1);
 }
 
+namespace
+{
+const vector<pair<string, string>> TRAINING_DATA = {
+    {"isthay isyay ayay esttay-N .", "this is a test N ."},
+    {"ouyay ouldshay esttay-V oftenyay .", "you should test V often ."},
+    {"isyay isthay orkingway ?", "is this working ?"},
+    {"isthay ouldshay orkway-V .", "this should work V ."},
+    {"ityay isyay orkingway .", "it is working ."},
+    {"orkway-N ancay ebay ardhay !", "work N can be hard !"},
+    {"ayay esttay-N ancay ebay ardhay .", "a test N can be hard ."},
+    {"isthay isyay ayay ordway !", "this is a word !"}};
+} // namespace
+
 void addTrainingData(AlignmentModel& model)
 {
-  addSentencePair(model, "isthay isyay ayay esttay-N .", "this is a test N .");
-  addSentencePair(model, "ouyay ouldshay esttay-V oftenyay .", "you should test V often .");
-  addSentencePair(model, "isyay isthay orkingway ?", "is this working ?");
-  addSentencePair(model, "isthay ouldshay orkway-V .", "this should work V .");
-  addSentencePair(model, "ityay isyay orkingway .", "it is working .");
-  addSentencePair(model, "orkway-N ancay ebay ardhay !", "work N can be hard !");
-  addSentencePair(model, "ayay esttay-N ancay ebay ardhay .", "a test N can be hard .");
-  addSentencePair(model, "isthay isyay ayay ordway !", "this is a word !");
+  for (auto& pair : TRAINING_DATA)
+    addSentencePair(model, pair.first, pair.second);
+}
+
+void addInverseTrainingData(AlignmentModel& model)
+{
+  for (auto& pair : TRAINING_DATA)
+    addSentencePair(model, pair.second, pair.first);
 }
 
 void addTrainingDataWordClasses(AlignmentModel& model)
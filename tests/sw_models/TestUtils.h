@@ -8,6 +8,7 @@
 std::pair<unsigned int, unsigned int> addSentencePair(AlignmentModel& model, const std::string& srcSentence,
                                                       const std::string& trgSentence);
 void addTrainingData(AlignmentModel& model);
+void addInverseTrainingData(AlignmentModel& model);
 void addTrainingDataWordClasses(AlignmentModel& model);
 void addSrcWordClass(AlignmentModel& model, const std::string& c, const std::unordered_set<std::string>& words);
 void addTrgWordClass(AlignmentModel& model, const std::string& c, const std::unordered_set<std::string>& words);
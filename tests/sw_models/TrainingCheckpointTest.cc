@@ -0,0 +1,215 @@
+#include "TestUtils.h"
+#include "nlp_common/ErrorDefs.h"
+#include "nlp_common/ModelContainer.h"
+#include "sw_models/FastAlignModel.h"
+#include "sw_models/HmmAlignmentModel.h"
+#include "sw_models/Ibm1Eflomal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+const char* const CHECKPOINT_PREFIX = "training_checkpoint_test";
+
+// Trains the model for one iteration, checkpoints it and trains it for one more. The
+// seed makes the sampling of the Eflomal model repeatable
+void trainAroundCheckpoint(AlignmentModel& model)
+{
+  model.startTraining();
+  model.train();
+  ASSERT_EQ(model.printCheckpoint(CHECKPOINT_PREFIX), THOT_OK);
+  srand(31);
+  model.train();
+}
+
+void resumeFromCheckpoint(AlignmentModel& model)
+{
+  ASSERT_EQ(model.loadCheckpoint(CHECKPOINT_PREFIX), THOT_OK);
+  srand(31);
+  model.train();
+}
+
+void expectSameAlignments(AlignmentModel& model, AlignmentModel& resumedModel)
+{
+  for (const std::pair<const char*, const char*>& sentencePair :
+       {std::make_pair("isthay isyay ayay esttay-N .", "this is a test N ."),
+        std::make_pair("isthay isyay otnay ayay esttay-N .", "this is not a test N ."),
+        std::make_pair("isthay isyay ayay esttay-N ardhay .", "this is a hard test N .")})
+  {
+    std::vector<PositionIndex> alignment;
+    LgProb logProb = model.getBestAlignment(sentencePair.first, sentencePair.second, alignment);
+    std::vector<PositionIndex> resumedAlignment;
+    LgProb resumedLogProb = resumedModel.getBestAlignment(sentencePair.first, sentencePair.second, resumedAlignment);
+    EXPECT_EQ(resumedAlignment, alignment);
+    EXPECT_NEAR(resumedLogProb, logProb, 0.001);
+  }
+}
+
+// Rewrites the training state of the checkpoint with the given section replaced
+void replaceSection(const std::vector<std::string>& sectionNames, const std::string& name, const std::string& data)
+{
+  std::string fileName = std::string(CHECKPOINT_PREFIX) + ".train_state";
+  ModelContainer container;
+  ASSERT_EQ(container.open(fileName.c_str()), THOT_OK);
+  ModelContainer corruptContainer;
+  corruptContainer.setModelType(container.getModelType());
+  for (const std::string& sectionName : sectionNames)
+  {
+    const char* sectionData;
+    std::size_t size;
+    ASSERT_EQ(container.getSection(sectionName, sectionData, size), THOT_OK);
+    corruptContainer.addSection(sectionName, sectionName == name ? data : std::string(sectionData, size));
+  }
+  container.clear();
+  ASSERT_EQ(corruptContainer.write(fileName.c_str()), THOT_OK);
+}
+
+std::string readSection(const std::string& name)
+{
+  ModelContainer container;
+  const char* data;
+  std::size_t size;
+  if (container.open((std::string(CHECKPOINT_PREFIX) + ".train_state").c_str()) == THOT_ERROR
+      || container.getSection(name, data, size) == THOT_ERROR)
+    return "";
+  return std::string(data, size);
+}
+
+std::string readTrainingState()
+{
+  std::ifstream in(std::string(CHECKPOINT_PREFIX) + ".train_state", std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void writeTrainingState(const std::string& data)
+{
+  std::ofstream out(std::string(CHECKPOINT_PREFIX) + ".train_state", std::ios::binary);
+  out << data;
+}
+
+std::string encodeUInts(const std::vector<unsigned int>& values)
+{
+  return std::string((const char*)values.data(), values.size() * sizeof(unsigned int));
+}
+
+// Every section of the training state, cut in half, makes loading the checkpoint fail
+template <typename Model>
+void expectTruncatedSectionsFail(const std::vector<std::string>& sectionNames)
+{
+  std::string original = readTrainingState();
+  for (const std::string& name : sectionNames)
+  {
+    std::string data = readSection(name);
+    replaceSection(sectionNames, name, data.substr(0, data.size() / 2));
+    Model model;
+    EXPECT_EQ(model.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR) << name;
+    writeTrainingState(original);
+  }
+
+  writeTrainingState(original.substr(0, original.size() / 2));
+  Model model;
+  EXPECT_EQ(model.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+  writeTrainingState(original);
+}
+
+void removeCheckpoint()
+{
+  for (const char* ext : {".yml", ".svcb", ".tvcb", ".src", ".trg", ".srctrgc", ".src_class_names", ".src_classes",
+                          ".trg_class_names", ".trg_classes", ".ibm_lexnd", ".slmodel", ".ibm2_alignd", ".hmm_alignd",
+                          ".hmm_lexnd", ".anji", ".hmm_p0", ".fa_lexnd", ".size_counts", ".params", ".train_state"})
+    std::remove((std::string(CHECKPOINT_PREFIX) + ext).c_str());
+}
+} // namespace
+
+TEST(TrainingCheckpointTest, hmm)
+{
+  HmmAlignmentModel model;
+  addTrainingData(model);
+  trainAroundCheckpoint(model);
+
+  HmmAlignmentModel resumedModel;
+  resumeFromCheckpoint(resumedModel);
+  expectSameAlignments(model, resumedModel);
+
+  std::vector<std::string> sectionNames = {".num_sent_pairs", ".lex_counts", ".alignment_counts",
+                                           ".hmm_alignment_counts"};
+  expectTruncatedSectionsFail<HmmAlignmentModel>(sectionNames);
+
+  // An entry that claims more counts than the section holds, and one with a position beyond the
+  // longest sentence
+  std::string original = readTrainingState();
+  replaceSection(sectionNames, ".hmm_alignment_counts", encodeUInts({1, 1, 5, 0x40000000}));
+  HmmAlignmentModel corruptModel;
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+  replaceSection(sectionNames, ".hmm_alignment_counts", encodeUInts({1, 0x7fffffff, 5, 0}));
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+
+  // Counts that fit in the section but not in the tables that training indexes: a row of
+  // the wrong size, and a target word outside the vocabulary
+  writeTrainingState(original);
+  replaceSection(sectionNames, ".hmm_alignment_counts", encodeUInts({1, 0, 0, 1, 0, 0}));
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+  writeTrainingState(original);
+  replaceSection(sectionNames, ".alignment_counts", encodeUInts({1, 1, 3, 0, 1, 0, 0}));
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+  writeTrainingState(original);
+  replaceSection(sectionNames, ".lex_counts", encodeUInts({1, 1, 0x7ffffff0, 0, 0}));
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+  writeTrainingState(original);
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_OK);
+
+  removeCheckpoint();
+}
+
+TEST(TrainingCheckpointTest, fastAlign)
+{
+  FastAlignModel model;
+  addTrainingData(model);
+  trainAroundCheckpoint(model);
+
+  FastAlignModel resumedModel;
+  resumeFromCheckpoint(resumedModel);
+  expectSameAlignments(model, resumedModel);
+
+  std::vector<std::string> sectionNames = {".num_sent_pairs", ".iter", ".lex_counts"};
+  expectTruncatedSectionsFail<FastAlignModel>(sectionNames);
+
+  replaceSection(sectionNames, ".lex_counts", encodeUInts({0xfffffff0}));
+  FastAlignModel corruptModel;
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+
+  removeCheckpoint();
+}
+
+TEST(TrainingCheckpointTest, eflomal)
+{
+  Ibm1Eflomal model;
+  addTrainingData(model);
+  trainAroundCheckpoint(model);
+
+  Ibm1Eflomal resumedModel;
+  resumeFromCheckpoint(resumedModel);
+  expectSameAlignments(model, resumedModel);
+
+  std::vector<std::string> sectionNames = {".num_sent_pairs", ".lex_counts", ".links", ".eflomal_counts",
+                                           ".dirichlet"};
+  std::string original = readTrainingState();
+  expectTruncatedSectionsFail<Ibm1Eflomal>(sectionNames);
+
+  // The links of a sentence pair longer than the section, and a dirichlet table larger than it
+  std::vector<unsigned int> links = {(unsigned int)model.numSentencePairs(), 0x7fffffff};
+  replaceSection(sectionNames, ".links", encodeUInts(links));
+  Ibm1Eflomal corruptModel;
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+  writeTrainingState(original);
+  replaceSection(sectionNames, ".dirichlet", encodeUInts({0xfffffff0}));
+  EXPECT_EQ(corruptModel.loadCheckpoint(CHECKPOINT_PREFIX), THOT_ERROR);
+
+  removeCheckpoint();
+}
@@ -1,5 +1,5 @@
 from enum import Enum
-from typing import Optional, Sequence, Tuple, overload
+from typing import Any, Optional, Sequence, Tuple, overload
 
 from ..common import WordAlignmentMatrix
 
@@ -7,6 +7,14 @@ class Aligner:
     def get_src_word_index(self, word: str) -> int: ...
     def get_trg_word_index(self, word: str) -> int: ...
     @overload
+    def encode_src_sentences(self, sentences: Sequence[str]) -> Tuple[Any, Any]: ...
+    @overload
+    def encode_src_sentences(self, buffer: bytes, sentence_offsets: Any) -> Tuple[Any, Any]: ...
+    @overload
+    def encode_trg_sentences(self, sentences: Sequence[str]) -> Tuple[Any, Any]: ...
+    @overload
+    def encode_trg_sentences(self, buffer: bytes, sentence_offsets: Any) -> Tuple[Any, Any]: ...
+    @overload
     def get_best_alignment(self, src_sentence: str, trg_sentence: str) -> Tuple[float, WordAlignmentMatrix]: ...
     @overload
     def get_best_alignment(
@@ -24,6 +32,10 @@ class Aligner:
     def get_best_alignments(
         self, src_sentences: Sequence[Sequence[str]], trg_sentences: Sequence[Sequence[str]]
     ) -> Sequence[Tuple[float, WordAlignmentMatrix]]: ...
+    @overload
+    def get_best_alignments(
+        self, src_word_indices: Any, src_offsets: Any, trg_word_indices: Any, trg_offsets: Any
+    ) -> Tuple[Any, Any]: ...
 
 class SymmetrizationHeuristic(Enum):
     NONE = ...
@@ -53,6 +65,46 @@ class AlignmentModelType(Enum):
     INCR_IBM2 = ...
     INCR_HMM = ...
 
+class TrainingPhaseMetrics:
+    @property
+    def count(self) -> int: ...
+    @property
+    def wall_time(self) -> float: ...
+    @property
+    def cpu_time(self) -> float: ...
+
+class TrainingMetrics:
+    @property
+    def start_training(self) -> TrainingPhaseMetrics: ...
+    @property
+    def iteration(self) -> TrainingPhaseMetrics: ...
+    @property
+    def io(self) -> TrainingPhaseMetrics: ...
+    @property
+    def e_step(self) -> TrainingPhaseMetrics: ...
+    @property
+    def m_step(self) -> TrainingPhaseMetrics: ...
+    @property
+    def reduction(self) -> TrainingPhaseMetrics: ...
+    @property
+    def load(self) -> TrainingPhaseMetrics: ...
+    @property
+    def save(self) -> TrainingPhaseMetrics: ...
+    @property
+    def num_tokens(self) -> int: ...
+    @property
+    def tokens_per_second(self) -> float: ...
+    @property
+    def peak_rss(self) -> int: ...
+    @property
+    def src_vocab_size(self) -> int: ...
+    @property
+    def trg_vocab_size(self) -> int: ...
+    @property
+    def num_sentence_pairs(self) -> int: ...
+    @property
+    def num_lex_counts(self) -> int: ...
+
 class AlignmentModel(Aligner):
     @property
     def model_type(self) -> AlignmentModelType: ...
@@ -68,6 +120,8 @@ class AlignmentModel(Aligner):
     def variational_bayes(self, value: bool) -> None: ...
     @property
     def max_sentence_length(self) -> int: ...
+    @property
+    def vocab_frozen(self) -> bool: ...
     def read_sentence_pairs(
         self, src_filename: str, trg_filename: str, counts_filename: Optional[str] = None
     ) -> None: ...
@@ -81,9 +135,31 @@ class AlignmentModel(Aligner):
     def add_trg_word(self, word: str) -> int: ...
     def get_trg_word(self, word_index: int) -> str: ...
     def trg_word_exists(self, word: str) -> bool: ...
+    def freeze_vocab(self) -> bool: ...
+    @overload
+    def get_alignment_posteriors(self, src_sentence: Sequence[int], trg_sentence: Sequence[int]) -> Any: ...
+    @overload
+    def get_alignment_posteriors(
+        self, src_sentences: Sequence[Sequence[str]], trg_sentences: Sequence[Sequence[str]]
+    ) -> Tuple[Any, Any]: ...
+    @overload
+    def get_alignment_posteriors(
+        self, src_sentences: Sequence[Sequence[int]], trg_sentences: Sequence[Sequence[int]]
+    ) -> Tuple[Any, Any]: ...
     def start_training(self) -> int: ...
-    def train(self) -> None: ...
+    def train(self, num_iters: int = 1, min_rel_improvement: float = 0) -> int: ...
     def end_training(self) -> None: ...
+    @property
+    def training_metrics(self) -> TrainingMetrics: ...
+    def clear_training_metrics(self) -> None: ...
+    def set_training_metrics_file(self, file_name: str) -> bool: ...
+    def read_held_out_sentence_pairs(self, src_filename: str, trg_filename: str) -> bool: ...
+    def add_held_out_sentence_pair(self, src_sentence: Sequence[str], trg_sentence: Sequence[str]) -> None: ...
+    @property
+    def num_held_out_sentence_pairs(self) -> int: ...
+    def clear_held_out_sentence_pairs(self) -> None: ...
+    def log_likelihood(self) -> Tuple[float, float]: ...
+    def held_out_log_likelihood(self) -> Tuple[float, float]: ...
     def sentence_length_log_prob(self, src_length: int, trg_length: int) -> float: ...
     def sentence_length_prob(self, src_length: int, trg_length: int) -> float: ...
     def translation_log_prob(self, src_word_index: int, trg_word_index: int) -> float: ...
@@ -93,6 +169,10 @@ class AlignmentModel(Aligner):
     def map_trg_word_to_word_class(self, word: str, word_class: str) -> None: ...
     def load(self, prefix_filename: str) -> bool: ...
     def print(self, prefix_filename: str) -> bool: ...
+    def load_container(self, filename: str) -> bool: ...
+    def print_container(self, filename: str) -> bool: ...
+    def load_checkpoint(self, prefix_filename: str) -> bool: ...
+    def print_checkpoint(self, prefix_filename: str) -> bool: ...
     def clear(self) -> None: ...
 
 class IncrAlignmentModel(AlignmentModel):
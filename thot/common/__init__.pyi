@@ -39,5 +39,6 @@ class WordAlignmentMatrix:
     def grow_diag_final_and(self, other: WordAlignmentMatrix) -> WordAlignmentMatrix: ...
     def __eq__(self, other: object) -> bool: ...
     def to_numpy(self) -> Any: ...
+    def to_packed_numpy(self) -> Any: ...
 
 __all__ = ["NGramLanguageModel", "WordAlignmentMatrix"]
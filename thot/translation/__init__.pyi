@@ -1,6 +1,6 @@
 from typing import AbstractSet, Sequence, Tuple
 
-from ..alignment import AlignmentModelType, AlignmentModel
+from ..alignment import Aligner, AlignmentModelType, AlignmentModel
 
 class OnlineTrainingParameters:
     algorithm: int
@@ -121,10 +121,52 @@ class PhraseExtractParameters:
 
     def __init__(self) -> None: ...
 
+class PhraseTablePruningParameters:
+    max_target_phrases_per_source: int
+    min_pair_count: float
+    min_significance: float
+    num_sentence_pairs: int
+
+    def __init__(self) -> None: ...
+
 class PhraseModel:
     def __init__(self) -> None: ...
     def build(self, alignment_filename: str, parameters: PhraseExtractParameters, pseudo_ml: bool) -> bool: ...
+    def build_phrase_table(
+        self,
+        alignment_filename: str,
+        parameters: PhraseExtractParameters,
+        pseudo_ml: bool,
+        output_filename: str,
+        memory_limit: int = 0,
+        temp_dir: str = "",
+        pruning_parameters: PhraseTablePruningParameters = ...,
+    ) -> bool: ...
+    def build_from_aligner(
+        self,
+        aligner: Aligner,
+        source_filename: str,
+        target_filename: str,
+        parameters: PhraseExtractParameters,
+        pseudo_ml: bool,
+    ) -> bool: ...
+    def build_phrase_table_from_aligner(
+        self,
+        aligner: Aligner,
+        source_filename: str,
+        target_filename: str,
+        parameters: PhraseExtractParameters,
+        pseudo_ml: bool,
+        output_filename: str,
+        memory_limit: int = 0,
+        temp_dir: str = "",
+        pruning_parameters: PhraseTablePruningParameters = ...,
+    ) -> bool: ...
     def print_phrase_table(self, filename: str, n: int = -1) -> bool: ...
+    @property
+    def extraction_batch_size(self) -> int: ...
+    @extraction_batch_size.setter
+    def extraction_batch_size(self, value: int) -> None: ...
     def clear(self) -> None: ...
 
 class AlignmentExtractor: